@@ -0,0 +1,75 @@
+//
+//  TOHostResolver.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "TOSMBConstants.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void(^TOHostResolverCompletionHandler)(NSArray<NSString *> * _Nullable results);
+
+extern NSTimeInterval kTOHostResolverDefaultPositiveTTL;
+extern NSTimeInterval kTOHostResolverDefaultNegativeTTL;
+
+/**
+ A process-wide cache in front of the blocking DNS (`TOHost`) and NetBIOS (`TONetBIOSNameService`) lookups.
+
+ Successful results are kept for `positiveTTL` seconds, failed lookups for `negativeTTL` seconds.
+ Concurrent requests for the same name are coalesced into a single lookup, and every lookup runs on a
+ background queue, so a warm cache answers without touching the network.
+ */
+@interface TOHostResolver : NSObject
+
++ (instancetype)sharedResolver;
+
+/** How long a successful lookup stays valid. Default is 5 minutes. */
+@property (atomic, assign) NSTimeInterval positiveTTL;
+
+/** How long a failed lookup is remembered before it is retried. Default is 30 seconds. */
+@property (atomic, assign) NSTimeInterval negativeTTL;
+
+// -------------------------------------------------------------------------------
+
+/**
+ Synchronous lookups. These return immediately when the cache holds a fresh answer, otherwise they
+ join (or start) the in-flight lookup and wait for it. Call them from a background queue.
+ */
+- (nullable NSArray<NSString *> *)addressesForHostname:(NSString *)hostname;
+
+- (nullable NSArray<NSString *> *)hostnamesForAddress:(NSString *)address;
+
+- (nullable NSString *)netBIOSAddressForName:(NSString *)name type:(TONetBIOSNameServiceType)type;
+
+- (nullable NSString *)netBIOSNameForAddress:(NSString *)address;
+
+// -------------------------------------------------------------------------------
+
+/**
+ Asynchronous lookups. The completion handler is called on an arbitrary background queue;
+ pass nil to simply warm the cache.
+ */
+- (void)addressesForHostname:(NSString *)hostname completion:(nullable TOHostResolverCompletionHandler)completion;
+
+- (void)hostnamesForAddress:(NSString *)address completion:(nullable TOHostResolverCompletionHandler)completion;
+
+- (void)netBIOSAddressForName:(NSString *)name
+                         type:(TONetBIOSNameServiceType)type
+                   completion:(nullable TOHostResolverCompletionHandler)completion;
+
+- (void)netBIOSNameForAddress:(NSString *)address completion:(nullable TOHostResolverCompletionHandler)completion;
+
+// -------------------------------------------------------------------------------
+
+/** Drops every cached entry that mentions the supplied host name or address. */
+- (void)invalidateCachedResultsForHost:(NSString *)host;
+
+- (void)removeAllCachedResults;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,317 @@
+//
+//  TOHostResolver.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOHostResolver.h"
+#import "TOHost.h"
+#import "TONetBIOSNameService.h"
+
+NSTimeInterval kTOHostResolverDefaultPositiveTTL = 300.0;
+NSTimeInterval kTOHostResolverDefaultNegativeTTL = 30.0;
+
+typedef NS_ENUM(NSInteger, TOHostResolverQueryType) {
+    TOHostResolverQueryTypeAddresses,
+    TOHostResolverQueryTypeHostnames,
+    TOHostResolverQueryTypeNetBIOSAddress,
+    TOHostResolverQueryTypeNetBIOSName
+};
+
+// -------------------------------------------------------------------------
+
+@interface TOHostResolverEntry : NSObject
+
+@property (nonatomic, copy) NSString *host;
+@property (nonatomic, copy) NSArray<NSString *> *results;
+@property (nonatomic, assign) CFAbsoluteTime expirationTime;
+
+@end
+
+@implementation TOHostResolverEntry
+@end
+
+// -------------------------------------------------------------------------
+
+@interface TOHostResolver (){
+    dispatch_queue_t _queue;
+}
+
+/* Cached answers, keyed by query type and host. Only accessed on _queue. */
+@property (nonatomic, strong) NSMutableDictionary<NSString *, TOHostResolverEntry *> *entries;
+
+/* When the cache is next swept for expired answers. Only accessed on _queue. */
+@property (nonatomic, assign) CFAbsoluteTime nextSweepTime;
+
+/* Completion handlers waiting for a lookup that is already running. Only accessed on _queue. */
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSMutableArray<TOHostResolverCompletionHandler> *> *pendingHandlers;
+
+/* Queue the blocking lookups are performed on. Completion handlers are delivered on a global queue. */
+@property (nonatomic, strong) NSOperationQueue *lookupQueue;
+
+@end
+
+@implementation TOHostResolver
+
++ (instancetype)sharedResolver{
+    static dispatch_once_t onceToken;
+    static TOHostResolver *shared;
+    dispatch_once(&onceToken, ^{
+        shared = [[TOHostResolver alloc] init];
+    });
+    return shared;
+}
+
+- (instancetype)init{
+    self = [super init];
+    if (self) {
+        _positiveTTL = kTOHostResolverDefaultPositiveTTL;
+        _negativeTTL = kTOHostResolverDefaultNegativeTTL;
+        _entries = [[NSMutableDictionary alloc] init];
+        _pendingHandlers = [[NSMutableDictionary alloc] init];
+        _queue = dispatch_queue_create("tosmb_host_resolver", DISPATCH_QUEUE_SERIAL);
+        _lookupQueue = [[NSOperationQueue alloc] init];
+        _lookupQueue.maxConcurrentOperationCount = 4;
+    }
+    return self;
+}
+
+- (void)dealloc{
+    [self.lookupQueue cancelAllOperations];
+}
+
+#pragma mark - Synchronous Lookups -
+
+- (NSArray<NSString *> *)addressesForHostname:(NSString *)hostname{
+    return [self resultsForQueryType:TOHostResolverQueryTypeAddresses host:hostname netBIOSType:0];
+}
+
+- (NSArray<NSString *> *)hostnamesForAddress:(NSString *)address{
+    return [self resultsForQueryType:TOHostResolverQueryTypeHostnames host:address netBIOSType:0];
+}
+
+- (NSString *)netBIOSAddressForName:(NSString *)name type:(TONetBIOSNameServiceType)type{
+    return [[self resultsForQueryType:TOHostResolverQueryTypeNetBIOSAddress host:name netBIOSType:type] firstObject];
+}
+
+- (NSString *)netBIOSNameForAddress:(NSString *)address{
+    return [[self resultsForQueryType:TOHostResolverQueryTypeNetBIOSName host:address netBIOSType:0] firstObject];
+}
+
+- (NSArray<NSString *> *)resultsForQueryType:(TOHostResolverQueryType)queryType
+                                        host:(NSString *)host
+                                 netBIOSType:(TONetBIOSNameServiceType)netBIOSType
+{
+    if (host.length == 0) {
+        return nil;
+    }
+
+    NSString *key = [self keyForQueryType:queryType host:host netBIOSType:netBIOSType];
+
+    //Fast path, a fresh answer is already cached
+    __block BOOL cached = NO;
+    __block NSArray<NSString *> *results = nil;
+    dispatch_sync(_queue, ^{
+        TOHostResolverEntry *entry = [self freshEntryForKey:key];
+        if (entry) {
+            cached = YES;
+            results = entry.results;
+        }
+    });
+    if (cached) {
+        return results;
+    }
+
+    //Otherwise join the lookup and wait for it to finish
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    [self resolveQueryType:queryType host:host netBIOSType:netBIOSType completion:^(NSArray<NSString *> *lookupResults) {
+        results = lookupResults;
+        dispatch_semaphore_signal(semaphore);
+    }];
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    return results;
+}
+
+#pragma mark - Asynchronous Lookups -
+
+- (void)addressesForHostname:(NSString *)hostname completion:(TOHostResolverCompletionHandler)completion{
+    [self resolveQueryType:TOHostResolverQueryTypeAddresses host:hostname netBIOSType:0 completion:completion];
+}
+
+- (void)hostnamesForAddress:(NSString *)address completion:(TOHostResolverCompletionHandler)completion{
+    [self resolveQueryType:TOHostResolverQueryTypeHostnames host:address netBIOSType:0 completion:completion];
+}
+
+- (void)netBIOSAddressForName:(NSString *)name
+                         type:(TONetBIOSNameServiceType)type
+                   completion:(TOHostResolverCompletionHandler)completion
+{
+    [self resolveQueryType:TOHostResolverQueryTypeNetBIOSAddress host:name netBIOSType:type completion:completion];
+}
+
+- (void)netBIOSNameForAddress:(NSString *)address completion:(TOHostResolverCompletionHandler)completion{
+    [self resolveQueryType:TOHostResolverQueryTypeNetBIOSName host:address netBIOSType:0 completion:completion];
+}
+
+- (void)resolveQueryType:(TOHostResolverQueryType)queryType
+                    host:(NSString *)host
+             netBIOSType:(TONetBIOSNameServiceType)netBIOSType
+              completion:(TOHostResolverCompletionHandler)completion
+{
+    if (host.length == 0) {
+        if (completion) {
+            completion(nil);
+        }
+        return;
+    }
+
+    NSString *key = [self keyForQueryType:queryType host:host netBIOSType:netBIOSType];
+    TOHostResolverCompletionHandler handler = completion ? [completion copy] : ^(NSArray<NSString *> *results){};
+
+    TOSMBMakeWeakReference();
+    dispatch_async(_queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+
+        TOHostResolverEntry *entry = [strongSelf freshEntryForKey:key];
+        if (entry) {
+            NSArray<NSString *> *results = entry.results;
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{ handler(results); });
+            return;
+        }
+
+        //Coalesce with a lookup that is already running for the same key
+        NSMutableArray<TOHostResolverCompletionHandler> *handlers = [strongSelf.pendingHandlers objectForKey:key];
+        if (handlers) {
+            [handlers addObject:handler];
+            return;
+        }
+        handlers = [NSMutableArray arrayWithObject:handler];
+        [strongSelf.pendingHandlers setObject:handlers forKey:key];
+
+        [strongSelf.lookupQueue addOperationWithBlock:^{
+            TOHostResolver *resolver = weakSelf;
+            NSArray<NSString *> *results = [resolver performLookupWithQueryType:queryType
+                                                                           host:host
+                                                                    netBIOSType:netBIOSType];
+            [resolver finishLookupForKey:key host:host results:results];
+        }];
+    });
+}
+
+- (void)finishLookupForKey:(NSString *)key host:(NSString *)host results:(NSArray<NSString *> *)results{
+    TOSMBMakeWeakReference();
+    dispatch_async(_queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+
+        const BOOL success = (results.count > 0);
+        TOHostResolverEntry *entry = [[TOHostResolverEntry alloc] init];
+        entry.host = host;
+        entry.results = success ? results : nil;
+        entry.expirationTime = CFAbsoluteTimeGetCurrent() + (success ? strongSelf.positiveTTL : strongSelf.negativeTTL);
+        [strongSelf removeExpiredEntriesIfNeeded];
+        [strongSelf.entries setObject:entry forKey:key];
+
+        NSArray<TOHostResolverCompletionHandler> *handlers = [[strongSelf.pendingHandlers objectForKey:key] copy];
+        [strongSelf.pendingHandlers removeObjectForKey:key];
+
+        NSArray<NSString *> *deliveredResults = entry.results;
+        for (TOHostResolverCompletionHandler handler in handlers) {
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{ handler(deliveredResults); });
+        }
+    });
+}
+
+/* Runs the blocking lookup itself. Kept to one method so the tests can stand in for the network. */
+- (NSArray<NSString *> *)performLookupWithQueryType:(TOHostResolverQueryType)queryType
+                                               host:(NSString *)host
+                                        netBIOSType:(TONetBIOSNameServiceType)netBIOSType
+{
+    switch (queryType) {
+        case TOHostResolverQueryTypeAddresses:
+            return [TOHost addressesForHostname:host];
+        case TOHostResolverQueryTypeHostnames:
+            return [TOHost hostnamesForAddress:host];
+        case TOHostResolverQueryTypeNetBIOSAddress:{
+            NSString *address = [[TONetBIOSNameService sharedService] resolveIPAddressWithName:host type:netBIOSType];
+            return address.length > 0 ? @[address] : nil;
+        }
+        case TOHostResolverQueryTypeNetBIOSName:{
+            NSString *name = [[TONetBIOSNameService sharedService] lookupNetworkNameForIPAddress:host];
+            return name.length > 0 ? @[name] : nil;
+        }
+    }
+    return nil;
+}
+
+#pragma mark - Cache Management -
+
+- (NSString *)keyForQueryType:(TOHostResolverQueryType)queryType
+                         host:(NSString *)host
+                  netBIOSType:(TONetBIOSNameServiceType)netBIOSType
+{
+    return [NSString stringWithFormat:@"%ld:%ld:%@", (long)queryType, (long)netBIOSType, [host lowercaseString]];
+}
+
+/* Must be called on _queue. Returns nil for an expired answer, and drops it. */
+- (TOHostResolverEntry *)freshEntryForKey:(NSString *)key{
+    TOHostResolverEntry *entry = [self.entries objectForKey:key];
+    if (entry && entry.expirationTime <= CFAbsoluteTimeGetCurrent()) {
+        [self.entries removeObjectForKey:key];
+        return nil;
+    }
+    return entry;
+}
+
+/* Must be called on _queue. Answers for hosts that are never asked about again would otherwise stay
+   forever, so every so often the whole cache is swept, at most once per shortest lifetime. */
+- (void)removeExpiredEntriesIfNeeded{
+    const CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    if (now < self.nextSweepTime) {
+        return;
+    }
+    self.nextSweepTime = now + MIN(self.positiveTTL, self.negativeTTL);
+    
+    NSMutableArray<NSString *> *keysToRemove = [NSMutableArray array];
+    [self.entries enumerateKeysAndObjectsUsingBlock:^(NSString *key, TOHostResolverEntry *entry, BOOL *stop) {
+        if (entry.expirationTime <= now) {
+            [keysToRemove addObject:key];
+        }
+    }];
+    [self.entries removeObjectsForKeys:keysToRemove];
+}
+
+- (void)invalidateCachedResultsForHost:(NSString *)host{
+    if (host.length == 0) {
+        return;
+    }
+    TOSMBMakeWeakReference();
+    dispatch_async(_queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        NSMutableArray<NSString *> *keysToRemove = [NSMutableArray array];
+        [strongSelf.entries enumerateKeysAndObjectsUsingBlock:^(NSString *key, TOHostResolverEntry *entry, BOOL *stop) {
+            if ([entry.host caseInsensitiveCompare:host] == NSOrderedSame) {
+                [keysToRemove addObject:key];
+                return;
+            }
+            for (NSString *result in entry.results) {
+                if ([result caseInsensitiveCompare:host] == NSOrderedSame) {
+                    [keysToRemove addObject:key];
+                    return;
+                }
+            }
+        }];
+        [strongSelf.entries removeObjectsForKeys:keysToRemove];
+    });
+}
+
+- (void)removeAllCachedResults{
+    TOSMBMakeWeakReference();
+    dispatch_async(_queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        [strongSelf.entries removeAllObjects];
+    });
+}
+
+@end
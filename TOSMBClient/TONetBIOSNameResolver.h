@@ -0,0 +1,78 @@
+//
+//  TONetBIOSNameResolver.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "TOSMBConstants.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void(^TONetBIOSNameResolverCompletionHandler)(NSString * _Nullable result);
+
+extern NSTimeInterval kTONetBIOSNameResolverDefaultTimeout;
+extern NSUInteger kTONetBIOSNameResolverDefaultMaximumConcurrentQueries;
+
+/**
+ Runs NetBIOS name queries in parallel.
+
+ Every query borrows its own `netbios_ns` handle from a small pool, so one slow or unanswered
+ query no longer stalls the others. The pool is independent from the handle used for device
+ discovery in `TONetBIOSNameService`, so stopping discovery never affects running queries.
+ */
+@interface TONetBIOSNameResolver : NSObject
+
++ (instancetype)sharedResolver;
+
+- (instancetype)initWithMaximumConcurrentQueries:(NSUInteger)maximumConcurrentQueries;
+
+/** The maximum number of queries (and `netbios_ns` handles) in flight at once. */
+@property (nonatomic, readonly) NSUInteger maximumConcurrentQueries;
+
+// -------------------------------------------------------------------------------
+
+/**
+ Resolves the IP address of a NetBIOS name. This operation is performed synchronously, and should be called on a background queue.
+
+ @param name The host name in which to resolve.
+ @param type The NetBIOS device type of the device.
+ @param timeout The number of seconds to wait before giving up. Values <= 0 use the default timeout.
+ @return A string of the IP address, or nil if the resolution failed or timed out.
+ */
+- (nullable NSString *)resolveIPAddressWithName:(NSString *)name
+                                           type:(TONetBIOSNameServiceType)type
+                                        timeout:(NSTimeInterval)timeout;
+
+/**
+ Resolves the NetBIOS name of an IP address. This operation is performed synchronously, and should be called on a background queue.
+
+ @param address The IP address in which to resolve.
+ @param timeout The number of seconds to wait before giving up. Values <= 0 use the default timeout.
+ @return A string of the resolved host name, or nil if the resolution failed or timed out.
+ */
+- (nullable NSString *)lookupNetworkNameForIPAddress:(NSString *)address
+                                             timeout:(NSTimeInterval)timeout;
+
+// -------------------------------------------------------------------------------
+
+/**
+ Asynchronous variants. The returned operation may be cancelled at any time, in which case the
+ completion handler is not called. The completion handler is called on the main queue.
+ */
+- (NSOperation *)resolveIPAddressWithName:(NSString *)name
+                                     type:(TONetBIOSNameServiceType)type
+                                  timeout:(NSTimeInterval)timeout
+                               completion:(TONetBIOSNameResolverCompletionHandler)completion;
+
+- (NSOperation *)lookupNetworkNameForIPAddress:(NSString *)address
+                                       timeout:(NSTimeInterval)timeout
+                                    completion:(TONetBIOSNameResolverCompletionHandler)completion;
+
+- (void)cancelAllQueries;
+
+@end
+
+NS_ASSUME_NONNULL_END
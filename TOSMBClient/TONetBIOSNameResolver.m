@@ -0,0 +1,316 @@
+//
+//  TONetBIOSNameResolver.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <arpa/inet.h>
+
+#import "TONetBIOSNameResolver.h"
+
+#import "netbios_ns.h"
+#import "netbios_defs.h"
+
+NSTimeInterval kTONetBIOSNameResolverDefaultTimeout = 5.0;
+NSUInteger kTONetBIOSNameResolverDefaultMaximumConcurrentQueries = 6;
+
+/* How often a waiting caller checks whether its query was cancelled */
+static const NSTimeInterval kTONetBIOSNameResolverCancellationCheckInterval = 0.1;
+
+typedef NSString *(^TONetBIOSNameResolverQueryBlock)(netbios_ns *nameService);
+
+@interface TONetBIOSNameResolver ()
+
+@property (nonatomic, assign, readwrite) NSUInteger maximumConcurrentQueries;
+
+/* Handles not currently used by a query. Guarded by @synchronized on the array itself. */
+@property (nonatomic, strong) NSMutableArray<NSValue *> *idleNameServices;
+
+/* Limits the number of handles (and so in-flight queries) to maximumConcurrentQueries */
+@property (nonatomic, strong) dispatch_semaphore_t capacitySemaphore;
+
+/* Concurrent queue the blocking libdsm calls run on */
+@property (nonatomic, strong) dispatch_queue_t queryQueue;
+
+/* Operation queue for the asynchronous, cancellable API */
+@property (nonatomic, strong) NSOperationQueue *operationQueue;
+
+@end
+
+/* The state of one query, shared by the caller and the detached libdsm call. Guarded by @synchronized on itself. */
+@interface TONetBIOSNameResolverQuery : NSObject
+
+@property (nonatomic, assign) BOOL started;     /* Holds a pool slot and a handle */
+@property (nonatomic, assign) BOOL finished;
+@property (nonatomic, assign) BOOL abandoned;   /* The caller timed out or was cancelled */
+@property (nonatomic, copy) NSString *result;
+
+@end
+
+@implementation TONetBIOSNameResolverQuery
+@end
+
+@implementation TONetBIOSNameResolver
+
++ (instancetype)sharedResolver{
+    static dispatch_once_t onceToken;
+    static TONetBIOSNameResolver *shared;
+    dispatch_once(&onceToken, ^{
+        shared = [[TONetBIOSNameResolver alloc] initWithMaximumConcurrentQueries:kTONetBIOSNameResolverDefaultMaximumConcurrentQueries];
+    });
+    return shared;
+}
+
+- (instancetype)init{
+    return [self initWithMaximumConcurrentQueries:kTONetBIOSNameResolverDefaultMaximumConcurrentQueries];
+}
+
+- (instancetype)initWithMaximumConcurrentQueries:(NSUInteger)maximumConcurrentQueries{
+    self = [super init];
+    if (self) {
+        _maximumConcurrentQueries = MAX(maximumConcurrentQueries, 1);
+        _idleNameServices = [[NSMutableArray alloc] init];
+        _capacitySemaphore = dispatch_semaphore_create(_maximumConcurrentQueries);
+        _queryQueue = dispatch_queue_create("tosmb_netbios_name_resolver", DISPATCH_QUEUE_CONCURRENT);
+        _operationQueue = [[NSOperationQueue alloc] init];
+        _operationQueue.maxConcurrentOperationCount = _maximumConcurrentQueries;
+    }
+    return self;
+}
+
+- (void)dealloc{
+    [self.operationQueue cancelAllOperations];
+    @synchronized (self.idleNameServices) {
+        for (NSValue *value in self.idleNameServices) {
+            netbios_ns_destroy((netbios_ns *)[value pointerValue]);
+        }
+        [self.idleNameServices removeAllObjects];
+    }
+}
+
+#pragma mark - Name Service Pool -
+
+- (netbios_ns *)checkoutNameService{
+    @synchronized (self.idleNameServices) {
+        NSValue *value = [self.idleNameServices lastObject];
+        if (value) {
+            [self.idleNameServices removeLastObject];
+            return (netbios_ns *)[value pointerValue];
+        }
+    }
+    return netbios_ns_new();
+}
+
+- (void)checkinNameService:(netbios_ns *)nameService{
+    if (nameService == NULL) {
+        return;
+    }
+    @synchronized (self.idleNameServices) {
+        [self.idleNameServices addObject:[NSValue valueWithPointer:nameService]];
+    }
+}
+
+#pragma mark - Queries -
+
+- (NSString *)performQueryWithTimeout:(NSTimeInterval)timeout
+                            operation:(NSOperation *)operation
+                                block:(TONetBIOSNameResolverQueryBlock)queryBlock
+{
+    if (timeout <= FLT_EPSILON) {
+        timeout = kTONetBIOSNameResolverDefaultTimeout;
+    }
+
+    const CFAbsoluteTime deadline = CFAbsoluteTimeGetCurrent() + timeout;
+    dispatch_semaphore_t capacitySemaphore = self.capacitySemaphore;
+    dispatch_semaphore_t completionSemaphore = dispatch_semaphore_create(0);
+    TONetBIOSNameResolverQuery *query = [[TONetBIOSNameResolverQuery alloc] init];
+
+    //The libdsm call can't be interrupted, so it runs detached from the caller. If the caller gives up,
+    //its pool slot is handed back straight away and the handle is thrown away once the call returns.
+    TOSMBMakeWeakReference();
+    dispatch_async(self.queryQueue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        if (strongSelf == nil) {
+            dispatch_semaphore_signal(completionSemaphore);
+            return;
+        }
+
+        const CFAbsoluteTime remaining = deadline - CFAbsoluteTimeGetCurrent();
+        if (remaining <= 0 || dispatch_semaphore_wait(capacitySemaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(remaining * NSEC_PER_SEC))) != 0) {
+            dispatch_semaphore_signal(completionSemaphore);
+            return;
+        }
+        @synchronized (query) {
+            if (query.abandoned) {
+                dispatch_semaphore_signal(capacitySemaphore);
+                return;
+            }
+            query.started = YES;
+        }
+
+        netbios_ns *nameService = [strongSelf checkoutNameService];
+        NSString *result = (nameService != NULL) ? queryBlock(nameService) : nil;
+        @synchronized (query) {
+            query.finished = YES;
+            if (query.abandoned) {
+                if (nameService != NULL) {
+                    netbios_ns_destroy(nameService);
+                }
+                return;
+            }
+            query.result = result;
+        }
+        [strongSelf checkinNameService:nameService];
+        dispatch_semaphore_signal(capacitySemaphore);
+        dispatch_semaphore_signal(completionSemaphore);
+    });
+
+    while (YES) {
+        if (dispatch_semaphore_wait(completionSemaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kTONetBIOSNameResolverCancellationCheckInterval * NSEC_PER_SEC))) == 0) {
+            @synchronized (query) {
+                return query.result;
+            }
+        }
+        if (operation.isCancelled || CFAbsoluteTimeGetCurrent() >= deadline) {
+            @synchronized (query) {
+                if (query.finished) {
+                    return query.result;
+                }
+                query.abandoned = YES;
+                if (query.started) {
+                    dispatch_semaphore_signal(capacitySemaphore);
+                }
+            }
+            return nil;
+        }
+    }
+}
+
+- (NSString *)resolveIPAddressWithName:(NSString *)name
+                                  type:(TONetBIOSNameServiceType)type
+                               timeout:(NSTimeInterval)timeout
+{
+    return [self resolveIPAddressWithName:name type:type timeout:timeout operation:nil];
+}
+
+- (NSString *)resolveIPAddressWithName:(NSString *)name
+                                  type:(TONetBIOSNameServiceType)type
+                               timeout:(NSTimeInterval)timeout
+                             operation:(NSOperation *)operation
+{
+    if (name.length == 0) {
+        return nil;
+    }
+
+    const char *nameCString = [[name copy] cStringUsingEncoding:NSUTF8StringEncoding];
+    if (nameCString == NULL) {
+        return nil;
+    }
+    NSData *nameData = [NSData dataWithBytes:nameCString length:strlen(nameCString) + 1];
+    const char cType = TONetBIOSNameServiceCTypeForType(type);
+
+    return [self performQueryWithTimeout:timeout operation:operation block:^NSString *(netbios_ns *nameService) {
+        struct in_addr addr;
+        int result = netbios_ns_resolve(nameService, (const char *)nameData.bytes, cType, &addr.s_addr);
+        if (result < 0) {
+            return nil;
+        }
+        char ipAddress[INET_ADDRSTRLEN];
+        if (inet_ntop(AF_INET, &addr, ipAddress, INET_ADDRSTRLEN) == NULL) {
+            return nil;
+        }
+        return [NSString stringWithCString:ipAddress encoding:NSUTF8StringEncoding];
+    }];
+}
+
+- (NSString *)lookupNetworkNameForIPAddress:(NSString *)address timeout:(NSTimeInterval)timeout{
+    return [self lookupNetworkNameForIPAddress:address timeout:timeout operation:nil];
+}
+
+- (NSString *)lookupNetworkNameForIPAddress:(NSString *)address
+                                    timeout:(NSTimeInterval)timeout
+                                  operation:(NSOperation *)operation
+{
+    if (address.length == 0) {
+        return nil;
+    }
+
+    struct in_addr addr;
+    if (inet_aton([address cStringUsingEncoding:NSASCIIStringEncoding], &addr) == 0) {
+        return nil;
+    }
+    const uint32_t ip = addr.s_addr;
+
+    return [self performQueryWithTimeout:timeout operation:operation block:^NSString *(netbios_ns *nameService) {
+        //The returned string is owned by the handle, so copy it before the handle goes back to the pool
+        const char *name = netbios_ns_inverse(nameService, ip);
+        if (name == NULL) {
+            return nil;
+        }
+        return [NSString stringWithCString:name encoding:NSUTF8StringEncoding];
+    }];
+}
+
+#pragma mark - Asynchronous Queries -
+
+- (NSOperation *)resolveIPAddressWithName:(NSString *)name
+                                     type:(TONetBIOSNameServiceType)type
+                                  timeout:(NSTimeInterval)timeout
+                               completion:(TONetBIOSNameResolverCompletionHandler)completion
+{
+    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
+    TOSMBMakeWeakReference();
+    TOSMBMakeWeakReferenceForOperation();
+    [operation addExecutionBlock:^{
+        TOSMBCheckIfWeakReferenceForOperationIsCancelledOrNilAndReturn();
+        TOSMBCheckIfWeakReferenceIsNilAndReturn();
+        TOSMBMakeStrongFromWeakReference();
+        NSString *address = [strongSelf resolveIPAddressWithName:name type:type timeout:timeout operation:weakOperation];
+        [strongSelf finishOperation:weakOperation withResult:address completion:completion];
+    }];
+    [self.operationQueue addOperation:operation];
+    return operation;
+}
+
+- (NSOperation *)lookupNetworkNameForIPAddress:(NSString *)address
+                                       timeout:(NSTimeInterval)timeout
+                                    completion:(TONetBIOSNameResolverCompletionHandler)completion
+{
+    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
+    TOSMBMakeWeakReference();
+    TOSMBMakeWeakReferenceForOperation();
+    [operation addExecutionBlock:^{
+        TOSMBCheckIfWeakReferenceForOperationIsCancelledOrNilAndReturn();
+        TOSMBCheckIfWeakReferenceIsNilAndReturn();
+        TOSMBMakeStrongFromWeakReference();
+        NSString *name = [strongSelf lookupNetworkNameForIPAddress:address timeout:timeout operation:weakOperation];
+        [strongSelf finishOperation:weakOperation withResult:name completion:completion];
+    }];
+    [self.operationQueue addOperation:operation];
+    return operation;
+}
+
+- (void)finishOperation:(NSOperation *)operation
+             withResult:(NSString *)result
+             completion:(TONetBIOSNameResolverCompletionHandler)completion
+{
+    if (completion == nil || operation == nil || operation.isCancelled) {
+        return;
+    }
+    __weak NSOperation *weakOperation = operation;
+    [[NSOperationQueue mainQueue] addOperationWithBlock:^{
+        //Cancellation may have happened while this block was queued
+        if (weakOperation.isCancelled) {
+            return;
+        }
+        completion(result);
+    }];
+}
+
+- (void)cancelAllQueries{
+    [self.operationQueue cancelAllOperations];
+}
+
+@end
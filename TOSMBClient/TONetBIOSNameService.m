@@ -25,6 +25,7 @@
 #import "TOSMBConstants.h"
 #import "TONetBIOSNameService.h"
 #import "TONetBIOSNameServiceEntry+Private.h"
+#import "TONetBIOSNameResolver.h"
 
 #import "netbios_ns.h"
 #import "netbios_defs.h"
@@ -35,6 +36,7 @@ const NSTimeInterval kTONetBIOSNameServiceDiscoveryTimeOut = 4.0f;
 
 @interface TONetBIOSNameService ()
 
+/* Handle used for device discovery only. Name queries go through TONetBIOSNameResolver. */
 @property (nonatomic, assign) netbios_ns *nameService;
 @property (nonatomic, assign, readwrite) BOOL discovering;
 
@@ -137,21 +139,10 @@ static void on_entry_removed(void *p_opaque, netbios_ns_entry *entry)
 
 #pragma mark - Device Name / IP Resolution -
 - (NSString *)resolveIPAddressWithName:(NSString *)name type:(TONetBIOSNameServiceType)type{
-    @synchronized (self) {
-        if (name == nil){
-            return nil;
-        }
-        struct in_addr addr;
-        int result = netbios_ns_resolve(self.nameService, [name cStringUsingEncoding:NSUTF8StringEncoding], TONetBIOSNameServiceCTypeForType(type), &addr.s_addr);
-        if (result < 0){
-            return nil;
-        }
-        char *ipAddress = inet_ntoa(addr);
-        if (ipAddress == NULL) {
-            return nil;
-        }
-        return [NSString stringWithCString:ipAddress encoding:NSUTF8StringEncoding];
-    }
+    //Queries run on their own pooled handles so they don't serialize behind each other or discovery
+    return [[TONetBIOSNameResolver sharedResolver] resolveIPAddressWithName:name
+                                                                      type:type
+                                                                   timeout:kTONetBIOSNameResolverDefaultTimeout];
 }
 
 - (void)resolveIPAddressWithName:(NSString *)name type:(TONetBIOSNameServiceType)type
@@ -196,18 +187,8 @@ static void on_entry_removed(void *p_opaque, netbios_ns_entry *entry)
 }
 
 - (NSString *)lookupNetworkNameForIPAddress:(NSString *)address{
-    @synchronized (self) {
-        if (address == nil){
-            return nil;
-        }
-        struct in_addr  addr;
-        inet_aton([address cStringUsingEncoding:NSASCIIStringEncoding], &addr);
-        char *addressString = (char *)netbios_ns_inverse(self.nameService, addr.s_addr);
-        if (addressString == NULL) {
-            return nil;
-        }
-        return [NSString stringWithCString:addressString encoding:NSUTF8StringEncoding];
-    }
+    return [[TONetBIOSNameResolver sharedResolver] lookupNetworkNameForIPAddress:address
+                                                                         timeout:kTONetBIOSNameResolverDefaultTimeout];
 }
 
 - (void)lookupNetworkNameForIPAddress:(NSString *)address success:(void (^)(NSString *))success failure:(void (^)(void))failure{
@@ -0,0 +1,62 @@
+//
+//  TOSMBCSessionRegistry.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class TOSMBCSessionWrapper;
+
+NS_ASSUME_NONNULL_BEGIN
+
+extern NSTimeInterval kTOSMBCSessionRegistryDefaultIdleTimeout;
+
+/**
+ A process-wide table of authenticated sessions, keyed on `-[TOSMBCSessionWrapper sessionKey]`.
+
+ `TOSMBSession` objects with the same server and credentials share one connection (and so one
+ tree connect cache) through the registry. Every user holds a reference; a session nobody references
+ is kept around for `idleTimeout` seconds so it can be picked up again, then closed.
+ Idle sessions are also closed straight away when the system reports memory pressure.
+ */
+@interface TOSMBCSessionRegistry : NSObject
+
++ (instancetype)sharedRegistry;
+
+/** How long an unreferenced session is kept open. Default is 30 seconds. */
+@property (atomic, assign) NSTimeInterval idleTimeout;
+
+/**
+ Returns a connected session for the key and takes a reference to it, or nil if there is none.
+ Sessions that have timed out or lost their connection are retired instead of being returned.
+ */
+- (nullable TOSMBCSessionWrapper *)checkoutSessionForKey:(NSString *)sessionKey;
+
+/**
+ Adds a freshly connected session under its session key and takes a reference to it.
+ If another session was registered for the same key in the meantime, a reference to that one
+ is returned instead, and the caller should close its own session and switch over.
+ */
+- (TOSMBCSessionWrapper *)registerSession:(TOSMBCSessionWrapper *)session;
+
+/**
+ Gives back a reference taken with one of the methods above.
+ @return NO if the session isn't managed by the registry, in which case the caller still owns it.
+ */
+- (BOOL)releaseSession:(TOSMBCSessionWrapper *)session;
+
+/** Stops handing out the session. It is closed once its last reference is released. */
+- (void)invalidateSession:(TOSMBCSessionWrapper *)session;
+
+/** YES if the session is shared through the registry */
+- (BOOL)containsSession:(TOSMBCSessionWrapper *)session;
+
+/** Closes every session that currently has no references */
+- (void)closeIdleSessions;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,318 @@
+//
+//  TOSMBCSessionRegistry.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBCSessionRegistry.h"
+#import "TOSMBCSessionWrapper.h"
+#import "TOSMBCSessionWrapper+Private.h"
+#import "TOSMBConstants.h"
+#import "TOSMBSession.h"
+
+NSTimeInterval kTOSMBCSessionRegistryDefaultIdleTimeout = 30.0;
+
+@interface TOSMBCSessionRegistryEntry : NSObject
+
+@property (nonatomic, strong) TOSMBCSessionWrapper *session;
+@property (nonatomic, copy) NSString *sessionKey;
+@property (nonatomic, assign) NSInteger referenceCount;
+@property (nonatomic, strong) NSDate *idleSinceDate;
+
+@end
+
+@implementation TOSMBCSessionRegistryEntry
+@end
+
+// -------------------------------------------------------------------------
+
+@interface TOSMBCSessionRegistry ()
+
+/* Sessions that can be handed out, by session key. Only touched on `queue`. */
+@property (nonatomic, strong) NSMutableDictionary<NSString *, TOSMBCSessionRegistryEntry *> *entries;
+
+/* Invalidated sessions that are still referenced. Only touched on `queue`. */
+@property (nonatomic, strong) NSMutableArray<TOSMBCSessionRegistryEntry *> *retiredEntries;
+
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, strong) dispatch_source_t evictionTimer;
+@property (nonatomic, strong) dispatch_source_t memoryPressureSource;
+
+@end
+
+@implementation TOSMBCSessionRegistry
+
++ (instancetype)sharedRegistry{
+    static dispatch_once_t onceToken;
+    static TOSMBCSessionRegistry *shared;
+    dispatch_once(&onceToken, ^{
+        shared = [[TOSMBCSessionRegistry alloc] init];
+    });
+    return shared;
+}
+
+- (instancetype)init{
+    self = [super init];
+    if (self) {
+        _idleTimeout = kTOSMBCSessionRegistryDefaultIdleTimeout;
+        _entries = [[NSMutableDictionary alloc] init];
+        _retiredEntries = [[NSMutableArray alloc] init];
+        _queue = dispatch_queue_create("tosmb_session_registry", DISPATCH_QUEUE_SERIAL);
+
+        TOSMBMakeWeakReference();
+        _memoryPressureSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE, 0,
+                                                       DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL,
+                                                       _queue);
+        dispatch_source_set_event_handler(_memoryPressureSource, ^{
+            TOSMBMakeStrongFromWeakReference();
+            [strongSelf closeSessionsIdleForAtLeast:0];
+        });
+        dispatch_resume(_memoryPressureSource);
+    }
+    return self;
+}
+
+- (void)dealloc{
+    if (_memoryPressureSource) {
+        dispatch_source_cancel(_memoryPressureSource);
+    }
+    if (_evictionTimer) {
+        dispatch_source_cancel(_evictionTimer);
+    }
+}
+
+#pragma mark - References -
+
+- (TOSMBCSessionWrapper *)checkoutSessionForKey:(NSString *)sessionKey{
+    if (sessionKey.length == 0) {
+        return nil;
+    }
+
+    __block TOSMBCSessionWrapper *session = nil;
+    TOSMBMakeWeakReference();
+    dispatch_sync(self.queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        TOSMBCSessionRegistryEntry *entry = strongSelf.entries[sessionKey];
+        if (entry == nil) {
+            return;
+        }
+        if ([strongSelf isEntryExpired:entry]) {
+            [strongSelf retireEntry:entry];
+            return;
+        }
+        entry.referenceCount++;
+        entry.idleSinceDate = nil;
+        session = entry.session;
+    });
+
+    if (session == nil) {
+        return nil;
+    }
+
+    //Checking the connection hops onto the session's own queue, so don't hold up the registry for it
+    if ([session isConnected] == NO) {
+        [self invalidateSession:session];
+        [self releaseSession:session];
+        return nil;
+    }
+
+    return session;
+}
+
+- (TOSMBCSessionWrapper *)registerSession:(TOSMBCSessionWrapper *)session{
+    NSParameterAssert(session);
+    NSString *sessionKey = [session sessionKey];
+
+    __block TOSMBCSessionWrapper *registeredSession = session;
+    TOSMBMakeWeakReference();
+    dispatch_sync(self.queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        TOSMBCSessionRegistryEntry *entry = strongSelf.entries[sessionKey];
+        if (entry && entry.session != session && [strongSelf isEntryExpired:entry] == NO) {
+            entry.referenceCount++;
+            entry.idleSinceDate = nil;
+            registeredSession = entry.session;
+            return;
+        }
+        if (entry && entry.session == session) {
+            entry.referenceCount++;
+            entry.idleSinceDate = nil;
+            return;
+        }
+        if (entry) {
+            [strongSelf retireEntry:entry];
+        }
+        entry = [[TOSMBCSessionRegistryEntry alloc] init];
+        entry.session = session;
+        entry.sessionKey = sessionKey;
+        entry.referenceCount = 1;
+        strongSelf.entries[sessionKey] = entry;
+    });
+
+    return registeredSession;
+}
+
+- (BOOL)releaseSession:(TOSMBCSessionWrapper *)session{
+    if (session == nil) {
+        return NO;
+    }
+
+    __block BOOL managed = NO;
+    TOSMBMakeWeakReference();
+    dispatch_sync(self.queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        TOSMBCSessionRegistryEntry *entry = [strongSelf entryForSession:session];
+        if (entry == nil) {
+            return;
+        }
+        managed = YES;
+        NSParameterAssert(entry.referenceCount > 0);
+        entry.referenceCount = MAX(entry.referenceCount - 1, 0);
+        if (entry.referenceCount > 0) {
+            return;
+        }
+        if ([strongSelf.retiredEntries containsObject:entry]) {
+            [strongSelf.retiredEntries removeObject:entry];
+            [strongSelf closeSessionsAsynchronously:@[entry.session]];
+            return;
+        }
+        entry.idleSinceDate = [NSDate date];
+        [strongSelf scheduleEvictionTimer];
+    });
+
+    return managed;
+}
+
+- (void)invalidateSession:(TOSMBCSessionWrapper *)session{
+    if (session == nil) {
+        return;
+    }
+    TOSMBMakeWeakReference();
+    dispatch_sync(self.queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        TOSMBCSessionRegistryEntry *entry = [strongSelf entryForSession:session];
+        if (entry && [strongSelf.retiredEntries containsObject:entry] == NO) {
+            [strongSelf retireEntry:entry];
+        }
+    });
+}
+
+- (BOOL)containsSession:(TOSMBCSessionWrapper *)session{
+    if (session == nil) {
+        return NO;
+    }
+    __block BOOL contains = NO;
+    TOSMBMakeWeakReference();
+    dispatch_sync(self.queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        contains = ([strongSelf entryForSession:session] != nil);
+    });
+    return contains;
+}
+
+#pragma mark - Eviction -
+
+- (void)closeIdleSessions{
+    TOSMBMakeWeakReference();
+    dispatch_sync(self.queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        [strongSelf closeSessionsIdleForAtLeast:0];
+    });
+}
+
+- (void)closeSessionsIdleForAtLeast:(NSTimeInterval)interval{
+    NSMutableArray<TOSMBCSessionWrapper *> *sessionsToClose = [NSMutableArray array];
+    NSDate *now = [NSDate date];
+    for (TOSMBCSessionRegistryEntry *entry in self.entries.allValues) {
+        if (entry.referenceCount > 0 || entry.idleSinceDate == nil) {
+            continue;
+        }
+        if ([now timeIntervalSinceDate:entry.idleSinceDate] >= interval || [self isEntryExpired:entry]) {
+            [self.entries removeObjectForKey:entry.sessionKey];
+            [sessionsToClose addObject:entry.session];
+        }
+    }
+    [self closeSessionsAsynchronously:sessionsToClose];
+
+    if ([self hasIdleEntries] == NO && self.evictionTimer) {
+        dispatch_source_cancel(self.evictionTimer);
+        self.evictionTimer = nil;
+    }
+}
+
+- (void)scheduleEvictionTimer{
+    if (self.evictionTimer) {
+        return;
+    }
+    const NSTimeInterval interval = MAX(self.idleTimeout / 2.0, 1.0);
+    dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.queue);
+    dispatch_source_set_timer(timer,
+                              dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC)),
+                              (uint64_t)(interval * NSEC_PER_SEC),
+                              (uint64_t)(NSEC_PER_SEC / 2));
+    TOSMBMakeWeakReference();
+    dispatch_source_set_event_handler(timer, ^{
+        TOSMBMakeStrongFromWeakReference();
+        [strongSelf closeSessionsIdleForAtLeast:strongSelf.idleTimeout];
+    });
+    self.evictionTimer = timer;
+    dispatch_resume(timer);
+}
+
+- (void)closeSessionsAsynchronously:(NSArray<TOSMBCSessionWrapper *> *)sessions{
+    if (sessions.count == 0) {
+        return;
+    }
+    //Logging off talks to the server, so keep it off the registry queue
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+        for (TOSMBCSessionWrapper *session in sessions) {
+            [session close];
+        }
+    });
+}
+
+#pragma mark - Entries -
+
+- (TOSMBCSessionRegistryEntry *)entryForSession:(TOSMBCSessionWrapper *)session{
+    for (TOSMBCSessionRegistryEntry *entry in self.entries.allValues) {
+        if (entry.session == session) {
+            return entry;
+        }
+    }
+    for (TOSMBCSessionRegistryEntry *entry in self.retiredEntries) {
+        if (entry.session == session) {
+            return entry;
+        }
+    }
+    return nil;
+}
+
+- (void)retireEntry:(TOSMBCSessionRegistryEntry *)entry{
+    if (self.entries[entry.sessionKey] == entry) {
+        [self.entries removeObjectForKey:entry.sessionKey];
+    }
+    if (entry.referenceCount > 0) {
+        [self.retiredEntries addObject:entry];
+    }
+    else {
+        [self closeSessionsAsynchronously:@[entry.session]];
+    }
+}
+
+- (BOOL)isEntryExpired:(TOSMBCSessionRegistryEntry *)entry{
+    NSDate *lastRequestDate = entry.session.lastRequestDate;
+    return lastRequestDate && [[NSDate date] timeIntervalSinceDate:lastRequestDate] > kTOSMBSessionTimeout;
+}
+
+- (BOOL)hasIdleEntries{
+    for (TOSMBCSessionRegistryEntry *entry in self.entries.allValues) {
+        if (entry.referenceCount == 0) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+@end
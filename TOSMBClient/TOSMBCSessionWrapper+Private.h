@@ -9,9 +9,57 @@
 
 #import "TOSMBCSessionWrapper.h"
 #import "smb_session.h"
+#import "smb_file.h"
+
+/**
+ Gives a block direct access to one session and its tree ID cache while it runs on the session queue.
+ Everything done through a context happens in a single queue hop, so a sequence of libdsm calls
+ (tree connect, stat, open...) doesn't pay a lock and a dispatch_sync per call.
+ A context is only valid inside the block it was passed to.
+ */
+@interface TOSMBSessionOperationContext : NSObject
+
+@property (nonatomic, readonly) smb_session *session;
+
+/* The wrapper the block runs on. Retries hand it back to the session, so only the connection that failed is replaced. */
+@property (nonatomic, readonly, weak) TOSMBCSessionWrapper *wrapper;
+
+/* Returns the cached tree ID for the share, or connects to it and caches the result. */
+- (smb_tid)treeIDForShareName:(NSString *)shareName;
+
+/* Returns the cached tree ID for the share without connecting. */
+- (smb_tid)cachedTreeIDForShareName:(NSString *)shareName;
+
+/* Disconnects and forgets the cached tree ID for the share. */
+- (void)invalidateTreeIDForShareName:(NSString *)shareName;
+
+/* Reads from an open file. Returns the number of bytes read, 0 at the end of the file and -1 on failure. */
+- (ssize_t)readFile:(smb_fd)fileID intoBuffer:(void *)buffer length:(size_t)length;
+
+/* Writes to an open file. Returns the number of bytes written and -1 on failure. */
+- (ssize_t)writeFile:(smb_fd)fileID fromBuffer:(void *)buffer length:(size_t)length;
+
+/* Opens the file and seeks it to the offset. Returns the libdsm result, `fileID` is only set on DSM_SUCCESS. */
+- (int)openFileAtPath:(const char *)path inTree:(smb_tid)treeID mode:(uint32_t)mode offset:(uint64_t)offset fileID:(smb_fd *)fileID;
+
+/**
+ Whether a call in this block failed because the connection did, rather than because the server turned it down.
+ Pass the call's libdsm result: DSM_ERROR_NETWORK and DSM_ERROR_NT settle it straight away. Anything else,
+ like the -1 of a read or a NULL stat, is ambiguous and goes to `hasConnectionFailed`.
+ */
+- (BOOL)hasConnectionFailedAfterResult:(int)result;
+
+/* Whether the connection has failed, for when the failed call gave no result to go on. A new status from the
+   server since the block started means it is still there. Otherwise costs one round trip to find out. */
+- (BOOL)hasConnectionFailed;
+
+@end
 
 @interface TOSMBCSessionWrapper()
 
+/* The class of the contexts handed to operations */
++ (Class)operationContextClass;
+
 - (smb_tid)cachedShareIDForName:(NSString *)shareName;
 
 - (void)cacheShareID:(smb_tid)shareID forName:(NSString *)shareName;
@@ -20,4 +68,13 @@
 
 - (void)inSMBCSession:(void (^)(smb_session *session))block;
 
+- (BOOL)isConnected;
+
+- (void)performOperation:(void (^)(TOSMBSessionOperationContext *context))block;
+
+/* Queues the block on the session queue and returns straight away. The queue is the connection's only
+   I/O thread, so any number of requests can wait on it without parking a thread each.
+   The context is nil if the session has been closed by the time the block runs. */
+- (void)performAsyncOperation:(void (^)(TOSMBSessionOperationContext *context))block;
+
 @end
@@ -17,6 +17,119 @@
 
 static const void * const kTOSMBCSessionWrapperQueueSpecificKey = &kTOSMBCSessionWrapperQueueSpecificKey;
 
+@interface TOSMBSessionOperationContext ()
+
+@property (nonatomic, assign) smb_session *session;
+@property (nonatomic, weak) TOSMBCSessionWrapper *wrapper;
+
+/* The owning wrapper's tree ID cache. Only touched on the wrapper's queue. */
+@property (nonatomic, unsafe_unretained) NSMutableDictionary<NSString *, NSNumber *> *shares;
+
+/* The last status the server sent before the block started */
+@property (nonatomic, assign) uint32_t initialNTStatus;
+
+@end
+
+@implementation TOSMBSessionOperationContext
+
+- (smb_tid)cachedTreeIDForShareName:(NSString *)shareName{
+    NSParameterAssert(shareName.length > 0);
+    NSNumber *obj = [self.shares objectForKey:shareName];
+    if (obj) {
+        return [obj unsignedShortValue];
+    }
+    return TOSMBShareIDUnknown;
+}
+
+- (smb_tid)treeIDForShareName:(NSString *)shareName{
+    if (shareName.length == 0) {
+        return TOSMBShareIDUnknown;
+    }
+    smb_tid treeID = [self cachedTreeIDForShareName:shareName];
+    if (treeID != TOSMBShareIDUnknown) {
+        return treeID;
+    }
+    const char *shareCString = [shareName cStringUsingEncoding:NSUTF8StringEncoding];
+    if (shareCString == NULL || smb_tree_connect(self.session, shareCString, &treeID) != DSM_SUCCESS) {
+        treeID = TOSMBShareIDUnknown;
+    }
+    if (treeID != TOSMBShareIDUnknown) {
+        [self.shares setObject:@(treeID) forKey:shareName];
+    }
+    return treeID;
+}
+
+- (ssize_t)readFile:(smb_fd)fileID intoBuffer:(void *)buffer length:(size_t)length{
+    return smb_fread(self.session, fileID, buffer, length);
+}
+
+- (ssize_t)writeFile:(smb_fd)fileID fromBuffer:(void *)buffer length:(size_t)length{
+    return smb_fwrite(self.session, fileID, buffer, length);
+}
+
+- (int)openFileAtPath:(const char *)path inTree:(smb_tid)treeID mode:(uint32_t)mode offset:(uint64_t)offset fileID:(smb_fd *)fileID{
+    NSParameterAssert(fileID);
+    smb_fd openedFileID = 0;
+    const int result = smb_fopen(self.session, treeID, path, mode, &openedFileID);
+    if (result != DSM_SUCCESS) {
+        return result;
+    }
+    if (offset > 0 && smb_fseek(self.session, openedFileID, (ssize_t)offset, SMB_SEEK_SET) < 0) {
+        smb_fclose(self.session, openedFileID);
+        return DSM_ERROR_GENERIC;
+    }
+    *fileID = openedFileID;
+    return DSM_SUCCESS;
+}
+
+- (BOOL)hasConnectionFailedAfterResult:(int)result{
+    if (result == DSM_ERROR_NETWORK) {
+        return YES;
+    }
+    //The server had to be there to send a status back
+    if (result == DSM_ERROR_NT) {
+        return NO;
+    }
+    return [self hasConnectionFailed];
+}
+
+- (BOOL)hasConnectionFailed{
+    //Never logged in, or the login itself was lost
+    if (smb_session_is_guest(self.session) < 0) {
+        return YES;
+    }
+    
+    //libdsm keeps its logged in state when a read or write fails on the transport, and most calls
+    //report any failure the same way, so a status the server sent since the block began is the only tell
+    if (smb_session_get_nt_status(self.session) != self.initialNTStatus) {
+        return NO;
+    }
+    
+    //Otherwise ask the server for something it always answers
+    smb_tid treeID = TOSMBShareIDUnknown;
+    const int result = smb_tree_connect(self.session, "IPC$", &treeID);
+    if (result == DSM_SUCCESS) {
+        smb_tree_disconnect(self.session, treeID);
+        return NO;
+    }
+    return (result != DSM_ERROR_NT);
+}
+
+- (void)invalidateTreeIDForShareName:(NSString *)shareName{
+    if (shareName.length == 0) {
+        return;
+    }
+    smb_tid treeID = [self cachedTreeIDForShareName:shareName];
+    [self.shares removeObjectForKey:shareName];
+    if (treeID != TOSMBShareIDUnknown) {
+        smb_tree_disconnect(self.session, treeID);
+    }
+}
+
+@end
+
+// -------------------------------------------------------------------------
+
 @interface TOSMBCSessionWrapper(){
     dispatch_queue_t _queue;
 }
@@ -86,16 +199,57 @@ static const void * const kTOSMBCSessionWrapperQueueSpecificKey = &kTOSMBCSessio
     });
 }
 
-- (smb_tid)cachedShareIDForName:(NSString *)shareName{
-    NSParameterAssert(shareName.length > 0);
-    __block smb_tid share_id = TOSMBShareIDUnknown;
+- (void)performOperation:(void (^)(TOSMBSessionOperationContext *context))block{
+    NSParameterAssert(block);
+    if (block == nil) {
+        return;
+    }
     TOSMBMakeWeakReference();
     [self inSMBCSession:^(smb_session *session) {
         TOSMBMakeStrongFromWeakReference();
-        NSNumber *obj = [strongSelf.shares objectForKey:shareName];
-        if (obj) {
-            share_id = [obj unsignedShortValue];
+        [strongSelf runOperation:block onSession:session];
+    }];
+}
+
+- (void)performAsyncOperation:(void (^)(TOSMBSessionOperationContext *context))block{
+    NSParameterAssert(block);
+    if (block == nil) {
+        return;
+    }
+    TOSMBMakeWeakReference();
+    dispatch_async(_queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        smb_session *session = strongSelf.smb_session;
+        if (session == NULL) {
+            block(nil);
+            return;
         }
+        [strongSelf runOperation:block onSession:session];
+    });
+}
+
+/* Must be called on the session queue */
+- (void)runOperation:(void (^)(TOSMBSessionOperationContext *context))block onSession:(smb_session *)session{
+    TOSMBSessionOperationContext *context = [[[[self class] operationContextClass] alloc] init];
+    context.session = session;
+    context.wrapper = self;
+    context.shares = self.shares;
+    context.initialNTStatus = smb_session_get_nt_status(session);
+    block(context);
+    context.session = NULL;
+    context.wrapper = nil;
+    context.shares = nil;
+}
+
++ (Class)operationContextClass{
+    return [TOSMBSessionOperationContext class];
+}
+
+- (smb_tid)cachedShareIDForName:(NSString *)shareName{
+    NSParameterAssert(shareName.length > 0);
+    __block smb_tid share_id = TOSMBShareIDUnknown;
+    [self performOperation:^(TOSMBSessionOperationContext *context) {
+        share_id = [context cachedTreeIDForShareName:shareName];
     }];
     return share_id;
 }
@@ -103,19 +257,16 @@ static const void * const kTOSMBCSessionWrapperQueueSpecificKey = &kTOSMBCSessio
 - (void)cacheShareID:(smb_tid)shareID forName:(NSString *)shareName{
     NSParameterAssert(shareName.length > 0);
     NSParameterAssert(shareID != TOSMBShareIDUnknown);
-    __block BOOL removeShare = NO;
-    __block smb_tid cachedShareID = TOSMBShareIDUnknown;
     if (shareName.length > 0 && shareID != TOSMBShareIDUnknown) {
         TOSMBMakeWeakReference();
-        cachedShareID = [self cachedShareIDForName:shareName];
-        [self inSMBCSession:^(smb_session *session) {
+        [self performOperation:^(TOSMBSessionOperationContext *context) {
             TOSMBMakeStrongFromWeakReference();
+            smb_tid cachedShareID = [context cachedTreeIDForShareName:shareName];
             if (shareID != cachedShareID) {
-                removeShare = cachedShareID != TOSMBShareIDUnknown;
                 [strongSelf.shares setObject:@(shareID) forKey:shareName];
-            }
-            if (removeShare) {
-                smb_tree_disconnect(session, cachedShareID);
+                if (cachedShareID != TOSMBShareIDUnknown) {
+                    smb_tree_disconnect(context.session, cachedShareID);
+                }
             }
         }];
     }
@@ -124,17 +275,8 @@ static const void * const kTOSMBCSessionWrapperQueueSpecificKey = &kTOSMBCSessio
 - (void)removeCachedShareIDForName:(NSString *)shareName{
     NSParameterAssert(shareName.length > 0);
     if (shareName.length > 0) {
-        __block smb_tid cachedShareID = TOSMBShareIDUnknown;
-        __block BOOL removeShare = NO;
-        TOSMBMakeWeakReference();
-        cachedShareID = [self cachedShareIDForName:shareName];
-        removeShare = (cachedShareID != TOSMBShareIDUnknown);
-        [self inSMBCSession:^(smb_session *session) {
-            TOSMBMakeStrongFromWeakReference();
-            [strongSelf.shares removeObjectForKey:shareName];
-            if (removeShare) {
-                smb_tree_disconnect(session, cachedShareID);
-            }
+        [self performOperation:^(TOSMBSessionOperationContext *context) {
+            [context invalidateTreeIDForShareName:shareName];
         }];
     }
 }
@@ -29,12 +29,24 @@ FOUNDATION_EXPORT double TOSMBClientVersionNumber;
 FOUNDATION_EXPORT const unsigned char TOSMBClientVersionString[];
 
 #import <TOSMBClient/TOHost.h>
+#import <TOSMBClient/TOHostResolver.h>
 #import <TOSMBClient/TONetBIOSNameService.h>
+#import <TOSMBClient/TONetBIOSNameResolver.h>
 #import <TOSMBClient/TONetBIOSNameServiceEntry.h>
 #import <TOSMBClient/TOSMBClient.h>
 #import <TOSMBClient/TOSMBConstants.h>
 #import <TOSMBClient/TOSMBSession.h>
 #import <TOSMBClient/TOSMBSessionFile.h>
+#import <TOSMBClient/TOSMBSessionFileList.h>
+#import <TOSMBClient/TOSMBPath.h>
+#import <TOSMBClient/TOSMBDigest.h>
 #import <TOSMBClient/TOSMBSessionTransferTask.h>
 #import <TOSMBClient/TOSMBSessionDownloadTask.h>
 #import <TOSMBClient/TOSMBSessionUploadTask.h>
+#import <TOSMBClient/TOSMBSyncEngine.h>
+#import <TOSMBClient/TOSMBShareIndex.h>
+#import <TOSMBClient/TOSMBPrefetcher.h>
+#import <TOSMBClient/TOSMBSessionRetryMetrics.h>
+#import <TOSMBClient/TOSMBProgressStream.h>
+#import <TOSMBClient/TOSMBNetworkHost.h>
+#import <TOSMBClient/TOSMBNetworkHostRegistry.h>
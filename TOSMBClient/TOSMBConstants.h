@@ -52,6 +52,8 @@ typedef NS_ENUM(NSInteger, TOSMBSessionErrorCode)
     TOSMBSessionErrorCodeDirectoryUploaded,
     TOSMBSessionErrorCodeFailToUpload,
     TOSMBSessionErrorCodeCancelled, 
+    TOSMBSessionErrorCodeIntegrityCheckFailed,                      /* The file on the device does not match the digest of the transferred data. */
+    TOSMBSessionErrorCodeBufferTooSmall,                            /* The file does not fit in the buffer it is being downloaded into. */
 };
 
 /** NetBIOS Service Device Types */
@@ -72,6 +72,12 @@ NSString *localizedStringForErrorCode(TOSMBSessionErrorCode errorCode)
         case TOSMBSessionErrorCodeDirectoryDownloaded:
             errorMessage = @"Unable to download a directory.";
             break;
+        case TOSMBSessionErrorCodeIntegrityCheckFailed:
+            errorMessage = @"The transferred file failed its integrity check.";
+            break;
+        case TOSMBSessionErrorCodeBufferTooSmall:
+            errorMessage = @"The file is too large for the buffer it is being downloaded into.";
+            break;
         case TOSMBSessionErrorCodeUnknown:
         default:
             errorMessage = @"Unknown Error Occurred.";
@@ -0,0 +1,46 @@
+//
+//  TOSMBDigest.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** Digest algorithms that can be computed while a file is transferred */
+typedef NS_ENUM(NSInteger, TOSMBDigestAlgorithm) {
+    TOSMBDigestAlgorithmNone,
+    TOSMBDigestAlgorithmXXH64,      /* 64-bit xxHash. Very fast, catches corruption but not tampering. */
+    TOSMBDigestAlgorithmSHA256      /* SHA-256. Slower, for when a cryptographic digest is needed. */
+};
+
+/**
+ A digest computed incrementally, one buffer at a time, so a file can be hashed
+ as it streams past instead of being read again afterwards.
+ */
+@interface TOSMBDigest : NSObject
+
+@property (nonatomic, readonly) TOSMBDigestAlgorithm algorithm;
+
+/** Returns nil for `TOSMBDigestAlgorithmNone` */
+- (nullable instancetype)initWithAlgorithm:(TOSMBDigestAlgorithm)algorithm;
+
+- (void)updateWithBytes:(const void *)bytes length:(size_t)length;
+- (void)updateWithData:(NSData *)data;
+
+/** Finishes the digest and returns it. Further updates are ignored and the same value is returned again. */
+- (NSData *)finish;
+
+/** One shot digests, e.g. to compare a local copy against a transfer's digest */
++ (nullable NSData *)digestOfData:(NSData *)data algorithm:(TOSMBDigestAlgorithm)algorithm;
++ (nullable NSData *)digestOfFileAtPath:(NSString *)path algorithm:(TOSMBDigestAlgorithm)algorithm error:(NSError **)error;
+
+/** Lowercase hexadecimal form of a digest */
++ (NSString *)hexStringFromDigest:(NSData *)digest;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,273 @@
+//
+//  TOSMBDigest.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBDigest.h"
+#import <CommonCrypto/CommonDigest.h>
+
+/* Size of the reads used when hashing a local file */
+static const NSUInteger kTOSMBDigestFileBufferSize = 1024 * 1024;
+
+#pragma mark - XXH64 -
+
+//Streaming 64-bit xxHash, seed 0, as specified at https://github.com/Cyan4973/xxHash
+
+static const uint64_t kTOSMBXXH64Prime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t kTOSMBXXH64Prime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t kTOSMBXXH64Prime3 = 0x165667B19E3779F9ULL;
+static const uint64_t kTOSMBXXH64Prime4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t kTOSMBXXH64Prime5 = 0x27D4EB2F165667C5ULL;
+
+typedef struct {
+    uint64_t totalLength;
+    uint64_t accumulators[4];
+    uint8_t buffer[32];
+    size_t bufferLength;
+} TOSMBXXH64State;
+
+static inline uint64_t TOSMBXXH64RotateLeft(uint64_t value, int bits){
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t TOSMBXXH64Read64(const uint8_t *bytes){
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return CFSwapInt64LittleToHost(value);
+}
+
+static inline uint32_t TOSMBXXH64Read32(const uint8_t *bytes){
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return CFSwapInt32LittleToHost(value);
+}
+
+static inline uint64_t TOSMBXXH64Round(uint64_t accumulator, uint64_t input){
+    accumulator += input * kTOSMBXXH64Prime2;
+    accumulator = TOSMBXXH64RotateLeft(accumulator, 31);
+    return accumulator * kTOSMBXXH64Prime1;
+}
+
+static inline uint64_t TOSMBXXH64MergeRound(uint64_t hash, uint64_t accumulator){
+    hash ^= TOSMBXXH64Round(0, accumulator);
+    return hash * kTOSMBXXH64Prime1 + kTOSMBXXH64Prime4;
+}
+
+static void TOSMBXXH64Reset(TOSMBXXH64State *state){
+    memset(state, 0, sizeof(*state));
+    state->accumulators[0] = kTOSMBXXH64Prime1 + kTOSMBXXH64Prime2;
+    state->accumulators[1] = kTOSMBXXH64Prime2;
+    state->accumulators[2] = 0;
+    state->accumulators[3] = 0 - kTOSMBXXH64Prime1;
+}
+
+static inline void TOSMBXXH64Consume(TOSMBXXH64State *state, const uint8_t *stripe){
+    state->accumulators[0] = TOSMBXXH64Round(state->accumulators[0], TOSMBXXH64Read64(stripe));
+    state->accumulators[1] = TOSMBXXH64Round(state->accumulators[1], TOSMBXXH64Read64(stripe + 8));
+    state->accumulators[2] = TOSMBXXH64Round(state->accumulators[2], TOSMBXXH64Read64(stripe + 16));
+    state->accumulators[3] = TOSMBXXH64Round(state->accumulators[3], TOSMBXXH64Read64(stripe + 24));
+}
+
+static void TOSMBXXH64Update(TOSMBXXH64State *state, const uint8_t *bytes, size_t length){
+    state->totalLength += length;
+
+    //Top up a partial stripe left over from the last update first
+    if (state->bufferLength > 0) {
+        const size_t fill = MIN(length, 32 - state->bufferLength);
+        memcpy(state->buffer + state->bufferLength, bytes, fill);
+        state->bufferLength += fill;
+        bytes += fill;
+        length -= fill;
+        if (state->bufferLength < 32) {
+            return;
+        }
+        TOSMBXXH64Consume(state, state->buffer);
+        state->bufferLength = 0;
+    }
+
+    while (length >= 32) {
+        TOSMBXXH64Consume(state, bytes);
+        bytes += 32;
+        length -= 32;
+    }
+
+    if (length > 0) {
+        memcpy(state->buffer, bytes, length);
+        state->bufferLength = length;
+    }
+}
+
+static uint64_t TOSMBXXH64Digest(const TOSMBXXH64State *state){
+    uint64_t hash;
+    if (state->totalLength >= 32) {
+        const uint64_t *accumulators = state->accumulators;
+        hash = TOSMBXXH64RotateLeft(accumulators[0], 1) + TOSMBXXH64RotateLeft(accumulators[1], 7) +
+               TOSMBXXH64RotateLeft(accumulators[2], 12) + TOSMBXXH64RotateLeft(accumulators[3], 18);
+        for (int i = 0; i < 4; i++) {
+            hash = TOSMBXXH64MergeRound(hash, accumulators[i]);
+        }
+    }
+    else {
+        hash = kTOSMBXXH64Prime5;
+    }
+    hash += state->totalLength;
+
+    const uint8_t *bytes = state->buffer;
+    const uint8_t *end = bytes + state->bufferLength;
+    while (bytes + 8 <= end) {
+        hash ^= TOSMBXXH64Round(0, TOSMBXXH64Read64(bytes));
+        hash = TOSMBXXH64RotateLeft(hash, 27) * kTOSMBXXH64Prime1 + kTOSMBXXH64Prime4;
+        bytes += 8;
+    }
+    if (bytes + 4 <= end) {
+        hash ^= (uint64_t)TOSMBXXH64Read32(bytes) * kTOSMBXXH64Prime1;
+        hash = TOSMBXXH64RotateLeft(hash, 23) * kTOSMBXXH64Prime2 + kTOSMBXXH64Prime3;
+        bytes += 4;
+    }
+    while (bytes < end) {
+        hash ^= (*bytes) * kTOSMBXXH64Prime5;
+        hash = TOSMBXXH64RotateLeft(hash, 11) * kTOSMBXXH64Prime1;
+        bytes++;
+    }
+
+    hash ^= hash >> 33;
+    hash *= kTOSMBXXH64Prime2;
+    hash ^= hash >> 29;
+    hash *= kTOSMBXXH64Prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+#pragma mark - TOSMBDigest -
+
+@interface TOSMBDigest () {
+    TOSMBXXH64State _xxh64State;
+    CC_SHA256_CTX _sha256Context;
+}
+
+@property (nonatomic, assign, readwrite) TOSMBDigestAlgorithm algorithm;
+@property (nonatomic, copy) NSData *result;
+
+@end
+
+@implementation TOSMBDigest
+
+- (instancetype)init{
+    return [self initWithAlgorithm:TOSMBDigestAlgorithmXXH64];
+}
+
+- (instancetype)initWithAlgorithm:(TOSMBDigestAlgorithm)algorithm{
+    if (algorithm != TOSMBDigestAlgorithmXXH64 && algorithm != TOSMBDigestAlgorithmSHA256) {
+        return nil;
+    }
+    self = [super init];
+    if (self) {
+        _algorithm = algorithm;
+        if (algorithm == TOSMBDigestAlgorithmXXH64) {
+            TOSMBXXH64Reset(&_xxh64State);
+        }
+        else {
+            CC_SHA256_Init(&_sha256Context);
+        }
+    }
+    return self;
+}
+
+- (void)updateWithBytes:(const void *)bytes length:(size_t)length{
+    NSParameterAssert(self.result == nil);
+    if (bytes == NULL || length == 0 || self.result) {
+        return;
+    }
+    if (self.algorithm == TOSMBDigestAlgorithmXXH64) {
+        TOSMBXXH64Update(&_xxh64State, bytes, length);
+        return;
+    }
+    //CC_LONG is 32 bits wide
+    const uint8_t *cursor = bytes;
+    while (length > 0) {
+        const CC_LONG chunkLength = (CC_LONG)MIN(length, (size_t)UINT32_MAX);
+        CC_SHA256_Update(&_sha256Context, cursor, chunkLength);
+        cursor += chunkLength;
+        length -= chunkLength;
+    }
+}
+
+- (void)updateWithData:(NSData *)data{
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+        [self updateWithBytes:bytes length:byteRange.length];
+    }];
+}
+
+- (NSData *)finish{
+    if (self.result) {
+        return self.result;
+    }
+    if (self.algorithm == TOSMBDigestAlgorithmXXH64) {
+        //Canonical form is big-endian
+        const uint64_t hash = CFSwapInt64HostToBig(TOSMBXXH64Digest(&_xxh64State));
+        self.result = [NSData dataWithBytes:&hash length:sizeof(hash)];
+    }
+    else {
+        unsigned char hash[CC_SHA256_DIGEST_LENGTH];
+        CC_SHA256_Final(hash, &_sha256Context);
+        self.result = [NSData dataWithBytes:hash length:sizeof(hash)];
+    }
+    return self.result;
+}
+
+#pragma mark - One Shot -
+
++ (NSData *)digestOfData:(NSData *)data algorithm:(TOSMBDigestAlgorithm)algorithm{
+    TOSMBDigest *digest = [[TOSMBDigest alloc] initWithAlgorithm:algorithm];
+    [digest updateWithData:data];
+    return [digest finish];
+}
+
++ (NSData *)digestOfFileAtPath:(NSString *)path algorithm:(TOSMBDigestAlgorithm)algorithm error:(NSError **)error{
+    TOSMBDigest *digest = [[TOSMBDigest alloc] initWithAlgorithm:algorithm];
+    if (digest == nil) {
+        return nil;
+    }
+    NSInputStream *stream = [NSInputStream inputStreamWithFileAtPath:path];
+    [stream open];
+    if (stream.streamStatus != NSStreamStatusOpen) {
+        if (error) {
+            *error = stream.streamError;
+        }
+        return nil;
+    }
+    uint8_t *buffer = malloc(kTOSMBDigestFileBufferSize);
+    NSInteger bytesRead = 0;
+    while ((bytesRead = [stream read:buffer maxLength:kTOSMBDigestFileBufferSize]) > 0) {
+        [digest updateWithBytes:buffer length:bytesRead];
+    }
+    free(buffer);
+    [stream close];
+    if (bytesRead < 0) {
+        if (error) {
+            *error = stream.streamError;
+        }
+        return nil;
+    }
+    return [digest finish];
+}
+
++ (NSString *)hexStringFromDigest:(NSData *)digest{
+    const unsigned char *bytes = digest.bytes;
+    NSMutableString *string = [NSMutableString stringWithCapacity:digest.length * 2];
+    for (NSUInteger i = 0; i < digest.length; i++) {
+        [string appendFormat:@"%02x", bytes[i]];
+    }
+    return string;
+}
+
+#pragma mark - Debug -
+
+- (NSString *)description{
+    return [NSString stringWithFormat:@"Digest - Algorithm: %ld | Finished: %@", (long)self.algorithm, self.result ? @"YES" : @"NO"];
+}
+
+@end
@@ -0,0 +1,42 @@
+//
+//  TOSMBNetworkHost+Private.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBNetworkHost.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface TOSMBNetworkHost ()
+
+@property (nonatomic, copy, readwrite) NSString *identifier;
+@property (nonatomic, copy, readwrite, nullable) NSString *netBIOSName;
+@property (nonatomic, copy, readwrite, nullable) NSString *group;
+@property (nonatomic, copy, readwrite, nullable) NSString *hostName;
+@property (nonatomic, copy, readwrite) NSArray<NSString *> *addresses;
+@property (nonatomic, assign, readwrite) TOSMBNetworkHostTransport preferredTransport;
+@property (nonatomic, assign, readwrite) NSTimeInterval roundTripTime;
+@property (nonatomic, strong, readwrite, nullable) NSDate *lastSeenDate;
+@property (nonatomic, strong, readwrite, nullable) NSDate *lastProbeDate;
+@property (nonatomic, assign, readwrite) BOOL reachable;
+@property (nonatomic, assign, readwrite) BOOL online;
+
+/* The address that answered the last successful probe */
+@property (nonatomic, copy, nullable) NSString *probedAddress;
+
+- (instancetype)initWithIdentifier:(NSString *)identifier;
+
+/* Puts the address first, as the most recently seen, keeping only the few latest. Returns YES if the list changed. */
+- (BOOL)addAddress:(NSString *)address;
+
+/* Forgets an address, e.g. once another device has been seen on it. Returns YES if the list changed. */
+- (BOOL)removeAddress:(NSString *)address;
+
++ (NSString *)identifierForNetBIOSName:(nullable NSString *)name address:(nullable NSString *)address;
+
+@end
+
+NS_ASSUME_NONNULL_END
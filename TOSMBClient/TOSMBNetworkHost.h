@@ -0,0 +1,50 @@
+//
+//  TOSMBNetworkHost.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "TOSMBConstants.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** The transport a host answered on when it was last probed */
+typedef NS_ENUM(NSInteger, TOSMBNetworkHostTransport) {
+    TOSMBNetworkHostTransportUnknown,
+    TOSMBNetworkHostTransportTCP,       /* Direct SMB over TCP, port 445 */
+    TOSMBNetworkHostTransportNetBIOS    /* SMB over NetBIOS session service, port 139 */
+};
+
+/**
+ A single, deduplicated entry in the `TOSMBNetworkHostRegistry`.
+ Instances are immutable snapshots; the registry replaces them as new information arrives.
+ */
+@interface TOSMBNetworkHost : NSObject <NSSecureCoding, NSCopying>
+
+/** The key the registry deduplicates on. The NetBIOS name when known, otherwise the first address. */
+@property (nonatomic, readonly, copy) NSString *identifier;
+
+@property (nonatomic, readonly, copy, nullable) NSString *netBIOSName;   /** The NetBIOS name of the device */
+@property (nonatomic, readonly, copy, nullable) NSString *group;         /** The NetBIOS workgroup of the device */
+@property (nonatomic, readonly, copy, nullable) NSString *hostName;      /** The DNS name from a reverse lookup */
+@property (nonatomic, readonly, copy) NSArray<NSString *> *addresses;    /** Every IP address the device was seen on */
+
+@property (nonatomic, readonly) TOSMBNetworkHostTransport preferredTransport; /** The transport that answered the last probe */
+@property (nonatomic, readonly) NSTimeInterval roundTripTime;         /** Connect time of the last successful probe, 0 if never probed */
+@property (nonatomic, readonly, nullable) NSDate *lastSeenDate;        /** When discovery or a probe last saw the device */
+@property (nonatomic, readonly, nullable) NSDate *lastProbeDate;       /** When the device was last probed */
+@property (nonatomic, readonly) BOOL reachable;                        /** Whether the last probe could open an SMB port */
+@property (nonatomic, readonly) BOOL online;                           /** Whether the device is currently announced or reachable */
+
+/** The name to show to the user */
+- (NSString *)displayName;
+
+/** The best address to connect to, preferring the one that answered the last probe */
+- (nullable NSString *)preferredAddress;
+
+@end
+
+NS_ASSUME_NONNULL_END
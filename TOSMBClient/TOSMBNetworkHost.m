@@ -0,0 +1,163 @@
+//
+//  TOSMBNetworkHost.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBNetworkHost.h"
+#import "TOSMBNetworkHost+Private.h"
+
+/* Addresses kept per host. Older ones are dropped as new ones are seen. */
+static const NSUInteger kTOSMBNetworkHostMaximumAddressCount = 4;
+
+@implementation TOSMBNetworkHost
+
+- (instancetype)initWithIdentifier:(NSString *)identifier{
+    NSParameterAssert(identifier.length > 0);
+    if (identifier.length == 0) {
+        return nil;
+    }
+    if (self = [super init]) {
+        _identifier = [identifier copy];
+        _addresses = @[];
+    }
+    return self;
+}
+
++ (NSString *)identifierForNetBIOSName:(NSString *)name address:(NSString *)address{
+    if (name.length > 0) {
+        return [name uppercaseString];
+    }
+    return address;
+}
+
+- (BOOL)addAddress:(NSString *)address{
+    if (address.length == 0 || [self.addresses.firstObject isEqualToString:address]) {
+        return NO;
+    }
+    NSMutableArray<NSString *> *addresses = [self.addresses mutableCopy];
+    [addresses removeObject:address];
+    [addresses insertObject:address atIndex:0];
+    if (addresses.count > kTOSMBNetworkHostMaximumAddressCount) {
+        [addresses removeObjectsInRange:NSMakeRange(kTOSMBNetworkHostMaximumAddressCount, addresses.count - kTOSMBNetworkHostMaximumAddressCount)];
+    }
+    self.addresses = addresses;
+    return YES;
+}
+
+- (BOOL)removeAddress:(NSString *)address{
+    if (address.length == 0 || [self.addresses containsObject:address] == NO) {
+        return NO;
+    }
+    NSMutableArray<NSString *> *addresses = [self.addresses mutableCopy];
+    [addresses removeObject:address];
+    self.addresses = addresses;
+    if ([self.probedAddress isEqualToString:address]) {
+        self.probedAddress = nil;
+    }
+    return YES;
+}
+
+- (NSString *)displayName{
+    if (self.netBIOSName.length > 0) {
+        return self.netBIOSName;
+    }
+    if (self.hostName.length > 0) {
+        return self.hostName;
+    }
+    return self.identifier;
+}
+
+- (NSString *)preferredAddress{
+    if (self.probedAddress.length > 0) {
+        return self.probedAddress;
+    }
+    return self.addresses.firstObject;
+}
+
+#pragma mark - NSCopying -
+
+- (id)copyWithZone:(NSZone *)zone{
+    TOSMBNetworkHost *host = [[TOSMBNetworkHost allocWithZone:zone] initWithIdentifier:self.identifier];
+    host.netBIOSName = self.netBIOSName;
+    host.group = self.group;
+    host.hostName = self.hostName;
+    host.addresses = self.addresses;
+    host.preferredTransport = self.preferredTransport;
+    host.roundTripTime = self.roundTripTime;
+    host.lastSeenDate = self.lastSeenDate;
+    host.lastProbeDate = self.lastProbeDate;
+    host.reachable = self.reachable;
+    host.online = self.online;
+    host.probedAddress = self.probedAddress;
+    return host;
+}
+
+#pragma mark - NSSecureCoding -
+
++ (BOOL)supportsSecureCoding{
+    return YES;
+}
+
+- (instancetype)initWithCoder:(NSCoder *)coder{
+    NSString *identifier = [coder decodeObjectOfClass:[NSString class] forKey:@"identifier"];
+    if (identifier.length == 0) {
+        return nil;
+    }
+    if (self = [self initWithIdentifier:identifier]) {
+        _netBIOSName = [coder decodeObjectOfClass:[NSString class] forKey:@"netBIOSName"];
+        _group = [coder decodeObjectOfClass:[NSString class] forKey:@"group"];
+        _hostName = [coder decodeObjectOfClass:[NSString class] forKey:@"hostName"];
+        _addresses = [coder decodeObjectOfClasses:[NSSet setWithObjects:[NSArray class], [NSString class], nil] forKey:@"addresses"] ?: @[];
+        _preferredTransport = [coder decodeIntegerForKey:@"preferredTransport"];
+        _roundTripTime = [coder decodeDoubleForKey:@"roundTripTime"];
+        _lastSeenDate = [coder decodeObjectOfClass:[NSDate class] forKey:@"lastSeenDate"];
+        _lastProbeDate = [coder decodeObjectOfClass:[NSDate class] forKey:@"lastProbeDate"];
+        _reachable = [coder decodeBoolForKey:@"reachable"];
+        _probedAddress = [coder decodeObjectOfClass:[NSString class] forKey:@"probedAddress"];
+        //Nothing is online until it has been seen again in this launch
+        _online = NO;
+    }
+    return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)coder{
+    [coder encodeObject:self.identifier forKey:@"identifier"];
+    [coder encodeObject:self.netBIOSName forKey:@"netBIOSName"];
+    [coder encodeObject:self.group forKey:@"group"];
+    [coder encodeObject:self.hostName forKey:@"hostName"];
+    [coder encodeObject:self.addresses forKey:@"addresses"];
+    [coder encodeInteger:self.preferredTransport forKey:@"preferredTransport"];
+    [coder encodeDouble:self.roundTripTime forKey:@"roundTripTime"];
+    [coder encodeObject:self.lastSeenDate forKey:@"lastSeenDate"];
+    [coder encodeObject:self.lastProbeDate forKey:@"lastProbeDate"];
+    [coder encodeBool:self.reachable forKey:@"reachable"];
+    [coder encodeObject:self.probedAddress forKey:@"probedAddress"];
+}
+
+#pragma mark - Equality -
+
+- (BOOL)isEqual:(id)object{
+    if (self == object) {
+        return YES;
+    }
+    if (![object isKindOfClass:[TOSMBNetworkHost class]]) {
+        return NO;
+    }
+    return [self.identifier isEqualToString:[(TOSMBNetworkHost *)object identifier]];
+}
+
+- (NSUInteger)hash{
+    return [self.identifier hash];
+}
+
+#pragma mark - Debug -
+
+- (NSString *)description{
+    return [NSString stringWithFormat:@"Host - Name: %@ | Addresses: %@ | Reachable: %d | RTT: %.1fms",
+            self.displayName, [self.addresses componentsJoinedByString:@","], self.reachable, self.roundTripTime * 1000.0];
+}
+
+@end
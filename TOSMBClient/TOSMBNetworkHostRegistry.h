@@ -0,0 +1,101 @@
+//
+//  TOSMBNetworkHostRegistry.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "TOSMBNetworkHost.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSInteger, TOSMBNetworkHostRegistryChange) {
+    TOSMBNetworkHostRegistryChangeAdded,
+    TOSMBNetworkHostRegistryChangeUpdated,
+    TOSMBNetworkHostRegistryChangeRemoved
+};
+
+typedef void(^TOSMBNetworkHostRegistryChangeHandler)(TOSMBNetworkHost *host, TOSMBNetworkHostRegistryChange change);
+
+/** Posted on the main queue for every change. The userInfo holds the host and the change type. */
+extern NSString * const TOSMBNetworkHostRegistryDidChangeNotification;
+extern NSString * const TOSMBNetworkHostRegistryHostKey;
+extern NSString * const TOSMBNetworkHostRegistryChangeKey;
+
+extern NSTimeInterval kTOSMBNetworkHostRegistryDefaultProbeTimeout;
+extern NSTimeInterval kTOSMBNetworkHostRegistryDefaultExpirationInterval;
+
+/**
+ A persisted table of the SMB devices on the local network.
+
+ NetBIOS discovery, reverse name lookups and active SMB port probes are merged into one deduplicated
+ list of `TOSMBNetworkHost` objects, which is saved to disk. Hosts from previous launches are
+ available as soon as the registry is created, and are refreshed incrementally as discovery runs.
+
+ While discovering, the registry drives `TONetBIOSNameService` discovery itself, so observe the
+ registry instead of starting discovery on the name service directly.
+ */
+@interface TOSMBNetworkHostRegistry : NSObject
+
+/** A registry saved to the application support directory */
++ (instancetype)sharedRegistry;
+
+/**
+ Creates a new registry and synchronously loads any hosts previously saved to the supplied location.
+
+ @param storageURL The file the registry is saved to. Pass nil for an in-memory registry.
+ */
+- (instancetype)initWithStorageURL:(nullable NSURL *)storageURL;
+
+@property (nonatomic, readonly, nullable) NSURL *storageURL;
+
+/** Called on the main queue whenever a host is added, updated or removed. */
+@property (atomic, copy, nullable) TOSMBNetworkHostRegistryChangeHandler changeHandler;
+
+/** How long a single port probe waits for a connection. Default is 1.5 seconds. */
+@property (atomic, assign) NSTimeInterval probeTimeout;
+
+/** Hosts that haven't been seen for this long are dropped when the registry is loaded. Default is 30 days. */
+@property (atomic, assign) NSTimeInterval expirationInterval;
+
+/** True while NetBIOS discovery is running */
+@property (atomic, readonly) BOOL discovering;
+
+// -------------------------------------------------------------------------------
+
+/** A snapshot of every known host, online hosts first, then by name */
+- (NSArray<TOSMBNetworkHost *> *)hosts;
+
+/** Looks up a host by NetBIOS name, DNS name or any of its addresses */
+- (nullable TOSMBNetworkHost *)hostForNameOrAddress:(NSString *)nameOrAddress;
+
+// -------------------------------------------------------------------------------
+
+/**
+ Starts NetBIOS discovery and probes every known host, plus every host that is discovered.
+
+ @param timeout The timeout delay, in seconds, between broadcasts. Default value is 4 seconds.
+ @return A bool value as to whether the start of discovery was successful
+ */
+- (BOOL)startDiscoveryWithTimeOut:(NSTimeInterval)timeout;
+
+- (void)stopDiscovery;
+
+/** Adds (or merges) a host that was entered manually, and probes it */
+- (void)addHostWithName:(nullable NSString *)name address:(nullable NSString *)address;
+
+- (void)removeHost:(TOSMBNetworkHost *)host;
+
+/** Re-measures reachability, transport and round trip time of a host */
+- (void)probeHost:(TOSMBNetworkHost *)host;
+
+- (void)probeAllHosts;
+
+/** Writes any pending changes to disk immediately */
+- (void)save;
+
+@end
+
+NS_ASSUME_NONNULL_END
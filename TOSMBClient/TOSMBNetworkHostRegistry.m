@@ -0,0 +1,560 @@
+//
+//  TOSMBNetworkHostRegistry.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <sys/socket.h>
+#import <netinet/in.h>
+#import <netdb.h>
+#import <fcntl.h>
+#import <poll.h>
+#import <unistd.h>
+
+#import "TOSMBNetworkHostRegistry.h"
+#import "TOSMBNetworkHost+Private.h"
+#import "TONetBIOSNameService.h"
+#import "TONetBIOSNameServiceEntry.h"
+#import "TOHostResolver.h"
+
+NSString * const TOSMBNetworkHostRegistryDidChangeNotification = @"TOSMBNetworkHostRegistryDidChangeNotification";
+NSString * const TOSMBNetworkHostRegistryHostKey = @"host";
+NSString * const TOSMBNetworkHostRegistryChangeKey = @"change";
+
+NSTimeInterval kTOSMBNetworkHostRegistryDefaultProbeTimeout = 1.5;
+NSTimeInterval kTOSMBNetworkHostRegistryDefaultExpirationInterval = 30.0 * 24.0 * 60.0 * 60.0;
+
+/* Hosts probed more recently than this aren't probed again when rediscovered */
+static const NSTimeInterval kTOSMBNetworkHostRegistryReprobeInterval = 60.0;
+
+/* Delay used to batch several changes into one write */
+static const NSTimeInterval kTOSMBNetworkHostRegistrySaveDelay = 1.0;
+
+static const uint16_t kTOSMBDirectTCPPort = 445;
+static const uint16_t kTOSMBNetBIOSSessionPort = 139;
+
+#pragma mark - Port Probing -
+
+/* Opens a TCP connection to the port with a timeout. Returns YES and the connect time on success. */
+static BOOL TOSMBProbePort(NSString *address, uint16_t port, NSTimeInterval timeout, NSTimeInterval *roundTripTime)
+{
+    const char *addressCString = [address cStringUsingEncoding:NSASCIIStringEncoding];
+    if (addressCString == NULL) {
+        return NO;
+    }
+
+    struct addrinfo hints;
+    struct addrinfo *result = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    hints.ai_family = PF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    char portString[8];
+    snprintf(portString, sizeof(portString), "%u", port);
+    if (getaddrinfo(addressCString, portString, &hints, &result) != 0 || result == NULL) {
+        return NO;
+    }
+
+    BOOL success = NO;
+    int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fd >= 0) {
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+        const CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+        int connectResult = connect(fd, result->ai_addr, result->ai_addrlen);
+        if (connectResult == 0) {
+            success = YES;
+        }
+        else if (errno == EINPROGRESS) {
+            struct pollfd pfd = { .fd = fd, .events = POLLOUT, .revents = 0 };
+            if (poll(&pfd, 1, (int)(timeout * 1000.0)) == 1) {
+                int socketError = 0;
+                socklen_t length = sizeof(socketError);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &socketError, &length);
+                success = (socketError == 0);
+            }
+        }
+        if (success && roundTripTime) {
+            *roundTripTime = CFAbsoluteTimeGetCurrent() - startTime;
+        }
+        close(fd);
+    }
+    freeaddrinfo(result);
+    return success;
+}
+
+// -------------------------------------------------------------------------
+
+@interface TOSMBNetworkHostRegistry (){
+    dispatch_queue_t _queue;
+}
+
+@property (nonatomic, strong, readwrite) NSURL *storageURL;
+@property (atomic, assign, readwrite) BOOL discovering;
+
+/* The host table. Only accessed on _queue. */
+@property (nonatomic, strong) NSMutableDictionary<NSString *, TOSMBNetworkHost *> *hostsByIdentifier;
+
+/* Identifiers with a probe in flight. Only accessed on _queue. */
+@property (nonatomic, strong) NSMutableSet<NSString *> *probingIdentifiers;
+
+@property (nonatomic, assign) BOOL savePending;
+
+@property (nonatomic, strong) NSOperationQueue *probeQueue;
+
+@end
+
+@implementation TOSMBNetworkHostRegistry
+
++ (instancetype)sharedRegistry{
+    static dispatch_once_t onceToken;
+    static TOSMBNetworkHostRegistry *shared;
+    dispatch_once(&onceToken, ^{
+        shared = [[TOSMBNetworkHostRegistry alloc] initWithStorageURL:[TOSMBNetworkHostRegistry defaultStorageURL]];
+    });
+    return shared;
+}
+
++ (NSURL *)defaultStorageURL{
+    NSURL *directoryURL = [[[NSFileManager defaultManager] URLsForDirectory:NSApplicationSupportDirectory inDomains:NSUserDomainMask] firstObject];
+    if (directoryURL == nil) {
+        return nil;
+    }
+    directoryURL = [directoryURL URLByAppendingPathComponent:@"TOSMBClient" isDirectory:YES];
+    return [directoryURL URLByAppendingPathComponent:@"NetworkHosts.archive"];
+}
+
+- (instancetype)init{
+    return [self initWithStorageURL:nil];
+}
+
+- (instancetype)initWithStorageURL:(NSURL *)storageURL{
+    self = [super init];
+    if (self) {
+        _storageURL = [storageURL copy];
+        _probeTimeout = kTOSMBNetworkHostRegistryDefaultProbeTimeout;
+        _expirationInterval = kTOSMBNetworkHostRegistryDefaultExpirationInterval;
+        _hostsByIdentifier = [[NSMutableDictionary alloc] init];
+        _probingIdentifiers = [[NSMutableSet alloc] init];
+        _queue = dispatch_queue_create("tosmb_network_host_registry", DISPATCH_QUEUE_SERIAL);
+        _probeQueue = [[NSOperationQueue alloc] init];
+        _probeQueue.maxConcurrentOperationCount = 8;
+        [self load];
+    }
+    return self;
+}
+
+- (void)dealloc{
+    [self.probeQueue cancelAllOperations];
+}
+
+#pragma mark - Persistence -
+
+- (void)load{
+    if (self.storageURL == nil) {
+        return;
+    }
+    NSData *data = [NSData dataWithContentsOfURL:self.storageURL];
+    if (data.length == 0) {
+        return;
+    }
+    NSSet *classes = [NSSet setWithObjects:[NSArray class], [TOSMBNetworkHost class], nil];
+    NSArray<TOSMBNetworkHost *> *hosts = [NSKeyedUnarchiver unarchivedObjectOfClasses:classes fromData:data error:nil];
+    if ([hosts isKindOfClass:[NSArray class]] == NO) {
+        return;
+    }
+    NSDate *expirationDate = [NSDate dateWithTimeIntervalSinceNow:-self.expirationInterval];
+    for (TOSMBNetworkHost *host in hosts) {
+        if ([host isKindOfClass:[TOSMBNetworkHost class]] == NO) {
+            continue;
+        }
+        if (host.lastSeenDate && [host.lastSeenDate compare:expirationDate] == NSOrderedAscending) {
+            continue;
+        }
+        [self.hostsByIdentifier setObject:host forKey:host.identifier];
+    }
+}
+
+- (void)save{
+    TOSMBMakeWeakReference();
+    dispatch_sync(_queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        [strongSelf performSave];
+    });
+}
+
+/* Must be called on _queue */
+- (void)performSave{
+    self.savePending = NO;
+    if (self.storageURL == nil) {
+        return;
+    }
+    NSArray<TOSMBNetworkHost *> *hosts = [self.hostsByIdentifier allValues];
+    NSData *data = [NSKeyedArchiver archivedDataWithRootObject:hosts requiringSecureCoding:YES error:nil];
+    if (data == nil) {
+        return;
+    }
+    [[NSFileManager defaultManager] createDirectoryAtURL:[self.storageURL URLByDeletingLastPathComponent]
+                             withIntermediateDirectories:YES
+                                              attributes:nil
+                                                   error:nil];
+    [data writeToURL:self.storageURL atomically:YES];
+}
+
+/* Must be called on _queue */
+- (void)scheduleSave{
+    if (self.savePending || self.storageURL == nil) {
+        return;
+    }
+    self.savePending = YES;
+    TOSMBMakeWeakReference();
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kTOSMBNetworkHostRegistrySaveDelay * NSEC_PER_SEC)), _queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        if (strongSelf.savePending) {
+            [strongSelf performSave];
+        }
+    });
+}
+
+#pragma mark - Host Access -
+
+- (NSArray<TOSMBNetworkHost *> *)hosts{
+    __block NSArray<TOSMBNetworkHost *> *hosts = nil;
+    dispatch_sync(_queue, ^{
+        hosts = [[NSArray alloc] initWithArray:[self.hostsByIdentifier allValues] copyItems:YES];
+    });
+    return [hosts sortedArrayUsingComparator:^NSComparisonResult(TOSMBNetworkHost *host1, TOSMBNetworkHost *host2) {
+        if (host1.online != host2.online) {
+            return host1.online ? NSOrderedAscending : NSOrderedDescending;
+        }
+        return [host1.displayName localizedCaseInsensitiveCompare:host2.displayName];
+    }];
+}
+
+- (TOSMBNetworkHost *)hostForNameOrAddress:(NSString *)nameOrAddress{
+    if (nameOrAddress.length == 0) {
+        return nil;
+    }
+    __block TOSMBNetworkHost *host = nil;
+    dispatch_sync(_queue, ^{
+        host = [[self existingHostForNetBIOSName:nameOrAddress address:nameOrAddress] copy];
+        if (host == nil) {
+            for (TOSMBNetworkHost *candidate in self.hostsByIdentifier.allValues) {
+                if ([candidate.hostName caseInsensitiveCompare:nameOrAddress] == NSOrderedSame) {
+                    host = [candidate copy];
+                    break;
+                }
+            }
+        }
+    });
+    return host;
+}
+
+/* Must be called on _queue */
+- (TOSMBNetworkHost *)existingHostForNetBIOSName:(NSString *)name address:(NSString *)address{
+    if (name.length > 0) {
+        TOSMBNetworkHost *host = [self.hostsByIdentifier objectForKey:[TOSMBNetworkHost identifierForNetBIOSName:name address:nil]];
+        if (host) {
+            return host;
+        }
+    }
+    if (address.length > 0) {
+        for (TOSMBNetworkHost *host in self.hostsByIdentifier.allValues) {
+            if ([host.addresses containsObject:address]) {
+                return host;
+            }
+        }
+    }
+    return nil;
+}
+
+#pragma mark - Merging -
+
+/* Must be called on _queue. Returns the merged host. */
+- (TOSMBNetworkHost *)mergeHostWithNetBIOSName:(NSString *)name
+                                         group:(NSString *)group
+                                       address:(NSString *)address
+                                          seen:(BOOL)seen
+{
+    NSString *identifier = [TOSMBNetworkHost identifierForNetBIOSName:name address:address];
+    if (identifier.length == 0) {
+        return nil;
+    }
+
+    TOSMBNetworkHost *host = [self existingHostForNetBIOSName:name address:address];
+    if (host && name.length > 0 && host.netBIOSName.length > 0 && [host.identifier isEqualToString:identifier] == NO) {
+        //Another device on an address this one used before, e.g. once DHCP has handed it out again
+        host = nil;
+    }
+    TOSMBNetworkHostRegistryChange change = TOSMBNetworkHostRegistryChangeUpdated;
+    if (host == nil) {
+        host = [[TOSMBNetworkHost alloc] initWithIdentifier:identifier];
+        change = TOSMBNetworkHostRegistryChangeAdded;
+    }
+    else if (name.length > 0 && host.netBIOSName.length == 0 && [host.identifier isEqualToString:identifier] == NO) {
+        //A host previously only known by its address now has a NetBIOS name, so re-key it
+        [self.hostsByIdentifier removeObjectForKey:host.identifier];
+        host.identifier = identifier;
+    }
+
+    if (name.length > 0) {
+        host.netBIOSName = name;
+    }
+    if (group.length > 0) {
+        host.group = group;
+    }
+    [host addAddress:address];
+    if (seen) {
+        host.lastSeenDate = [NSDate date];
+        host.online = YES;
+    }
+
+    [self.hostsByIdentifier setObject:host forKey:host.identifier];
+    [self notifyChange:change forHost:host];
+    [self removeAddress:address fromHostsOtherThan:host];
+    return host;
+}
+
+/* Must be called on _queue. An address belongs to one device at a time, so whoever had it before loses it. */
+- (void)removeAddress:(NSString *)address fromHostsOtherThan:(TOSMBNetworkHost *)host{
+    if (address.length == 0) {
+        return;
+    }
+    for (TOSMBNetworkHost *otherHost in self.hostsByIdentifier.allValues) {
+        if (otherHost == host || [otherHost removeAddress:address] == NO) {
+            continue;
+        }
+        //A host only ever known by that address was this device all along
+        if (otherHost.netBIOSName.length == 0 && otherHost.addresses.count == 0) {
+            [self.hostsByIdentifier removeObjectForKey:otherHost.identifier];
+            [self notifyChange:TOSMBNetworkHostRegistryChangeRemoved forHost:otherHost];
+        }
+        else {
+            [self notifyChange:TOSMBNetworkHostRegistryChangeUpdated forHost:otherHost];
+        }
+    }
+}
+
+/* Must be called on _queue */
+- (void)notifyChange:(TOSMBNetworkHostRegistryChange)change forHost:(TOSMBNetworkHost *)host{
+    [self scheduleSave];
+    TOSMBNetworkHost *snapshot = [host copy];
+    TOSMBMakeWeakReference();
+    dispatch_async(dispatch_get_main_queue(), ^{
+        TOSMBCheckIfWeakReferenceIsNilAndReturn();
+        TOSMBMakeStrongFromWeakReference();
+        TOSMBNetworkHostRegistryChangeHandler changeHandler = strongSelf.changeHandler;
+        if (changeHandler) {
+            changeHandler(snapshot, change);
+        }
+        [[NSNotificationCenter defaultCenter] postNotificationName:TOSMBNetworkHostRegistryDidChangeNotification
+                                                            object:strongSelf
+                                                          userInfo:@{TOSMBNetworkHostRegistryHostKey:snapshot,
+                                                                     TOSMBNetworkHostRegistryChangeKey:@(change)}];
+    });
+}
+
+#pragma mark - Discovery -
+
+- (BOOL)startDiscoveryWithTimeOut:(NSTimeInterval)timeout{
+    TOSMBMakeWeakReference();
+    BOOL result = [[TONetBIOSNameService sharedService] startDiscoveryWithTimeOut:timeout added:^(TONetBIOSNameServiceEntry *entry) {
+        [weakSelf discoveredEntry:entry];
+    } removed:^(TONetBIOSNameServiceEntry *entry) {
+        [weakSelf lostEntry:entry];
+    }];
+    self.discovering = result;
+    [self probeAllHosts];
+    return result;
+}
+
+- (void)stopDiscovery{
+    if (self.discovering == NO) {
+        return;
+    }
+    self.discovering = NO;
+    [[TONetBIOSNameService sharedService] stopDiscovery];
+    [self save];
+}
+
+- (void)discoveredEntry:(TONetBIOSNameServiceEntry *)entry{
+    NSString *name = entry.name;
+    NSString *group = entry.group;
+    NSString *address = entry.ipAddressString;
+    TOSMBMakeWeakReference();
+    dispatch_async(_queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        TOSMBNetworkHost *host = [strongSelf mergeHostWithNetBIOSName:name group:group address:address seen:YES];
+        if (host == nil) {
+            return;
+        }
+        if (host.lastProbeDate == nil || -[host.lastProbeDate timeIntervalSinceNow] > kTOSMBNetworkHostRegistryReprobeInterval) {
+            [strongSelf scheduleProbeForHostWithIdentifier:host.identifier];
+        }
+    });
+}
+
+- (void)lostEntry:(TONetBIOSNameServiceEntry *)entry{
+    NSString *name = entry.name;
+    NSString *address = entry.ipAddressString;
+    TOSMBMakeWeakReference();
+    dispatch_async(_queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        TOSMBNetworkHost *host = [strongSelf existingHostForNetBIOSName:name address:address];
+        if (host == nil || host.online == NO) {
+            return;
+        }
+        host.online = NO;
+        [strongSelf notifyChange:TOSMBNetworkHostRegistryChangeUpdated forHost:host];
+    });
+}
+
+#pragma mark - Manual Management -
+
+- (void)addHostWithName:(NSString *)name address:(NSString *)address{
+    if (name.length == 0 && address.length == 0) {
+        return;
+    }
+    TOSMBMakeWeakReference();
+    dispatch_async(_queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        TOSMBNetworkHost *host = [strongSelf mergeHostWithNetBIOSName:name group:nil address:address seen:NO];
+        if (host) {
+            [strongSelf scheduleProbeForHostWithIdentifier:host.identifier];
+        }
+    });
+}
+
+- (void)removeHost:(TOSMBNetworkHost *)host{
+    NSString *identifier = host.identifier;
+    if (identifier.length == 0) {
+        return;
+    }
+    TOSMBMakeWeakReference();
+    dispatch_async(_queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        TOSMBNetworkHost *existingHost = [strongSelf.hostsByIdentifier objectForKey:identifier];
+        if (existingHost == nil) {
+            return;
+        }
+        [strongSelf.hostsByIdentifier removeObjectForKey:identifier];
+        [strongSelf notifyChange:TOSMBNetworkHostRegistryChangeRemoved forHost:existingHost];
+    });
+}
+
+#pragma mark - Probing -
+
+- (void)probeHost:(TOSMBNetworkHost *)host{
+    NSString *identifier = host.identifier;
+    if (identifier.length == 0) {
+        return;
+    }
+    TOSMBMakeWeakReference();
+    dispatch_async(_queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        [strongSelf scheduleProbeForHostWithIdentifier:identifier];
+    });
+}
+
+- (void)probeAllHosts{
+    TOSMBMakeWeakReference();
+    dispatch_async(_queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        for (NSString *identifier in strongSelf.hostsByIdentifier.allKeys) {
+            [strongSelf scheduleProbeForHostWithIdentifier:identifier];
+        }
+    });
+}
+
+/* Must be called on _queue */
+- (void)scheduleProbeForHostWithIdentifier:(NSString *)identifier{
+    TOSMBNetworkHost *host = [self.hostsByIdentifier objectForKey:identifier];
+    if (host == nil || [self.probingIdentifiers containsObject:identifier]) {
+        return;
+    }
+    [self.probingIdentifiers addObject:identifier];
+
+    //Try the address that answered last time first
+    NSMutableArray<NSString *> *addresses = [host.addresses mutableCopy];
+    if (host.probedAddress.length > 0 && [addresses containsObject:host.probedAddress]) {
+        [addresses removeObject:host.probedAddress];
+        [addresses insertObject:host.probedAddress atIndex:0];
+    }
+    const BOOL needsHostName = (host.hostName.length == 0);
+    const BOOL needsNetBIOSName = (host.netBIOSName.length == 0);
+    const NSTimeInterval timeout = self.probeTimeout;
+
+    TOSMBMakeWeakReference();
+    [self.probeQueue addOperationWithBlock:^{
+        NSString *probedAddress = nil;
+        TOSMBNetworkHostTransport transport = TOSMBNetworkHostTransportUnknown;
+        NSTimeInterval roundTripTime = 0;
+        for (NSString *address in addresses) {
+            if (TOSMBProbePort(address, kTOSMBDirectTCPPort, timeout, &roundTripTime)) {
+                transport = TOSMBNetworkHostTransportTCP;
+            }
+            else if (TOSMBProbePort(address, kTOSMBNetBIOSSessionPort, timeout, &roundTripTime)) {
+                transport = TOSMBNetworkHostTransportNetBIOS;
+            }
+            if (transport != TOSMBNetworkHostTransportUnknown) {
+                probedAddress = address;
+                break;
+            }
+        }
+
+        //Fill in missing names through the shared resolver cache
+        NSString *lookupAddress = probedAddress ?: addresses.firstObject;
+        NSString *hostName = needsHostName ? [[[TOHostResolver sharedResolver] hostnamesForAddress:lookupAddress] firstObject] : nil;
+        NSString *netBIOSName = needsNetBIOSName ? [[TOHostResolver sharedResolver] netBIOSNameForAddress:lookupAddress] : nil;
+
+        [weakSelf finishProbeForHostWithIdentifier:identifier
+                                     probedAddress:probedAddress
+                                         transport:transport
+                                     roundTripTime:roundTripTime
+                                          hostName:hostName
+                                       netBIOSName:netBIOSName];
+    }];
+}
+
+- (void)finishProbeForHostWithIdentifier:(NSString *)identifier
+                           probedAddress:(NSString *)probedAddress
+                               transport:(TOSMBNetworkHostTransport)transport
+                           roundTripTime:(NSTimeInterval)roundTripTime
+                                hostName:(NSString *)hostName
+                             netBIOSName:(NSString *)netBIOSName
+{
+    TOSMBMakeWeakReference();
+    dispatch_async(_queue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        [strongSelf.probingIdentifiers removeObject:identifier];
+
+        TOSMBNetworkHost *host = [strongSelf.hostsByIdentifier objectForKey:identifier];
+        if (host == nil) {
+            return;
+        }
+
+        host.lastProbeDate = [NSDate date];
+        host.reachable = (probedAddress != nil);
+        if (host.reachable) {
+            host.probedAddress = probedAddress;
+            host.preferredTransport = transport;
+            host.roundTripTime = roundTripTime;
+            host.lastSeenDate = host.lastProbeDate;
+            host.online = YES;
+        }
+        if (hostName.length > 0 && [hostName isEqualToString:probedAddress] == NO) {
+            host.hostName = hostName;
+        }
+        [strongSelf notifyChange:TOSMBNetworkHostRegistryChangeUpdated forHost:host];
+
+        if (netBIOSName.length > 0 && host.netBIOSName.length == 0) {
+            [strongSelf mergeHostWithNetBIOSName:netBIOSName group:nil address:host.addresses.firstObject seen:NO];
+        }
+    });
+}
+
+@end
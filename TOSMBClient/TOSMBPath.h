@@ -0,0 +1,65 @@
+//
+//  TOSMBPath.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ An immutable, already parsed path on an SMB device, such as "/Share/Folder/File.txt".
+
+ The share name, the path inside the share and its UTF-8 and UTF-16 encodings are worked out once,
+ when the path is created, so an operation can pass the same object through all of its steps
+ instead of re-deriving them from a string. Child and parent paths are derived from the parsed
+ parts without parsing again.
+
+ Forward and back slashes are both accepted as separators, and empty components are ignored.
+ */
+@interface TOSMBPath : NSObject <NSCopying>
+
+/** The root of the device, which lists the shares */
++ (instancetype)rootPath;
+
++ (instancetype)pathWithString:(nullable NSString *)string;
+
+- (instancetype)initWithString:(nullable NSString *)string;
+
+/** The path with forward slashes and a leading slash, e.g. "/Share/Folder/File.txt" */
+@property (nonatomic, readonly, copy) NSString *string;
+
+/** The share name, or nil for the root path */
+@property (nonatomic, readonly, copy, nullable) NSString *shareName;
+
+/** The components inside the share, e.g. @[@"Folder", @"File.txt"] */
+@property (nonatomic, readonly, copy) NSArray<NSString *> *components;
+
+/** The last component. This is the share name for a share, and an empty string for the root path. */
+@property (nonatomic, readonly, copy) NSString *lastComponent;
+
+/** The path inside the share in SMB form, e.g. "\Folder\File.txt". A share itself is "\". */
+@property (nonatomic, readonly, copy) NSString *relativeSMBPath;
+
+/** The relative SMB path as little-endian UTF-16, without a terminator, as it is sent on the wire */
+@property (nonatomic, readonly, copy) NSData *relativeSMBPathUTF16Data;
+
+@property (nonatomic, readonly) BOOL isRoot;        /** Whether this is the root of the device */
+@property (nonatomic, readonly) BOOL isShareRoot;   /** Whether this is a share itself */
+
+/** NUL terminated UTF-8 forms, valid for as long as the path object is */
+- (nullable const char *)shareNameUTF8String NS_RETURNS_INNER_POINTER;
+- (const char *)relativeSMBPathUTF8String NS_RETURNS_INNER_POINTER;
+
+/** A path one level down. Appending to the root path gives a share. */
+- (TOSMBPath *)pathByAppendingComponent:(NSString *)component;
+
+/** The path one level up. The parent of the root path is the root path. */
+- (TOSMBPath *)parentPath;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,202 @@
+//
+//  TOSMBPath.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBPath.h"
+
+@interface TOSMBPath ()
+
+@property (nonatomic, copy, readwrite) NSString *string;
+@property (nonatomic, copy, readwrite) NSString *shareName;
+@property (nonatomic, copy, readwrite) NSArray<NSString *> *components;
+@property (nonatomic, copy, readwrite) NSString *relativeSMBPath;
+
+/* Made on first use, since nothing on the listing and walking paths needs it */
+@property (nonatomic, copy) NSData *cachedRelativeSMBPathUTF16Data;
+
+/* NUL terminated UTF-8 encodings */
+@property (nonatomic, copy) NSData *shareNameUTF8Data;
+@property (nonatomic, copy) NSData *relativeSMBPathUTF8Data;
+
+@end
+
+@implementation TOSMBPath
+
++ (instancetype)rootPath{
+    static dispatch_once_t onceToken;
+    static TOSMBPath *rootPath;
+    dispatch_once(&onceToken, ^{
+        rootPath = [[TOSMBPath alloc] initWithShareName:nil components:@[] string:@"/" relativeSMBPath:@"\\"];
+    });
+    return rootPath;
+}
+
++ (instancetype)pathWithString:(NSString *)string{
+    return [[self alloc] initWithString:string];
+}
+
+- (instancetype)init{
+    return [self initWithString:nil];
+}
+
+- (instancetype)initWithString:(NSString *)string{
+    //Split on both kinds of separator in one pass, dropping the empty components
+    NSMutableArray<NSString *> *parts = [NSMutableArray array];
+    NSCharacterSet *separators = [NSCharacterSet characterSetWithCharactersInString:@"/\\"];
+    for (NSString *part in [string componentsSeparatedByCharactersInSet:separators]) {
+        if (part.length > 0) {
+            [parts addObject:part];
+        }
+    }
+
+    if (parts.count == 0) {
+        return [self initWithShareName:nil components:@[] string:@"/" relativeSMBPath:@"\\"];
+    }
+
+    NSString *shareName = parts.firstObject;
+    NSArray<NSString *> *components = [parts subarrayWithRange:NSMakeRange(1, parts.count - 1)];
+    NSString *fullString = [@"/" stringByAppendingString:[parts componentsJoinedByString:@"/"]];
+    NSString *relativeSMBPath = [@"\\" stringByAppendingString:[components componentsJoinedByString:@"\\"]];
+    return [self initWithShareName:shareName components:components string:fullString relativeSMBPath:relativeSMBPath];
+}
+
+- (instancetype)initWithShareName:(NSString *)shareName
+                       components:(NSArray<NSString *> *)components
+                           string:(NSString *)string
+                  relativeSMBPath:(NSString *)relativeSMBPath
+{
+    self = [super init];
+    if (self) {
+        _shareName = [shareName copy];
+        _components = [components copy];
+        _string = [string copy];
+        _relativeSMBPath = [relativeSMBPath copy];
+        _shareNameUTF8Data = [TOSMBPath UTF8DataForString:shareName];
+        _relativeSMBPathUTF8Data = [TOSMBPath UTF8DataForString:relativeSMBPath];
+    }
+    return self;
+}
+
++ (NSData *)UTF8DataForString:(NSString *)string{
+    if (string == nil) {
+        return nil;
+    }
+    NSMutableData *data = [[string dataUsingEncoding:NSUTF8StringEncoding] mutableCopy] ?: [NSMutableData data];
+    [data appendBytes:"\0" length:1];
+    return data;
+}
+
+#pragma mark - Accessors -
+
+- (BOOL)isRoot{
+    return (self.shareName == nil);
+}
+
+- (BOOL)isShareRoot{
+    return (self.shareName != nil && self.components.count == 0);
+}
+
+- (NSString *)lastComponent{
+    NSString *lastComponent = self.components.lastObject ?: self.shareName;
+    return lastComponent ?: @"";
+}
+
+- (const char *)shareNameUTF8String{
+    return (const char *)self.shareNameUTF8Data.bytes;
+}
+
+- (const char *)relativeSMBPathUTF8String{
+    return (const char *)self.relativeSMBPathUTF8Data.bytes;
+}
+
+- (NSData *)relativeSMBPathUTF16Data{
+    @synchronized (self) {
+        if (self.cachedRelativeSMBPathUTF16Data == nil) {
+            self.cachedRelativeSMBPathUTF16Data = [self.relativeSMBPath dataUsingEncoding:NSUTF16LittleEndianStringEncoding] ?: [NSData data];
+        }
+        return self.cachedRelativeSMBPathUTF16Data;
+    }
+}
+
+#pragma mark - Derived Paths -
+
+- (TOSMBPath *)pathByAppendingComponent:(NSString *)component{
+    NSParameterAssert(component.length > 0);
+    if (component.length == 0) {
+        return self;
+    }
+
+    //A component with separators in it is really several components, so parse it properly
+    if ([component rangeOfCharacterFromSet:[NSCharacterSet characterSetWithCharactersInString:@"/\\"]].location != NSNotFound) {
+        return [TOSMBPath pathWithString:[self.string stringByAppendingFormat:@"/%@", component]];
+    }
+
+    if (self.isRoot) {
+        return [[TOSMBPath alloc] initWithShareName:component
+                                         components:@[]
+                                             string:[@"/" stringByAppendingString:component]
+                                    relativeSMBPath:@"\\"];
+    }
+
+    NSString *relativeSMBPath = self.isShareRoot ?
+    [self.relativeSMBPath stringByAppendingString:component] :
+    [self.relativeSMBPath stringByAppendingFormat:@"\\%@", component];
+
+    return [[TOSMBPath alloc] initWithShareName:self.shareName
+                                     components:[self.components arrayByAddingObject:component]
+                                         string:[self.string stringByAppendingFormat:@"/%@", component]
+                                relativeSMBPath:relativeSMBPath];
+}
+
+- (TOSMBPath *)parentPath{
+    if (self.isRoot || self.isShareRoot) {
+        return [TOSMBPath rootPath];
+    }
+
+    NSArray<NSString *> *components = [self.components subarrayWithRange:NSMakeRange(0, self.components.count - 1)];
+    //Both strings end in the last component and its separator, so trimming them is enough
+    const NSUInteger trimLength = self.lastComponent.length + 1;
+    NSString *string = [self.string substringToIndex:self.string.length - trimLength];
+    NSString *relativeSMBPath = (components.count == 0) ? @"\\" :
+    [self.relativeSMBPath substringToIndex:self.relativeSMBPath.length - trimLength];
+
+    return [[TOSMBPath alloc] initWithShareName:self.shareName
+                                     components:components
+                                         string:string
+                                relativeSMBPath:relativeSMBPath];
+}
+
+#pragma mark - NSCopying -
+
+- (id)copyWithZone:(NSZone *)zone{
+    //Immutable
+    return self;
+}
+
+#pragma mark - Equality -
+
+- (BOOL)isEqual:(id)object{
+    if (self == object) {
+        return YES;
+    }
+    if (![object isKindOfClass:[TOSMBPath class]]) {
+        return NO;
+    }
+    return [self.string isEqualToString:[(TOSMBPath *)object string]];
+}
+
+- (NSUInteger)hash{
+    return [self.string hash];
+}
+
+#pragma mark - Debug -
+
+- (NSString *)description{
+    return [NSString stringWithFormat:@"Path - %@ | Share: %@ | Relative: %@", self.string, self.shareName, self.relativeSMBPath];
+}
+
+@end
@@ -0,0 +1,98 @@
+//
+//  TOSMBPrefetcher.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class TOSMBSession;
+@class TOSMBSessionFile;
+@class TOSMBSessionFileList;
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSInteger, TOSMBPrefetchPriority) {
+    TOSMBPrefetchPriorityLow = -1,      /* e.g. the rows just past the edge of the screen */
+    TOSMBPrefetchPriorityNormal = 0,
+    TOSMBPrefetchPriorityVisible = 1    /* On screen right now */
+};
+
+/**
+ Called once for every file of a prefetch that wasn't cancelled, on the session's callback queue.
+ The head is the first bytes of the file, up to the requested length.
+ */
+typedef void (^TOSMBPrefetchHandler)(TOSMBSessionFile *file, NSData * _Nullable head, NSError * _Nullable error);
+
+/** One batch of files handed to the prefetcher */
+@interface TOSMBPrefetchRequest : NSObject
+
+/** Can be changed while the request is running, e.g. as its rows scroll on or off screen */
+@property (atomic, assign) TOSMBPrefetchPriority priority;
+
+@property (nonatomic, readonly) NSUInteger fileCount;
+@property (atomic, readonly) NSUInteger completedFileCount;
+@property (atomic, readonly, getter=isCancelled) BOOL cancelled;
+
+/** Drops the files that haven't been read yet. Their handlers are not called. */
+- (void)cancel;
+
+@end
+
+/**
+ Reads the first few kilobytes of many files at once, for previews, thumbnails and metadata.
+
+ Each file is read with a single open, read and close on the session's queue: no stat, no temporary
+ file and no per-file transfer task. Reads are spread over a fixed number of workers per session,
+ and each worker always takes the next file of the highest priority request, so reprioritizing or
+ cancelling requests while scrolling takes effect straight away. Requests on different sessions run
+ independently of each other.
+
+ Heads are kept in a memory cache bounded by `cacheCapacity`. A cached head is only used while the
+ file's size and write time are unchanged.
+ */
+@interface TOSMBPrefetcher : NSObject
+
++ (instancetype)sharedPrefetcher;
+
+/** @param cacheCapacity The most bytes of heads kept in memory */
+- (instancetype)initWithCacheCapacity:(NSUInteger)cacheCapacity;
+
+@property (nonatomic, readonly) NSUInteger cacheCapacity;
+
+/** Reads run at once for each session. Default is 4. */
+@property (atomic, assign) NSUInteger maximumConcurrentReadsPerSession;
+
+/**
+ Reads the head of every file. Files that are already cached are handed over straight away,
+ and directories are skipped.
+
+ @param files The files, in the order they should be read at the same priority
+ @param session The session the files were listed with
+ @param length The most bytes to read from each file
+ @param priority The priority of the whole batch
+ @param handler Called as each file is read
+ */
+- (TOSMBPrefetchRequest *)prefetchHeadsOfFiles:(NSArray<TOSMBSessionFile *> *)files
+                                     inSession:(TOSMBSession *)session
+                                        length:(NSUInteger)length
+                                      priority:(TOSMBPrefetchPriority)priority
+                                       handler:(nullable TOSMBPrefetchHandler)handler;
+
+/** The same, for every file of a listing */
+- (TOSMBPrefetchRequest *)prefetchHeadsOfFilesInList:(TOSMBSessionFileList *)fileList
+                                           inSession:(TOSMBSession *)session
+                                              length:(NSUInteger)length
+                                            priority:(TOSMBPrefetchPriority)priority
+                                             handler:(nullable TOSMBPrefetchHandler)handler;
+
+/** The cached head of a file, if at least `length` bytes of it (or the whole file) are cached */
+- (nullable NSData *)cachedHeadOfFile:(TOSMBSessionFile *)file inSession:(TOSMBSession *)session length:(NSUInteger)length;
+
+- (void)removeAllCachedHeads;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,361 @@
+//
+//  TOSMBPrefetcher.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBPrefetcher.h"
+#import "TOSMBSession.h"
+#import "TOSMBSession+Private.h"
+#import "TOSMBSessionFile+Private.h"
+#import "TOSMBSessionFileList.h"
+#import "TOSMBPath.h"
+#import "smb_file.h"
+
+static const NSUInteger kTOSMBPrefetcherDefaultCacheCapacity = 32 * 1024 * 1024;
+static const NSUInteger kTOSMBPrefetcherDefaultConcurrentReads = 4;
+
+#pragma mark - Cache Entry -
+
+@interface TOSMBPrefetchCacheEntry : NSObject
+
+@property (nonatomic, strong) NSData *head;
+@property (nonatomic, assign) uint64_t fileSize;
+@property (nonatomic, assign) uint64_t writeTimestamp;
+
+@end
+
+@implementation TOSMBPrefetchCacheEntry
+@end
+
+#pragma mark - Request -
+
+@interface TOSMBPrefetchRequest ()
+
+@property (nonatomic, strong) TOSMBSession *session;
+@property (nonatomic, copy) NSArray<TOSMBSessionFile *> *files;     /* The files that weren't cached */
+@property (nonatomic, assign) NSUInteger nextFileIndex;             /* Guarded by the prefetcher */
+@property (nonatomic, assign) NSUInteger length;
+@property (nonatomic, copy) TOSMBPrefetchHandler handler;
+@property (nonatomic, assign) uint64_t sequence;                    /* Breaks ties between equal priorities, oldest first */
+
+@property (nonatomic, assign, readwrite) NSUInteger fileCount;
+@property (atomic, assign, readwrite) NSUInteger completedFileCount;
+@property (atomic, assign, readwrite, getter=isCancelled) BOOL cancelled;
+
+@end
+
+@implementation TOSMBPrefetchRequest
+
+- (void)cancel{
+    self.cancelled = YES;
+}
+
+- (void)didCompleteFile{
+    @synchronized (self) {
+        self.completedFileCount++;
+    }
+}
+
+- (NSString *)description{
+    return [NSString stringWithFormat:@"Prefetch Request - Files: %lu | Completed: %lu | Priority: %ld",
+            (unsigned long)self.fileCount, (unsigned long)self.completedFileCount, (long)self.priority];
+}
+
+@end
+
+#pragma mark - Session Queue -
+
+/* The requests waiting on one session, and the workers reading for them */
+@interface TOSMBPrefetchSessionQueue : NSObject
+
+@property (nonatomic, strong) TOSMBSession *session;
+@property (nonatomic, strong) NSMutableArray<TOSMBPrefetchRequest *> *requests;
+@property (nonatomic, assign) NSUInteger workerCount;
+
+@end
+
+@implementation TOSMBPrefetchSessionQueue
+@end
+
+#pragma mark - Prefetcher -
+
+@interface TOSMBPrefetcher ()
+
+@property (nonatomic, assign, readwrite) NSUInteger cacheCapacity;
+@property (nonatomic, strong) NSCache<NSString *, TOSMBPrefetchCacheEntry *> *cache;
+
+/* Guarded by @synchronized on self, like the request state they hold */
+@property (nonatomic, strong) NSMapTable<TOSMBSession *, TOSMBPrefetchSessionQueue *> *sessionQueues;
+@property (nonatomic, assign) uint64_t nextSequence;
+
+@end
+
+@implementation TOSMBPrefetcher
+
++ (instancetype)sharedPrefetcher{
+    static TOSMBPrefetcher *sharedPrefetcher = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedPrefetcher = [[TOSMBPrefetcher alloc] initWithCacheCapacity:kTOSMBPrefetcherDefaultCacheCapacity];
+    });
+    return sharedPrefetcher;
+}
+
+- (instancetype)init{
+    return [self initWithCacheCapacity:kTOSMBPrefetcherDefaultCacheCapacity];
+}
+
+- (instancetype)initWithCacheCapacity:(NSUInteger)cacheCapacity{
+    self = [super init];
+    if (self) {
+        _cacheCapacity = cacheCapacity;
+        _cache = [[NSCache alloc] init];
+        _cache.totalCostLimit = cacheCapacity;
+        _sessionQueues = [NSMapTable strongToStrongObjectsMapTable];
+        _maximumConcurrentReadsPerSession = kTOSMBPrefetcherDefaultConcurrentReads;
+    }
+    return self;
+}
+
+#pragma mark - Prefetching -
+
+- (TOSMBPrefetchRequest *)prefetchHeadsOfFilesInList:(TOSMBSessionFileList *)fileList
+                                           inSession:(TOSMBSession *)session
+                                              length:(NSUInteger)length
+                                            priority:(TOSMBPrefetchPriority)priority
+                                             handler:(TOSMBPrefetchHandler)handler
+{
+    return [self prefetchHeadsOfFiles:fileList.allFiles inSession:session length:length priority:priority handler:handler];
+}
+
+- (TOSMBPrefetchRequest *)prefetchHeadsOfFiles:(NSArray<TOSMBSessionFile *> *)files
+                                     inSession:(TOSMBSession *)session
+                                        length:(NSUInteger)length
+                                      priority:(TOSMBPrefetchPriority)priority
+                                       handler:(TOSMBPrefetchHandler)handler
+{
+    NSParameterAssert(session);
+    NSParameterAssert(length > 0);
+
+    TOSMBPrefetchRequest *request = [[TOSMBPrefetchRequest alloc] init];
+    request.session = session;
+    request.length = length;
+    request.priority = priority;
+    request.handler = handler;
+
+    //Hand over whatever is cached right away, and queue up the rest
+    NSMutableArray<TOSMBSessionFile *> *pendingFiles = [NSMutableArray arrayWithCapacity:files.count];
+    for (TOSMBSessionFile *file in files) {
+        if (file.directory) {
+            continue;
+        }
+        request.fileCount++;
+        NSData *head = [self cachedHeadOfFile:file inSession:session length:length];
+        if (head) {
+            [self finishFile:file ofRequest:request head:head error:nil];
+        }
+        else {
+            [pendingFiles addObject:file];
+        }
+    }
+    request.files = pendingFiles;
+    if (pendingFiles.count == 0) {
+        return request;
+    }
+
+    NSUInteger newWorkerCount = 0;
+    TOSMBPrefetchSessionQueue *queue = nil;
+    @synchronized (self) {
+        request.sequence = self.nextSequence++;
+        queue = [self.sessionQueues objectForKey:session];
+        if (queue == nil) {
+            queue = [[TOSMBPrefetchSessionQueue alloc] init];
+            queue.session = session;
+            queue.requests = [NSMutableArray array];
+            [self.sessionQueues setObject:queue forKey:session];
+        }
+        [queue.requests addObject:request];
+
+        const NSUInteger maximumWorkerCount = MAX(self.maximumConcurrentReadsPerSession, 1);
+        if (queue.workerCount < maximumWorkerCount) {
+            newWorkerCount = MIN(maximumWorkerCount - queue.workerCount, pendingFiles.count);
+            queue.workerCount += newWorkerCount;
+        }
+    }
+
+    for (NSUInteger i = 0; i < newWorkerCount; i++) {
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+            [self runWorkerForQueue:queue];
+        });
+    }
+    return request;
+}
+
+/* Reads files for the session until none are left */
+- (void)runWorkerForQueue:(TOSMBPrefetchSessionQueue *)queue{
+    TOSMBSession *session = queue.session;
+    NSError *connectionError = [session attemptConnection];
+
+    TOSMBPrefetchRequest *request = nil;
+    TOSMBSessionFile *file = nil;
+    while ((file = [self nextFileInQueue:queue request:&request])) {
+        NSError *error = connectionError;
+        NSData *head = nil;
+        if (error == nil) {
+            //Another request may have read this file in the meantime
+            head = [self cachedHeadOfFile:file inSession:session length:request.length];
+            if (head == nil) {
+                head = [self readHeadOfFile:file inSession:session length:request.length error:&error];
+            }
+        }
+        [self finishFile:file ofRequest:request head:head error:error];
+    }
+}
+
+/* The next file of the highest priority request, or nil after retiring the worker if there is none */
+- (TOSMBSessionFile *)nextFileInQueue:(TOSMBPrefetchSessionQueue *)queue request:(TOSMBPrefetchRequest **)request{
+    @synchronized (self) {
+        TOSMBPrefetchRequest *bestRequest = nil;
+        for (TOSMBPrefetchRequest *candidate in [queue.requests copy]) {
+            if (candidate.cancelled || candidate.nextFileIndex >= candidate.files.count) {
+                [queue.requests removeObjectIdenticalTo:candidate];
+                continue;
+            }
+            if (bestRequest == nil || candidate.priority > bestRequest.priority ||
+                (candidate.priority == bestRequest.priority && candidate.sequence < bestRequest.sequence)) {
+                bestRequest = candidate;
+            }
+        }
+
+        if (bestRequest == nil) {
+            queue.workerCount--;
+            if (queue.workerCount == 0) {
+                [self.sessionQueues removeObjectForKey:queue.session];
+            }
+            return nil;
+        }
+
+        *request = bestRequest;
+        return bestRequest.files[bestRequest.nextFileIndex++];
+    }
+}
+
+- (NSData *)readHeadOfFile:(TOSMBSessionFile *)file inSession:(TOSMBSession *)session length:(NSUInteger)length error:(NSError **)error{
+    TOSMBPath *path = [TOSMBPath pathWithString:file.fullPath];
+    if (path.shareName == nil || path.isShareRoot) {
+        if (error) {
+            *error = errorForErrorCode(TOSMBSessionErrorCodeFileNotFound);
+        }
+        return nil;
+    }
+
+    //The listed size saves asking for bytes past the end
+    const NSUInteger capacity = (NSUInteger)MIN((uint64_t)length, file.fileSize);
+    NSMutableData *head = [NSMutableData dataWithLength:capacity];
+    if (capacity == 0) {
+        return head;
+    }
+
+    NSString *shareName = path.shareName;
+    const char *relativePathCString = path.relativeSMBPathUTF8String;
+    char *bytes = head.mutableBytes;
+    __block BOOL opened = NO;
+    __block BOOL failed = NO;
+    __block NSUInteger bytesRead = 0;
+
+    //Open, read and close in one hop onto the session's queue
+    [session performSMBOperation:^(TOSMBSessionOperationContext *context) {
+        smb_tid treeID = [context treeIDForShareName:shareName];
+        if (treeID == TOSMBShareIDUnknown) {
+            return;
+        }
+        smb_fd fileID = 0;
+        smb_fopen(context.session, treeID, relativePathCString, SMB_MOD_RO, &fileID);
+        if (fileID == 0) {
+            return;
+        }
+        opened = YES;
+        while (bytesRead < capacity) {
+            const ssize_t result = smb_fread(context.session, fileID, bytes + bytesRead, capacity - bytesRead);
+            if (result < 0) {
+                failed = YES;
+                break;
+            }
+            if (result == 0) {
+                break;
+            }
+            bytesRead += (NSUInteger)result;
+        }
+        smb_fclose(context.session, fileID);
+    }];
+
+    if (opened == NO || failed) {
+        if (error) {
+            *error = errorForErrorCode(opened ? TOSMBSessionErrorCodeFileDownloadFailed : TOSMBSessionErrorCodeFileNotFound);
+        }
+        return nil;
+    }
+
+    head.length = bytesRead;
+    return head;
+}
+
+- (void)finishFile:(TOSMBSessionFile *)file ofRequest:(TOSMBPrefetchRequest *)request head:(NSData *)head error:(NSError *)error{
+    if (head) {
+        [self cacheHead:head ofFile:file inSession:request.session];
+    }
+    if (request.cancelled) {
+        return;
+    }
+    [request didCompleteFile];
+    TOSMBPrefetchHandler handler = request.handler;
+    if (handler) {
+        [request.session performCallBackWithBlock:^{ handler(file, head, error); }];
+    }
+}
+
+#pragma mark - Cache -
+
+- (NSString *)cacheKeyForFile:(TOSMBSessionFile *)file inSession:(TOSMBSession *)session{
+    NSString *host = session.hostName.length ? session.hostName : session.ipAddress;
+    return [NSString stringWithFormat:@"%@\n%@\n%@", host ?: @"", session.userName ?: @"", file.fullPath];
+}
+
+- (void)cacheHead:(NSData *)head ofFile:(TOSMBSessionFile *)file inSession:(TOSMBSession *)session{
+    if (head.length > self.cacheCapacity) {
+        return;
+    }
+    TOSMBPrefetchCacheEntry *entry = [[TOSMBPrefetchCacheEntry alloc] init];
+    entry.head = head;
+    entry.fileSize = file.fileSize;
+    entry.writeTimestamp = file.writeTimestamp;
+    [self.cache setObject:entry forKey:[self cacheKeyForFile:file inSession:session] cost:head.length];
+}
+
+- (NSData *)cachedHeadOfFile:(TOSMBSessionFile *)file inSession:(TOSMBSession *)session length:(NSUInteger)length{
+    TOSMBPrefetchCacheEntry *entry = [self.cache objectForKey:[self cacheKeyForFile:file inSession:session]];
+    if (entry == nil || entry.fileSize != file.fileSize || entry.writeTimestamp != file.writeTimestamp) {
+        return nil;
+    }
+    if (entry.head.length >= length) {
+        return (entry.head.length == length) ? entry.head : [entry.head subdataWithRange:NSMakeRange(0, length)];
+    }
+    //A shorter head is still the whole file if the file is that short
+    return (entry.head.length == entry.fileSize) ? entry.head : nil;
+}
+
+- (void)removeAllCachedHeads{
+    [self.cache removeAllObjects];
+}
+
+#pragma mark - Debug -
+
+- (NSString *)description{
+    return [NSString stringWithFormat:@"Prefetcher - Cache Capacity: %lu | Reads Per Session: %lu",
+            (unsigned long)self.cacheCapacity, (unsigned long)self.maximumConcurrentReadsPerSession];
+}
+
+@end
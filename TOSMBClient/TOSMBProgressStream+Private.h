@@ -0,0 +1,35 @@
+//
+//  TOSMBProgressStream+Private.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBProgressStream.h"
+
+@interface TOSMBProgressEvent ()
+
+@property (nonatomic, assign) uint64_t completedBytes;
+@property (nonatomic, assign) uint64_t totalBytes;
+@property (nonatomic, assign) double fractionCompleted;
+@property (nonatomic, assign) NSUInteger activeTaskCount;
+@property (nonatomic, assign) NSUInteger finishedTaskCount;
+@property (nonatomic, assign) double bytesPerSecond;
+@property (nonatomic, assign) NSTimeInterval estimatedTimeRemaining;
+
+@end
+
+@interface TOSMBProgressStream ()
+
+/* Smoothing window of the throughput, in seconds */
+@property (nonatomic, assign) NSTimeInterval throughputWindow;
+
+/* Called by the tasks as bytes are transferred. Only records the counts; events are put together later. */
+- (void)task:(TOSMBSessionTransferTask *)task didTransferBytes:(uint64_t)completedBytes ofTotal:(uint64_t)totalBytes;
+- (void)taskDidFinish:(TOSMBSessionTransferTask *)task;
+
+/* Called by a task as it is deallocated. Counts every task that went away without finishing as finished. */
+- (void)finishAbandonedTasks;
+
+@end
@@ -0,0 +1,71 @@
+//
+//  TOSMBProgressStream.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class TOSMBSession;
+@class TOSMBSessionTransferTask;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** A snapshot of the progress of every task in a stream */
+@interface TOSMBProgressEvent : NSObject
+
+@property (nonatomic, readonly) uint64_t completedBytes;
+@property (nonatomic, readonly) uint64_t totalBytes;            /* 0 until the sizes are known */
+@property (nonatomic, readonly) double fractionCompleted;       /* 0 to 1 */
+
+@property (nonatomic, readonly) NSUInteger activeTaskCount;
+@property (nonatomic, readonly) NSUInteger finishedTaskCount;   /* Succeeded, failed or cancelled */
+
+/** Bytes per second, smoothed over the last few seconds. Bytes a task resumed from aren't counted. */
+@property (nonatomic, readonly) double bytesPerSecond;
+
+/** Seconds until every active task is done at the current throughput, or -1 if that isn't known yet */
+@property (nonatomic, readonly) NSTimeInterval estimatedTimeRemaining;
+
+@end
+
+typedef void (^TOSMBProgressStreamHandler)(TOSMBProgressEvent *event);
+
+/**
+ Delivers the combined progress of a group of transfer tasks at a steady rate.
+
+ Tasks only record their byte counts as they go. Events are put together at most once per `interval`,
+ however small the chunks or however many tasks there are, so the cost of following progress doesn't
+ depend on how the transfers are going. A final event is always delivered once the last active task
+ finishes.
+ */
+@interface TOSMBProgressStream : NSObject
+
+/**
+ @param interval The shortest time between two events
+ @param queue The queue the handler is called on
+ @param handler Called with each event
+ */
+- (instancetype)initWithInterval:(NSTimeInterval)interval
+                           queue:(dispatch_queue_t)queue
+                         handler:(TOSMBProgressStreamHandler)handler;
+
+@property (nonatomic, readonly) NSTimeInterval interval;
+
+/** The most recent event, or nil before the first */
+@property (nullable, atomic, readonly) TOSMBProgressEvent *lastEvent;
+
+/** Adds a task to the group. Can be called before or after the task starts. */
+- (void)addTask:(TOSMBSessionTransferTask *)task;
+
+/** Adds every transfer task of the session that reports progress from now on */
+- (void)addTasksOfSession:(TOSMBSession *)session;
+
+/** Stops delivering events. Pending events are dropped. */
+- (void)invalidate;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,291 @@
+//
+//  TOSMBProgressStream.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBProgressStream.h"
+#import "TOSMBProgressStream+Private.h"
+#import "TOSMBSessionTransferTask+Private.h"
+#import "TOSMBSession+Private.h"
+
+static const NSTimeInterval kTOSMBProgressStreamThroughputWindow = 5.0;
+
+@implementation TOSMBProgressEvent
+
+- (NSString *)description{
+    return [NSString stringWithFormat:@"<%@: %p> %llu/%llu bytes, %lu active, %lu finished, %.0f B/s, ETA %.1fs",
+            NSStringFromClass([self class]), self,
+            self.completedBytes, self.totalBytes,
+            (unsigned long)self.activeTaskCount, (unsigned long)self.finishedTaskCount,
+            self.bytesPerSecond, self.estimatedTimeRemaining];
+}
+
+@end
+
+/* What the stream knows about one task */
+@interface TOSMBProgressStreamEntry : NSObject
+
+@property (nonatomic, weak) TOSMBSessionTransferTask *task;
+@property (nonatomic, assign) BOOL started;
+@property (nonatomic, assign) BOOL finished;
+@property (nonatomic, assign) uint64_t startBytes;      /* Where the task started or resumed from */
+@property (nonatomic, assign) uint64_t completedBytes;
+@property (nonatomic, assign) uint64_t totalBytes;
+
+@end
+
+@implementation TOSMBProgressStreamEntry
+@end
+
+@interface TOSMBProgressStream ()
+
+@property (nonatomic, assign) NSTimeInterval interval;
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, copy) TOSMBProgressStreamHandler handler;
+@property (nonatomic, strong) dispatch_queue_t deliveryQueue;
+@property (nullable, atomic, strong) TOSMBProgressEvent *lastEvent;
+
+@end
+
+@implementation TOSMBProgressStream {
+    /* Everything below is guarded by @synchronized(self) */
+    NSMapTable<TOSMBSessionTransferTask *, TOSMBProgressStreamEntry *> *_entries;
+    NSMutableSet<TOSMBProgressStreamEntry *> *_unfinishedEntries;    /* Outlive their tasks, so a task that goes away unfinished can still be counted off */
+    uint64_t _completedBytes;
+    uint64_t _totalBytes;
+    uint64_t _transferredBytes;         /* Completed bytes minus the bytes each task started from */
+    NSUInteger _activeTaskCount;
+    NSUInteger _finishedTaskCount;
+    
+    BOOL _deliveryScheduled;
+    BOOL _invalidated;
+    CFAbsoluteTime _lastDeliveryTime;
+    
+    CFAbsoluteTime _lastSampleTime;
+    uint64_t _lastSampleBytes;
+    double _bytesPerSecond;
+    BOOL _hasThroughput;
+}
+
+- (instancetype)initWithInterval:(NSTimeInterval)interval
+                           queue:(dispatch_queue_t)queue
+                         handler:(TOSMBProgressStreamHandler)handler
+{
+    NSParameterAssert(queue);
+    NSParameterAssert(handler);
+    self = [super init];
+    if (self) {
+        _interval = MAX(interval, 0.0);
+        _queue = queue;
+        _handler = [handler copy];
+        _deliveryQueue = dispatch_queue_create("tosmb_progress_stream.delivery", DISPATCH_QUEUE_SERIAL);
+        _entries = [NSMapTable weakToStrongObjectsMapTable];
+        _unfinishedEntries = [NSMutableSet set];
+        _throughputWindow = kTOSMBProgressStreamThroughputWindow;
+    }
+    return self;
+}
+
+#pragma mark - Tasks -
+
+- (void)addTask:(TOSMBSessionTransferTask *)task{
+    NSParameterAssert(task);
+    if (task == nil) {
+        return;
+    }
+    @synchronized (self) {
+        [self entryForTask:task];
+    }
+    [task addProgressStream:self];
+}
+
+- (void)addTasksOfSession:(TOSMBSession *)session{
+    NSParameterAssert(session);
+    [session addProgressStream:self];
+}
+
+- (void)invalidate{
+    @synchronized (self) {
+        _invalidated = YES;
+    }
+}
+
+/* Must be called inside @synchronized(self) */
+- (TOSMBProgressStreamEntry *)entryForTask:(TOSMBSessionTransferTask *)task{
+    TOSMBProgressStreamEntry *entry = [_entries objectForKey:task];
+    if (entry == nil) {
+        entry = [[TOSMBProgressStreamEntry alloc] init];
+        entry.task = task;
+        [_entries setObject:entry forKey:task];
+        [_unfinishedEntries addObject:entry];
+        _activeTaskCount++;
+    }
+    return entry;
+}
+
+- (void)task:(TOSMBSessionTransferTask *)task didTransferBytes:(uint64_t)completedBytes ofTotal:(uint64_t)totalBytes{
+    @synchronized (self) {
+        if (_invalidated) {
+            return;
+        }
+        TOSMBProgressStreamEntry *entry = [self entryForTask:task];
+        if (entry.finished) {
+            return;
+        }
+        if (entry.started == NO) {
+            entry.started = YES;
+            entry.startBytes = completedBytes;
+            entry.completedBytes = completedBytes;
+            _completedBytes += completedBytes;
+            if (_lastSampleTime == 0) {
+                _lastSampleTime = CFAbsoluteTimeGetCurrent();
+                _lastSampleBytes = _transferredBytes;
+            }
+        }
+        
+        const uint64_t completed = MAX(completedBytes, entry.startBytes);
+        _completedBytes = _completedBytes - entry.completedBytes + completed;
+        _transferredBytes = _transferredBytes - (entry.completedBytes - entry.startBytes) + (completed - entry.startBytes);
+        entry.completedBytes = completed;
+        
+        _totalBytes = _totalBytes - entry.totalBytes + totalBytes;
+        entry.totalBytes = totalBytes;
+        
+        [self scheduleDelivery];
+    }
+}
+
+- (void)taskDidFinish:(TOSMBSessionTransferTask *)task{
+    @synchronized (self) {
+        if (_invalidated) {
+            return;
+        }
+        TOSMBProgressStreamEntry *entry = [self entryForTask:task];
+        if (entry.finished) {
+            return;
+        }
+        [self finishEntry:entry];
+        [self scheduleDelivery];
+    }
+}
+
+- (void)finishAbandonedTasks{
+    @synchronized (self) {
+        if (_invalidated) {
+            return;
+        }
+        if ([self finishEntriesOfAbandonedTasks]) {
+            [self scheduleDelivery];
+        }
+    }
+}
+
+/* Must be called inside @synchronized(self) */
+- (void)finishEntry:(TOSMBProgressStreamEntry *)entry{
+    entry.finished = YES;
+    [_unfinishedEntries removeObject:entry];
+    _activeTaskCount--;
+    _finishedTaskCount++;
+    
+    //A task that failed, was cancelled or went away won't send the rest of its bytes
+    _totalBytes = _totalBytes - entry.totalBytes + entry.completedBytes;
+    entry.totalBytes = entry.completedBytes;
+}
+
+/* Must be called inside @synchronized(self). Returns YES if any were found. */
+- (BOOL)finishEntriesOfAbandonedTasks{
+    BOOL found = NO;
+    for (TOSMBProgressStreamEntry *entry in [_unfinishedEntries allObjects]) {
+        if (entry.task == nil) {
+            [self finishEntry:entry];
+            found = YES;
+        }
+    }
+    return found;
+}
+
+#pragma mark - Delivery -
+
+/* Must be called inside @synchronized(self). At most one delivery is ever pending, however often this is called. */
+- (void)scheduleDelivery{
+    if (_deliveryScheduled) {
+        return;
+    }
+    _deliveryScheduled = YES;
+    
+    const CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    const NSTimeInterval delay = MAX(0.0, _lastDeliveryTime + self.interval - now);
+    __weak typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), self.deliveryQueue, ^{
+        [weakSelf deliver];
+    });
+}
+
+- (void)deliver{
+    TOSMBProgressEvent *event = nil;
+    @synchronized (self) {
+        _deliveryScheduled = NO;
+        if (_invalidated) {
+            return;
+        }
+        [self finishEntriesOfAbandonedTasks];
+        const CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+        _lastDeliveryTime = now;
+        [self updateThroughputAtTime:now];
+        
+        event = [[TOSMBProgressEvent alloc] init];
+        event.completedBytes = _completedBytes;
+        event.totalBytes = MAX(_totalBytes, _completedBytes);
+        event.fractionCompleted = (event.totalBytes > 0) ? (double)event.completedBytes / (double)event.totalBytes : 0.0;
+        event.activeTaskCount = _activeTaskCount;
+        event.finishedTaskCount = _finishedTaskCount;
+        event.bytesPerSecond = _bytesPerSecond;
+        if (_activeTaskCount == 0) {
+            event.estimatedTimeRemaining = 0.0;
+        }
+        else if (_hasThroughput && _bytesPerSecond > 0.0 && _totalBytes > 0) {
+            event.estimatedTimeRemaining = (double)(event.totalBytes - event.completedBytes) / _bytesPerSecond;
+        }
+        else {
+            event.estimatedTimeRemaining = -1.0;
+        }
+    }
+    self.lastEvent = event;
+    
+    TOSMBProgressStreamHandler handler = self.handler;
+    dispatch_async(self.queue, ^{
+        handler(event);
+    });
+}
+
+/*
+ Exponentially weighted moving average of the bytes per second. Weighting each sample by how long it covers
+ keeps the average over the same stretch of time whatever the interval is and however irregular deliveries are.
+ Must be called inside @synchronized(self).
+ */
+- (void)updateThroughputAtTime:(CFAbsoluteTime)now{
+    if (_lastSampleTime == 0) {
+        return;
+    }
+    const NSTimeInterval elapsed = now - _lastSampleTime;
+    if (elapsed <= 0.0) {
+        return;
+    }
+    const double bytes = (_transferredBytes > _lastSampleBytes) ? (double)(_transferredBytes - _lastSampleBytes) : 0.0;
+    const double sample = bytes / elapsed;
+    if (_hasThroughput) {
+        const double alpha = 1.0 - exp(-elapsed / MAX(self.throughputWindow, DBL_EPSILON));
+        _bytesPerSecond += alpha * (sample - _bytesPerSecond);
+    }
+    else {
+        _bytesPerSecond = sample;
+        _hasThroughput = YES;
+    }
+    _lastSampleTime = now;
+    _lastSampleBytes = _transferredBytes;
+}
+
+@end
@@ -13,6 +13,9 @@
 #import "smb_dir.h"
 #import "TOSMBCSessionWrapper.h"
 #import "TOSMBCSessionWrapper+Private.h"
+#import "TOSMBSessionRetryMetrics.h"
+
+@class TOSMBProgressStream;
 
 
 @interface TOSMBSession ()
@@ -27,6 +30,9 @@
 /* The session pointer responsible for this object. */
 @property (nonatomic, strong) TOSMBCSessionWrapper *smbSessionWrapper;
 @property (nonatomic, strong) NSRecursiveLock *smbSessionLock;
+
+/* Held while connecting, so only one request at a time sets up or swaps the connection */
+@property (nonatomic, strong) NSRecursiveLock *connectionLock;
 @property (nonatomic, strong) NSDate *lastRequestDate;
 
 @property (atomic, assign) BOOL useInternalNameResolution;
@@ -37,6 +43,9 @@
 /* Operation queue for asynchronous callbacks */
 @property (nonatomic, strong) NSOperationQueue *callbackQueue;
 
+/* Serial queue the completion-based core connects on, so requests waiting for a connection don't park a thread each */
+@property (nonatomic, strong) dispatch_queue_t connectionQueue;
+
 /* Connection/Authentication handling */
 - (NSError *)attemptConnection;
 
@@ -50,10 +59,69 @@
                   withBlock:(void(^)(void))operationBlock;
 
 /* SMB Session */
+
+/* The class of the wrappers each new connection is made with */
++ (Class)sessionWrapperClass;
+
 - (void)inSMBCSession:(void (^)(smb_session *session))block;
 
+/* Runs a sequence of libdsm calls against one session in a single hop onto the session queue */
+- (void)performSMBOperation:(void (^)(TOSMBSessionOperationContext *context))block;
+
+/* Retries after a dropped connection */
+
+/* The wait before a reconnect, doubling with each attempt up to the maximum */
+- (NSTimeInterval)retryDelayForAttempt:(NSUInteger)attempt;
+
+/* Called after a request or transfer step has failed on the connection of `failedWrapper`, the wrapper
+   of the context it ran in, or with nil if the server answered. Reconnects with backoff until it succeeds
+   or the retries run out, and returns YES if the caller should go again. If another caller has already
+   replaced that connection, goes again on theirs without reconnecting. `attempt` is advanced past every
+   go. Blocks, so it must not be called on the connection's queue. */
+- (BOOL)reconnectAfterFailureOfSessionWrapper:(TOSMBCSessionWrapper *)failedWrapper attempt:(NSUInteger *)attempt;
+
+/* Completion-based core. Queues the block on the connection's I/O queue and returns straight away,
+   connecting first on the connection queue if needed. The context is nil and the error set if no
+   connection could be made. */
+- (void)performAsyncSMBOperation:(void (^)(TOSMBSessionOperationContext *context, NSError *error))block;
+
+/* Adds a request that runs on the connection's I/O queue through the completion-based core, without holding
+   a request queue thread while it waits. Its result or error is handed to the handlers on the callback queue.
+   The block must set the error when it fails, a nil result with no error is handed to the success handler.
+   An idempotent request that fails because the connection dropped is sent again once reconnected. */
+- (NSOperation *)addAsyncRequestWithBlock:(id (^)(TOSMBSessionOperationContext *context, NSError **error))requestBlock
+                               idempotent:(BOOL)idempotent
+                                  success:(void (^)(id result))successHandler
+                                    error:(void (^)(NSError *error))errorHandler;
+
+/* Requests run inside an operation context, for callers already on the connection's I/O queue */
+- (TOSMBSessionFileList *)fileListOfDirectoryAtSMBPath:(TOSMBPath *)path context:(TOSMBSessionOperationContext *)context error:(NSError **)error;
+- (TOSMBSessionFile *)itemAttributesAtSMBPath:(TOSMBPath *)path context:(TOSMBSessionOperationContext *)context error:(NSError **)error;
+- (BOOL)moveItemAtSMBPath:(TOSMBPath *)fromPath toSMBPath:(TOSMBPath *)toPath context:(TOSMBSessionOperationContext *)context error:(NSError **)error;
+- (BOOL)createDirectoryAtSMBPath:(TOSMBPath *)path context:(TOSMBSessionOperationContext *)context error:(NSError **)error;
+- (BOOL)deleteItemAtSMBPath:(TOSMBPath *)path context:(TOSMBSessionOperationContext *)context error:(NSError **)error;
+
+/* Synchronous requests, for callers that are already running off the calling thread */
+- (TOSMBSessionFileList *)fileListOfDirectoryAtSMBPath:(TOSMBPath *)path error:(NSError **)error;
+- (TOSMBSessionFile *)itemAttributesAtSMBPath:(TOSMBPath *)path error:(NSError **)error;
+- (BOOL)createDirectoryAtSMBPath:(TOSMBPath *)path error:(NSError **)error;
+- (BOOL)deleteItemAtSMBPath:(TOSMBPath *)path error:(NSError **)error;
+
+/* Progress streams following every transfer task of this session */
+- (void)addProgressStream:(TOSMBProgressStream *)stream;
+- (NSArray<TOSMBProgressStream *> *)progressStreams;
+
 - (smb_tid)cachedShareIDForName:(NSString *)shareName;
 - (void)cacheShareID:(smb_tid)shareID forName:(NSString *)shareName;
 - (void)removeCachedShareIDForName:(NSString *)shareName;
 
 @end
+
+@interface TOSMBSessionRetryMetrics ()
+
+- (void)countDroppedConnection;
+- (void)countReconnectAttemptAfterBackoff:(NSTimeInterval)backoff succeeded:(BOOL)succeeded;
+- (void)countRetriedRequest;
+- (void)countResumedTransfer;
+
+@end
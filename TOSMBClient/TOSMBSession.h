@@ -28,7 +28,11 @@ extern const NSTimeInterval kTOSMBSessionTimeout;
 @class TOSMBSessionDownloadTask;
 @class TOSMBSessionUploadTask;
 @class TOSMBSessionFile;
+@class TOSMBSessionFileList;
+@class TOSMBPath;
+@class TOSMBSessionRetryMetrics;
 @protocol TOSMBSessionDownloadTaskDelegate;
+@protocol TOSMBSessionDownloadSink;
 
 @interface TOSMBSession : NSObject
 
@@ -46,6 +50,19 @@ extern const NSTimeInterval kTOSMBSessionTimeout;
 
 - (BOOL)connected;
 
+/**
+ How many times a listing, a stat or a transfer reconnects and goes again after the connection drops,
+ before it fails. Requests that fail on a connection that is still up are never retried. Default is 3; 0 turns retries off.
+ */
+@property (atomic, assign) NSUInteger maximumRetryCount;
+
+/** The wait before the first reconnect. Each further one waits twice as long, up to `maximumRetryDelay`. Defaults are 0.5 and 8 seconds. */
+@property (atomic, assign) NSTimeInterval retryDelay;
+@property (atomic, assign) NSTimeInterval maximumRetryDelay;
+
+/** How often this session has had to recover from a dropped connection */
+@property (nonatomic, readonly) TOSMBSessionRetryMetrics *retryMetrics;
+
 /** 
  Creates a new SMB object, but doesn't try to connect until the first request is made.
  For a successful connection, most devices require both the host name and the IP address.
@@ -86,6 +103,18 @@ extern const NSTimeInterval kTOSMBSessionTimeout;
                                    success:(void (^)(NSArray *files))successHandler
                                      error:(void (^)(NSError *))errorHandler;
 
+/**
+ Performs an asynchronous request for the contents of a directory, returned in compact form.
+ Prefer this over `contentsOfDirectoryAtPath:` for very large directories: file objects and dates
+ are only created for the entries that are accessed, and entries are left in server order.
+ 
+ @param path The file path to request. Supplying nil or "" will reuest the root list of share folders
+ @param errorHandler A pointer to an NSError object that will be non-nil if an error occurs.
+ */
+- (NSOperation *)fileListOfDirectoryAtPath:(NSString *)path
+                                   success:(void (^)(TOSMBSessionFileList *fileList))successHandler
+                                     error:(void (^)(NSError *))errorHandler;
+
 /**
  Creates a download task object for asynchronously downloading a file to disk.
  Only files may be downloaded; folders will return an error.
@@ -122,6 +151,44 @@ extern const NSTimeInterval kTOSMBSessionTimeout;
                                       completionHandler:(void (^)(NSString *filePath))completionHandler
                                             failHandler:(void (^)(NSError *error))failHandler;
 
+//Memory and streaming downloads
+//These use the same chunked reads as the downloads above, but never touch the disk.
+
+/**
+ Creates a download task that reads a whole file into memory. Suited to small files such as thumbnails and metadata.
+ 
+ @param completionHandler A block called with the contents of the file once the download has completed.
+ */
+- (TOSMBSessionDownloadTask *)dataTaskForFileAtPath:(NSString *)path
+                                    progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                  completionHandler:(void (^)(NSData *data))completionHandler
+                                        failHandler:(void (^)(NSError *error))failHandler;
+
+/**
+ Creates a download task that reads a file into a buffer owned by the caller, which must stay valid until the task ends.
+ The download fails if the file doesn't fit.
+ 
+ @param completionHandler A block called with the number of bytes written to the buffer.
+ */
+- (TOSMBSessionDownloadTask *)downloadTaskForFileAtPath:(NSString *)path
+                                               toBuffer:(void *)buffer
+                                                 length:(NSUInteger)length
+                                        progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                      completionHandler:(void (^)(uint64_t length))completionHandler
+                                            failHandler:(void (^)(NSError *error))failHandler;
+
+/**
+ Creates a download task that streams a file to a sink chunk by chunk. The next chunk is only read
+ once the sink has finished with the previous one.
+ 
+ @param completionHandler A block called with the number of bytes streamed.
+ */
+- (TOSMBSessionDownloadTask *)downloadTaskForFileAtPath:(NSString *)path
+                                                 toSink:(id <TOSMBSessionDownloadSink>)sink
+                                        progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                      completionHandler:(void (^)(uint64_t length))completionHandler
+                                            failHandler:(void (^)(NSError *error))failHandler;
+
 //Extra
 
 - (NSOperation *)openConnection:(void (^)(void))successHandler
@@ -149,6 +216,68 @@ extern const NSTimeInterval kTOSMBSessionTimeout;
                                   completionHandler:(void (^)(NSString *filePath))completionHandler
                                         failHandler:(void (^)(NSError *error))error;
 
+//Parsed paths
+//Each of these matches the string based method above it. The path is parsed once when it is created,
+//so a path object can be reused across several requests without being parsed again.
+
+- (NSOperation *)contentsOfDirectoryAtSMBPath:(TOSMBPath *)path
+                                      success:(void (^)(NSArray *files))successHandler
+                                        error:(void (^)(NSError *))errorHandler;
+
+- (NSOperation *)fileListOfDirectoryAtSMBPath:(TOSMBPath *)path
+                                      success:(void (^)(TOSMBSessionFileList *fileList))successHandler
+                                        error:(void (^)(NSError *))errorHandler;
+
+- (TOSMBSessionDownloadTask *)downloadTaskForFileAtSMBPath:(TOSMBPath *)path
+                                           destinationPath:(NSString *)destinationPath
+                                                  delegate:(id <TOSMBSessionDownloadTaskDelegate>)delegate;
+
+- (TOSMBSessionDownloadTask *)downloadTaskForFileAtSMBPath:(TOSMBPath *)path
+                                           destinationPath:(NSString *)destinationPath
+                                           progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                         completionHandler:(void (^)(NSString *filePath))completionHandler
+                                               failHandler:(void (^)(NSError *error))failHandler;
+
+- (TOSMBSessionDownloadTask *)dataTaskForFileAtSMBPath:(TOSMBPath *)path
+                                       progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                     completionHandler:(void (^)(NSData *data))completionHandler
+                                           failHandler:(void (^)(NSError *error))failHandler;
+
+- (TOSMBSessionDownloadTask *)downloadTaskForFileAtSMBPath:(TOSMBPath *)path
+                                                  toBuffer:(void *)buffer
+                                                    length:(NSUInteger)length
+                                           progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                         completionHandler:(void (^)(uint64_t length))completionHandler
+                                               failHandler:(void (^)(NSError *error))failHandler;
+
+- (TOSMBSessionDownloadTask *)downloadTaskForFileAtSMBPath:(TOSMBPath *)path
+                                                    toSink:(id <TOSMBSessionDownloadSink>)sink
+                                           progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                         completionHandler:(void (^)(uint64_t length))completionHandler
+                                               failHandler:(void (^)(NSError *error))failHandler;
+
+- (NSOperation *)itemAttributesAtSMBPath:(TOSMBPath *)path
+                                 success:(void (^)(TOSMBSessionFile *))successHandler
+                                   error:(void (^)(NSError *))errorHandler;
+
+- (NSOperation *)moveItemAtSMBPath:(TOSMBPath *)fromPath toSMBPath:(TOSMBPath *)toPath
+                           success:(void (^)(TOSMBSessionFile *newFile))successHandler
+                             error:(void (^)(NSError *))errorHandler;
+
+- (NSOperation *)createDirectoryAtSMBPath:(TOSMBPath *)path
+                                  success:(void (^)(TOSMBSessionFile *createdDirectory))successHandler
+                                    error:(void (^)(NSError *))errorHandler;
+
+- (NSOperation *)deleteItemAtSMBPath:(TOSMBPath *)path
+                             success:(void (^)(void))successHandler
+                               error:(void (^)(NSError *))errorHandler;
+
+- (TOSMBSessionUploadTask *)uploadTaskForFileAtPath:(NSString *)path
+                                 destinationSMBPath:(TOSMBPath *)destinationPath
+                                    progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                  completionHandler:(void (^)(NSString *filePath))completionHandler
+                                        failHandler:(void (^)(NSError *error))error;
+
 - (void)close;
 
 - (void)cancelAllRequests;
@@ -25,17 +25,26 @@
 #import "TOSMBSession+Private.h"
 #import "TOSMBSession.h"
 #import "TOSMBSessionFile+Private.h"
+#import "TOSMBSessionFileList+Private.h"
 #import "TONetBIOSNameService.h"
 #import "TOSMBSessionDownloadTask.h"
 #import "TOHost.h"
+#import "TOHostResolver.h"
+#import "TOSMBCSessionRegistry.h"
 #import "TOSMBSessionUploadTask.h"
 #import "NSString+TOSMB.h"
+#import "TOSMBPath.h"
+#import "TOSMBSessionTransferTask+Private.h"
+#import "TOSMBSessionAsyncOperation.h"
 
 const NSTimeInterval kTOSMBSessionTimeout = 30.0;
 
 @interface TOSMBSession()
 
 @property (atomic, readwrite) BOOL connected;
+@property (nonatomic, strong, readwrite) TOSMBSessionRetryMetrics *retryMetrics;
+@property (nonatomic, strong) NSHashTable<TOSMBProgressStream *> *progressStreamTable;
+@property (atomic, assign) BOOL hostResolutionPrefetched;
 
 @end
 
@@ -64,8 +73,15 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
         self.callbackQueue.maxConcurrentOperationCount = 1;
         self.requestsQueue = [[NSOperationQueue alloc] init];
         self.requestsQueue.maxConcurrentOperationCount = 10;
-        self.smbSessionWrapper = [[TOSMBCSessionWrapper alloc] init];
+        self.connectionQueue = dispatch_queue_create("tosmb_session.connection", DISPATCH_QUEUE_SERIAL);
+        self.maximumRetryCount = 3;
+        self.retryDelay = 0.5;
+        self.maximumRetryDelay = 8.0;
+        self.retryMetrics = [[TOSMBSessionRetryMetrics alloc] init];
+        self.progressStreamTable = [NSHashTable<TOSMBProgressStream *> weakObjectsHashTable];
+        self.smbSessionWrapper = [[[[self class] sessionWrapperClass] alloc] init];
         self.smbSessionLock = [NSRecursiveLock new];
+        self.connectionLock = [NSRecursiveLock new];
         self.useInternalNameResolution = useInternalNameResolution;
         self.ipAddress = ipAddress;
         self.hostName = hostName;
@@ -99,25 +115,56 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
 
 #pragma mark - Connections/Authentication -
 
+- (void)prefetchHostResolutionIfNeeded{
+    //Warm the shared resolver cache while the first request waits in the queue. Lookups go in the order
+    //the connection makes them, so NetBIOS is only asked when DNS has nothing.
+    @synchronized (self) {
+        if (self.hostResolutionPrefetched) {
+            return;
+        }
+        self.hostResolutionPrefetched = YES;
+    }
+    
+    TOHostResolver *resolver = [TOHostResolver sharedResolver];
+    NSString *hostName = self.hostName;
+    NSString *ipAddress = self.ipAddress;
+    const BOOL useNetBIOS = self.useInternalNameResolution;
+    if (ipAddress.length == 0 && hostName.length > 0) {
+        [resolver addressesForHostname:hostName completion:^(NSArray<NSString *> *results) {
+            if (results.count == 0 && useNetBIOS) {
+                [resolver netBIOSAddressForName:hostName type:TONetBIOSNameServiceTypeFileServer completion:nil];
+            }
+        }];
+    }
+    else if (hostName.length == 0 && ipAddress.length > 0) {
+        [resolver hostnamesForAddress:ipAddress completion:^(NSArray<NSString *> *results) {
+            if (results.count == 0 && useNetBIOS) {
+                [resolver netBIOSNameForAddress:ipAddress completion:nil];
+            }
+        }];
+    }
+}
+
 - (NSError *)attemptConnectionToAddress:(NSString *)ipaddr
                                    port:(NSString *)port
                               transport:(int)transport
 {
     self.ipAddress = ipaddr;
     
+    TOHostResolver *resolver = [TOHostResolver sharedResolver];
+    
     if (self.hostName.length == 0) {
-        self.hostName = [TOHost hostnameForAddress:self.ipAddress];
+        self.hostName = [[resolver hostnamesForAddress:self.ipAddress] firstObject];
     }
     
     //If only one piece of information was supplied, use NetBIOS to resolve the other
     if (self.useInternalNameResolution && (self.ipAddress.length == 0 || self.hostName.length == 0)) {
-        TONetBIOSNameService *nameService = [TONetBIOSNameService sharedService];
         if (self.ipAddress.length==0){
-            self.ipAddress = [nameService resolveIPAddressWithName:self.hostName
-                                                              type:TONetBIOSNameServiceTypeFileServer];
+            self.ipAddress = [resolver netBIOSAddressForName:self.hostName
+                                                        type:TONetBIOSNameServiceTypeFileServer];
         }
         if(self.hostName.length==0){
-            self.hostName = [nameService lookupNetworkNameForIPAddress:self.ipAddress];
+            self.hostName = [resolver netBIOSNameForAddress:self.ipAddress];
         }
     }
     
@@ -149,6 +196,16 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
     NSString *session_password = [NSString stringWithUTF8String:password];
     NSString *session_ip_address = self.ipAddress;
     
+    //Another session may already be logged in to this server with the same credentials
+    NSString *sessionKey = [TOSMBCSessionWrapper sessionKeyForIPAddress:session_ip_address
+                                                                 domain:session_domain
+                                                               userName:session_userName
+                                                               password:session_password];
+    if ([self adoptSharedSMBSessionForKey:sessionKey]) {
+        self.connected = YES;
+        return nil;
+    }
+    
     [self updateSMBSessionUserName:session_userName
                           password:session_password
                          ipAddress:session_ip_address
@@ -182,10 +239,21 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
     
     self.connected = guest != -1;
     
+    if (self.connected) {
+        [self shareSMBSession];
+    }
+    
     return nil;
 }
 
 - (NSError *)attemptConnection{
+    [self.connectionLock lock];
+    NSError *error = [self attemptConnectionWhileLocked];
+    [self.connectionLock unlock];
+    return error;
+}
+
+- (NSError *)attemptConnectionWhileLocked{
     
     __block BOOL sessionValid = NO;
     [self inSMBCSession:^(smb_session *session) {
@@ -218,6 +286,11 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
         return nil;
     }
     
+    //Don't reconnect a shared session in place, other sessions may still be using it
+    if ([[TOSMBCSessionRegistry sharedRegistry] containsSession:self.smbSessionWrapper]) {
+        [self reloadSession];
+    }
+    
     //Ensure at least one piece of connection information was supplied
     if (self.ipAddress.length == 0 && self.hostName.length == 0) {
         return errorForErrorCode(TOSMBSessionErrorCodeUnableToResolveAddress);
@@ -225,7 +298,7 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
     
     if (self.ipAddress.length == 0) {
         NSMutableArray *addressesForHost = [[NSMutableArray alloc] init];
-        NSArray *addresses = [TOHost addressesForHostname:self.hostName];
+        NSArray *addresses = [[TOHostResolver sharedResolver] addressesForHostname:self.hostName];
         for(NSString *addr in addresses) {
             if ([TOHost isValidIPAddress:addr] && [addr hasPrefix:@"127."] == NO) {
                 [addressesForHost addObject:addr];
@@ -233,6 +306,7 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
         }
         
         __block NSError *connectError = nil;
+        __block BOOL addressesUnreachable = YES;
         NSArray *resultArr = [addressesForHost sortedArrayUsingComparator:^NSComparisonResult(id  _Nonnull obj1, id  _Nonnull obj2) {
             return [@([obj1 length]) compare:@([obj2 length])];
         }];
@@ -242,6 +316,9 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
                 connectError = [self attemptConnectionToAddress:obj
                                                            port:self.port
                                                       transport:SMB_TRANSPORT_TCP];
+                if (connectError.code != TOSMBSessionErrorCodeUnableToConnect) {
+                    addressesUnreachable = NO;
+                }
                 if (self.connected) {
                     *stop = YES;
                 }
@@ -251,6 +328,7 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
             connectError = [self attemptConnectionToAddress:nil
                                                        port:self.port
                                                   transport:SMB_TRANSPORT_TCP];
+            addressesUnreachable = (connectError.code == TOSMBSessionErrorCodeUnableToConnect);
         }
         
         if (self.connected == NO) {
@@ -258,12 +336,21 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
                 connectError = [self attemptConnectionToAddress:obj
                                                            port:self.port
                                                       transport:SMB_TRANSPORT_NBT];
+                if (connectError.code != TOSMBSessionErrorCodeUnableToConnect) {
+                    addressesUnreachable = NO;
+                }
                 if(self.connected){
                     *stop = YES;
                 }
             }];
         }
         
+        //None of the cached addresses could be reached, so don't hand them out again. A server that
+        //answered and then turned us away, like one that rejected the credentials, says nothing about them.
+        if (self.connected == NO && addressesUnreachable) {
+            [[TOHostResolver sharedResolver] invalidateCachedResultsForHost:self.hostName];
+        }
+        
         return self.connected ? nil : connectError;
     }
     else{
@@ -283,34 +370,43 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
 
 #pragma mark - Directory Content -
 
-- (smb_tid)connectToShareWithName:(NSString *)shareName error:(NSError **)error{
-    //Connect to that share
-    //If not, make a new connection
-    const char *cStringName = [shareName cStringUsingEncoding:NSUTF8StringEncoding];
-    __block smb_tid shareID = [self cachedShareIDForName:shareName];
-    if (shareID == TOSMBShareIDUnknown) {
-        [self inSMBCSession:^(smb_session *session) {
-            smb_tree_connect(session, cStringName, &shareID);
-        }];
-    }
-    if (shareID == TOSMBShareIDUnknown) {
-        [self removeCachedShareIDForName:shareName];
-        if (error) {
-            NSError *resultError = errorForErrorCode(TOSMBSessionErrorCodeShareConnectionFailed);
-            *error = resultError;
-        }
-        return TOSMBShareIDUnknown;
+- (NSArray *)contentsOfDirectoryAtPath:(NSString *)path
+                                 error:(NSError **)error
+{
+    return [self contentsOfDirectoryAtSMBPath:[TOSMBPath pathWithString:path] error:error];
+}
+
+- (NSArray *)contentsOfDirectoryAtSMBPath:(TOSMBPath *)path
+                                    error:(NSError **)error
+{
+    TOSMBSessionFileList *fileList = [self fileListOfDirectoryAtSMBPath:path error:error];
+    return [TOSMBSession contentsOfDirectoryAtSMBPath:path fromFileList:fileList];
+}
+
++ (NSArray *)contentsOfDirectoryAtSMBPath:(TOSMBPath *)path fromFileList:(TOSMBSessionFileList *)fileList
+{
+    if (fileList.count == 0){
+        return nil;
     }
-    else{
-        [self cacheShareID:shareID forName:shareName];
+    
+    //Shares are returned in the order the server lists them
+    if (path == nil || path.isRoot) {
+        return [fileList allFiles];
     }
-    return shareID;
+    
+    NSArray *result = [[fileList allFiles] sortedArrayUsingDescriptors:@[[NSSortDescriptor sortDescriptorWithKey:@"name" ascending:YES]]];
+    return result;
 }
 
-- (NSArray *)contentsOfDirectoryAtPath:(NSString *)path
-                                 error:(NSError **)error
+- (TOSMBSessionFileList *)fileListOfDirectoryAtPath:(NSString *)path
+                                              error:(NSError **)error
+{
+    return [self fileListOfDirectoryAtSMBPath:[TOSMBPath pathWithString:path] error:error];
+}
+
+- (TOSMBSessionFileList *)fileListOfDirectoryAtSMBPath:(TOSMBPath *)path
+                                                 error:(NSError **)error
 {
-    
     //Attempt a connection attempt (If it has not already been done)
     NSError *resultError = [self attemptConnection];
     if (error && resultError){
@@ -321,127 +417,134 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
         return nil;
     }
     
-    //-----------------------------------------------------------------------------
+    //Connect to the share and query for a list of files in this directory in one pass,
+    //going again on a new connection if this one has dropped
+    __block TOSMBSessionFileList *fileList = nil;
+    __block NSError *listError = nil;
+    __block TOSMBCSessionWrapper *failedWrapper = nil;
+    NSUInteger attempt = 0;
+    do {
+        if (attempt > 0) {
+            [self.retryMetrics countRetriedRequest];
+        }
+        failedWrapper = nil;
+        [self performSMBOperation:^(TOSMBSessionOperationContext *context) {
+            NSError *contextError = nil;
+            fileList = [self fileListOfDirectoryAtSMBPath:path context:context error:&contextError];
+            listError = contextError;
+            if (fileList == nil && [context hasConnectionFailed]) {
+                failedWrapper = context.wrapper;
+            }
+        }];
+    } while (fileList == nil && [self reconnectAfterFailureOfSessionWrapper:failedWrapper attempt:&attempt]);
     
+    if (error && listError) {
+        *error = listError;
+    }
+    
+    return fileList;
+}
+
+- (TOSMBSessionFileList *)fileListOfDirectoryAtSMBPath:(TOSMBPath *)path
+                                               context:(TOSMBSessionOperationContext *)context
+                                                 error:(NSError **)error
+{
     //If the path is nil, or '/', we'll be specifically requesting the
     //parent network share names as opposed to the actual file lists
-    if (path.length == 0 || [path isEqualToString:@"/"]) {
-        NSMutableArray *shareList = [NSMutableArray array];
-        [self inSMBCSession:^(smb_session *session) {
-            int smb_result = DSM_ERROR_GENERIC;
-            smb_share_list list=NULL;
-            size_t shareCount = 0;
-            smb_result = smb_share_get_list(session, &list, &shareCount);
-            if (smb_result==DSM_SUCCESS){
-                for (NSInteger i = 0; i < shareCount; i++) {
-                    const char *shareName = smb_share_list_at(list, i);
-                    //Skip system shares suffixed by '$'
-                    if (shareName[strlen(shareName)-1] == '$'){
-                        continue;
-                    }
-                    NSString *shareNameString = [NSString stringWithCString:shareName encoding:NSUTF8StringEncoding];
-                    TOSMBSessionFile *share = [[TOSMBSessionFile alloc] initWithShareName:shareNameString];
-                    [shareList addObject:share];
-                }
-                if(list!=NULL){
-                    smb_share_list_destroy(list);
+    if (path == nil || path.isRoot) {
+        TOSMBSessionFileList *shareList = nil;
+        smb_share_list list=NULL;
+        size_t shareCount = 0;
+        int smb_result = smb_share_get_list(context.session, &list, &shareCount);
+        if (smb_result==DSM_SUCCESS){
+            shareList = [[TOSMBSessionFileList alloc] initWithPath:@"/" capacity:shareCount];
+            for (NSInteger i = 0; i < shareCount; i++) {
+                const char *shareName = smb_share_list_at(list, i);
+                //Skip system shares suffixed by '$'
+                if (shareName[strlen(shareName)-1] == '$'){
+                    continue;
                 }
+                [shareList addShareWithName:shareName];
             }
-        }];
-        return (shareList.count==0)?nil:shareList;
+            if(list!=NULL){
+                smb_share_list_destroy(list);
+            }
+        }
+        if (shareList == nil && error) {
+            *error = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
+        }
+        return shareList;
     }
     
     //-----------------------------------------------------------------------------
     
-    //Replace any backslashes with forward slashes
-    path = [path TOSMB_stringByReplacingOccurrencesOfBackSlashWithForwardSlash];
-    
-    //Work out just the share name from the path (The first directory in the string)
-    NSString *shareName = [TOSMBSession shareNameFromPath:path];
-    
-    //Connect to that share
-    //If not, make a new connection
-    smb_tid shareID = [self connectToShareWithName:shareName error:error];
+    smb_tid shareID = [context treeIDForShareName:path.shareName];
     if (shareID == TOSMBShareIDUnknown) {
+        if (error) {
+            *error = errorForErrorCode(TOSMBSessionErrorCodeShareConnectionFailed);
+        }
         return nil;
     }
     
-    //work out the remainder of the file path and create the search query
-    NSString *relativePath = [TOSMBSession relativeSMBPathFromPath:path];
-    //append double backslash if we don't have one
-    if (![[relativePath substringFromIndex:relativePath.length-1] isEqualToString:@"\\"]){
-        relativePath = [relativePath stringByAppendingString:@"\\"];
-    }
-    
     //Add the wildcard symbol for everything in this folder
-    relativePath = [relativePath stringByAppendingString:@"*"]; //wildcard to search for all files
-    
-    NSMutableArray *fileList = [NSMutableArray array];
-    
-    //Query for a list of files in this directory
-    [self inSMBCSession:^(smb_session *session) {
-        smb_stat_list statList = NULL;
-        statList = smb_find(session, shareID, relativePath.UTF8String);
-        if(statList!=NULL){
-            size_t listCount = smb_stat_list_count(statList);
-            if (listCount != 0){
-                for (NSInteger i = 0; i < listCount; i++) {
-                    smb_stat item = smb_stat_list_at(statList, i);
-                    const char* name = smb_stat_name(item);
-                    if (name[0] == '.') { //skip hidden files
-                        continue;
-                    }
-                    TOSMBSessionFile *file = [[TOSMBSessionFile alloc] initWithStat:item parentDirectoryPath:path];
-                    if(file){
-                        [fileList addObject:file];
-                    }
-                }
+    TOSMBPath *searchPath = [path pathByAppendingComponent:@"*"]; //wildcard to search for all files
+    
+    TOSMBSessionFileList *fileList = nil;
+    smb_stat_list statList = smb_find(context.session, shareID, searchPath.relativeSMBPathUTF8String);
+    if(statList!=NULL){
+        size_t listCount = smb_stat_list_count(statList);
+        fileList = [[TOSMBSessionFileList alloc] initWithPath:path.string capacity:listCount];
+        for (NSInteger i = 0; i < listCount; i++) {
+            smb_stat item = smb_stat_list_at(statList, i);
+            const char* name = smb_stat_name(item);
+            if (name == NULL || name[0] == '.') { //skip hidden files
+                continue;
             }
-            smb_stat_list_destroy(statList);
+            [fileList addEntryWithStat:item];
         }
-    }];
+        smb_stat_list_destroy(statList);
+    }
     
-    if (fileList.count == 0){
-        return nil;
+    if (fileList == nil && error) {
+        *error = errorForErrorCode(TOSMBSessionErrorCodeFileNotFound);
     }
     
-    NSArray *result = [fileList sortedArrayUsingDescriptors:@[[NSSortDescriptor sortDescriptorWithKey:@"name" ascending:YES]]];
-    return result;
+    return fileList;
+}
+
+- (NSOperation *)fileListOfDirectoryAtPath:(NSString *)path
+                                   success:(void (^)(TOSMBSessionFileList *fileList))successHandler
+                                     error:(void (^)(NSError *))errorHandler
+{
+    return [self fileListOfDirectoryAtSMBPath:[TOSMBPath pathWithString:path] success:successHandler error:errorHandler];
+}
+
+- (NSOperation *)fileListOfDirectoryAtSMBPath:(TOSMBPath *)path
+                                      success:(void (^)(TOSMBSessionFileList *fileList))successHandler
+                                        error:(void (^)(NSError *))errorHandler
+{
+    TOSMBMakeWeakReference();
+    return [self addAsyncRequestWithBlock:^id(TOSMBSessionOperationContext *context, NSError **error) {
+        return [weakSelf fileListOfDirectoryAtSMBPath:path context:context error:error];
+    } idempotent:YES success:successHandler error:errorHandler];
 }
 
 - (NSOperation *)contentsOfDirectoryAtPath:(NSString *)path
                                    success:(void (^)(NSArray *))successHandler
                                      error:(void (^)(NSError *))errorHandler
 {
-    
-    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
-    
+    return [self contentsOfDirectoryAtSMBPath:[TOSMBPath pathWithString:path] success:successHandler error:errorHandler];
+}
+
+- (NSOperation *)contentsOfDirectoryAtSMBPath:(TOSMBPath *)path
+                                      success:(void (^)(NSArray *))successHandler
+                                        error:(void (^)(NSError *))errorHandler
+{
     TOSMBMakeWeakReference();
-    TOSMBMakeWeakReferenceForOperation();
-    
-    id operationBlock = ^{
-        
-        TOSMBCheckIfWeakReferenceForOperationIsCancelledOrNilAndReturn();
-        TOSMBCheckIfWeakReferenceIsNilAndReturn();
-        TOSMBMakeStrongFromWeakReference();
-        
-        NSError *error = nil;
-        NSArray *files = [strongSelf contentsOfDirectoryAtPath:path error:&error];
-        
-        if (error) {
-            if (errorHandler) {
-                [strongSelf performCallBackWithBlock:^{ if(errorHandler){errorHandler(error);} }];
-            }
-        }
-        else {
-            if (successHandler) {
-                [strongSelf performCallBackWithBlock:^{ if(successHandler){successHandler(files);} }];
-            }
-        }
-        
-    };
-    
-    return [self addRequestOperation:operation withBlock:operationBlock];
+    return [self addAsyncRequestWithBlock:^id(TOSMBSessionOperationContext *context, NSError **error) {
+        TOSMBSessionFileList *fileList = [weakSelf fileListOfDirectoryAtSMBPath:path context:context error:error];
+        return [TOSMBSession contentsOfDirectoryAtSMBPath:path fromFileList:fileList];
+    } idempotent:YES success:successHandler error:errorHandler];
 }
 
 #pragma mark - Download Tasks -
@@ -472,36 +575,60 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
     return task;
 }
 
+- (TOSMBSessionDownloadTask *)dataTaskForFileAtPath:(NSString *)path
+                                    progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                  completionHandler:(void (^)(NSData *data))completionHandler
+                                        failHandler:(void (^)(NSError *error))failHandler{
+    TOSMBSessionDownloadTask *task = [[TOSMBSessionDownloadTask alloc] initWithSession:self
+                                                                              filePath:path
+                                                                       progressHandler:progressHandler
+                                                                           dataHandler:completionHandler
+                                                                           failHandler:failHandler];
+    return task;
+}
+
+- (TOSMBSessionDownloadTask *)downloadTaskForFileAtPath:(NSString *)path
+                                               toBuffer:(void *)buffer
+                                                 length:(NSUInteger)length
+                                        progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                      completionHandler:(void (^)(uint64_t length))completionHandler
+                                            failHandler:(void (^)(NSError *error))failHandler{
+    TOSMBSessionDownloadTask *task = [[TOSMBSessionDownloadTask alloc] initWithSession:self
+                                                                              filePath:path
+                                                                                buffer:buffer
+                                                                                length:length
+                                                                       progressHandler:progressHandler
+                                                                         lengthHandler:completionHandler
+                                                                           failHandler:failHandler];
+    return task;
+}
+
+- (TOSMBSessionDownloadTask *)downloadTaskForFileAtPath:(NSString *)path
+                                                 toSink:(id<TOSMBSessionDownloadSink>)sink
+                                        progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                      completionHandler:(void (^)(uint64_t length))completionHandler
+                                            failHandler:(void (^)(NSError *error))failHandler{
+    TOSMBSessionDownloadTask *task = [[TOSMBSessionDownloadTask alloc] initWithSession:self
+                                                                              filePath:path
+                                                                                  sink:sink
+                                                                       progressHandler:progressHandler
+                                                                         lengthHandler:completionHandler
+                                                                           failHandler:failHandler];
+    return task;
+}
+
 #pragma mark - Open Connection -
 
 - (NSOperation *)openConnection:(void (^)(void))successHandler
                           error:(void (^)(NSError *))errorHandler
 {
-    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
-    
-    TOSMBMakeWeakReference();
-    TOSMBMakeWeakReferenceForOperation();
-    
-    id operationBlock = ^{
-        
-        TOSMBCheckIfWeakReferenceForOperationIsCancelledOrNilAndReturn();
-        TOSMBCheckIfWeakReferenceIsNilAndReturn();
-        TOSMBMakeStrongFromWeakReference();
-        
-        NSError *error = [strongSelf attemptConnection];
-        
-        if (error) {
-            if (errorHandler) {
-                [strongSelf performCallBackWithBlock:^{ if(errorHandler){errorHandler(error);} }];
-            }
+    return [self addAsyncRequestWithBlock:^id(TOSMBSessionOperationContext *context, NSError **error) {
+        return @YES;
+    } idempotent:YES success:^(id result) {
+        if (successHandler) {
+            successHandler();
         }
-        else {
-            if (successHandler) {
-                [strongSelf performCallBackWithBlock:^{ if(successHandler){successHandler();} }];
-            }
-        }
-    };
-    return [self addRequestOperation:operation withBlock:operationBlock];
+    } error:errorHandler];
 }
 
 #pragma mark - Item Info -
@@ -509,7 +636,13 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
 - (TOSMBSessionFile *)itemAttributesAtPath:(NSString *)path
                                      error:(NSError **)error
 {
-    TOSMBSessionFile *file = nil;
+    return [self itemAttributesAtSMBPath:[TOSMBPath pathWithString:path] error:error];
+}
+
+- (TOSMBSessionFile *)itemAttributesAtSMBPath:(TOSMBPath *)path
+                                        error:(NSError **)error
+{
+    __block TOSMBSessionFile *file = nil;
     
     //Attempt a connection attempt (If it has not already been done)
     NSError *resultError = [self attemptConnection];
@@ -521,58 +654,69 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
         return nil;
     }
     
-    if (path.length == 0 || [path isEqualToString:@"/"]) {
+    //Connect to the share and stat the file in one pass,
+    //going again on a new connection if this one has dropped
+    __block NSError *statError = nil;
+    __block TOSMBCSessionWrapper *failedWrapper = nil;
+    NSUInteger attempt = 0;
+    do {
+        if (attempt > 0) {
+            [self.retryMetrics countRetriedRequest];
+        }
+        failedWrapper = nil;
+        [self performSMBOperation:^(TOSMBSessionOperationContext *context) {
+            NSError *contextError = nil;
+            file = [self itemAttributesAtSMBPath:path context:context error:&contextError];
+            statError = contextError;
+            if (file == nil && [context hasConnectionFailed]) {
+                failedWrapper = context.wrapper;
+            }
+        }];
+    } while (file == nil && [self reconnectAfterFailureOfSessionWrapper:failedWrapper attempt:&attempt]);
+    
+    if (error && statError) {
+        *error = statError;
+    }
+    
+    return file;
+}
+
+- (TOSMBSessionFile *)itemAttributesAtSMBPath:(TOSMBPath *)path
+                                      context:(TOSMBSessionOperationContext *)context
+                                        error:(NSError **)error
+{
+    if (path == nil || path.isRoot) {
         if (error) {
-            resultError = errorForErrorCode(TOSMBSessionErrorCodeFileNotFound);
-            *error = resultError;
+            *error = errorForErrorCode(TOSMBSessionErrorCodeFileNotFound);
         }
         return nil;
     }
     
-    //Replace any backslashes with forward slashes
-    path = [path TOSMB_stringByReplacingOccurrencesOfBackSlashWithForwardSlash];
-    
-    //Work out just the share name from the path (The first directory in the string)
-    NSString *shareName = [TOSMBSession shareNameFromPath:path];
-    
-    //Connect to that share
-    //If not, make a new connection
-    smb_tid shareID = [self connectToShareWithName:shareName error:error];
+    NSString *shareName = path.shareName;
+    smb_tid shareID = [context treeIDForShareName:shareName];
     if (shareID == TOSMBShareIDUnknown) {
         if (error) {
-            resultError = errorForErrorCode(TOSMBSessionErrorCodeShareConnectionFailed);
-            *error = resultError;
+            *error = errorForErrorCode(TOSMBSessionErrorCodeShareConnectionFailed);
         }
         return nil;
     }
     
-    //work out the remainder of the file path and create the search query
-    NSString *relativePath = [TOSMBSession relativeSMBPathFromPath:path];
-    
-    if ([[path stringByDeletingLastPathComponent] isEqualToString:@"/"]) {
-        file = [[TOSMBSessionFile alloc] initWithShareName:shareName];
-        return file;
+    if (path.isShareRoot) {
+        return [[TOSMBSessionFile alloc] initWithShareName:shareName];
     }
-
-    const char *relativePathCString = [relativePath cStringUsingEncoding:NSUTF8StringEncoding];
     
-    __block smb_stat stat = NULL;
-    [self inSMBCSession:^(smb_session *session) {
-        stat = smb_fstat(session, shareID, relativePathCString);
-    }];
+    TOSMBSessionFile *file = nil;
+    smb_stat stat = smb_fstat(context.session, shareID, path.relativeSMBPathUTF8String);
+    if (stat != NULL) {
+        file = [[TOSMBSessionFile alloc] initWithStat:stat fullPath:path.string];
+        smb_stat_destroy(stat);
+    }
     
-    if (stat == NULL) {
+    if (file == nil) {
         if (error) {
-            resultError = errorForErrorCode(TOSMBSessionErrorCodeFileNotFound);
-            *error = resultError;
+            *error = errorForErrorCode(TOSMBSessionErrorCodeFileNotFound);
         }
     }
-    else {
-        file = [[TOSMBSessionFile alloc] initWithStat:stat fullPath:path];
-        [self inSMBCSession:^(smb_session *session) {
-            smb_stat_destroy(stat);
-        }];
-    }
     
     return file;
 }
@@ -581,33 +725,17 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
                               success:(void (^)(TOSMBSessionFile *))successHandler
                                 error:(void (^)(NSError *))errorHandler
 {
-    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
+    return [self itemAttributesAtSMBPath:[TOSMBPath pathWithString:path] success:successHandler error:errorHandler];
+}
+
+- (NSOperation *)itemAttributesAtSMBPath:(TOSMBPath *)path
+                                 success:(void (^)(TOSMBSessionFile *))successHandler
+                                   error:(void (^)(NSError *))errorHandler
+{
     TOSMBMakeWeakReference();
-    TOSMBMakeWeakReferenceForOperation();
-    
-    id operationBlock = ^{
-        
-        TOSMBCheckIfWeakReferenceForOperationIsCancelledOrNilAndReturn();
-        TOSMBCheckIfWeakReferenceIsNilAndReturn();
-        TOSMBMakeStrongFromWeakReference();
-        
-        NSError *error = nil;
-        TOSMBSessionFile *file = [strongSelf itemAttributesAtPath:path error:&error];
-        
-        if (error) {
-            if (errorHandler) {
-                [strongSelf performCallBackWithBlock:^{ if(errorHandler){errorHandler(error);} }];
-            }
-        }
-        else {
-            if (successHandler) {
-                [strongSelf performCallBackWithBlock:^{ if(successHandler){successHandler(file);} }];
-            }
-        }
-        
-    };
-    
-    return [self addRequestOperation:operation withBlock:operationBlock];
+    return [self addAsyncRequestWithBlock:^id(TOSMBSessionOperationContext *context, NSError **error) {
+        return [weakSelf itemAttributesAtSMBPath:path context:context error:error];
+    } idempotent:YES success:successHandler error:errorHandler];
 }
 
 #pragma mark - Move Item -
@@ -616,6 +744,15 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
                 toPath:(NSString *)toPath
                  error:(NSError **)error
 {
+    return [self moveItemAtSMBPath:[TOSMBPath pathWithString:fromPath]
+                         toSMBPath:[TOSMBPath pathWithString:toPath]
+                             error:error];
+}
+
+- (BOOL)moveItemAtSMBPath:(TOSMBPath *)fromPath
+                toSMBPath:(TOSMBPath *)toPath
+                    error:(NSError **)error
+{
     
     NSError *resultError = [self attemptConnection];
     if (error && resultError){
@@ -626,43 +763,46 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
         return NO;
     }
     
-    if (fromPath.length == 0 || [fromPath isEqualToString:@"/"] || toPath.length == 0 || [toPath isEqualToString:@"/"]) {
+    //Connect to the share and move the item in one pass
+    __block BOOL moved = NO;
+    __block NSError *moveError = nil;
+    [self performSMBOperation:^(TOSMBSessionOperationContext *context) {
+        NSError *contextError = nil;
+        moved = [self moveItemAtSMBPath:fromPath toSMBPath:toPath context:context error:&contextError];
+        moveError = contextError;
+    }];
+    
+    if (error && moveError) {
+        *error = moveError;
+    }
+    
+    return moved;
+}
+
+- (BOOL)moveItemAtSMBPath:(TOSMBPath *)fromPath
+                toSMBPath:(TOSMBPath *)toPath
+                  context:(TOSMBSessionOperationContext *)context
+                    error:(NSError **)error
+{
+    if (fromPath == nil || fromPath.isRoot || toPath == nil || toPath.isRoot) {
         if (error) {
-            resultError = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
-            *error = resultError;
+            *error = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
         }
         return NO;
     }
     
-    //Replace any backslashes with forward slashes
-    fromPath = [fromPath TOSMB_stringByReplacingOccurrencesOfBackSlashWithForwardSlash];
-    toPath = [toPath TOSMB_stringByReplacingOccurrencesOfBackSlashWithForwardSlash];
-    
-    //Work out just the share name from the path (The first directory in the string)
-    NSString *shareName = [TOSMBSession shareNameFromPath:fromPath];
-    
-    //Connect to that share
-    //If not, make a new connection
-    smb_tid shareID = [self connectToShareWithName:shareName error:error];
+    smb_tid shareID = [context treeIDForShareName:fromPath.shareName];
     if (shareID == TOSMBShareIDUnknown) {
+        if (error) {
+            *error = errorForErrorCode(TOSMBSessionErrorCodeShareConnectionFailed);
+        }
         return NO;
     }
     
-    NSString *relativeFromPath = [TOSMBSession relativeSMBPathFromPath:fromPath];
-    NSString *relativeToPath = [TOSMBSession relativeSMBPathFromPath:toPath];
-    
-    const char *relativeFromPathCString = [relativeFromPath cStringUsingEncoding:NSUTF8StringEncoding];
-    const char *relativeToPathCString = [relativeToPath cStringUsingEncoding:NSUTF8StringEncoding];
-    
-    __block int result = DSM_ERROR_GENERIC;
-    [self inSMBCSession:^(smb_session *session) {
-        result = smb_file_mv(session, shareID, relativeFromPathCString, relativeToPathCString);
-    }];
-    
+    int result = smb_file_mv(context.session, shareID, fromPath.relativeSMBPathUTF8String, toPath.relativeSMBPathUTF8String);
     if (result != DSM_SUCCESS) {
         if (error) {
-            resultError = errorForErrorCode(TOSMBSessionErrorCodeUnableToMoveFile);
-            *error = resultError;
+            *error = errorForErrorCode(TOSMBSessionErrorCodeUnableToMoveFile);
         }
     }
     
@@ -674,38 +814,36 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
                         success:(void (^)(TOSMBSessionFile *newFile))successHandler
                           error:(void (^)(NSError *))errorHandler
 {
-    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
+    return [self moveItemAtSMBPath:[TOSMBPath pathWithString:fromPath]
+                         toSMBPath:[TOSMBPath pathWithString:toPath]
+                           success:successHandler
+                             error:errorHandler];
+}
+
+- (NSOperation *)moveItemAtSMBPath:(TOSMBPath *)fromPath
+                         toSMBPath:(TOSMBPath *)toPath
+                           success:(void (^)(TOSMBSessionFile *newFile))successHandler
+                             error:(void (^)(NSError *))errorHandler
+{
     TOSMBMakeWeakReference();
-    TOSMBMakeWeakReferenceForOperation();
-    
-    id operationBlock = ^{
-        
-        TOSMBCheckIfWeakReferenceForOperationIsCancelledOrNilAndReturn();
-        TOSMBCheckIfWeakReferenceIsNilAndReturn();
-        TOSMBMakeStrongFromWeakReference();
-        
-        NSError *error = nil;
-        BOOL success = [strongSelf moveItemAtPath:fromPath toPath:toPath error:&error];
-        
-        if (success==NO || error) {
-            if (errorHandler) {
-                [strongSelf performCallBackWithBlock:^{ if(errorHandler){errorHandler(error);} }];
-            }
-        }
-        else {
-            TOSMBSessionFile *file = [weakSelf itemAttributesAtPath:toPath error:&error];
-            if (successHandler) {
-                [strongSelf performCallBackWithBlock:^{ if(successHandler){successHandler(file);} }];
+    return [self addAsyncRequestWithBlock:^id(TOSMBSessionOperationContext *context, NSError **error) {
+        if ([weakSelf moveItemAtSMBPath:fromPath toSMBPath:toPath context:context error:error] == NO) {
+            if (error && *error == nil) {
+                *error = errorForErrorCode(TOSMBSessionErrorCodeUnableToMoveFile);
             }
+            return nil;
         }
-        
-    };
-    return [self addRequestOperation:operation withBlock:operationBlock];
+        return [weakSelf itemAttributesAtSMBPath:toPath context:context error:NULL];
+    } idempotent:NO success:successHandler error:errorHandler];
 }
 
 #pragma mark - Create Directory -
 
 - (BOOL)createDirectoryAtPath:(NSString *)path error:(NSError **)error{
+    return [self createDirectoryAtSMBPath:[TOSMBPath pathWithString:path] error:error];
+}
+
+- (BOOL)createDirectoryAtSMBPath:(TOSMBPath *)path error:(NSError **)error{
     
     NSError *resultError = [self attemptConnection];
     if (error && resultError){
@@ -716,89 +854,86 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
         return NO;
     }
     
-    if (path.length == 0 || [path isEqualToString:@"/"]) {
+    //Connect to the share and create the directory in one pass
+    __block BOOL created = NO;
+    __block NSError *createError = nil;
+    [self performSMBOperation:^(TOSMBSessionOperationContext *context) {
+        NSError *contextError = nil;
+        created = [self createDirectoryAtSMBPath:path context:context error:&contextError];
+        createError = contextError;
+    }];
+    
+    if (error && createError) {
+        *error = createError;
+    }
+    
+    return created;
+}
+
+- (BOOL)createDirectoryAtSMBPath:(TOSMBPath *)path
+                         context:(TOSMBSessionOperationContext *)context
+                           error:(NSError **)error
+{
+    if (path == nil || path.isRoot) {
         if (error) {
-            resultError = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
-            *error = resultError;
+            *error = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
         }
         return NO;
     }
     
-    //Replace any backslashes with forward slashes
-    path = [path TOSMB_stringByReplacingOccurrencesOfBackSlashWithForwardSlash];
-    
-    //Work out just the share name from the path (The first directory in the string)
-    NSString *shareName = [TOSMBSession shareNameFromPath:path];
-    
-    //Connect to that share
-    //If not, make a new connection
-    smb_tid shareID = [self connectToShareWithName:shareName error:error];
+    smb_tid shareID = [context treeIDForShareName:path.shareName];
     if (shareID == TOSMBShareIDUnknown) {
+        if (error) {
+            *error = errorForErrorCode(TOSMBSessionErrorCodeShareConnectionFailed);
+        }
         return NO;
     }
     
-    NSString *relativePath = [TOSMBSession relativeSMBPathFromPath:path];
-    const char *relativePathCString = [relativePath cStringUsingEncoding:NSUTF8StringEncoding];
-    
-    __block int result = DSM_ERROR_GENERIC;
-    [self inSMBCSession:^(smb_session *session) {
-        result = smb_directory_create(session,shareID,relativePathCString);
-    }];
-    
+    int result = smb_directory_create(context.session, shareID, path.relativeSMBPathUTF8String);
     if(result!=DSM_SUCCESS){
         if (error) {
-            resultError = errorForErrorCode(TOSMBSessionErrorCodeUnableToCreateDirectory);
-            *error = resultError;
+            *error = errorForErrorCode(TOSMBSessionErrorCodeUnableToCreateDirectory);
         }
     }
     
     return (result==DSM_SUCCESS);
-    
 }
 
 - (NSOperation *)createDirectoryAtPath:(NSString *)path
                                success:(void (^)(TOSMBSessionFile *createdDirectory))successHandler
                                  error:(void (^)(NSError *))errorHandler
 {
-    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
+    return [self createDirectoryAtSMBPath:[TOSMBPath pathWithString:path] success:successHandler error:errorHandler];
+}
+
+- (NSOperation *)createDirectoryAtSMBPath:(TOSMBPath *)path
+                                  success:(void (^)(TOSMBSessionFile *createdDirectory))successHandler
+                                    error:(void (^)(NSError *))errorHandler
+{
     TOSMBMakeWeakReference();
-    TOSMBMakeWeakReferenceForOperation();
-    
-    id operationBlock = ^{
-        
-        TOSMBCheckIfWeakReferenceForOperationIsCancelledOrNilAndReturn();
-        TOSMBCheckIfWeakReferenceIsNilAndReturn();
-        TOSMBMakeStrongFromWeakReference();
-        
-        NSError *error = nil;
-        BOOL success = [strongSelf createDirectoryAtPath:path error:&error];
-        
-        if (success==NO || error) {
-            if (errorHandler) {
-                [strongSelf performCallBackWithBlock:^{ if(errorHandler){errorHandler(error);} }];
-            }
-        }
-        else {
-            TOSMBSessionFile *file = [strongSelf itemAttributesAtPath:path error:&error];
-            if (successHandler) {
-                [strongSelf performCallBackWithBlock:^{ if(successHandler){successHandler(file);} }];
+    return [self addAsyncRequestWithBlock:^id(TOSMBSessionOperationContext *context, NSError **error) {
+        if ([weakSelf createDirectoryAtSMBPath:path context:context error:error] == NO) {
+            if (error && *error == nil) {
+                *error = errorForErrorCode(TOSMBSessionErrorCodeUnableToCreateDirectory);
             }
+            return nil;
         }
-    };
-    
-    return [self addRequestOperation:operation withBlock:operationBlock];
+        return [weakSelf itemAttributesAtSMBPath:path context:context error:NULL];
+    } idempotent:NO success:successHandler error:errorHandler];
 }
 
 
 #pragma mark - Delete Item -
 
 
-- (BOOL)recursiveContentOfDirectoryAtPath:(NSString *)dirPath
-                                  inShare:(smb_tid)shareID
-                                    items:(NSMutableArray **)items
-                                    error:(NSError **)error{
+- (BOOL)recursiveContentOfDirectoryAtSMBPath:(TOSMBPath *)path
+                                     inShare:(smb_tid)shareID
+                                     context:(TOSMBSessionOperationContext *)context
+                                       items:(NSMutableArray<TOSMBPath *> *)items
+                                 directories:(NSMutableSet<TOSMBPath *> *)directoryItems
+                                       error:(NSError **)error{
     
-    if (dirPath.length == 0 || [dirPath isEqualToString:@"/"]) {
+    if (path == nil || path.isRoot) {
         if (error) {
             NSError *resultError = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
             *error = resultError;
@@ -806,25 +941,14 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
         return NO;
     }
     
-    NSString *path = dirPath;
-    path = [path TOSMB_stringByReplacingOccurrencesOfBackSlashWithForwardSlash];
-    
-    NSParameterAssert([self cachedShareIDForName:[TOSMBSession shareNameFromPath:path]]==shareID);
+    NSParameterAssert([context cachedTreeIDForShareName:path.shareName]==shareID);
     
-    NSString *relativePath = [TOSMBSession relativeSMBPathFromPath:path];
-    //append double backslash if we don't have one
-    if (![[relativePath substringFromIndex:relativePath.length-1] isEqualToString:@"\\"]){
-        relativePath = [relativePath stringByAppendingString:@"\\"];
-    }
-    relativePath = [relativePath stringByAppendingString:@"*"];
-    const char *relativePathCString = [relativePath cStringUsingEncoding:NSUTF8StringEncoding];
+    const char *relativePathCString = [path pathByAppendingComponent:@"*"].relativeSMBPathUTF8String;
     
-    __block smb_stat_list statList = NULL;
-    [self inSMBCSession:^(smb_session *session) {
-        statList = smb_find(session, shareID, relativePathCString);
-    }];
+    NSMutableArray<TOSMBPath *> *directories = [[NSMutableArray alloc] init];
     
-    if(statList==NULL){
+    smb_stat_list statList = smb_find(context.session, shareID, relativePathCString);
+    if (statList == NULL) {
         if (error) {
             NSError *resultError = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
             *error = resultError;
@@ -832,44 +956,38 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
         return NO;
     }
     
-    NSMutableArray *directories = [[NSMutableArray alloc] init];
-    NSMutableArray *fileItems = [NSMutableArray new];
-    
-    [self inSMBCSession:^(smb_session *session) {
-        size_t listCount = 0;
-        listCount = smb_stat_list_count(statList);
-        if (listCount > 0){
-            for (NSInteger i = 0; i < listCount; i++) {
-                smb_stat item = smb_stat_list_at(statList, i);
-                const char* name = smb_stat_name(item);
-                NSString *itemName = [[NSString alloc] initWithBytes:name length:strlen(name) encoding:NSUTF8StringEncoding];
-                if([itemName isEqualToString:@"."] || [itemName isEqualToString:@".."]){
-                    continue;
-                }
-                TOSMBSessionFile *file = [[TOSMBSessionFile alloc] initWithStat:item parentDirectoryPath:path];
-                if(file){
-                    if(file.directory){
-                        [directories addObject:file];
-                    }
-                    else{
-                        [fileItems addObject:file];
-                    }
-                }
-            }
+    size_t listCount = 0;
+    listCount = smb_stat_list_count(statList);
+    for (NSInteger i = 0; i < listCount; i++) {
+        smb_stat item = smb_stat_list_at(statList, i);
+        const char* name = smb_stat_name(item);
+        if(name == NULL || strcmp(name, ".") == 0 || strcmp(name, "..") == 0){
+            continue;
+        }
+        NSString *itemName = [[NSString alloc] initWithBytes:name length:strlen(name) encoding:NSUTF8StringEncoding];
+        if(itemName.length == 0){
+            continue;
+        }
+        TOSMBPath *itemPath = [path pathByAppendingComponent:itemName];
+        if(smb_stat_get(item, SMB_STAT_ISDIR) != 0){
+            [directories addObject:itemPath];
+        }
+        else{
+            [items addObject:itemPath];
         }
-        smb_stat_list_destroy(statList);
-    }];
-    
-    if(items){
-        [*items addObjectsFromArray:fileItems];
-        [*items addObjectsFromArray:directories];
     }
-    
-    for(TOSMBSessionFile *dir in directories){
-        BOOL result = [self recursiveContentOfDirectoryAtPath:dir.fullPath
-                                                      inShare:shareID
-                                                        items:items
-                                                        error:error];
+    smb_stat_list_destroy(statList);
+    
+    [items addObjectsFromArray:directories];
+    [directoryItems addObjectsFromArray:directories];
+    
+    for(TOSMBPath *dir in directories){
+        BOOL result = [self recursiveContentOfDirectoryAtSMBPath:dir
+                                                         inShare:shareID
+                                                         context:context
+                                                           items:items
+                                                     directories:directoryItems
+                                                           error:error];
         if(result==NO){
             return NO;
         }
@@ -878,12 +996,13 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
     return YES;
 }
 
-- (BOOL)deleteDirectoryAtPath:(NSString *)dirPath
-                      inShare:(smb_tid)shareID
-                        error:(NSError **)error
+- (BOOL)deleteDirectoryAtSMBPath:(TOSMBPath *)path
+                         inShare:(smb_tid)shareID
+                         context:(TOSMBSessionOperationContext *)context
+                           error:(NSError **)error
 {
     
-    if (dirPath.length == 0 || [dirPath isEqualToString:@"/"]) {
+    if (path == nil || path.isRoot) {
         if (error) {
             NSError *resultError = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
             *error = resultError;
@@ -891,18 +1010,9 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
         return NO;
     }
     
-    NSString *path = dirPath;
-    path = [path TOSMB_stringByReplacingOccurrencesOfBackSlashWithForwardSlash];
-    
-    NSParameterAssert([self cachedShareIDForName:[TOSMBSession shareNameFromPath:path]]==shareID);
+    NSParameterAssert([context cachedTreeIDForShareName:path.shareName]==shareID);
     
-    NSString *relativePath = [TOSMBSession relativeSMBPathFromPath:path];
-    const char *relativePathCString = [relativePath cStringUsingEncoding:NSUTF8StringEncoding];
-    
-    __block int result = DSM_ERROR_GENERIC;
-    [self inSMBCSession:^(smb_session *session) {
-        result = smb_directory_rm(session, shareID, relativePathCString);
-    }];
+    int result = smb_directory_rm(context.session, shareID, path.relativeSMBPathUTF8String);
     
     if(result!=DSM_SUCCESS){
         if (error) {
@@ -913,9 +1023,13 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
     return (result==DSM_SUCCESS);
 }
 
-- (BOOL)deleteFileAtPath:(NSString *)filePath inShare:(smb_tid)shareID error:(NSError **)error{
+- (BOOL)deleteFileAtSMBPath:(TOSMBPath *)path
+                    inShare:(smb_tid)shareID
+                    context:(TOSMBSessionOperationContext *)context
+                      error:(NSError **)error
+{
     
-    if (filePath.length == 0 || [filePath isEqualToString:@"/"]) {
+    if (path == nil || path.isRoot) {
         if (error) {
             NSError *resultError = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
             *error = resultError;
@@ -923,18 +1037,9 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
         return NO;
     }
     
-    NSString *path = filePath;
-    path = [path TOSMB_stringByReplacingOccurrencesOfBackSlashWithForwardSlash];
-    
-    NSParameterAssert([self cachedShareIDForName:[TOSMBSession shareNameFromPath:path]]==shareID);
-    
-    NSString *relativePath = [TOSMBSession relativeSMBPathFromPath:path];
-    const char *relativePathCString = [relativePath cStringUsingEncoding:NSUTF8StringEncoding];
+    NSParameterAssert([context cachedTreeIDForShareName:path.shareName]==shareID);
     
-    __block int result = DSM_ERROR_GENERIC;
-    [self inSMBCSession:^(smb_session *session) {
-        result = smb_file_rm(session, shareID, relativePathCString);
-    }];
+    int result = smb_file_rm(context.session, shareID, path.relativeSMBPathUTF8String);
     
     if(result!=DSM_SUCCESS){
         if (error) {
@@ -947,9 +1052,12 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
 }
 
 - (BOOL)deleteItemAtPath:(NSString *)path error:(NSError **)error{
+    return [self deleteItemAtSMBPath:[TOSMBPath pathWithString:path] error:error];
+}
+
+- (BOOL)deleteItemAtSMBPath:(TOSMBPath *)path error:(NSError **)error{
     
     NSError *resultError = [self attemptConnection];
-    int result = -1;
     if (error && resultError){
         *error = resultError;
     }
@@ -958,139 +1066,200 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
         return NO;
     }
     
-    if (path.length == 0 || [path isEqualToString:@"/"]) {
+    //Connect to the share, walk the directory and delete everything in it in one pass
+    __block BOOL deleted = NO;
+    __block NSError *deleteError = nil;
+    [self performSMBOperation:^(TOSMBSessionOperationContext *context) {
+        NSError *contextError = nil;
+        deleted = [self deleteItemAtSMBPath:path context:context error:&contextError];
+        deleteError = contextError;
+    }];
+    
+    if (error && deleteError) {
+        *error = deleteError;
+    }
+    
+    return deleted;
+}
+
+- (BOOL)deleteItemAtSMBPath:(TOSMBPath *)path
+                    context:(TOSMBSessionOperationContext *)context
+                      error:(NSError **)error
+{
+    
+    if (path == nil || path.isRoot) {
         if (error) {
-            resultError = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
-            *error = resultError;
+            *error = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
         }
         return NO;
     }
     
-    //Replace any backslashes with forward slashes
-    path = [path TOSMB_stringByReplacingOccurrencesOfBackSlashWithForwardSlash];
+    const char *relativePathCString = path.relativeSMBPathUTF8String;
     
-    //Work out just the share name from the path (The first directory in the string)
-    NSString *shareName = [TOSMBSession shareNameFromPath:path];
-    
-    //Connect to that share
-    //If not, make a new connection
-    smb_tid shareID = [self connectToShareWithName:shareName error:error];
+    smb_tid shareID = [context treeIDForShareName:path.shareName];
     if (shareID == TOSMBShareIDUnknown) {
+        if (error) {
+            *error = errorForErrorCode(TOSMBSessionErrorCodeShareConnectionFailed);
+        }
         return NO;
     }
     
-    NSString *relativePath = [TOSMBSession relativeSMBPathFromPath:path];
-    const char *relativePathCString = [relativePath cStringUsingEncoding:NSUTF8StringEncoding];
-    
-    __block smb_stat stat = NULL;
-    [self inSMBCSession:^(smb_session *session) {
-        stat = smb_fstat(session, shareID, relativePathCString);
-    }];
-    
+    smb_stat stat = smb_fstat(context.session, shareID, relativePathCString);
     if (stat == NULL) {
         if (error) {
-            resultError = errorForErrorCode(TOSMBSessionErrorCodeFileNotFound);
-            *error = resultError;
+            *error = errorForErrorCode(TOSMBSessionErrorCodeFileNotFound);
         }
+        return NO;
     }
-    else{
-        __block BOOL directory = NO;
-        [self inSMBCSession:^(smb_session *session) {
-            directory = (smb_stat_get(stat, SMB_STAT_ISDIR) != 0);
-            smb_stat_destroy(stat);
-        }];
+    const BOOL directory = (smb_stat_get(stat, SMB_STAT_ISDIR) != 0);
+    smb_stat_destroy(stat);
+    
+    BOOL deleted = NO;
+    if(directory){
         
-        if(directory){
-            
-            NSMutableArray *childItems = [[NSMutableArray alloc] init];
-            BOOL fetchResultSuccess = [self recursiveContentOfDirectoryAtPath:path inShare:shareID items:&childItems error:nil];
-            
-            if(fetchResultSuccess){
-                if(childItems.count>0){
-                    for(NSInteger index = childItems.count-1;index>=0;index--){
-                        TOSMBSessionFile *file = [childItems objectAtIndex:index];
-                        BOOL success = NO;
-                        if(file.directory){
-                            success = [self deleteDirectoryAtPath:file.fullPath inShare:shareID error:nil];
-                        }
-                        else{
-                            success = [self deleteFileAtPath:file.fullPath inShare:shareID error:nil];
-                        }
-                        if(success==NO){
-                            break;
-                        }
-                    }
+        NSMutableArray<TOSMBPath *> *childItems = [[NSMutableArray alloc] init];
+        NSMutableSet<TOSMBPath *> *childDirectories = [[NSMutableSet alloc] init];
+        BOOL fetchResultSuccess = [self recursiveContentOfDirectoryAtSMBPath:path
+                                                                     inShare:shareID
+                                                                     context:context
+                                                                       items:childItems
+                                                                 directories:childDirectories
+                                                                       error:nil];
+        
+        if(fetchResultSuccess){
+            for(NSInteger index = childItems.count-1;index>=0;index--){
+                TOSMBPath *itemPath = [childItems objectAtIndex:index];
+                BOOL success = NO;
+                if([childDirectories containsObject:itemPath]){
+                    success = [self deleteDirectoryAtSMBPath:itemPath inShare:shareID context:context error:nil];
+                }
+                else{
+                    success = [self deleteFileAtSMBPath:itemPath inShare:shareID context:context error:nil];
+                }
+                if(success==NO){
+                    break;
                 }
-                result = ([self deleteDirectoryAtPath:path inShare:shareID error:error]?0:-1);
-            }
-            else{
-                result = -1;
             }
-            
-        }
-        else{
-            result = ([self deleteFileAtPath:path inShare:shareID error:error]?0:-1);
+            deleted = [self deleteDirectoryAtSMBPath:path inShare:shareID context:context error:error];
         }
         
-        if(result!=0){
-            
-            //double check
-            __block smb_stat stat = NULL;
-            [self inSMBCSession:^(smb_session *session) {
-                stat = smb_fstat(session, shareID, relativePathCString);
-            }];
-            
-            if(stat==NULL){
-                if(error){
-                    *error = nil;
-                }
-                result = 0;
-            }
-            else{
-                [self inSMBCSession:^(smb_session *session) {
-                    smb_stat_destroy(stat);
-                }];
-                if (error) {
-                    resultError = errorForErrorCode(TOSMBSessionErrorCodeUnableToDeleteItem);
-                    *error = resultError;
-                }
+    }
+    else{
+        deleted = [self deleteFileAtSMBPath:path inShare:shareID context:context error:error];
+    }
+    
+    if(deleted==NO){
+        
+        //double check
+        stat = smb_fstat(context.session, shareID, relativePathCString);
+        if (stat == NULL) {
+            if(error){
+                *error = nil;
             }
+            return YES;
+        }
+        smb_stat_destroy(stat);
+        
+        if (error) {
+            *error = errorForErrorCode(TOSMBSessionErrorCodeUnableToDeleteItem);
         }
     }
     
-    return (result==0);
+    return deleted;
 }
 
 - (NSOperation *)deleteItemAtPath:(NSString *)path
                           success:(void (^)(void))successHandler
                             error:(void (^)(NSError *))errorHandler
 {
-    
-    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
+    return [self deleteItemAtSMBPath:[TOSMBPath pathWithString:path] success:successHandler error:errorHandler];
+}
+
+- (NSOperation *)deleteItemAtSMBPath:(TOSMBPath *)path
+                             success:(void (^)(void))successHandler
+                               error:(void (^)(NSError *))errorHandler
+{
     TOSMBMakeWeakReference();
-    TOSMBMakeWeakReferenceForOperation();
-    
-    id operationBlock = ^{
-        TOSMBCheckIfWeakReferenceForOperationIsCancelledOrNilAndReturn();
-        TOSMBCheckIfWeakReferenceIsNilAndReturn();
-        TOSMBMakeStrongFromWeakReference();
-        
-        NSError *error = nil;
-        BOOL success = [strongSelf deleteItemAtPath:path error:&error];
-        
-        if (success==NO) {
-            if (errorHandler) {
-                [strongSelf performCallBackWithBlock:^{ if(errorHandler){errorHandler(error);} }];
+    return [self addAsyncRequestWithBlock:^id(TOSMBSessionOperationContext *context, NSError **error) {
+        if ([weakSelf deleteItemAtSMBPath:path context:context error:error] == NO) {
+            if (error && *error == nil) {
+                *error = errorForErrorCode(TOSMBSessionErrorCodeUnableToDeleteItem);
             }
+            return nil;
         }
-        else {
-            if (successHandler) {
-                [strongSelf performCallBackWithBlock:^{ if(successHandler){successHandler();} }];
-            }
+        return @YES;
+    } idempotent:NO success:^(id result) {
+        if (successHandler) {
+            successHandler();
         }
-    };
-    
-    return [self addRequestOperation:operation withBlock:operationBlock];
+    } error:errorHandler];
+}
+
+- (TOSMBSessionDownloadTask *)downloadTaskForFileAtSMBPath:(TOSMBPath *)path
+                                           destinationPath:(NSString *)destinationPath
+                                                  delegate:(id<TOSMBSessionDownloadTaskDelegate>)delegate
+{
+    TOSMBSessionDownloadTask *task = [self downloadTaskForFileAtPath:path.string
+                                                     destinationPath:destinationPath
+                                                            delegate:delegate];
+    task.remotePath = path;
+    return task;
+}
+
+- (TOSMBSessionDownloadTask *)downloadTaskForFileAtSMBPath:(TOSMBPath *)path
+                                           destinationPath:(NSString *)destinationPath
+                                           progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                         completionHandler:(void (^)(NSString *filePath))completionHandler
+                                               failHandler:(void (^)(NSError *error))failHandler{
+    TOSMBSessionDownloadTask *task = [self downloadTaskForFileAtPath:path.string
+                                                     destinationPath:destinationPath
+                                                     progressHandler:progressHandler
+                                                   completionHandler:completionHandler
+                                                         failHandler:failHandler];
+    task.remotePath = path;
+    return task;
+}
+
+- (TOSMBSessionDownloadTask *)dataTaskForFileAtSMBPath:(TOSMBPath *)path
+                                       progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                     completionHandler:(void (^)(NSData *data))completionHandler
+                                           failHandler:(void (^)(NSError *error))failHandler{
+    TOSMBSessionDownloadTask *task = [self dataTaskForFileAtPath:path.string
+                                                 progressHandler:progressHandler
+                                               completionHandler:completionHandler
+                                                     failHandler:failHandler];
+    task.remotePath = path;
+    return task;
+}
+
+- (TOSMBSessionDownloadTask *)downloadTaskForFileAtSMBPath:(TOSMBPath *)path
+                                                  toBuffer:(void *)buffer
+                                                    length:(NSUInteger)length
+                                           progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                         completionHandler:(void (^)(uint64_t length))completionHandler
+                                               failHandler:(void (^)(NSError *error))failHandler{
+    TOSMBSessionDownloadTask *task = [self downloadTaskForFileAtPath:path.string
+                                                            toBuffer:buffer
+                                                              length:length
+                                                     progressHandler:progressHandler
+                                                   completionHandler:completionHandler
+                                                         failHandler:failHandler];
+    task.remotePath = path;
+    return task;
+}
+
+- (TOSMBSessionDownloadTask *)downloadTaskForFileAtSMBPath:(TOSMBPath *)path
+                                                    toSink:(id<TOSMBSessionDownloadSink>)sink
+                                           progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                         completionHandler:(void (^)(uint64_t length))completionHandler
+                                               failHandler:(void (^)(NSError *error))failHandler{
+    TOSMBSessionDownloadTask *task = [self downloadTaskForFileAtPath:path.string
+                                                              toSink:sink
+                                                     progressHandler:progressHandler
+                                                   completionHandler:completionHandler
+                                                         failHandler:failHandler];
+    task.remotePath = path;
+    return task;
 }
 
 #pragma mark - Upload Task -
@@ -1109,6 +1278,20 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
     return task;
 }
 
+- (TOSMBSessionUploadTask *)uploadTaskForFileAtPath:(NSString *)path
+                                 destinationSMBPath:(TOSMBPath *)destinationPath
+                                    progressHandler:(void (^)(uint64_t totalBytesWritten, uint64_t totalBytesExpected))progressHandler
+                                  completionHandler:(void (^)(NSString *filePath))completionHandler
+                                        failHandler:(void (^)(NSError *error))errorHandler{
+    TOSMBSessionUploadTask *task = [self uploadTaskForFileAtPath:path
+                                                 destinationPath:destinationPath.string
+                                                 progressHandler:progressHandler
+                                               completionHandler:completionHandler
+                                                     failHandler:errorHandler];
+    task.remotePath = destinationPath;
+    return task;
+}
+
 #pragma mark - Concurrency Management -
 
 - (void)performCallBackWithBlock:(void(^)(void))block{
@@ -1151,6 +1334,7 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
         } @catch (NSException *exception) {}
     };
     [operation addExecutionBlock:operationBlockWrapped];
+    [self prefetchHostResolutionIfNeeded];
     [self.requestsQueue addOperation:operation];
     return operation;
 }
@@ -1159,6 +1343,246 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
     [self.requestsQueue cancelAllOperations];
 }
 
+#pragma mark - Completion-Based Core -
+
+- (void)performAsyncSMBOperation:(void (^)(TOSMBSessionOperationContext *context, NSError *error))block{
+    NSParameterAssert(block);
+    if (block == nil) {
+        return;
+    }
+    
+    TOSMBMakeWeakReference();
+    void (^connectAndPerform)(void) = ^{
+        TOSMBMakeStrongFromWeakReference();
+        if (strongSelf == nil) {
+            block(nil, errorForErrorCode(TOSMBSessionErrorCodeCancelled));
+            return;
+        }
+        //Connecting blocks, so it is done off the I/O queue, one connection attempt at a time
+        dispatch_async(strongSelf.connectionQueue, ^{
+            NSError *error = [strongSelf attemptConnection];
+            if (strongSelf.connected == NO) {
+                block(nil, error ?: errorForErrorCode(TOSMBSessionErrorCodeUnableToConnect));
+                return;
+            }
+            [[strongSelf currentSMBSessionWrapper] performAsyncOperation:^(TOSMBSessionOperationContext *context) {
+                block(context, context ? nil : errorForErrorCode(TOSMBSessionErrorCodeUnableToConnect));
+            }];
+        });
+    };
+    
+    TOSMBCSessionWrapper *smbSessionWrapper = [self currentSMBSessionWrapper];
+    if (smbSessionWrapper == nil) {
+        connectAndPerform();
+        return;
+    }
+    
+    [smbSessionWrapper performAsyncOperation:^(TOSMBSessionOperationContext *context) {
+        //Logged in and not timed out, so the request runs straight away on the I/O queue
+        NSDate *lastRequestDate = smbSessionWrapper.lastRequestDate;
+        const BOOL timedOut = lastRequestDate && [[NSDate date] timeIntervalSinceDate:lastRequestDate] > kTOSMBSessionTimeout;
+        if (context && timedOut == NO && smb_session_is_guest(context.session) >= 0) {
+            smbSessionWrapper.lastRequestDate = [NSDate date];
+            block(context, nil);
+            return;
+        }
+        connectAndPerform();
+    }];
+}
+
+- (NSOperation *)addAsyncRequestWithBlock:(id (^)(TOSMBSessionOperationContext *context, NSError **error))requestBlock
+                               idempotent:(BOOL)idempotent
+                                  success:(void (^)(id result))successHandler
+                                    error:(void (^)(NSError *error))errorHandler
+{
+    NSParameterAssert(requestBlock);
+    if (requestBlock == nil) {
+        return nil;
+    }
+    
+    TOSMBMakeWeakReference();
+    TOSMBSessionAsyncOperation *operation = [[TOSMBSessionAsyncOperation alloc] initWithBlock:^(TOSMBSessionAsyncOperation *asyncOperation) {
+        TOSMBMakeStrongFromWeakReference();
+        if (strongSelf == nil) {
+            [asyncOperation finish];
+            return;
+        }
+        [strongSelf performAsyncRequest:requestBlock
+                             idempotent:idempotent
+                                attempt:0
+                              operation:asyncOperation
+                                success:successHandler
+                                  error:errorHandler];
+    }];
+    
+    [self prefetchHostResolutionIfNeeded];
+    [self.requestsQueue addOperation:operation];
+    return operation;
+}
+
+- (void)performAsyncRequest:(id (^)(TOSMBSessionOperationContext *context, NSError **error))requestBlock
+                 idempotent:(BOOL)idempotent
+                    attempt:(NSUInteger)attempt
+                  operation:(TOSMBSessionAsyncOperation *)asyncOperation
+                    success:(void (^)(id result))successHandler
+                      error:(void (^)(NSError *error))errorHandler
+{
+    TOSMBMakeWeakReference();
+    [self performAsyncSMBOperation:^(TOSMBSessionOperationContext *context, NSError *error) {
+        TOSMBMakeStrongFromWeakReference();
+        if (asyncOperation.isCancelled || strongSelf == nil) {
+            [asyncOperation finish];
+            return;
+        }
+        
+        NSError *requestError = error;
+        id result = nil;
+        if (context) {
+            @try {
+                result = requestBlock(context, &requestError);
+            } @catch (NSException *exception) {
+                requestError = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
+            }
+        }
+        
+        //A failure on a dropped connection is worth going again for, once reconnected. A status
+        //error from the server isn't, and neither are rejected credentials.
+        //Request blocks always set an error when they fail, a nil result on its own is an answer.
+        TOSMBCSessionWrapper *failedWrapper = nil;
+        if (requestError && idempotent && attempt < strongSelf.maximumRetryCount) {
+            if (context == nil) {
+                failedWrapper = (error.code != TOSMBSessionErrorCodeAuthenticationFailed) ? [strongSelf currentSMBSessionWrapper] : nil;
+            }
+            else if ([context hasConnectionFailed]) {
+                failedWrapper = context.wrapper;
+            }
+        }
+        if (failedWrapper) {
+            [strongSelf retryAsyncRequest:requestBlock
+             afterFailureOfSessionWrapper:failedWrapper
+                                  attempt:attempt
+                                operation:asyncOperation
+                                  success:successHandler
+                                    error:errorHandler];
+            return;
+        }
+        
+        if (requestError) {
+            if (errorHandler) {
+                [weakSelf performCallBackWithBlock:^{ if(errorHandler){errorHandler(requestError);} }];
+            }
+        }
+        else {
+            if (successHandler) {
+                [weakSelf performCallBackWithBlock:^{ if(successHandler){successHandler(result);} }];
+            }
+        }
+        [asyncOperation finish];
+    }];
+}
+
+- (void)retryAsyncRequest:(id (^)(TOSMBSessionOperationContext *context, NSError **error))requestBlock
+afterFailureOfSessionWrapper:(TOSMBCSessionWrapper *)failedWrapper
+                  attempt:(NSUInteger)attempt
+                operation:(TOSMBSessionAsyncOperation *)asyncOperation
+                  success:(void (^)(id result))successHandler
+                    error:(void (^)(NSError *error))errorHandler
+{
+    //Wait out the backoff without holding a thread, then drop the dead connection so the next go reconnects.
+    //Another request may have replaced it in the meantime, then this one goes again on theirs.
+    const NSTimeInterval delay = [self retryDelayForAttempt:attempt];
+    TOSMBMakeWeakReference();
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), self.connectionQueue, ^{
+        TOSMBMakeStrongFromWeakReference();
+        if (strongSelf == nil || asyncOperation.isCancelled) {
+            [asyncOperation finish];
+            return;
+        }
+        [strongSelf.connectionLock lock];
+        const BOOL replaced = [strongSelf replaceFailedSessionWrapper:failedWrapper];
+        NSError *error = [strongSelf attemptConnection];
+        [strongSelf.connectionLock unlock];
+        if (replaced) {
+            [strongSelf.retryMetrics countReconnectAttemptAfterBackoff:delay succeeded:(error == nil && strongSelf.connected)];
+        }
+        [strongSelf.retryMetrics countRetriedRequest];
+        [strongSelf performAsyncRequest:requestBlock
+                             idempotent:YES
+                                attempt:attempt + 1
+                              operation:asyncOperation
+                                success:successHandler
+                                  error:errorHandler];
+    });
+}
+
+#pragma mark - Retries -
+
+- (NSTimeInterval)retryDelayForAttempt:(NSUInteger)attempt{
+    NSTimeInterval delay = self.retryDelay * pow(2.0, (double)MIN(attempt, (NSUInteger)16));
+    delay = MIN(delay, self.maximumRetryDelay);
+    //Up to a quarter more, so sessions that dropped together don't all reconnect at the same moment
+    return delay + delay * 0.25 * (arc4random_uniform(1000) / 1000.0);
+}
+
+- (BOOL)replaceFailedSessionWrapper:(TOSMBCSessionWrapper *)failedWrapper{
+    //Must be called holding the connection lock
+    if (failedWrapper == nil || [self currentSMBSessionWrapper] != failedWrapper) {
+        return NO;
+    }
+    //A connection that never came back up after a reconnect didn't drop
+    if (self.connected) {
+        [self.retryMetrics countDroppedConnection];
+    }
+    [self reloadSession];
+    self.connected = NO;
+    return YES;
+}
+
+- (BOOL)reconnectAfterFailureOfSessionWrapper:(TOSMBCSessionWrapper *)failedWrapper attempt:(NSUInteger *)attempt{
+    NSParameterAssert(attempt);
+    
+    //No wrapper means the server answered, and asking again won't change the answer
+    while (failedWrapper && *attempt < self.maximumRetryCount) {
+        //Requests running side by side see the same drop, and only the first of them reconnects.
+        //The rest go again straight away on the connection it made.
+        const BOOL alreadyReplaced = ([self currentSMBSessionWrapper] != failedWrapper);
+        const NSTimeInterval delay = alreadyReplaced ? 0.0 : [self retryDelayForAttempt:*attempt];
+        (*attempt)++;
+        [NSThread sleepForTimeInterval:delay];
+        
+        [self.connectionLock lock];
+        const BOOL replaced = [self replaceFailedSessionWrapper:failedWrapper];
+        NSError *error = [self attemptConnection];
+        const BOOL reconnected = (error == nil && self.connected);
+        TOSMBCSessionWrapper *currentWrapper = [self currentSMBSessionWrapper];
+        [self.connectionLock unlock];
+        
+        if (replaced) {
+            [self.retryMetrics countReconnectAttemptAfterBackoff:delay succeeded:reconnected];
+        }
+        if (reconnected) {
+            return YES;
+        }
+        failedWrapper = currentWrapper;
+    }
+    return NO;
+}
+
+#pragma mark - Progress Streams -
+
+- (void)addProgressStream:(TOSMBProgressStream *)stream{
+    NSParameterAssert(stream);
+    @synchronized (self.progressStreamTable) {
+        [self.progressStreamTable addObject:stream];
+    }
+}
+
+- (NSArray<TOSMBProgressStream *> *)progressStreams{
+    @synchronized (self.progressStreamTable) {
+        return self.progressStreamTable.count > 0 ? self.progressStreamTable.allObjects : nil;
+    }
+}
+
 #pragma mark - SMB Session -
 
 - (void)setLastRequestDate:(NSDate *)lastRequestDate{
@@ -1175,19 +1599,78 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
     return date;
 }
 
++ (Class)sessionWrapperClass{
+    return [TOSMBCSessionWrapper class];
+}
+
 - (void)reloadSession{
     [self.smbSessionLock lock];
-    [self.smbSessionWrapper close];
-    self.smbSessionWrapper = [[TOSMBCSessionWrapper alloc] init];
+    TOSMBCSessionWrapper *previousWrapper = self.smbSessionWrapper;
+    self.smbSessionWrapper = [[[[self class] sessionWrapperClass] alloc] init];
     [self.smbSessionLock unlock];
+    [self relinquishSMBSessionWrapper:previousWrapper invalidate:YES];
 }
 
-- (void)inSMBCSession:(void (^)(smb_session *session))block {
+- (BOOL)adoptSharedSMBSessionForKey:(NSString *)sessionKey{
+    TOSMBCSessionWrapper *sharedWrapper = [[TOSMBCSessionRegistry sharedRegistry] checkoutSessionForKey:sessionKey];
+    if (sharedWrapper == nil) {
+        return NO;
+    }
+    [self.smbSessionLock lock];
+    TOSMBCSessionWrapper *previousWrapper = self.smbSessionWrapper;
+    self.smbSessionWrapper = sharedWrapper;
+    [self.smbSessionLock unlock];
+    //If we were already holding this session, this drops the extra reference from the checkout
+    [self relinquishSMBSessionWrapper:previousWrapper invalidate:NO];
+    return YES;
+}
+
+- (void)shareSMBSession{
+    [self.smbSessionLock lock];
+    TOSMBCSessionWrapper *smbSessionWrapper = self.smbSessionWrapper;
+    [self.smbSessionLock unlock];
+    if (smbSessionWrapper == nil) {
+        return;
+    }
+    //Someone else may have logged in to the same server while we were connecting; use theirs.
+    //Connecting holds the connection lock, so no request of this session can be using ours yet.
+    TOSMBCSessionWrapper *registeredWrapper = [[TOSMBCSessionRegistry sharedRegistry] registerSession:smbSessionWrapper];
+    if (registeredWrapper != smbSessionWrapper) {
+        [self.smbSessionLock lock];
+        self.smbSessionWrapper = registeredWrapper;
+        [self.smbSessionLock unlock];
+        [smbSessionWrapper close];
+    }
+}
+
+- (void)relinquishSMBSessionWrapper:(TOSMBCSessionWrapper *)smbSessionWrapper invalidate:(BOOL)invalidate{
+    if (smbSessionWrapper == nil) {
+        return;
+    }
+    TOSMBCSessionRegistry *registry = [TOSMBCSessionRegistry sharedRegistry];
+    if (invalidate) {
+        [registry invalidateSession:smbSessionWrapper];
+    }
+    //Sessions the registry doesn't know about are ours alone to close
+    if ([registry releaseSession:smbSessionWrapper] == NO) {
+        [smbSessionWrapper close];
+    }
+}
+
+- (TOSMBCSessionWrapper *)currentSMBSessionWrapper{
     TOSMBCSessionWrapper *smbSessionWrapper = nil;
     [self.smbSessionLock lock];
     smbSessionWrapper = self.smbSessionWrapper;
     [self.smbSessionLock unlock];
-    [smbSessionWrapper inSMBCSession:block];
+    return smbSessionWrapper;
+}
+
+- (void)inSMBCSession:(void (^)(smb_session *session))block {
+    [[self currentSMBSessionWrapper] inSMBCSession:block];
+}
+
+- (void)performSMBOperation:(void (^)(TOSMBSessionOperationContext *context))block {
+    [[self currentSMBSessionWrapper] performOperation:block];
 }
 
 - (smb_tid)cachedShareIDForName:(NSString *)shareName{
@@ -1213,9 +1696,10 @@ const NSTimeInterval kTOSMBSessionTimeout = 30.0;
 
 - (void)closeSMBSession {
     [self.smbSessionLock lock];
-    [self.smbSessionWrapper close];
+    TOSMBCSessionWrapper *previousWrapper = self.smbSessionWrapper;
     self.smbSessionWrapper = nil;
     [self.smbSessionLock unlock];
+    [self relinquishSMBSessionWrapper:previousWrapper invalidate:NO];
 }
 
 - (void)updateSMBSessionUserName:(NSString *)userName
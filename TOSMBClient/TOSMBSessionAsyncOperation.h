@@ -0,0 +1,28 @@
+//
+//  TOSMBSessionAsyncOperation.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A request queue operation that hands its work off and stays executing, without holding a thread,
+ until it is told the work has finished. Used for requests that run on a connection's queue through
+ the completion-based core, so a queue full of waiting requests doesn't park a thread for each.
+ */
+@interface TOSMBSessionAsyncOperation : NSOperation
+
+/* Called once from `start` unless the operation was cancelled first. Must lead to `finish` being called. */
+- (instancetype)initWithBlock:(void (^)(TOSMBSessionAsyncOperation *operation))block;
+
+/* Marks the operation finished. Safe to call from any thread, more than once. */
+- (void)finish;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,88 @@
+//
+//  TOSMBSessionAsyncOperation.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBSessionAsyncOperation.h"
+
+@interface TOSMBSessionAsyncOperation ()
+
+@property (atomic, copy) void (^block)(TOSMBSessionAsyncOperation *operation);
+
+@end
+
+@implementation TOSMBSessionAsyncOperation {
+    BOOL _executing;
+    BOOL _finished;
+    BOOL _finishing;
+}
+
+- (instancetype)initWithBlock:(void (^)(TOSMBSessionAsyncOperation *operation))block{
+    NSParameterAssert(block);
+    if (self = [super init]) {
+        self.block = block;
+    }
+    return self;
+}
+
+- (BOOL)isAsynchronous{
+    return YES;
+}
+
+- (BOOL)isExecuting{
+    @synchronized (self) {
+        return _executing;
+    }
+}
+
+- (BOOL)isFinished{
+    @synchronized (self) {
+        return _finished;
+    }
+}
+
+- (void)start{
+    if (self.isCancelled) {
+        [self finish];
+        return;
+    }
+    
+    [self willChangeValueForKey:@"isExecuting"];
+    @synchronized (self) {
+        _executing = YES;
+    }
+    [self didChangeValueForKey:@"isExecuting"];
+    
+    void (^block)(TOSMBSessionAsyncOperation *operation) = self.block;
+    self.block = nil;
+    @try {
+        block(self);
+    } @catch (NSException *exception) {
+        [self finish];
+    }
+}
+
+- (void)finish{
+    @synchronized (self) {
+        if (_finishing) {
+            return;
+        }
+        _finishing = YES;
+    }
+    //The block may hold the last reference to whoever would call finish again
+    self.block = nil;
+    
+    [self willChangeValueForKey:@"isExecuting"];
+    [self willChangeValueForKey:@"isFinished"];
+    @synchronized (self) {
+        _executing = NO;
+        _finished = YES;
+    }
+    [self didChangeValueForKey:@"isFinished"];
+    [self didChangeValueForKey:@"isExecuting"];
+}
+
+@end
@@ -25,6 +25,49 @@
 
 @class TOSMBSessionDownloadTask;
 
+typedef void(^TOSMBSessionDownloadTaskDataHandler)(NSData *data);
+typedef void(^TOSMBSessionDownloadTaskLengthHandler)(uint64_t length);
+
+/**
+ Receives the contents of a file as it is downloaded, in place of a file on disk.
+ 
+ Chunks are handed over one at a time, on a background queue, and the next chunk isn't read from the
+ device until the completion handler of the last one has been called. A slow consumer therefore
+ slows the download down instead of having data pile up in memory.
+ */
+@protocol TOSMBSessionDownloadSink <NSObject>
+
+/**
+ Called with each chunk of the file, in order.
+ 
+ @param downloadTask The download task object calling this method.
+ @param data The next bytes of the file.
+ @param completionHandler Must be called exactly once, from any thread, when the sink is ready for more. Pass an error to stop the download.
+ */
+- (void)downloadTask:(TOSMBSessionDownloadTask *)downloadTask
+      didReceiveData:(NSData *)data
+   completionHandler:(void (^)(NSError *error))completionHandler;
+
+@optional
+
+/**
+ Called once before the first chunk.
+ 
+ @param downloadTask The download task object calling this method.
+ @param length The number of bytes expected.
+ */
+- (void)downloadTask:(TOSMBSessionDownloadTask *)downloadTask willReceiveDataOfLength:(uint64_t)length;
+
+/**
+ Called once the download has ended, on the session's callback queue.
+ 
+ @param downloadTask The download task object calling this method.
+ @param error Nil if every byte was delivered, or the reason the download failed.
+ */
+- (void)downloadTask:(TOSMBSessionDownloadTask *)downloadTask didCompleteWithError:(NSError *)error;
+
+@end
+
 @protocol TOSMBSessionDownloadTaskDelegate <NSObject>
 
 @optional
@@ -98,5 +141,39 @@ totalBytesExpectedToReceive:(uint64_t)totalBytesToReceive;
                  successHandler:(TOSMBSessionTransferTaskSuccessHandler)successHandler
                     failHandler:(TOSMBSessionTransferTaskFailHandler)failHandler;
 
+/**
+ Downloads the file into memory, without touching the disk. The data is read straight into one
+ allocation sized from the file's attributes.
+ */
+- (instancetype)initWithSession:(TOSMBSession *)session
+                       filePath:(NSString *)filePath
+                progressHandler:(TOSMBSessionTransferTaskProgressHandler)progressHandler
+                    dataHandler:(TOSMBSessionDownloadTaskDataHandler)dataHandler
+                    failHandler:(TOSMBSessionTransferTaskFailHandler)failHandler;
+
+/**
+ Downloads the file into a buffer owned by the caller, which must stay valid until the task ends.
+ The task fails with `TOSMBSessionErrorCodeBufferTooSmall` if the file doesn't fit.
+ The length handler is called with the number of bytes written to the buffer.
+ */
+- (instancetype)initWithSession:(TOSMBSession *)session
+                       filePath:(NSString *)filePath
+                         buffer:(void *)buffer
+                         length:(NSUInteger)length
+                progressHandler:(TOSMBSessionTransferTaskProgressHandler)progressHandler
+                  lengthHandler:(TOSMBSessionDownloadTaskLengthHandler)lengthHandler
+                    failHandler:(TOSMBSessionTransferTaskFailHandler)failHandler;
+
+/**
+ Streams the file to a sink, without touching the disk.
+ The length handler is called with the number of bytes delivered to the sink.
+ */
+- (instancetype)initWithSession:(TOSMBSession *)session
+                       filePath:(NSString *)filePath
+                           sink:(id<TOSMBSessionDownloadSink>)sink
+                progressHandler:(TOSMBSessionTransferTaskProgressHandler)progressHandler
+                  lengthHandler:(TOSMBSessionDownloadTaskLengthHandler)lengthHandler
+                    failHandler:(TOSMBSessionTransferTaskFailHandler)failHandler;
+
 @end
 
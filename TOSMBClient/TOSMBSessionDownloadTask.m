@@ -23,8 +23,18 @@
 #import "TOSMBSessionDownloadTask.h"
 #import "TOSMBSessionTransferTask+Private.h"
 
+/* Where the downloaded bytes go */
+typedef NS_ENUM(NSInteger, TOSMBSessionDownloadDestination) {
+    TOSMBSessionDownloadDestinationFile,
+    TOSMBSessionDownloadDestinationData,
+    TOSMBSessionDownloadDestinationBuffer,
+    TOSMBSessionDownloadDestinationSink
+};
+
 @interface TOSMBSessionDownloadTask ()
 
+@property (nonatomic, assign) TOSMBSessionDownloadDestination destination;
+
 @property (nonatomic, copy) NSString *tempFilePath;
 @property (nonatomic, strong) NSMutableData *callbackData;
 
@@ -33,6 +43,20 @@
 @property (nonatomic, assign) int64_t countOfBytesReceived;
 @property (nonatomic, assign) int64_t countOfBytesExpectedToReceive;
 
+/* Where the digested bytes start in the file on the device */
+@property (nonatomic, assign) uint64_t digestStartOffset;
+
+/* In-memory destinations. Chunks are read straight into the data or the caller's buffer. */
+@property (nonatomic, strong) NSMutableData *receivedData;
+@property (nonatomic, assign) void *buffer;
+@property (nonatomic, assign) NSUInteger bufferLength;
+@property (nonatomic, assign) NSUInteger bufferedLength;
+
+@property (nonatomic, strong) id<TOSMBSessionDownloadSink> sink;
+
+@property (nonatomic, copy) TOSMBSessionDownloadTaskDataHandler dataHandler;
+@property (nonatomic, copy) TOSMBSessionDownloadTaskLengthHandler lengthHandler;
+
 @end
 
 @implementation TOSMBSessionDownloadTask
@@ -51,6 +75,7 @@
     if (self = [super init]) {
         self.session = session;
         self.sourceFilePath = [filePath copy];
+        self.remotePath = [TOSMBPath pathWithString:filePath];
         self.destinationFilePath = destinationPath.length ? [destinationPath copy] : [self documentsDirectory];
         self.delegate = delegate;
         self.seekOffset = NSNotFound;
@@ -69,6 +94,7 @@
     if (self = [super init]) {
         self.session = session;
         self.sourceFilePath = [filePath copy];
+        self.remotePath = [TOSMBPath pathWithString:filePath];
         self.destinationFilePath = destinationPath.length ? [destinationPath copy] : [self documentsDirectory];
         self.progressHandler = [progressHandler copy];
         self.successHandler = [successHandler copy];
@@ -79,6 +105,70 @@
     return self;
 }
 
+- (instancetype)initWithSession:(TOSMBSession *)session
+                       filePath:(NSString *)filePath
+                progressHandler:(TOSMBSessionTransferTaskProgressHandler)progressHandler
+                    dataHandler:(TOSMBSessionDownloadTaskDataHandler)dataHandler
+                    failHandler:(TOSMBSessionTransferTaskFailHandler)failHandler
+{
+    if (self = [self initWithSession:session filePath:filePath progressHandler:progressHandler failHandler:failHandler]) {
+        self.destination = TOSMBSessionDownloadDestinationData;
+        self.dataHandler = [dataHandler copy];
+    }
+    return self;
+}
+
+- (instancetype)initWithSession:(TOSMBSession *)session
+                       filePath:(NSString *)filePath
+                         buffer:(void *)buffer
+                         length:(NSUInteger)length
+                progressHandler:(TOSMBSessionTransferTaskProgressHandler)progressHandler
+                  lengthHandler:(TOSMBSessionDownloadTaskLengthHandler)lengthHandler
+                    failHandler:(TOSMBSessionTransferTaskFailHandler)failHandler
+{
+    NSParameterAssert(buffer || length == 0);
+    if (self = [self initWithSession:session filePath:filePath progressHandler:progressHandler failHandler:failHandler]) {
+        self.destination = TOSMBSessionDownloadDestinationBuffer;
+        self.buffer = buffer;
+        self.bufferLength = length;
+        self.lengthHandler = [lengthHandler copy];
+    }
+    return self;
+}
+
+- (instancetype)initWithSession:(TOSMBSession *)session
+                       filePath:(NSString *)filePath
+                           sink:(id<TOSMBSessionDownloadSink>)sink
+                progressHandler:(TOSMBSessionTransferTaskProgressHandler)progressHandler
+                  lengthHandler:(TOSMBSessionDownloadTaskLengthHandler)lengthHandler
+                    failHandler:(TOSMBSessionTransferTaskFailHandler)failHandler
+{
+    NSParameterAssert(sink);
+    if (self = [self initWithSession:session filePath:filePath progressHandler:progressHandler failHandler:failHandler]) {
+        self.destination = TOSMBSessionDownloadDestinationSink;
+        self.sink = sink;
+        self.lengthHandler = [lengthHandler copy];
+    }
+    return self;
+}
+
+/* Shared by the destinations that don't use the disk, so no temporary file path is set up */
+- (instancetype)initWithSession:(TOSMBSession *)session
+                       filePath:(NSString *)filePath
+                progressHandler:(TOSMBSessionTransferTaskProgressHandler)progressHandler
+                    failHandler:(TOSMBSessionTransferTaskFailHandler)failHandler
+{
+    if (self = [super init]) {
+        self.session = session;
+        self.sourceFilePath = [filePath copy];
+        self.remotePath = [TOSMBPath pathWithString:filePath];
+        self.progressHandler = [progressHandler copy];
+        self.failHandler = [failHandler copy];
+        self.seekOffset = NSNotFound;
+    }
+    return self;
+}
+
 - (void)dealloc {
     [NSObject cancelPreviousPerformRequestsWithTarget:self];
 }
@@ -130,7 +220,9 @@
 - (void)cancel{
     [super cancel];
     [NSObject cancelPreviousPerformRequestsWithTarget:self];
-    @try{[[NSFileManager defaultManager] removeItemAtPath:self.tempFilePath error:nil];}@catch(NSException *exc){}
+    if (self.tempFilePath) {
+        @try{[[NSFileManager defaultManager] removeItemAtPath:self.tempFilePath error:nil];}@catch(NSException *exc){}
+    }
 }
 
 #pragma mark - Private Control Methods -
@@ -144,6 +236,7 @@
 }
 
 - (void)didSucceedWithFilePath:(NSString *)filePath{
+    [self reportProgressFinished];
     TOSMBMakeWeakReference();
     NSParameterAssert(self.session);
     [self.session performCallBackWithBlock:^{
@@ -158,12 +251,50 @@
     }];
 }
 
+/* Success for the destinations that don't end up in a file */
+- (void)didSucceedInMemory{
+    NSData *data = nil;
+    if (self.destination == TOSMBSessionDownloadDestinationData) {
+        self.receivedData.length = self.bufferedLength;
+        data = self.receivedData;
+        self.receivedData = nil;
+    }
+    const uint64_t length = self.countOfBytesReceived - self.digestStartOffset;
+    id<TOSMBSessionDownloadSink> sink = self.sink;
+    self.sink = nil;
+    [self reportProgressFinished];
+    
+    TOSMBMakeWeakReference();
+    NSParameterAssert(self.session);
+    [self.session performCallBackWithBlock:^{
+        TOSMBCheckIfWeakReferenceIsNilAndReturn();
+        TOSMBMakeStrongFromWeakReference();
+        if ([sink respondsToSelector:@selector(downloadTask:didCompleteWithError:)]){
+            [sink downloadTask:strongSelf didCompleteWithError:nil];
+        }
+        if (data && strongSelf.dataHandler){
+            strongSelf.dataHandler(data);
+        }
+        if (strongSelf.lengthHandler){
+            strongSelf.lengthHandler(length);
+        }
+    }];
+}
+
 - (void)didFailWithError:(NSError *)error{
+    self.receivedData = nil;
+    id<TOSMBSessionDownloadSink> sink = self.sink;
+    self.sink = nil;
+    [self reportProgressFinished];
+    
     TOSMBMakeWeakReference();
     NSParameterAssert(self.session);
     [self.session performCallBackWithBlock:^{
         TOSMBCheckIfWeakReferenceIsNilAndReturn();
         TOSMBMakeStrongFromWeakReference();
+        if ([sink respondsToSelector:@selector(downloadTask:didCompleteWithError:)]){
+            [sink downloadTask:strongSelf didCompleteWithError:error];
+        }
         if (strongSelf.delegate && [strongSelf.delegate respondsToSelector:@selector(downloadTask:didCompleteWithError:)]){
             [strongSelf.delegate downloadTask:strongSelf didCompleteWithError:error];
         }
@@ -173,13 +304,6 @@
     }];
 }
 
-- (BOOL)shouldNotifyWithProgress:(float)progress{
-    float lastProgress = self.lastProgress;
-    return (progress>0) && (ABS(lastProgress - progress) > 0.1 ||
-                            (fabs(progress - 1.0) < FLT_EPSILON) ||
-                            (fabs(progress) < FLT_EPSILON));
-}
-
 - (void)progressDidChange:(float)progress{
     if([self shouldNotifyWithProgress:progress] == NO){
         return;
@@ -286,55 +410,50 @@
     }
     
     //---------------------------------------------------------------------------------------
-    //Connect to share
+    //Connect to share and open the file
+    
+    //Attach to the share, get the file info we'll be working off and open it in one pass
+    TOSMBPath *remotePath = self.remotePath;
+    NSString *shareName = remotePath.shareName;
+    NSString *formattedPath = remotePath.relativeSMBPath;
+    const char *formattedPathCString = remotePath.relativeSMBPathUTF8String;
+    __block smb_tid treeID = TOSMBShareIDUnknown;
+    __block TOSMBSessionFile *file = nil;
+    __block smb_fd fileID = 0;
+    [self.session performSMBOperation:^(TOSMBSessionOperationContext *context) {
+        treeID = [context treeIDForShareName:shareName];
+        if (treeID == TOSMBShareIDUnknown) {
+            return;
+        }
+        smb_stat stat = smb_fstat(context.session, treeID, formattedPathCString);
+        if (stat == NULL) {
+            return;
+        }
+        file = [[TOSMBSessionFile alloc] initWithStat:stat fullPath:formattedPath];
+        smb_stat_destroy(stat);
+        if (file.directory) {
+            return;
+        }
+        if (smb_fopen(context.session, treeID, formattedPathCString, SMB_MOD_RO, &fileID) != DSM_SUCCESS) {
+            fileID = 0;
+        }
+    }];
     
-    //Next attach to the share we'll be using
-    NSString *shareName = [TOSMBSession shareNameFromPath:self.sourceFilePath];
-    const char *shareCString = [shareName cStringUsingEncoding:NSUTF8StringEncoding];
-    __block smb_tid treeID = [self.session cachedShareIDForName:shareName];
     if (treeID == TOSMBShareIDUnknown) {
-        [self.session inSMBCSession:^(smb_session *session) {
-            smb_tree_connect(session, shareCString, &treeID);
-        }];
-    }
-    if (treeID == TOSMBShareIDUnknown) {
-        [self.session removeCachedShareIDForName:shareName];
         [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeShareConnectionFailed)];
         [self cleanUp];
         return;
     }
-    else{
-        [self.session cacheShareID:treeID forName:shareName];
-    }
     self.treeID = treeID;
+    self.fileID = fileID;
     
-    if (self.isCancelled) {
-        [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeCancelled)];
-        [self cleanUp];
-        return;
-    }
-    
-    //---------------------------------------------------------------------------------------
-    //Find the target file
-    
-    NSString *formattedPath = [TOSMBSession relativeSMBPathFromPath:self.sourceFilePath];
-    
-    //Get the file info we'll be working off
-    self.file = [self requestFileForItemAtFormattedPath:formattedPath
-                                               fullPath:self.sourceFilePath
-                                                 inTree:treeID];
+    self.file = file;
     if (self.file == nil) {
         [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeFileNotFound)];
         [self cleanUp];
         return;
     }
     
-    if (self.isCancelled) {
-        [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeCancelled)];
-        [self cleanUp];
-        return;
-    }
-    
     if (self.file.directory) {
         [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeDirectoryDownloaded)];
         [self cleanUp];
@@ -343,21 +462,12 @@
     
     self.countOfBytesExpectedToReceive = self.file.fileSize;
     
-    //---------------------------------------------------------------------------------------
-    //Open the file handle
-    __block smb_fd fileID = 0;
-    [self.session inSMBCSession:^(smb_session *session) {
-        smb_fopen(session, treeID, [formattedPath cStringUsingEncoding:NSUTF8StringEncoding], SMB_MOD_RO, &fileID);
-    }];
-    
     if (fileID == 0) {
         [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeFileNotFound)];
         [self cleanUp];
         return;
     }
     
-    self.fileID = fileID;
-    
     if (self.isCancelled) {
         [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeCancelled)];
         [self cleanUp];
@@ -368,25 +478,39 @@
     //---------------------------------------------------------------------------------------
     //Start downloading
     
-    //Create the directories to the download destination
-    [[NSFileManager defaultManager] createDirectoryAtPath:[self.tempFilePath stringByDeletingLastPathComponent]
-                              withIntermediateDirectories:YES
-                                               attributes:nil
-                                                    error:nil];
-    
-    //Create a new blank file to write to
-    [[NSFileManager defaultManager] removeItemAtPath:self.tempFilePath error:nil];
-    [[NSFileManager defaultManager] createFileAtPath:self.tempFilePath contents:nil attributes:nil];
-    
-    //Open a handle to the file and skip ahead if we're resuming
-    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:self.tempFilePath];
-    self.fileHandle = fileHandle;
+    unsigned long long seekOffset = 0;
+    if (self.destination == TOSMBSessionDownloadDestinationFile) {
+        //Create the directories to the download destination
+        [[NSFileManager defaultManager] createDirectoryAtPath:[self.tempFilePath stringByDeletingLastPathComponent]
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:nil];
+        
+        //Create a new blank file to write to
+        [[NSFileManager defaultManager] removeItemAtPath:self.tempFilePath error:nil];
+        [[NSFileManager defaultManager] createFileAtPath:self.tempFilePath contents:nil attributes:nil];
+        
+        //Open a handle to the file and skip ahead if we're resuming
+        NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:self.tempFilePath];
+        self.fileHandle = fileHandle;
+        seekOffset = (ssize_t)[fileHandle seekToEndOfFile];
+    }
     
-    unsigned long long seekOffset = (ssize_t)[fileHandle seekToEndOfFile];
     if (self.seekOffset != NSNotFound) {
         seekOffset = self.seekOffset;
     }
     self.countOfBytesReceived = seekOffset;
+    self.digestStartOffset = seekOffset;
+    [self reportProgressWithCompletedBytes:seekOffset totalBytes:self.countOfBytesExpectedToReceive];
+    [self resetDigest];
+    
+    TOSMBSessionErrorCode errorCode = [self prepareInMemoryDestinationFromOffset:seekOffset];
+    if (errorCode != TOSMBSessionErrorCodeNone) {
+        [self fail];
+        [self didFailWithError:errorForErrorCode(errorCode)];
+        [self cleanUp];
+        return;
+    }
     
     if (seekOffset > 0) {
         [self.session inSMBCSession:^(smb_session *session) {
@@ -401,6 +525,75 @@
     [self downloadNextChunk];
 }
 
+/* Sets up the destinations that don't use the disk for the bytes from the offset onwards */
+- (TOSMBSessionErrorCode)prepareInMemoryDestinationFromOffset:(uint64_t)offset{
+    const uint64_t expectedLength = (self.countOfBytesExpectedToReceive > (int64_t)offset) ? self.countOfBytesExpectedToReceive - offset : 0;
+    self.bufferedLength = 0;
+    switch (self.destination) {
+        case TOSMBSessionDownloadDestinationData:
+            //Room for the whole file and one more chunk, so reading straight into it never has to grow it
+            if (expectedLength > NSUIntegerMax - kTOSMBSessionTransferTaskBufferSize) {
+                return TOSMBSessionErrorCodeBufferTooSmall;
+            }
+            self.receivedData = [NSMutableData dataWithLength:(NSUInteger)expectedLength + kTOSMBSessionTransferTaskBufferSize];
+            return self.receivedData ? TOSMBSessionErrorCodeNone : TOSMBSessionErrorCodeBufferTooSmall;
+        case TOSMBSessionDownloadDestinationBuffer:
+            return (expectedLength <= self.bufferLength) ? TOSMBSessionErrorCodeNone : TOSMBSessionErrorCodeBufferTooSmall;
+        case TOSMBSessionDownloadDestinationSink:
+            if ([self.sink respondsToSelector:@selector(downloadTask:willReceiveDataOfLength:)]) {
+                [self.sink downloadTask:self willReceiveDataOfLength:expectedLength];
+            }
+            return TOSMBSessionErrorCodeNone;
+        case TOSMBSessionDownloadDestinationFile:
+            return TOSMBSessionErrorCodeNone;
+    }
+}
+
+/* Where an in-memory destination wants the next chunk read to, or NULL if it should go through a scratch buffer */
+- (char *)destinationBytesForNextChunkOfLength:(NSInteger *)length{
+    switch (self.destination) {
+        case TOSMBSessionDownloadDestinationData:
+            //The file may have grown since its size was read
+            if (self.bufferedLength + *length > self.receivedData.length) {
+                self.receivedData.length = self.bufferedLength + *length;
+            }
+            return (char *)self.receivedData.mutableBytes + self.bufferedLength;
+        case TOSMBSessionDownloadDestinationBuffer: {
+            const NSUInteger remainingLength = self.bufferLength - self.bufferedLength;
+            if (remainingLength == 0) {
+                //Full, so read a single byte to tell the end of the file from a file that doesn't fit
+                *length = 1;
+                return NULL;
+            }
+            *length = MIN(*length, (NSInteger)remainingLength);
+            return (char *)self.buffer + self.bufferedLength;
+        }
+        default:
+            return NULL;
+    }
+}
+
+- (void)deliverDataToSink:(NSData *)data{
+    TOSMBMakeWeakReference();
+    [self.sink downloadTask:self didReceiveData:data completionHandler:^(NSError *error) {
+        TOSMBCheckIfWeakReferenceIsNilAndReturn();
+        TOSMBMakeStrongFromWeakReference();
+        if (error) {
+            [strongSelf fail];
+            [strongSelf didFailWithError:error];
+            [strongSelf cleanUp];
+            return;
+        }
+        if (strongSelf.isCancelled) {
+            [strongSelf didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeCancelled)];
+            [strongSelf cleanUp];
+            return;
+        }
+        //Only read on once the sink has caught up
+        [strongSelf downloadNextChunk];
+    }];
+}
+
 - (void)downloadNextChunk {
     NSBlockOperation *operation = [[NSBlockOperation alloc] init];
     TOSMBMakeWeakReference();
@@ -452,34 +645,71 @@
 //    [self addCancellableOperation:operation];
 //}
 
+/* Returns 1 to read on, 0 at the end of the file, 2 while a sink holds the chunk and -1 on failure */
 - (int)performDownloadNextChunk {
     NSInteger bufferSize = kTOSMBSessionTransferTaskBufferSize;
     NSInteger callbackDataBufferSize = kTOSMBSessionTransferTaskCallbackDataBufferSize;
     
-    char *buffer = malloc(bufferSize);
-    
-    __block int64_t bytesRead = 0;
-    __block smb_fd fileID = self.fileID;
+    //In-memory destinations are read into directly, everything else goes through a scratch buffer
+    char *buffer = [self destinationBytesForNextChunkOfLength:&bufferSize];
+    const BOOL scratchBuffer = (buffer == NULL);
+    if (scratchBuffer) {
+        buffer = malloc(bufferSize);
+    }
     
-    [self.session inSMBCSession:^(smb_session *session) {
-        bytesRead = smb_fread(session, fileID, buffer, bufferSize);
-    }];
+    //A dropped connection is picked up again from the last byte that was read
+    const int64_t bytesRead = [self readRemoteFileAtPath:self.remotePath
+                                                  offset:self.countOfBytesReceived
+                                              intoBuffer:buffer
+                                                  length:bufferSize];
     
     if (bytesRead < 0) {
+        if (scratchBuffer) {
+            free(buffer);
+        }
         [self fail];
         [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeFileDownloadFailed)];
         [self cleanUp];
         return -1;
     }
     
-    //Save them to the file handle (And ensure the NSData object is flushed immediately)
-    NSData *data = [NSData dataWithBytes:buffer length:bytesRead];
-    @try {
-        [self.fileHandle writeData:data];
-        
-        //Ensure the data is properly written to disk before proceeding
-        [self.fileHandle synchronizeFile];
-    } @catch (NSException *exception) {}
+    //Anything past the end of a full buffer means the file doesn't fit
+    if (self.destination == TOSMBSessionDownloadDestinationBuffer && scratchBuffer && bytesRead > 0) {
+        free(buffer);
+        [self fail];
+        [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeBufferTooSmall)];
+        [self cleanUp];
+        return -1;
+    }
+    
+    //Hash the chunk while it is still in memory
+    [self updateDigestWithBytes:buffer length:(size_t)bytesRead];
+    
+    NSData *data = nil;
+    if (self.destination == TOSMBSessionDownloadDestinationFile) {
+        //Save them to the file handle (And ensure the NSData object is flushed immediately)
+        data = [NSData dataWithBytes:buffer length:bytesRead];
+        @try {
+            [self.fileHandle writeData:data];
+            
+            //Ensure the data is properly written to disk before proceeding
+            [self.fileHandle synchronizeFile];
+        } @catch (NSException *exception) {}
+    }
+    else if (self.destination == TOSMBSessionDownloadDestinationSink) {
+        //The sink takes the chunk over without a copy
+        if (bytesRead > 0) {
+            data = [NSData dataWithBytesNoCopy:buffer length:bytesRead freeWhenDone:YES];
+            buffer = NULL;
+        }
+    }
+    else {
+        self.bufferedLength += bytesRead;
+    }
+    
+    if (scratchBuffer) {
+        free(buffer);
+    }
     
     if (self.isCancelled){
         [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeCancelled)];
@@ -487,13 +717,23 @@
         return -1;
     }
     self.countOfBytesReceived += bytesRead;
-    [self.callbackData appendData:data];
-    if (self.callbackData.length >= callbackDataBufferSize || bytesRead == 0) {
-        [self didUpdateWriteBytes:self.callbackData];
-        self.callbackData = [[NSMutableData alloc] init];
+    [self reportProgressWithCompletedBytes:self.countOfBytesReceived totalBytes:self.countOfBytesExpectedToReceive];
+    
+    if (self.destination == TOSMBSessionDownloadDestinationFile) {
+        [self.callbackData appendData:data];
+        if (self.callbackData.length >= callbackDataBufferSize || bytesRead == 0) {
+            [self didUpdateWriteBytes:self.callbackData];
+            self.callbackData = [[NSMutableData alloc] init];
+        }
+    }
+    else if (self.countOfBytesExpectedToReceive > 0) {
+        [self progressDidChange:(float)self.countOfBytesReceived/(float)self.countOfBytesExpectedToReceive];
     }
     
-    free(buffer);
+    if (data && self.destination == TOSMBSessionDownloadDestinationSink) {
+        [self deliverDataToSink:data];
+        return 2;
+    }
     
     return bytesRead > 0 ? 1 : 0;
 }
@@ -519,12 +759,17 @@
 }
 
 - (void)performFinishDownload{
-    @try{[self.fileHandle closeFile];}@catch(NSException *exc){}
-    
-    //Set the modification date to match the one on the SMB device so we can compare the two at a later date
-    [[NSFileManager defaultManager] setAttributes:@{NSFileModificationDate:self.file.modificationTime}
-                                     ofItemAtPath:self.tempFilePath
-                                            error:nil];
+    if (self.destination == TOSMBSessionDownloadDestinationFile) {
+        @try{[self.fileHandle closeFile];}@catch(NSException *exc){}
+        
+        //Set the modification date to match the one on the SMB device so we can compare the two at a later date
+        NSDate *modificationTime = self.file.modificationTime;
+        if (modificationTime) {
+            [[NSFileManager defaultManager] setAttributes:@{NSFileModificationDate:modificationTime}
+                                             ofItemAtPath:self.tempFilePath
+                                                    error:nil];
+        }
+    }
     
     if (self.isCancelled  || self.state != TOSMBSessionTransferTaskStateRunning) {
         [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeCancelled)];
@@ -532,6 +777,24 @@
         return;
     }
     
+    //---------------------------------------------------------------------------------------
+    //Check the digest against the file on the device, while its handle is still open
+    
+    if ([self finishDigestVerifyingFile:self.fileID fromOffset:self.digestStartOffset] == NO) {
+        TOSMBSessionErrorCode errorCode = self.isCancelled ? TOSMBSessionErrorCodeCancelled : TOSMBSessionErrorCodeIntegrityCheckFailed;
+        [self fail];
+        [self didFailWithError:errorForErrorCode(errorCode)];
+        [self cleanUp];
+        return;
+    }
+    
+    if (self.destination != TOSMBSessionDownloadDestinationFile) {
+        self.state = TOSMBSessionTransferTaskStateCompleted;
+        [self cleanUp];
+        [self didSucceedInMemory];
+        return;
+    }
+    
     //---------------------------------------------------------------------------------------
     //Move the finished file to its destination
     
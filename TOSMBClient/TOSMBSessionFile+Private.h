@@ -9,6 +9,10 @@
 #import "TOSMBSessionFile.h"
 #import "smb_stat.h"
 
+/* Converts a FILETIME (100-nanosecond intervals since January 1, 1601) without any calendar math */
+extern NSTimeInterval TOSMBTimeIntervalSince1970FromFileTime(uint64_t fileTime);
+extern NSDate *TOSMBDateFromFileTime(uint64_t fileTime);
+
 @interface TOSMBSessionFile()
 
 @property (nonatomic, copy) NSString *fullPath;
@@ -39,6 +43,15 @@
 
 - (instancetype)initWithStat:(smb_stat)stat fullPath:(NSString *)fullPath;
 
+/**
+ * Init a new instance with only its name and path. Sizes and timestamps are set through the properties above.
+ *
+ * @param name The name of the file
+ * @param fullPath The full path of the file, including the share name
+ * @param directory Whether this file is a directory or not
+ */
+- (instancetype)initWithName:(NSString *)name fullPath:(NSString *)fullPath directory:(BOOL)directory;
+
 /**
  * Init a new instance representing the share itself, which in the case of libSMD, is simply another directory
  *
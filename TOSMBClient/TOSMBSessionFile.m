@@ -22,6 +22,21 @@
 
 #import "TOSMBSessionFile+Private.h"
 
+/* Seconds between the FILETIME epoch (1601-01-01) and the Unix epoch (1970-01-01) */
+static const uint64_t kTOSMBFileTimeEpochOffset = 11644473600ULL;
+static const uint64_t kTOSMBFileTimeTicksPerSecond = 10000000ULL;
+
+NSTimeInterval TOSMBTimeIntervalSince1970FromFileTime(uint64_t fileTime){
+    //Split into whole seconds and the remainder so no precision is lost converting to double
+    const int64_t seconds = (int64_t)(fileTime / kTOSMBFileTimeTicksPerSecond) - (int64_t)kTOSMBFileTimeEpochOffset;
+    const uint64_t ticks = fileTime % kTOSMBFileTimeTicksPerSecond;
+    return (NSTimeInterval)seconds + (NSTimeInterval)ticks / (NSTimeInterval)kTOSMBFileTimeTicksPerSecond;
+}
+
+NSDate *TOSMBDateFromFileTime(uint64_t fileTime){
+    return [NSDate dateWithTimeIntervalSince1970:TOSMBTimeIntervalSince1970FromFileTime(fileTime)];
+}
+
 @implementation TOSMBSessionFile
 
 - (instancetype)init
@@ -54,8 +69,6 @@
         _creationTimestamp = smb_stat_get(stat, SMB_STAT_CTIME);
         _accessTimestamp = smb_stat_get(stat, SMB_STAT_ATIME);
         _writeTimestamp = smb_stat_get(stat, SMB_STAT_WTIME);
-        _modificationTime = [self dateFromLDAPTimeStamp:_modificationTimestamp];
-        _creationTime = [self dateFromLDAPTimeStamp:_creationTimestamp];
         [self normalizeFullPath];
     }
     
@@ -84,8 +97,6 @@
         _creationTimestamp = smb_stat_get(stat, SMB_STAT_CTIME);
         _accessTimestamp = smb_stat_get(stat, SMB_STAT_ATIME);
         _writeTimestamp = smb_stat_get(stat, SMB_STAT_WTIME);
-        _modificationTime = [self dateFromLDAPTimeStamp:_modificationTimestamp];
-        _creationTime = [self dateFromLDAPTimeStamp:_creationTimestamp];
         uint64_t writeTimestampDep = smb_stat_get(stat, SMB_STAT_WTIME_DEP);
         if (writeTimestampDep > 0) {
             _modificationTime = [NSDate dateWithTimeIntervalSince1970:writeTimestampDep];
@@ -95,6 +106,20 @@
     return self;
 }
 
+- (instancetype)initWithName:(NSString *)name fullPath:(NSString *)fullPath directory:(BOOL)directory{
+    if (fullPath == nil){
+        NSParameterAssert(NO);
+        return nil;
+    }
+    if (self = [self init]) {
+        _name = [name copy];
+        _fullPath = [fullPath copy];
+        _directory = directory;
+        [self normalizeFullPath];
+    }
+    return self;
+}
+
 - (instancetype)initWithShareName:(NSString *)name{
     if (name.length == 0){
         return nil;
@@ -137,22 +162,26 @@
     _fullPath = [normalizedPath copy];
 }
 
-//SO Answer by Dave DeLong - http://stackoverflow.com/a/11978614/599344
 - (NSDate *)dateFromLDAPTimeStamp:(uint64_t)timestamp{
-    
-    NSDateComponents *base = [[NSDateComponents alloc] init];
-    [base setDay:1];
-    [base setMonth:1];
-    [base setYear:1601];
-    [base setEra:1]; // AD
-    
-    NSCalendar *gregorian = [[NSCalendar alloc] initWithCalendarIdentifier:NSCalendarIdentifierGregorian];
-    NSDate *baseDate = [gregorian dateFromComponents:base];
-    
-    NSTimeInterval newTimestamp = timestamp / 10000000.0f;
-    NSDate *finalDate = [baseDate dateByAddingTimeInterval:newTimestamp];
-    
-    return finalDate;
+    return TOSMBDateFromFileTime(timestamp);
+}
+
+- (NSDate *)modificationTime{
+    //Share roots and the root directory have no timestamps
+    if (_modificationTime || _modificationTimestamp == 0){
+        return _modificationTime;
+    }
+    _modificationTime = [self dateFromLDAPTimeStamp:_modificationTimestamp];
+    return _modificationTime;
+}
+
+- (NSDate *)creationTime{
+    //Share roots and the root directory have no timestamps
+    if (_creationTime || _creationTimestamp == 0){
+        return _creationTime;
+    }
+    _creationTime = [self dateFromLDAPTimeStamp:_creationTimestamp];
+    return _creationTime;
 }
 
 - (NSDate *)accessTime{
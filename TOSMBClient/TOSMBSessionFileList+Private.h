@@ -0,0 +1,38 @@
+//
+//  TOSMBSessionFileList+Private.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBSessionFileList.h"
+#import "smb_stat.h"
+
+@interface TOSMBSessionFileList ()
+
+/**
+ * Creates an empty list for the directory at the given path
+ *
+ * @param path The full path of the directory, including the share name
+ * @param capacity The number of entries to reserve space for
+ */
+- (instancetype)initWithPath:(NSString *)path capacity:(NSUInteger)capacity;
+
+/* Appends the entry described by a libdsm stat. Must not be called once entries have been read. */
+- (void)addEntryWithStat:(smb_stat)stat;
+
+/* Appends a network share, which is listed as a directory */
+- (void)addShareWithName:(const char *)name;
+
+- (void)addEntryWithName:(const char *)name
+                  length:(size_t)length
+                fileSize:(uint64_t)fileSize
+          allocationSize:(uint64_t)allocationSize
+               directory:(BOOL)directory
+            creationTime:(uint64_t)creationTime
+              accessTime:(uint64_t)accessTime
+               writeTime:(uint64_t)writeTime
+        modificationTime:(uint64_t)modificationTime;
+
+@end
@@ -0,0 +1,57 @@
+//
+//  TOSMBSessionFileList.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class TOSMBSessionFile;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The contents of one directory, stored in columns instead of one object per entry.
+
+ All names live in a single UTF-8 buffer, and sizes, flags and timestamps are kept in packed arrays,
+ so very large directories stay cheap to list. `TOSMBSessionFile` objects, `NSString` names and
+ `NSDate` timestamps are only created for the entries that are actually asked for.
+
+ Entries are in the order the server returned them. Timestamps are Windows FILETIME values:
+ the number of 100-nanosecond intervals since January 1, 1601 (UTC).
+ */
+@interface TOSMBSessionFileList : NSObject <NSFastEnumeration>
+
+@property (nonatomic, readonly, copy) NSString *path;   /** The full path of the listed directory, including the share name */
+@property (nonatomic, readonly) NSUInteger count;       /** The number of entries */
+
+/** The file object for an entry. It is created on first access and reused afterwards. */
+- (TOSMBSessionFile *)fileAtIndex:(NSUInteger)index;
+- (TOSMBSessionFile *)objectAtIndexedSubscript:(NSUInteger)index;
+
+/** File objects for every entry */
+- (NSArray<TOSMBSessionFile *> *)allFiles;
+
+- (NSString *)nameAtIndex:(NSUInteger)index;
+- (const char *)UTF8NameAtIndex:(NSUInteger)index NS_RETURNS_INNER_POINTER;
+
+- (uint64_t)fileSizeAtIndex:(NSUInteger)index;
+- (uint64_t)allocationSizeAtIndex:(NSUInteger)index;
+- (BOOL)isDirectoryAtIndex:(NSUInteger)index;
+
+- (uint64_t)creationFileTimeAtIndex:(NSUInteger)index;
+- (uint64_t)accessFileTimeAtIndex:(NSUInteger)index;
+- (uint64_t)writeFileTimeAtIndex:(NSUInteger)index;
+- (uint64_t)modificationFileTimeAtIndex:(NSUInteger)index;
+
+/** The modification time as seconds since 1970, without creating an `NSDate` */
+- (NSTimeInterval)modificationTimeIntervalSince1970AtIndex:(NSUInteger)index;
+
+- (NSDate *)creationTimeAtIndex:(NSUInteger)index;
+- (NSDate *)modificationTimeAtIndex:(NSUInteger)index;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,348 @@
+//
+//  TOSMBSessionFileList.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBSessionFileList.h"
+#import "TOSMBSessionFileList+Private.h"
+#import "TOSMBSessionFile+Private.h"
+
+static const NSUInteger kTOSMBSessionFileListDefaultCapacity = 64;
+
+/* Average name length used to size the name buffer up front */
+static const NSUInteger kTOSMBSessionFileListEstimatedNameLength = 24;
+
+typedef NS_OPTIONS(uint8_t, TOSMBSessionFileListFlags) {
+    TOSMBSessionFileListFlagDirectory = 1 << 0
+};
+
+@interface TOSMBSessionFileList () {
+    //Names, NUL terminated and back to back
+    char *_names;
+    size_t _namesLength;
+    size_t _namesCapacity;
+
+    //One column per attribute, all `_capacity` long
+    uint32_t *_nameOffsets;
+    uint64_t *_fileSizes;
+    uint64_t *_allocationSizes;
+    uint8_t *_flags;
+    uint64_t *_creationTimes;
+    uint64_t *_accessTimes;
+    uint64_t *_writeTimes;
+    uint64_t *_modificationTimes;
+
+    NSUInteger _count;
+    NSUInteger _capacity;
+}
+
+@property (nonatomic, copy, readwrite) NSString *path;
+
+/* Materialized file objects, filled in on demand. Guarded by @synchronized on the array itself. */
+@property (nonatomic, strong) NSPointerArray *files;
+
+@end
+
+@implementation TOSMBSessionFileList
+
+- (instancetype)init{
+    return [self initWithPath:@"/" capacity:kTOSMBSessionFileListDefaultCapacity];
+}
+
+- (instancetype)initWithPath:(NSString *)path capacity:(NSUInteger)capacity{
+    self = [super init];
+    if (self) {
+        //Entry paths are built by appending to this, so make sure it ends in a slash
+        NSString *directoryPath = (path.length > 0) ? path : @"/";
+        if ([directoryPath hasSuffix:@"/"] == NO) {
+            directoryPath = [directoryPath stringByAppendingString:@"/"];
+        }
+        _path = [directoryPath copy];
+        if ([self reserveCapacity:MAX(capacity, 1)] == NO ||
+            [self reserveNamesCapacity:MAX(capacity, 1) * kTOSMBSessionFileListEstimatedNameLength] == NO) {
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (void)dealloc{
+    free(_names);
+    free(_nameOffsets);
+    free(_fileSizes);
+    free(_allocationSizes);
+    free(_flags);
+    free(_creationTimes);
+    free(_accessTimes);
+    free(_writeTimes);
+    free(_modificationTimes);
+}
+
+#pragma mark - Storage -
+
+static BOOL TOSMBSessionFileListResize(void **column, size_t elementSize, NSUInteger capacity){
+    void *resized = realloc(*column, elementSize * capacity);
+    if (resized == NULL) {
+        return NO;
+    }
+    *column = resized;
+    return YES;
+}
+
+- (BOOL)reserveCapacity:(NSUInteger)capacity{
+    if (capacity <= _capacity) {
+        return YES;
+    }
+    BOOL success =
+    TOSMBSessionFileListResize((void **)&_nameOffsets, sizeof(uint32_t), capacity) &&
+    TOSMBSessionFileListResize((void **)&_fileSizes, sizeof(uint64_t), capacity) &&
+    TOSMBSessionFileListResize((void **)&_allocationSizes, sizeof(uint64_t), capacity) &&
+    TOSMBSessionFileListResize((void **)&_flags, sizeof(uint8_t), capacity) &&
+    TOSMBSessionFileListResize((void **)&_creationTimes, sizeof(uint64_t), capacity) &&
+    TOSMBSessionFileListResize((void **)&_accessTimes, sizeof(uint64_t), capacity) &&
+    TOSMBSessionFileListResize((void **)&_writeTimes, sizeof(uint64_t), capacity) &&
+    TOSMBSessionFileListResize((void **)&_modificationTimes, sizeof(uint64_t), capacity);
+    if (success) {
+        _capacity = capacity;
+    }
+    return success;
+}
+
+- (BOOL)reserveNamesCapacity:(size_t)capacity{
+    if (capacity <= _namesCapacity) {
+        return YES;
+    }
+    if (TOSMBSessionFileListResize((void **)&_names, sizeof(char), capacity) == NO) {
+        return NO;
+    }
+    _namesCapacity = capacity;
+    return YES;
+}
+
+#pragma mark - Building -
+
+- (void)addEntryWithStat:(smb_stat)stat{
+    if (stat == NULL) {
+        return;
+    }
+    const char *name = smb_stat_name(stat);
+    if (name == NULL) {
+        return;
+    }
+    [self addEntryWithName:name
+                    length:strlen(name)
+                  fileSize:smb_stat_get(stat, SMB_STAT_SIZE)
+            allocationSize:smb_stat_get(stat, SMB_STAT_ALLOC_SIZE)
+                 directory:(smb_stat_get(stat, SMB_STAT_ISDIR) != 0)
+              creationTime:smb_stat_get(stat, SMB_STAT_CTIME)
+                accessTime:smb_stat_get(stat, SMB_STAT_ATIME)
+                 writeTime:smb_stat_get(stat, SMB_STAT_WTIME)
+          modificationTime:smb_stat_get(stat, SMB_STAT_MTIME)];
+}
+
+- (void)addShareWithName:(const char *)name{
+    if (name == NULL) {
+        return;
+    }
+    [self addEntryWithName:name length:strlen(name) fileSize:0 allocationSize:0 directory:YES
+              creationTime:0 accessTime:0 writeTime:0 modificationTime:0];
+}
+
+- (void)addEntryWithName:(const char *)name
+                  length:(size_t)length
+                fileSize:(uint64_t)fileSize
+          allocationSize:(uint64_t)allocationSize
+               directory:(BOOL)directory
+            creationTime:(uint64_t)creationTime
+              accessTime:(uint64_t)accessTime
+               writeTime:(uint64_t)writeTime
+        modificationTime:(uint64_t)modificationTime
+{
+    NSParameterAssert(self.files == nil);
+    if (name == NULL || _namesLength + length + 1 > UINT32_MAX) {
+        return;
+    }
+    if (_count == _capacity && [self reserveCapacity:_capacity * 2] == NO) {
+        return;
+    }
+    if (_namesLength + length + 1 > _namesCapacity &&
+        [self reserveNamesCapacity:MAX(_namesCapacity * 2, _namesLength + length + 1)] == NO) {
+        return;
+    }
+
+    const NSUInteger index = _count;
+    _nameOffsets[index] = (uint32_t)_namesLength;
+    memcpy(_names + _namesLength, name, length);
+    _names[_namesLength + length] = '\0';
+    _namesLength += length + 1;
+
+    _fileSizes[index] = fileSize;
+    _allocationSizes[index] = allocationSize;
+    _flags[index] = directory ? TOSMBSessionFileListFlagDirectory : 0;
+    _creationTimes[index] = creationTime;
+    _accessTimes[index] = accessTime;
+    _writeTimes[index] = writeTime;
+    _modificationTimes[index] = modificationTime;
+    _count++;
+}
+
+#pragma mark - Columns -
+
+- (NSUInteger)count{
+    return _count;
+}
+
+- (const char *)UTF8NameAtIndex:(NSUInteger)index{
+    NSParameterAssert(index < _count);
+    return _names + _nameOffsets[index];
+}
+
+- (size_t)nameLengthAtIndex:(NSUInteger)index{
+    const size_t end = (index + 1 < _count) ? _nameOffsets[index + 1] : _namesLength;
+    return end - _nameOffsets[index] - 1;
+}
+
+- (NSString *)nameAtIndex:(NSUInteger)index{
+    NSParameterAssert(index < _count);
+    return [[NSString alloc] initWithBytes:_names + _nameOffsets[index]
+                                    length:[self nameLengthAtIndex:index]
+                                  encoding:NSUTF8StringEncoding];
+}
+
+- (uint64_t)fileSizeAtIndex:(NSUInteger)index{
+    NSParameterAssert(index < _count);
+    return _fileSizes[index];
+}
+
+- (uint64_t)allocationSizeAtIndex:(NSUInteger)index{
+    NSParameterAssert(index < _count);
+    return _allocationSizes[index];
+}
+
+- (BOOL)isDirectoryAtIndex:(NSUInteger)index{
+    NSParameterAssert(index < _count);
+    return (_flags[index] & TOSMBSessionFileListFlagDirectory) != 0;
+}
+
+- (uint64_t)creationFileTimeAtIndex:(NSUInteger)index{
+    NSParameterAssert(index < _count);
+    return _creationTimes[index];
+}
+
+- (uint64_t)accessFileTimeAtIndex:(NSUInteger)index{
+    NSParameterAssert(index < _count);
+    return _accessTimes[index];
+}
+
+- (uint64_t)writeFileTimeAtIndex:(NSUInteger)index{
+    NSParameterAssert(index < _count);
+    return _writeTimes[index];
+}
+
+- (uint64_t)modificationFileTimeAtIndex:(NSUInteger)index{
+    NSParameterAssert(index < _count);
+    return _modificationTimes[index];
+}
+
+- (NSTimeInterval)modificationTimeIntervalSince1970AtIndex:(NSUInteger)index{
+    return TOSMBTimeIntervalSince1970FromFileTime([self modificationFileTimeAtIndex:index]);
+}
+
+- (NSDate *)creationTimeAtIndex:(NSUInteger)index{
+    const uint64_t fileTime = [self creationFileTimeAtIndex:index];
+    return (fileTime > 0) ? TOSMBDateFromFileTime(fileTime) : nil;
+}
+
+- (NSDate *)modificationTimeAtIndex:(NSUInteger)index{
+    const uint64_t fileTime = [self modificationFileTimeAtIndex:index];
+    return (fileTime > 0) ? TOSMBDateFromFileTime(fileTime) : nil;
+}
+
+#pragma mark - Files -
+
+- (TOSMBSessionFile *)fileAtIndex:(NSUInteger)index{
+    NSParameterAssert(index < _count);
+    if (index >= _count) {
+        return nil;
+    }
+
+    NSPointerArray *files = nil;
+    @synchronized (self) {
+        if (self.files == nil) {
+            self.files = [NSPointerArray strongObjectsPointerArray];
+            self.files.count = _count;
+        }
+        files = self.files;
+    }
+
+    @synchronized (files) {
+        TOSMBSessionFile *file = (__bridge TOSMBSessionFile *)[files pointerAtIndex:index];
+        if (file) {
+            return file;
+        }
+        NSString *name = [self nameAtIndex:index];
+        const BOOL directory = [self isDirectoryAtIndex:index];
+        NSString *fullPath = [self.path stringByAppendingString:name];
+        file = [[TOSMBSessionFile alloc] initWithName:name fullPath:fullPath directory:directory];
+        //Entries of the root list are the network shares themselves
+        file.isShareRoot = [self.path isEqualToString:@"/"];
+        file.fileSize = _fileSizes[index];
+        file.allocationSize = _allocationSizes[index];
+        file.creationTimestamp = _creationTimes[index];
+        file.accessTimestamp = _accessTimes[index];
+        file.writeTimestamp = _writeTimes[index];
+        file.modificationTimestamp = _modificationTimes[index];
+        [files replacePointerAtIndex:index withPointer:(__bridge void *)file];
+        return file;
+    }
+}
+
+- (TOSMBSessionFile *)objectAtIndexedSubscript:(NSUInteger)index{
+    return [self fileAtIndex:index];
+}
+
+- (NSArray<TOSMBSessionFile *> *)allFiles{
+    NSMutableArray *files = [NSMutableArray arrayWithCapacity:_count];
+    for (NSUInteger i = 0; i < _count; i++) {
+        TOSMBSessionFile *file = [self fileAtIndex:i];
+        if (file) {
+            [files addObject:file];
+        }
+    }
+    return files;
+}
+
+#pragma mark - NSFastEnumeration -
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
+                                  objects:(id __unsafe_unretained _Nullable [])buffer
+                                    count:(NSUInteger)len
+{
+    if (state->state == 0) {
+        //The list never changes once built
+        state->mutationsPtr = &state->extra[0];
+        state->extra[1] = 0;
+        state->state = 1;
+    }
+
+    NSUInteger index = state->extra[1];
+    NSUInteger produced = 0;
+    while (index < _count && produced < len) {
+        //Materialized files are kept alive by `files`, so handing them out unretained is safe
+        buffer[produced++] = [self fileAtIndex:index++];
+    }
+    state->extra[1] = index;
+    state->itemsPtr = buffer;
+    return produced;
+}
+
+#pragma mark - Debug -
+
+- (NSString *)description{
+    return [NSString stringWithFormat:@"File List - Path: %@ | Count: %lu", self.path, (unsigned long)_count];
+}
+
+@end
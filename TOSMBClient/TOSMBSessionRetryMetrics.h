@@ -0,0 +1,39 @@
+//
+//  TOSMBSessionRetryMetrics.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Counts how often a session had to recover from its connection dropping. All counts start at zero
+ when the session is created and only ever go up until `reset` is called.
+ */
+@interface TOSMBSessionRetryMetrics : NSObject
+
+/** Failed requests and transfer steps that turned out to be the connection dropping */
+@property (atomic, readonly) NSUInteger droppedConnectionCount;
+
+/** Reconnects tried after a drop, and how many of them failed */
+@property (atomic, readonly) NSUInteger reconnectAttemptCount;
+@property (atomic, readonly) NSUInteger failedReconnectCount;
+
+/** Listings, stats and other idempotent requests that were sent again on a new connection */
+@property (atomic, readonly) NSUInteger retriedRequestCount;
+
+/** Transfers that carried on from their last confirmed offset on a new connection */
+@property (atomic, readonly) NSUInteger resumedTransferCount;
+
+/** Time spent waiting between reconnects */
+@property (atomic, readonly) NSTimeInterval backoffDuration;
+
+- (void)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,77 @@
+//
+//  TOSMBSessionRetryMetrics.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBSessionRetryMetrics.h"
+#import "TOSMBSession+Private.h"
+
+@interface TOSMBSessionRetryMetrics ()
+
+@property (atomic, readwrite) NSUInteger droppedConnectionCount;
+@property (atomic, readwrite) NSUInteger reconnectAttemptCount;
+@property (atomic, readwrite) NSUInteger failedReconnectCount;
+@property (atomic, readwrite) NSUInteger retriedRequestCount;
+@property (atomic, readwrite) NSUInteger resumedTransferCount;
+@property (atomic, readwrite) NSTimeInterval backoffDuration;
+
+@end
+
+@implementation TOSMBSessionRetryMetrics
+
+- (void)countDroppedConnection{
+    @synchronized (self) {
+        self.droppedConnectionCount++;
+    }
+}
+
+- (void)countReconnectAttemptAfterBackoff:(NSTimeInterval)backoff succeeded:(BOOL)succeeded{
+    @synchronized (self) {
+        self.reconnectAttemptCount++;
+        self.backoffDuration += backoff;
+        if (succeeded == NO) {
+            self.failedReconnectCount++;
+        }
+    }
+}
+
+- (void)countRetriedRequest{
+    @synchronized (self) {
+        self.retriedRequestCount++;
+    }
+}
+
+- (void)countResumedTransfer{
+    @synchronized (self) {
+        self.resumedTransferCount++;
+    }
+}
+
+- (void)reset{
+    @synchronized (self) {
+        self.droppedConnectionCount = 0;
+        self.reconnectAttemptCount = 0;
+        self.failedReconnectCount = 0;
+        self.retriedRequestCount = 0;
+        self.resumedTransferCount = 0;
+        self.backoffDuration = 0;
+    }
+}
+
+- (NSString *)description{
+    @synchronized (self) {
+        return [NSString stringWithFormat:@"<%@: %p drops: %lu, reconnects: %lu (%lu failed), retried requests: %lu, resumed transfers: %lu, backoff: %.2fs>",
+                NSStringFromClass([self class]), self,
+                (unsigned long)self.droppedConnectionCount,
+                (unsigned long)self.reconnectAttemptCount,
+                (unsigned long)self.failedReconnectCount,
+                (unsigned long)self.retriedRequestCount,
+                (unsigned long)self.resumedTransferCount,
+                self.backoffDuration];
+    }
+}
+
+@end
@@ -11,7 +11,9 @@
 #import "TOSMBSession+Private.h"
 #import "NSString+TOSMB.h"
 #import "TOSMBSessionFile+Private.h"
+#import "TOSMBPath.h"
 #import "TOSMBClient.h"
+#import "TOSMBProgressStream+Private.h"
 #import "smb_session.h"
 #import "smb_share.h"
 #import "smb_file.h"
@@ -27,8 +29,13 @@
 @property (nonatomic, copy) NSString *sourceFilePath;
 @property (nonatomic, copy) NSString *destinationFilePath;
 
+/* The file on the SMB device, parsed once when the task is created and reused by every step */
+@property (nonatomic, strong) TOSMBPath *remotePath;
+
 @property (nonatomic, weak) TOSMBSession *session;
 @property (nonatomic, assign) float lastProgress;
+@property (nonatomic, assign) CFAbsoluteTime lastProgressTime;
+@property (nonatomic, strong) NSHashTable <TOSMBProgressStream *> *progressStreams;
 @property (nonatomic, strong) NSFileHandle *fileHandle;
 @property (nonatomic, strong) NSHashTable <NSOperation *> *operations;
 
@@ -36,6 +43,10 @@
 @property (nonatomic, copy) TOSMBSessionTransferTaskSuccessHandler successHandler;
 @property (nonatomic, copy) TOSMBSessionTransferTaskFailHandler failHandler;
 
+/* Running digest of the transferred bytes, nil when no digest was asked for */
+@property (nonatomic, strong) TOSMBDigest *streamingDigest;
+@property (nullable, readwrite, copy) NSData *digest;
+
 - (void)startTaskInternal;
 
 - (void)cancelAllOperations;
@@ -44,6 +55,45 @@
 
 - (void)removeCancellableOperation:(NSOperation *)operation;
 
+/* Progress handling, shared by downloads and uploads */
+
+/* YES at most once per `kTOSMBSessionTransferTaskProgressInterval`, and always once the task is done */
+- (BOOL)shouldNotifyWithProgress:(float)progress;
+
+- (void)addProgressStream:(TOSMBProgressStream *)stream;
+
+/* Records the byte counts with the progress streams of the task and its session. Cheap enough to call for every chunk. */
+- (void)reportProgressWithCompletedBytes:(int64_t)completedBytes totalBytes:(int64_t)totalBytes;
+- (void)reportProgressFinished;
+
+/* Digest handling, shared by downloads and uploads */
+- (void)resetDigest;
+- (void)updateDigestWithBytes:(const void *)bytes length:(size_t)length;
+
+/**
+ Finishes the streaming digest and, if asked to, checks it against the file on the device.
+ Returns NO if the check fails or the file could not be read back.
+ */
+- (BOOL)finishDigestVerifyingFile:(smb_fd)fileID fromOffset:(uint64_t)offset;
+
+/**
+ Called after a read or write on the open file has failed on the connection of `failedWrapper`, or with nil if
+ the server answered. Reconnects with backoff, unless another caller already has, opens the file again on the
+ new connection and seeks it to the offset, so the transfer can carry on from there.
+ Returns NO if the transfer should fail instead. Blocks while it waits between reconnects.
+ */
+- (BOOL)reopenRemoteFileAtPath:(TOSMBPath *)path
+                          mode:(uint32_t)mode
+                        offset:(uint64_t)offset
+  afterFailureOfSessionWrapper:(TOSMBCSessionWrapper *)failedWrapper
+                       attempt:(NSUInteger *)attempt;
+
+/**
+ Reads the next bytes of the open file. If the connection drops under the read, reopens the file at the offset
+ on a new connection and reads again. Returns the number of bytes read, 0 at the end of the file and -1 on failure.
+ */
+- (ssize_t)readRemoteFileAtPath:(TOSMBPath *)path offset:(uint64_t)offset intoBuffer:(void *)buffer length:(size_t)length;
+
 - (TOSMBSessionFile *)requestFileForItemAtFormattedPath:(NSString *)filePath
                                                fullPath:(NSString *)fullPath
                                                  inTree:(smb_tid)treeID;
@@ -8,6 +8,7 @@
 
 #import <Foundation/Foundation.h>
 #import "TOSMBConstants.h"
+#import "TOSMBDigest.h"
 
 @class TOSMBSession;
 
@@ -20,6 +21,8 @@ typedef void(^TOSMBSessionTransferTaskFailHandler)(NSError *error);
 extern NSInteger kTOSMBSessionTransferTaskBufferSize;
 extern NSInteger kTOSMBSessionTransferTaskCallbackDataBufferSize;
 extern NSTimeInterval kTOSMBSessionTransferAsyncDelay;
+extern NSInteger kTOSMBSessionTransferTaskVerifyBufferSize;
+extern NSTimeInterval kTOSMBSessionTransferTaskProgressInterval;
 
 @interface TOSMBSessionTransferTask : NSObject
 
@@ -31,6 +34,22 @@ extern NSTimeInterval kTOSMBSessionTransferAsyncDelay;
 
 - (TOSMBSessionTransferTaskState)state;
 
+/**
+ The digest to compute over the file contents as they stream through the transfer.
+ Must be set before the task is started. Defaults to `TOSMBDigestAlgorithmNone`.
+ */
+@property (nonatomic, assign) TOSMBDigestAlgorithm digestAlgorithm;
+
+/**
+ When set, the file on the device is read back once the transfer finishes and the task fails
+ with `TOSMBSessionErrorCodeIntegrityCheckFailed` if its digest doesn't match. Nothing is read from local disk.
+ Has no effect without a digest algorithm.
+ */
+@property (nonatomic, assign) BOOL verifiesRemoteDigest;
+
+/** The digest of the transferred bytes, available once the task has completed successfully */
+@property (nullable, readonly, copy) NSData *digest;
+
 - (void)start;
 
 - (void)cancel;
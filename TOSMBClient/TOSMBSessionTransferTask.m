@@ -12,12 +12,18 @@
 NSInteger kTOSMBSessionTransferTaskBufferSize = 32 * 1024; //32 KB
 NSInteger kTOSMBSessionTransferTaskCallbackDataBufferSize = 1 * 1024 * 1024; // 1 MB
 NSTimeInterval kTOSMBSessionTransferAsyncDelay = 0.05;
+NSInteger kTOSMBSessionTransferTaskVerifyBufferSize = 1 * 1024 * 1024; // 1 MB
+NSTimeInterval kTOSMBSessionTransferTaskProgressInterval = 0.25;
 
 
 @implementation TOSMBSessionTransferTask
 
 - (void)dealloc{
     [NSObject cancelPreviousPerformRequestsWithTarget:self];
+    //Streams would otherwise wait on a task that was never started or never finished for good
+    for (TOSMBProgressStream *stream in [self allProgressStreams]) {
+        [stream finishAbandonedTasks];
+    }
 }
 
 #pragma mark - Public Control Methods -
@@ -68,6 +74,209 @@ NSTimeInterval kTOSMBSessionTransferAsyncDelay = 0.05;
     }
 }
 
+#pragma mark - Progress -
+
+- (BOOL)shouldNotifyWithProgress:(float)progress{
+    if (progress <= 0) {
+        return NO;
+    }
+    if (fabs(progress - 1.0) < FLT_EPSILON) {
+        return (fabs(self.lastProgress - 1.0) >= FLT_EPSILON);
+    }
+    const CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    if (now - self.lastProgressTime < kTOSMBSessionTransferTaskProgressInterval) {
+        return NO;
+    }
+    self.lastProgressTime = now;
+    return YES;
+}
+
+- (void)addProgressStream:(TOSMBProgressStream *)stream{
+    NSParameterAssert(stream);
+    @synchronized (self) {
+        if (self.progressStreams == nil) {
+            self.progressStreams = [NSHashTable<TOSMBProgressStream *> weakObjectsHashTable];
+        }
+        [self.progressStreams addObject:stream];
+    }
+}
+
+- (NSArray<TOSMBProgressStream *> *)allProgressStreams{
+    NSArray<TOSMBProgressStream *> *streams = nil;
+    @synchronized (self) {
+        streams = self.progressStreams.allObjects;
+    }
+    NSArray<TOSMBProgressStream *> *sessionStreams = [self.session progressStreams];
+    if (sessionStreams.count == 0) {
+        return streams;
+    }
+    if (streams.count == 0) {
+        return sessionStreams;
+    }
+    NSMutableOrderedSet<TOSMBProgressStream *> *allStreams = [NSMutableOrderedSet orderedSetWithArray:streams];
+    [allStreams addObjectsFromArray:sessionStreams];
+    return allStreams.array;
+}
+
+- (void)reportProgressWithCompletedBytes:(int64_t)completedBytes totalBytes:(int64_t)totalBytes{
+    for (TOSMBProgressStream *stream in [self allProgressStreams]) {
+        [stream task:self didTransferBytes:(uint64_t)MAX(completedBytes, 0) ofTotal:(uint64_t)MAX(totalBytes, 0)];
+    }
+}
+
+- (void)reportProgressFinished{
+    for (TOSMBProgressStream *stream in [self allProgressStreams]) {
+        [stream taskDidFinish:self];
+    }
+}
+
+#pragma mark - Digest -
+
+- (void)resetDigest{
+    self.digest = nil;
+    self.streamingDigest = [[TOSMBDigest alloc] initWithAlgorithm:self.digestAlgorithm];
+}
+
+- (void)updateDigestWithBytes:(const void *)bytes length:(size_t)length{
+    [self.streamingDigest updateWithBytes:bytes length:length];
+}
+
+- (BOOL)finishDigestVerifyingFile:(smb_fd)fileID fromOffset:(uint64_t)offset{
+    TOSMBDigest *streamingDigest = self.streamingDigest;
+    if (streamingDigest == nil) {
+        return YES;
+    }
+    NSData *digest = [streamingDigest finish];
+    
+    if (self.verifiesRemoteDigest == NO) {
+        self.digest = digest;
+        return YES;
+    }
+    
+    NSData *remoteDigest = [self remoteDigestOfFile:fileID fromOffset:offset algorithm:streamingDigest.algorithm];
+    if (remoteDigest == nil || [remoteDigest isEqualToData:digest] == NO) {
+        return NO;
+    }
+    
+    self.digest = digest;
+    return YES;
+}
+
+- (NSData *)remoteDigestOfFile:(smb_fd)fileID fromOffset:(uint64_t)offset algorithm:(TOSMBDigestAlgorithm)algorithm{
+    if (fileID == 0) {
+        return nil;
+    }
+    
+    TOSMBDigest *remoteDigest = [[TOSMBDigest alloc] initWithAlgorithm:algorithm];
+    const NSInteger bufferSize = kTOSMBSessionTransferTaskVerifyBufferSize;
+    char *buffer = malloc(bufferSize);
+    if (buffer == NULL) {
+        return nil;
+    }
+    
+    __block BOOL failed = NO;
+    __block BOOL finished = NO;
+    __block BOOL seeked = NO;
+    while (finished == NO && failed == NO && self.isCancelled == NO) {
+        //libdsm reads are synchronous, so fill the whole buffer with back to back reads in one hop onto the session queue
+        __block NSInteger bufferLength = 0;
+        [self.session inSMBCSession:^(smb_session *session) {
+            if (seeked == NO) {
+                seeked = (smb_fseek(session, fileID, (ssize_t)offset, SMB_SEEK_SET) >= 0);
+                if (seeked == NO) {
+                    failed = YES;
+                    return;
+                }
+            }
+            while (bufferLength < bufferSize) {
+                ssize_t bytesRead = smb_fread(session, fileID, buffer + bufferLength, bufferSize - bufferLength);
+                if (bytesRead < 0) {
+                    failed = YES;
+                    return;
+                }
+                if (bytesRead == 0) {
+                    finished = YES;
+                    return;
+                }
+                bufferLength += bytesRead;
+            }
+        }];
+        [remoteDigest updateWithBytes:buffer length:bufferLength];
+    }
+    
+    free(buffer);
+    
+    if (failed || finished == NO) {
+        return nil;
+    }
+    return [remoteDigest finish];
+}
+
+#pragma mark - Retries -
+
+- (BOOL)reopenRemoteFileAtPath:(TOSMBPath *)path
+                          mode:(uint32_t)mode
+                        offset:(uint64_t)offset
+  afterFailureOfSessionWrapper:(TOSMBCSessionWrapper *)failedWrapper
+                       attempt:(NSUInteger *)attempt
+{
+    TOSMBSession *session = self.session;
+    while (self.isCancelled == NO && [session reconnectAfterFailureOfSessionWrapper:failedWrapper attempt:attempt]) {
+        //The old handle died with the old connection, so it is dropped rather than closed
+        __block smb_tid treeID = TOSMBShareIDUnknown;
+        __block smb_fd fileID = 0;
+        __block TOSMBCSessionWrapper *droppedWrapper = nil;
+        NSString *shareName = path.shareName;
+        const char *relativePathCString = path.relativeSMBPathUTF8String;
+        [session performSMBOperation:^(TOSMBSessionOperationContext *context) {
+            treeID = [context treeIDForShareName:shareName];
+            if (treeID == TOSMBShareIDUnknown) {
+                if ([context hasConnectionFailed]) {
+                    droppedWrapper = context.wrapper;
+                }
+                return;
+            }
+            const int result = [context openFileAtPath:relativePathCString inTree:treeID mode:mode offset:offset fileID:&fileID];
+            if (result != DSM_SUCCESS && [context hasConnectionFailedAfterResult:result]) {
+                droppedWrapper = context.wrapper;
+            }
+        }];
+        
+        //Going round again gives up unless the new connection has dropped as well
+        if (fileID == 0) {
+            failedWrapper = droppedWrapper;
+            continue;
+        }
+        
+        self.treeID = treeID;
+        self.fileID = fileID;
+        [session.retryMetrics countResumedTransfer];
+        return YES;
+    }
+    return NO;
+}
+
+- (ssize_t)readRemoteFileAtPath:(TOSMBPath *)path offset:(uint64_t)offset intoBuffer:(void *)buffer length:(size_t)length{
+    __block ssize_t bytesRead = -1;
+    __block TOSMBCSessionWrapper *failedWrapper = nil;
+    NSUInteger attempt = 0;
+    do {
+        const smb_fd fileID = self.fileID;
+        failedWrapper = nil;
+        [self.session performSMBOperation:^(TOSMBSessionOperationContext *context) {
+            bytesRead = [context readFile:fileID intoBuffer:buffer length:length];
+            if (bytesRead < 0 && [context hasConnectionFailedAfterResult:(int)bytesRead]) {
+                failedWrapper = context.wrapper;
+            }
+        }];
+    } while (bytesRead < 0 && [self reopenRemoteFileAtPath:path
+                                                       mode:SMB_MOD_RO
+                                                     offset:offset
+                               afterFailureOfSessionWrapper:failedWrapper
+                                                    attempt:&attempt]);
+    return bytesRead;
+}
+
 #pragma mark - Request File -
 
 - (TOSMBSessionFile *)requestFileForItemAtFormattedPath:(NSString *)filePath
@@ -75,18 +284,13 @@ NSTimeInterval kTOSMBSessionTransferAsyncDelay = 0.05;
                                                  inTree:(smb_tid)treeID
 {
     const char *fileCString = [filePath cStringUsingEncoding:NSUTF8StringEncoding];
-    __block smb_stat stat = NULL;
-    [self.session inSMBCSession:^(smb_session *session) {
-        stat = smb_fstat(session, treeID, fileCString);
-    }];
-    
-    if (stat == NULL) {
-        return nil;
-    }
-    
-    TOSMBSessionFile *file = [[TOSMBSessionFile alloc] initWithStat:stat fullPath:filePath];
-    
-    [self.session inSMBCSession:^(smb_session *session) {
+    __block TOSMBSessionFile *file = nil;
+    [self.session performSMBOperation:^(TOSMBSessionOperationContext *context) {
+        smb_stat stat = smb_fstat(context.session, treeID, fileCString);
+        if (stat == NULL) {
+            return;
+        }
+        file = [[TOSMBSessionFile alloc] initWithStat:stat fullPath:filePath];
         smb_stat_destroy(stat);
     }];
     
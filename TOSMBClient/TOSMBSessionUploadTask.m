@@ -13,7 +13,7 @@
 
 @interface TOSMBSessionUploadTask ()
 
-@property (nonatomic, copy) NSString *uploadTemporaryFilePath;
+@property (nonatomic, strong) TOSMBPath *uploadTemporaryPath;
 
 @property (nonatomic, assign) int64_t countOfBytesSend;
 @property (nonatomic, assign) int64_t countOfBytesExpectedToSend;
@@ -39,6 +39,7 @@
         self.session = session;
         self.sourceFilePath = [filePath copy];
         self.destinationFilePath = [destinationPath copy];
+        self.remotePath = [TOSMBPath pathWithString:destinationPath];
         self.progressHandler = [progressHandler copy];
         self.successHandler = [successHandler copy];
         self.failHandler = [failHandler copy];
@@ -54,6 +55,7 @@
 #pragma mark - Feedback Methods -
 
 - (void)didSucceedWithFilePath:(NSString *)filePath{
+    [self reportProgressFinished];
     TOSMBMakeWeakReference();
     NSParameterAssert(self.session);
     [self.session performCallBackWithBlock:^{
@@ -66,6 +68,7 @@
 }
 
 - (void)didFailWithError:(NSError *)error{
+    [self reportProgressFinished];
     TOSMBMakeWeakReference();
     NSParameterAssert(self.session);
     [self.session performCallBackWithBlock:^{
@@ -77,13 +80,6 @@
     }];
 }
 
-- (BOOL)shouldNotifyWithProgress:(float)progress{
-    float lastProgress = self.lastProgress;
-    return (progress>0) && (ABS(lastProgress - progress) > 0.1 ||
-                            (fabs(progress - 1.0) < FLT_EPSILON) ||
-                            (fabs(progress) < FLT_EPSILON));
-}
-
 - (void)progressDidChange:(float)progress{
     if([self shouldNotifyWithProgress:progress] == NO){
         return;
@@ -147,10 +143,10 @@
     
     //---------------------------------------------------------------------------------------
     //Set up paths
-    self.uploadTemporaryFilePath =
-    [[self.destinationFilePath stringByDeletingLastPathComponent] stringByAppendingPathComponent:[NSString stringWithFormat:@"%@.%@",
-                                                                                                  [NSString TOSMB_uuidString],
-                                                                                                  self.destinationFilePath.pathExtension?:@"tmp"]];
+    NSString *temporaryFileName = [NSString stringWithFormat:@"%@.%@",
+                                   [NSString TOSMB_uuidString],
+                                   self.remotePath.lastComponent.pathExtension.length ? self.remotePath.lastComponent.pathExtension : @"tmp"];
+    self.uploadTemporaryPath = [self.remotePath.parentPath pathByAppendingComponent:temporaryFileName];
     
     const char *relativeUploadPathCString = [self relativeUploadPathCString];
     
@@ -171,35 +167,6 @@
         return;
     }
     
-    //---------------------------------------------------------------------------------------
-    //Connect to share
-    
-    //Next attach to the share we'll be using
-    NSString *shareName = [TOSMBSession shareNameFromPath:self.destinationFilePath];
-    const char *shareCString = [shareName cStringUsingEncoding:NSUTF8StringEncoding];
-    __block smb_tid treeID = [self.session cachedShareIDForName:shareName];
-    if (treeID == TOSMBShareIDUnknown) {
-        [self.session inSMBCSession:^(smb_session *session) {
-            smb_tree_connect(session, shareCString,&treeID);
-        }];
-    }
-    self.treeID = treeID;
-    if (treeID == TOSMBShareIDUnknown) {
-        [self.session removeCachedShareIDForName:shareName];
-        [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeShareConnectionFailed)];
-        [self cleanUp];
-        return;
-    }
-    else{
-        [self.session cacheShareID:treeID forName:shareName];
-    }
-    
-    if (self.isCancelled) {
-        [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeCancelled)];
-        [self cleanUp];
-        return;
-    }
-    
     //---------------------------------------------------------------------------------------
     //Find the target file
     
@@ -228,13 +195,30 @@
     self.countOfBytesExpectedToSend = [sourceFileAttributes fileSize];
     
     //---------------------------------------------------------------------------------------
-    //Open the file handle
+    //Connect to share and open the file handle
+    
+    //Attach to the share we'll be using and create the file in one pass
+    NSString *shareName = self.remotePath.shareName;
+    __block smb_tid treeID = TOSMBShareIDUnknown;
     __block smb_fd fileID = 0;
-    [self.session inSMBCSession:^(smb_session *session) {
-        smb_fopen(session, treeID, relativeUploadPathCString, SMB_MOD_RW, &fileID);
+    [self.session performSMBOperation:^(TOSMBSessionOperationContext *context) {
+        treeID = [context treeIDForShareName:shareName];
+        if (treeID == TOSMBShareIDUnknown) {
+            return;
+        }
+        if (smb_fopen(context.session, treeID, relativeUploadPathCString, SMB_MOD_RW, &fileID) != DSM_SUCCESS) {
+            fileID = 0;
+        }
     }];
+    self.treeID = treeID;
     self.fileID = fileID;
     
+    if (treeID == TOSMBShareIDUnknown) {
+        [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeShareConnectionFailed)];
+        [self cleanUp];
+        return;
+    }
+    
     if (fileID == 0) {
         [self didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeFailToUpload)];
         [self cleanUp];
@@ -255,6 +239,8 @@
     self.fileHandle = fileHandle;
     unsigned long long seekOffset = 0;
     self.countOfBytesSend = seekOffset;
+    [self reportProgressWithCompletedBytes:(int64_t)seekOffset totalBytes:self.countOfBytesExpectedToSend];
+    [self resetDigest];
     
     //Perform the file upload
     [self uploadNextChunk];
@@ -330,10 +316,16 @@
     
     if (bytesToWrite > 0) {
         void *bytes = (void *)data.bytes;
+        NSUInteger attempt = 0;
         while (bytesToWrite > 0) {
             __block ssize_t write_size = -1;
-            [self.session inSMBCSession:^(smb_session *session) {
-                write_size = smb_fwrite(session, self.fileID, bytes, bytesToWrite);
+            __block TOSMBCSessionWrapper *failedWrapper = nil;
+            const smb_fd fileID = self.fileID;
+            [self.session performSMBOperation:^(TOSMBSessionOperationContext *context) {
+                write_size = [context writeFile:fileID fromBuffer:bytes length:bytesToWrite];
+                if (write_size < 0 && [context hasConnectionFailedAfterResult:(int)write_size]) {
+                    failedWrapper = context.wrapper;
+                }
             }];
             
             if (write_size == 0){
@@ -341,6 +333,17 @@
             }
             
             if (write_size < 0) {
+                //Writes are positional, so after a dropped connection the whole chunk is written again
+                //from where it starts, over whatever part of it may already have landed
+                if ([self reopenRemoteFileAtPath:self.uploadTemporaryPath
+                                            mode:SMB_MOD_RW
+                                          offset:self.countOfBytesSend
+                    afterFailureOfSessionWrapper:failedWrapper
+                                         attempt:&attempt]) {
+                    bytes = (void *)data.bytes;
+                    bytesToWrite = dataLength;
+                    continue;
+                }
                 uploadError = YES;
                 break;
             }
@@ -361,7 +364,10 @@
         return -1;
     }
     
+    //Hash the chunk only once it has been fully written
+    [self updateDigestWithBytes:data.bytes length:dataLength];
     self.countOfBytesSend += dataLength;
+    [self reportProgressWithCompletedBytes:self.countOfBytesSend totalBytes:self.countOfBytesExpectedToSend];
     
     [self didUpdateWriteBytes:data
             totalBytesWritten:self.countOfBytesSend
@@ -397,11 +403,17 @@
     __block smb_fd fileID = self.fileID;
     __block smb_tid treeID = self.treeID;
     
-    NSString *formattedPath = [TOSMBSession relativeSMBPathFromPath:self.destinationFilePath];
-    
     const char *relativeUploadPathCString = [self relativeUploadPathCString];
     const char *relativeToPathCString = [self relativeToPathCString];
     
+    //Read the uploaded data back from the device before the handle is closed, and check its digest
+    if (self.isCancelled == NO && [self finishDigestVerifyingFile:fileID fromOffset:0] == NO) {
+        TOSMBSessionErrorCode errorCode = self.isCancelled ? TOSMBSessionErrorCodeCancelled : TOSMBSessionErrorCodeIntegrityCheckFailed;
+        [self didFailWithError:errorForErrorCode(errorCode)];
+        [self cleanUp];
+        return;
+    }
+    
     if (fileID > 0) {
         [self.session inSMBCSession:^(smb_session *session) {
             smb_fclose(session, fileID);
@@ -415,19 +427,15 @@
     }
     
     //---------------------------------------------------------------------------------------
-    //Move the finished file to its destination
-    TOSMBSessionFile *existingFile = [self requestFileForItemAtFormattedPath:formattedPath
-                                                                    fullPath:self.destinationFilePath
-                                                                      inTree:treeID];
-    if (existingFile){
-        [self.session inSMBCSession:^(smb_session *session) {
-            smb_file_rm(session, treeID, relativeToPathCString);
-        }];
-    }
-    
+    //Move the finished file to its destination, replacing any existing file, in one pass
     __block int result = DSM_ERROR_GENERIC;
-    [self.session inSMBCSession:^(smb_session *session) {
-        result = smb_file_mv(session, treeID, relativeUploadPathCString, relativeToPathCString);
+    [self.session performSMBOperation:^(TOSMBSessionOperationContext *context) {
+        smb_stat existingStat = smb_fstat(context.session, treeID, relativeToPathCString);
+        if (existingStat != NULL) {
+            smb_stat_destroy(existingStat);
+            smb_file_rm(context.session, treeID, relativeToPathCString);
+        }
+        result = smb_file_mv(context.session, treeID, relativeUploadPathCString, relativeToPathCString);
     }];
     
     self.state = TOSMBSessionTransferTaskStateCompleted;
@@ -443,31 +451,26 @@
 }
 
 - (const char *)relativeUploadPathCString{
-    NSString *formattedUploadPath = [TOSMBSession relativeSMBPathFromPath:self.uploadTemporaryFilePath];
-    return [formattedUploadPath cStringUsingEncoding:NSUTF8StringEncoding];
+    return self.uploadTemporaryPath.relativeSMBPathUTF8String;
 }
 
 - (const char *)relativeToPathCString{
-    NSString *formattedPath = [TOSMBSession relativeSMBPathFromPath:self.destinationFilePath];
-    return [formattedPath cStringUsingEncoding:NSUTF8StringEncoding];
+    return self.remotePath.relativeSMBPathUTF8String;
 }
 
 - (void)cleanUp{
     __block smb_fd fileID = self.fileID;
     __block smb_tid treeID = self.treeID;
     
-    if (fileID > 0) {
-        [self.session inSMBCSession:^(smb_session *session) {
-            smb_fclose(session, fileID);
-        }];
-    }
-    
-    if (treeID > 0) {
-        const char *relativeUploadPathCString = self.relativeUploadPathCString;
-        [self.session inSMBCSession:^(smb_session *session) {
-            smb_file_rm(session, treeID, relativeUploadPathCString);
-        }];
-    }
+    const char *relativeUploadPathCString = self.relativeUploadPathCString;
+    [self.session performSMBOperation:^(TOSMBSessionOperationContext *context) {
+        if (fileID > 0) {
+            smb_fclose(context.session, fileID);
+        }
+        if (treeID > 0) {
+            smb_file_rm(context.session, treeID, relativeUploadPathCString);
+        }
+    }];
 }
 
 @end
@@ -0,0 +1,94 @@
+//
+//  TOSMBShareIndex.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class TOSMBSession;
+@class TOSMBSessionFile;
+@class TOSMBPath;
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSInteger, TOSMBShareIndexMatch) {
+    TOSMBShareIndexMatchSubstring,  /* The name contains the search string */
+    TOSMBShareIndexMatchPrefix      /* The name starts with the search string */
+};
+
+/**
+ A local, searchable index of the names and attributes of everything inside a folder on an SMB
+ device, or of every share on it.
+
+ The index is opt-in: nothing is crawled until `crawl:` is called or periodic crawls are started.
+ Directories are listed with bounded concurrency and the result is saved to disk, from where it is
+ memory mapped the next time the index is opened. Searches never touch the network, ignore case,
+ diacritics and width, and take milliseconds even with millions of items.
+
+ Recrawls are incremental. A directory whose write time is the same as when it was last listed
+ is not listed again: its indexed contents are kept, and only its subdirectories are checked.
+ Adding, removing or renaming items changes a directory's write time, but files changed in place
+ usually don't, so set `skipsUnchangedDirectories` to NO now and then to refresh sizes and dates.
+ */
+@interface TOSMBShareIndex : NSObject
+
+/**
+ @param session The session for the device
+ @param rootPath The folder to index. Use the root path to index every share.
+ @param indexURL Where the index is saved. An existing index there is opened straight away.
+ */
+- (instancetype)initWithSession:(TOSMBSession *)session
+                       rootPath:(TOSMBPath *)rootPath
+                       indexURL:(NSURL *)indexURL;
+
+@property (nonatomic, readonly) TOSMBSession *session;
+@property (nonatomic, readonly) TOSMBPath *rootPath;
+@property (nonatomic, readonly) NSURL *indexURL;
+
+/** Directories listed at once while crawling. Default is 4. */
+@property (nonatomic, assign) NSUInteger maximumConcurrentListings;
+
+/** Reuse the indexed contents of directories whose write time hasn't changed. Default is YES. */
+@property (nonatomic, assign) BOOL skipsUnchangedDirectories;
+
+@property (atomic, readonly) NSUInteger itemCount;                  /** Items in the index, not counting the root */
+@property (atomic, readonly, getter=isCrawling) BOOL crawling;
+@property (atomic, readonly) NSUInteger listedDirectoryCount;       /** Directories listed by the last crawl */
+@property (atomic, readonly) NSUInteger skippedDirectoryCount;      /** Unchanged directories the last crawl didn't list */
+
+/**
+ Crawls on the session's request queue and replaces the index once the crawl has finished.
+ Searches keep using the previous index until then.
+
+ @param completionHandler Called on the session's callback queue
+ */
+- (NSOperation *)crawlWithCompletionHandler:(nullable void (^)(NSError * _Nullable error))completionHandler;
+
+/** Crawls on the calling thread. Must not be called on the main thread. */
+- (BOOL)crawl:(NSError **)error;
+
+/** Crawls in the background every `interval` seconds, starting now. Crawls that are due while one is running are skipped. */
+- (void)startPeriodicCrawlsWithInterval:(NSTimeInterval)interval;
+- (void)stopPeriodicCrawls;
+
+/** Cancels a crawl in progress. The index is left as it was. */
+- (void)cancel;
+
+/**
+ Searches the index.
+
+ @param string The text to look for in item names
+ @param match Whether the text can be anywhere in the name or has to start it
+ @param limit The most results to return, or 0 for no limit
+ @return Matching files and folders, shallowest first. Their paths include the share name.
+ */
+- (NSArray<TOSMBSessionFile *> *)filesMatchingString:(NSString *)string
+                                               match:(TOSMBShareIndexMatch)match
+                                               limit:(NSUInteger)limit;
+
+@end
+
+NS_ASSUME_NONNULL_END
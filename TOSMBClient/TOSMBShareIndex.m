@@ -0,0 +1,445 @@
+//
+//  TOSMBShareIndex.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBShareIndex.h"
+#import "TOSMBShareIndexTable.h"
+#import "TOSMBSession.h"
+#import "TOSMBSession+Private.h"
+#import "TOSMBSessionFile+Private.h"
+#import "TOSMBSessionFileList.h"
+#import "TOSMBPath.h"
+
+static const NSUInteger kTOSMBShareIndexDefaultConcurrentListings = 4;
+
+#pragma mark - Crawl State -
+
+/* One directory found by a crawl */
+@interface TOSMBShareIndexCrawlNode : NSObject
+
+@property (nonatomic, strong) TOSMBPath *path;
+@property (nonatomic, assign) uint64_t writeTime;
+@property (nonatomic, assign) BOOL writeTimeKnown;      /* Taken from the parent's listing, so no stat is needed */
+@property (nonatomic, assign) uint32_t previousRecord;  /* The directory in the previous index, if it was there */
+
+@property (nonatomic, strong) TOSMBSessionFileList *fileList;   /* Set if the directory was listed */
+@property (nonatomic, assign) BOOL reused;                      /* Set if its contents come from the previous index */
+@property (nonatomic, assign) BOOL listingFailed;
+
+/* One node per directory among the contents, in the same order */
+@property (nonatomic, strong) NSMutableArray<TOSMBShareIndexCrawlNode *> *subdirectories;
+
+/* Its record in the index being built */
+@property (nonatomic, assign) uint32_t record;
+
+@end
+
+@implementation TOSMBShareIndexCrawlNode
+
+- (instancetype)init{
+    self = [super init];
+    if (self) {
+        _previousRecord = TOSMBShareIndexNoRecord;
+        _subdirectories = [NSMutableArray array];
+    }
+    return self;
+}
+
+@end
+
+@interface TOSMBShareIndexCrawl : NSObject
+
+@property (nonatomic, strong) TOSMBShareIndexTable *previousTable;
+@property (nonatomic, strong) NSOperationQueue *queue;
+@property (nonatomic, strong) dispatch_group_t group;
+@property (nonatomic, assign) NSUInteger listedDirectoryCount;
+@property (nonatomic, assign) NSUInteger skippedDirectoryCount;
+
+- (void)countDirectoryListed:(BOOL)listed;
+
+@end
+
+@implementation TOSMBShareIndexCrawl
+
+- (void)countDirectoryListed:(BOOL)listed{
+    @synchronized (self) {
+        if (listed) {
+            _listedDirectoryCount++;
+        }
+        else {
+            _skippedDirectoryCount++;
+        }
+    }
+}
+
+@end
+
+#pragma mark - Index -
+
+@interface TOSMBShareIndex ()
+
+@property (nonatomic, strong, readwrite) TOSMBSession *session;
+@property (nonatomic, strong, readwrite) TOSMBPath *rootPath;
+@property (nonatomic, strong, readwrite) NSURL *indexURL;
+
+@property (atomic, assign, readwrite, getter=isCrawling) BOOL crawling;
+@property (atomic, assign, readwrite) NSUInteger listedDirectoryCount;
+@property (atomic, assign, readwrite) NSUInteger skippedDirectoryCount;
+@property (atomic, assign) BOOL cancelled;
+
+/* Replaced as a whole when a crawl finishes, so searches never see a half built index */
+@property (atomic, strong) TOSMBShareIndexTable *table;
+
+@property (nonatomic, strong) dispatch_queue_t timerQueue;
+@property (nonatomic, strong) dispatch_source_t crawlTimer;
+
+@end
+
+@implementation TOSMBShareIndex
+
+- (instancetype)initWithSession:(TOSMBSession *)session rootPath:(TOSMBPath *)rootPath indexURL:(NSURL *)indexURL{
+    NSParameterAssert(session);
+    NSParameterAssert(rootPath);
+    NSParameterAssert(indexURL.isFileURL);
+    self = [super init];
+    if (self) {
+        _session = session;
+        _rootPath = rootPath;
+        _indexURL = [indexURL copy];
+        _maximumConcurrentListings = kTOSMBShareIndexDefaultConcurrentListings;
+        _skipsUnchangedDirectories = YES;
+        _timerQueue = dispatch_queue_create("TOSMBShareIndex.timer", DISPATCH_QUEUE_SERIAL);
+        //A missing or damaged index is simply crawled again
+        _table = [TOSMBShareIndexTable tableWithContentsOfURL:indexURL error:nil];
+    }
+    return self;
+}
+
+- (void)dealloc{
+    if (_crawlTimer) {
+        dispatch_source_cancel(_crawlTimer);
+    }
+}
+
+- (NSUInteger)itemCount{
+    TOSMBShareIndexTable *table = self.table;
+    return table ? table.recordCount - 1 : 0;
+}
+
+#pragma mark - Crawling -
+
+- (NSOperation *)crawlWithCompletionHandler:(void (^)(NSError *))completionHandler{
+    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
+    TOSMBMakeWeakReference();
+    TOSMBMakeWeakReferenceForOperation();
+
+    id operationBlock = ^{
+        TOSMBCheckIfWeakReferenceForOperationIsCancelledOrNilAndReturn();
+        TOSMBCheckIfWeakReferenceIsNilAndReturn();
+        TOSMBMakeStrongFromWeakReference();
+
+        NSError *error = nil;
+        [strongSelf crawl:&error];
+        if (completionHandler) {
+            [strongSelf.session performCallBackWithBlock:^{ completionHandler(error); }];
+        }
+    };
+
+    return [self.session addRequestOperation:operation withBlock:operationBlock];
+}
+
+- (BOOL)crawl:(NSError **)error{
+    NSParameterAssert([NSThread isMainThread] == NO);
+
+    @synchronized (self) {
+        if (self.crawling) {
+            if (error) {
+                *error = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
+            }
+            return NO;
+        }
+        self.crawling = YES;
+        self.cancelled = NO;
+    }
+
+    NSError *resultError = [self.session attemptConnection];
+    TOSMBShareIndexTable *table = nil;
+    TOSMBShareIndexCrawl *crawl = [[TOSMBShareIndexCrawl alloc] init];
+    if (resultError == nil) {
+        crawl.previousTable = self.table;
+        crawl.queue = [[NSOperationQueue alloc] init];
+        crawl.queue.maxConcurrentOperationCount = MAX(self.maximumConcurrentListings, 1);
+        crawl.group = dispatch_group_create();
+
+        TOSMBShareIndexCrawlNode *root = [[TOSMBShareIndexCrawlNode alloc] init];
+        root.path = self.rootPath;
+        root.previousRecord = crawl.previousTable ? 0 : TOSMBShareIndexNoRecord;
+        [self enqueueNode:root crawl:crawl];
+        dispatch_group_wait(crawl.group, DISPATCH_TIME_FOREVER);
+
+        if (self.cancelled) {
+            resultError = errorForErrorCode(TOSMBSessionErrorCodeCancelled);
+        }
+        else if (root.fileList == nil && root.reused == NO) {
+            resultError = errorForErrorCode(TOSMBSessionErrorCodeFileNotFound);
+        }
+        else {
+            table = [self tableFromRootNode:root previousTable:crawl.previousTable];
+        }
+    }
+
+    if (table) {
+        [table writeToURL:self.indexURL error:&resultError];
+        self.table = table;
+        self.listedDirectoryCount = crawl.listedDirectoryCount;
+        self.skippedDirectoryCount = crawl.skippedDirectoryCount;
+    }
+
+    self.crawling = NO;
+    if (error) {
+        *error = resultError;
+    }
+    return (resultError == nil);
+}
+
+- (void)enqueueNode:(TOSMBShareIndexCrawlNode *)node crawl:(TOSMBShareIndexCrawl *)crawl{
+    dispatch_group_enter(crawl.group);
+    [crawl.queue addOperationWithBlock:^{
+        [self visitNode:node crawl:crawl];
+        dispatch_group_leave(crawl.group);
+    }];
+}
+
+- (void)visitNode:(TOSMBShareIndexCrawlNode *)node crawl:(TOSMBShareIndexCrawl *)crawl{
+    if (self.cancelled) {
+        return;
+    }
+
+    //Shares and the device itself have no write time, so they are always listed
+    if (node.writeTimeKnown == NO && node.path.isRoot == NO && node.path.isShareRoot == NO) {
+        node.writeTime = [self.session itemAttributesAtSMBPath:node.path error:nil].writeTimestamp;
+    }
+
+    TOSMBShareIndexTable *previousTable = crawl.previousTable;
+    const TOSMBShareIndexRecord *previous = NULL;
+    if (node.previousRecord != TOSMBShareIndexNoRecord) {
+        previous = &previousTable.records[node.previousRecord];
+    }
+
+    //Unchanged since it was last listed: keep its contents, and check its subdirectories instead
+    if (self.skipsUnchangedDirectories && previous && node.writeTime != 0 && previous->writeTime == node.writeTime) {
+        node.reused = YES;
+        [crawl countDirectoryListed:NO];
+        [self enqueueSubdirectoriesOfPreviousRecord:node.previousRecord ofNode:node crawl:crawl];
+        return;
+    }
+
+    NSError *error = nil;
+    TOSMBSessionFileList *fileList = [self.session fileListOfDirectoryAtSMBPath:node.path error:&error];
+    if (fileList == nil) {
+        //Keep what was indexed before, and list it again next time
+        node.listingFailed = YES;
+        if (previous) {
+            node.reused = YES;
+            [self enqueueSubdirectoriesOfPreviousRecord:node.previousRecord ofNode:node crawl:crawl];
+        }
+        return;
+    }
+    node.fileList = fileList;
+    [crawl countDirectoryListed:YES];
+
+    //Match subdirectories up with the previous index by name, so they can be skipped if unchanged
+    NSMutableDictionary<NSString *, NSNumber *> *previousSubdirectories = nil;
+    if (previous) {
+        previousSubdirectories = [NSMutableDictionary dictionary];
+        const NSRange children = [previousTable childRangeOfRecordAtIndex:node.previousRecord];
+        for (uint32_t i = (uint32_t)children.location; i < NSMaxRange(children); i++) {
+            if (previousTable.records[i].flags & TOSMBShareIndexRecordFlagDirectory) {
+                previousSubdirectories[[previousTable nameAtIndex:i]] = @(i);
+            }
+        }
+    }
+
+    for (NSUInteger i = 0; i < fileList.count; i++) {
+        if ([fileList isDirectoryAtIndex:i] == NO) {
+            continue;
+        }
+        NSString *name = [fileList nameAtIndex:i];
+        TOSMBShareIndexCrawlNode *subdirectory = [[TOSMBShareIndexCrawlNode alloc] init];
+        subdirectory.path = [node.path pathByAppendingComponent:name];
+        subdirectory.writeTime = [fileList writeFileTimeAtIndex:i];
+        subdirectory.writeTimeKnown = YES;
+        NSNumber *previousRecord = previousSubdirectories[name];
+        subdirectory.previousRecord = previousRecord ? previousRecord.unsignedIntValue : TOSMBShareIndexNoRecord;
+        [node.subdirectories addObject:subdirectory];
+        [self enqueueNode:subdirectory crawl:crawl];
+    }
+}
+
+- (void)enqueueSubdirectoriesOfPreviousRecord:(uint32_t)record ofNode:(TOSMBShareIndexCrawlNode *)node crawl:(TOSMBShareIndexCrawl *)crawl{
+    TOSMBShareIndexTable *previousTable = crawl.previousTable;
+    const NSRange children = [previousTable childRangeOfRecordAtIndex:record];
+    for (uint32_t i = (uint32_t)children.location; i < NSMaxRange(children); i++) {
+        if ((previousTable.records[i].flags & TOSMBShareIndexRecordFlagDirectory) == 0) {
+            continue;
+        }
+        TOSMBShareIndexCrawlNode *subdirectory = [[TOSMBShareIndexCrawlNode alloc] init];
+        subdirectory.path = [node.path pathByAppendingComponent:[previousTable nameAtIndex:i]];
+        subdirectory.previousRecord = i;
+        [node.subdirectories addObject:subdirectory];
+        [self enqueueNode:subdirectory crawl:crawl];
+    }
+}
+
+/* Lays the crawled tree out breadth first, so every directory's contents end up next to each other */
+- (TOSMBShareIndexTable *)tableFromRootNode:(TOSMBShareIndexCrawlNode *)root previousTable:(TOSMBShareIndexTable *)previousTable{
+    TOSMBShareIndexTableBuilder *builder = [[TOSMBShareIndexTableBuilder alloc] initWithRootWriteTime:root.writeTime];
+    root.record = 0;
+
+    NSMutableArray<TOSMBShareIndexCrawlNode *> *nodes = [NSMutableArray arrayWithObject:root];
+    for (NSUInteger n = 0; n < nodes.count; n++) {
+        @autoreleasepool {
+            TOSMBShareIndexCrawlNode *node = nodes[n];
+            NSEnumerator<TOSMBShareIndexCrawlNode *> *subdirectories = node.subdirectories.objectEnumerator;
+            const uint32_t first = builder.recordCount;
+
+            if (node.fileList) {
+                TOSMBSessionFileList *fileList = node.fileList;
+                for (NSUInteger i = 0; i < fileList.count; i++) {
+                    const char *name = [fileList UTF8NameAtIndex:i];
+                    const BOOL directory = [fileList isDirectoryAtIndex:i];
+                    const uint32_t record = [builder appendRecordWithUTF8Name:name
+                                                                       length:strlen(name)
+                                                                   foldedName:NULL
+                                                                 foldedLength:0
+                                                                       parent:node.record
+                                                                    directory:directory
+                                                                         size:[fileList fileSizeAtIndex:i]
+                                                                    writeTime:[fileList writeFileTimeAtIndex:i]];
+                    if (directory) {
+                        TOSMBShareIndexCrawlNode *subdirectory = subdirectories.nextObject;
+                        subdirectory.record = record;
+                        [nodes addObject:subdirectory];
+                    }
+                }
+                node.fileList = nil;
+            }
+            else if (node.reused) {
+                const NSRange children = [previousTable childRangeOfRecordAtIndex:node.previousRecord];
+                for (uint32_t i = (uint32_t)children.location; i < NSMaxRange(children); i++) {
+                    const TOSMBShareIndexRecord *child = &previousTable.records[i];
+                    const BOOL directory = (child->flags & TOSMBShareIndexRecordFlagDirectory) != 0;
+                    //The lengths come from the checked names, not the record, in case the record is damaged
+                    const char *name = [previousTable UTF8NameAtIndex:i];
+                    const char *foldedName = [previousTable foldedUTF8NameAtIndex:i];
+                    const uint32_t record = [builder appendRecordWithUTF8Name:name
+                                                                       length:strlen(name)
+                                                                   foldedName:foldedName
+                                                                 foldedLength:strlen(foldedName)
+                                                                       parent:node.record
+                                                                    directory:directory
+                                                                         size:child->size
+                                                                    writeTime:child->writeTime];
+                    if (directory) {
+                        TOSMBShareIndexCrawlNode *subdirectory = subdirectories.nextObject;
+                        subdirectory.record = record;
+                        [nodes addObject:subdirectory];
+                    }
+                }
+            }
+
+            const uint64_t writeTime = node.listingFailed ? 0 : node.writeTime;
+            [builder setChildrenOfRecord:node.record first:first count:builder.recordCount - first writeTime:writeTime];
+        }
+    }
+
+    return [builder finish];
+}
+
+#pragma mark - Periodic Crawls -
+
+- (void)startPeriodicCrawlsWithInterval:(NSTimeInterval)interval{
+    NSParameterAssert(interval > 0);
+    [self stopPeriodicCrawls];
+
+    dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.timerQueue);
+    dispatch_source_set_timer(timer,
+                              DISPATCH_TIME_NOW,
+                              (uint64_t)(interval * NSEC_PER_SEC),
+                              (uint64_t)(NSEC_PER_SEC));
+    TOSMBMakeWeakReference();
+    dispatch_source_set_event_handler(timer, ^{
+        TOSMBMakeStrongFromWeakReference();
+        if (strongSelf.crawling == NO) {
+            [strongSelf crawlWithCompletionHandler:nil];
+        }
+    });
+    @synchronized (self) {
+        self.crawlTimer = timer;
+    }
+    dispatch_resume(timer);
+}
+
+- (void)stopPeriodicCrawls{
+    @synchronized (self) {
+        if (self.crawlTimer) {
+            dispatch_source_cancel(self.crawlTimer);
+            self.crawlTimer = nil;
+        }
+    }
+}
+
+- (void)cancel{
+    self.cancelled = YES;
+}
+
+#pragma mark - Searching -
+
+- (NSArray<TOSMBSessionFile *> *)filesMatchingString:(NSString *)string match:(TOSMBShareIndexMatch)match limit:(NSUInteger)limit{
+    TOSMBShareIndexTable *table = self.table;
+    if (table == nil || string.length == 0) {
+        return @[];
+    }
+
+    NSData *query = [TOSMBShareIndexFoldedString(string) dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableArray<TOSMBSessionFile *> *files = [NSMutableArray array];
+    [table enumerateRecordsMatchingFoldedUTF8String:query.bytes
+                                             length:query.length
+                                             prefix:(match == TOSMBShareIndexMatchPrefix)
+                                         usingBlock:^(uint32_t index, BOOL *stop) {
+        [files addObject:[self fileForRecord:index inTable:table]];
+        if (limit > 0 && files.count >= limit) {
+            *stop = YES;
+        }
+    }];
+    return files;
+}
+
+- (TOSMBSessionFile *)fileForRecord:(uint32_t)index inTable:(TOSMBShareIndexTable *)table{
+    const TOSMBShareIndexRecord *record = &table.records[index];
+    NSString *relativePath = [table relativePathAtIndex:index];
+    NSString *fullPath = self.rootPath.isRoot ?
+    [@"/" stringByAppendingString:relativePath] :
+    [self.rootPath.string stringByAppendingFormat:@"/%@", relativePath];
+
+    TOSMBSessionFile *file = [[TOSMBSessionFile alloc] initWithName:[table nameAtIndex:index]
+                                                           fullPath:fullPath
+                                                          directory:(record->flags & TOSMBShareIndexRecordFlagDirectory) != 0];
+    file.isShareRoot = (self.rootPath.isRoot && record->parent == 0);
+    file.fileSize = record->size;
+    file.writeTimestamp = record->writeTime;
+    return file;
+}
+
+#pragma mark - Debug -
+
+- (NSString *)description{
+    return [NSString stringWithFormat:@"Share Index - Root: %@ | Items: %lu | Crawling: %@",
+            self.rootPath.string, (unsigned long)self.itemCount, self.crawling ? @"YES" : @"NO"];
+}
+
+@end
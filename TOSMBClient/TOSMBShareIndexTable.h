@@ -0,0 +1,116 @@
+//
+//  TOSMBShareIndexTable.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/* Stands in for a missing record, e.g. the parent of the root */
+extern const uint32_t TOSMBShareIndexNoRecord;
+
+typedef NS_OPTIONS(uint32_t, TOSMBShareIndexRecordFlags) {
+    TOSMBShareIndexRecordFlagDirectory = 1 << 0
+};
+
+/**
+ One indexed item. Record 0 is the indexed folder itself, and the children of every directory
+ are stored next to each other, so a directory's contents are a single range of records.
+ */
+typedef struct {
+    uint32_t parent;
+    uint32_t firstChild;
+    uint32_t childCount;
+    uint32_t nameOffset;        /* Into the names, which are UTF-8 and NUL terminated */
+    uint32_t foldedNameOffset;  /* Into the folded names that searches run against */
+    uint16_t nameLength;
+    uint16_t foldedNameLength;
+    uint64_t size;
+    uint64_t writeTime;         /* Windows FILETIME. For directories, the write time their children were listed at. 0 if unknown. */
+    uint32_t flags;
+    uint32_t reserved;
+} TOSMBShareIndexRecord;
+
+/** Folds case, diacritics and width, so searches match the way people type names */
+extern NSString *TOSMBShareIndexFoldedString(NSString *string);
+
+/**
+ An immutable index of a folder tree, held in one contiguous buffer that is written to disk as is
+ and memory mapped when read back, so opening even a large index costs next to nothing.
+
+ Folded names are broken into trigrams (every run of three bytes), which are hashed into a fixed
+ number of buckets. Each bucket holds the sorted list of records whose names contain one of its
+ trigrams. A search intersects the lists of the query's trigrams and only compares names for the
+ few records that are left. Hash collisions only add candidates, which that comparison removes.
+ */
+@interface TOSMBShareIndexTable : NSObject
+
+/**
+ Returns nil if the header doesn't describe a valid index. The records aren't read until they are
+ used, and one that turns out to be damaged reads as having no name and no children.
+ */
+- (nullable instancetype)initWithData:(NSData *)data error:(NSError **)error;
+
++ (nullable instancetype)tableWithContentsOfURL:(NSURL *)URL error:(NSError **)error;
+
+@property (nonatomic, readonly) NSData *data;
+@property (nonatomic, readonly) uint32_t recordCount;
+@property (nonatomic, readonly) const TOSMBShareIndexRecord *records NS_RETURNS_INNER_POINTER;
+
+- (const char *)UTF8NameAtIndex:(uint32_t)index NS_RETURNS_INNER_POINTER;
+- (const char *)foldedUTF8NameAtIndex:(uint32_t)index NS_RETURNS_INNER_POINTER;
+- (NSString *)nameAtIndex:(uint32_t)index;
+
+/** The records holding a record's children. Use this rather than the record's own fields, as it is bounds checked. */
+- (NSRange)childRangeOfRecordAtIndex:(uint32_t)index;
+
+/** The path of a record relative to record 0, using "/" as the separator */
+- (NSString *)relativePathAtIndex:(uint32_t)index;
+
+/**
+ Calls the block for every record, other than record 0, whose folded name contains the folded
+ query, or starts with it if `prefix` is set. Records are visited in index order.
+ */
+- (void)enumerateRecordsMatchingFoldedUTF8String:(const char *)query
+                                          length:(size_t)length
+                                          prefix:(BOOL)prefix
+                                      usingBlock:(void (^)(uint32_t index, BOOL *stop))block;
+
+- (BOOL)writeToURL:(NSURL *)URL error:(NSError **)error;
+
+@end
+
+/**
+ Builds a table one directory at a time. Append a directory's children, then call
+ `setChildrenOfRecord:` for it before moving on to the next directory.
+ */
+@interface TOSMBShareIndexTableBuilder : NSObject
+
+/** Starts the table with record 0, the indexed folder */
+- (instancetype)initWithRootWriteTime:(uint64_t)writeTime;
+
+@property (nonatomic, readonly) uint32_t recordCount;
+
+/** Appends a record and returns its index. Pass a NULL folded name to have it worked out. */
+- (uint32_t)appendRecordWithUTF8Name:(const char *)name
+                              length:(size_t)length
+                          foldedName:(nullable const char *)foldedName
+                        foldedLength:(size_t)foldedLength
+                              parent:(uint32_t)parent
+                           directory:(BOOL)directory
+                                size:(uint64_t)size
+                           writeTime:(uint64_t)writeTime;
+
+/** Records the range of children appended for a directory, and the write time they were listed at */
+- (void)setChildrenOfRecord:(uint32_t)index first:(uint32_t)first count:(uint32_t)count writeTime:(uint64_t)writeTime;
+
+/** Builds the trigram buckets and returns the finished table. The builder can't be used afterwards. */
+- (TOSMBShareIndexTable *)finish;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,487 @@
+//
+//  TOSMBShareIndexTable.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBShareIndexTable.h"
+
+const uint32_t TOSMBShareIndexNoRecord = UINT32_MAX;
+
+static const uint32_t kTOSMBShareIndexMagic = 0x58444954; // "TIDX"
+static const uint32_t kTOSMBShareIndexVersion = 1;
+
+/* Trigrams are hashed into 2^16 buckets, which keeps the bucket table at 256 KB whatever the index size */
+static const uint32_t kTOSMBShareIndexBucketBits = 16;
+static const uint32_t kTOSMBShareIndexBucketCount = 1 << kTOSMBShareIndexBucketBits;
+
+static const size_t kTOSMBShareIndexTrigramLength = 3;
+
+/* The index is stored in native byte order, which is little-endian on every Apple platform */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordCount;
+    uint32_t bucketCount;
+    uint32_t postingCount;
+    uint32_t namesLength;
+    uint32_t foldedNamesLength;
+    uint32_t reserved;
+} TOSMBShareIndexHeader;
+
+NSString *TOSMBShareIndexFoldedString(NSString *string){
+    NSString *folded = [string stringByFoldingWithOptions:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch | NSWidthInsensitiveSearch
+                                                   locale:nil];
+    return folded.precomposedStringWithCanonicalMapping;
+}
+
+static inline uint32_t TOSMBShareIndexBucketForTrigram(const char *bytes){
+    const uint8_t *trigram = (const uint8_t *)bytes;
+    const uint32_t value = (uint32_t)trigram[0] | ((uint32_t)trigram[1] << 8) | ((uint32_t)trigram[2] << 16);
+    return (value * 2654435761u) >> (32 - kTOSMBShareIndexBucketBits);
+}
+
+static NSError *TOSMBShareIndexCorruptError(void){
+    return [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:nil];
+}
+
+#pragma mark - Table -
+
+@interface TOSMBShareIndexTable () {
+    const TOSMBShareIndexRecord *_records;
+    const uint32_t *_bucketOffsets;
+    const uint32_t *_postings;
+    const char *_names;
+    const char *_foldedNames;
+    uint32_t _recordCount;
+    uint32_t _postingCount;
+    uint32_t _namesLength;
+    uint32_t _foldedNamesLength;
+}
+
+@property (nonatomic, strong, readwrite) NSData *data;
+
+@end
+
+@implementation TOSMBShareIndexTable
+
++ (instancetype)tableWithContentsOfURL:(NSURL *)URL error:(NSError **)error{
+    NSData *data = [NSData dataWithContentsOfURL:URL options:NSDataReadingMappedIfSafe error:error];
+    if (data == nil) {
+        return nil;
+    }
+    return [[TOSMBShareIndexTable alloc] initWithData:data error:error];
+}
+
+/* Only the header is checked here, so opening a large mapped index doesn't read all of it. Every
+   offset taken from the records and buckets is checked when a lookup uses it instead. */
+- (instancetype)initWithData:(NSData *)data error:(NSError **)error{
+    self = [self initWithTrustedData:data];
+    if (self == nil) {
+        if (error) {
+            *error = TOSMBShareIndexCorruptError();
+        }
+        return nil;
+    }
+    return self;
+}
+
+/* Sets up the pointers into the data, after checking that the sections fit in it */
+- (instancetype)initWithTrustedData:(NSData *)data{
+    if (data.length < sizeof(TOSMBShareIndexHeader)) {
+        return nil;
+    }
+    const TOSMBShareIndexHeader *header = data.bytes;
+    if (header->magic != kTOSMBShareIndexMagic || header->version != kTOSMBShareIndexVersion ||
+        header->bucketCount != kTOSMBShareIndexBucketCount || header->recordCount == 0) {
+        return nil;
+    }
+    const uint64_t expectedLength = sizeof(TOSMBShareIndexHeader) +
+    (uint64_t)header->recordCount * sizeof(TOSMBShareIndexRecord) +
+    ((uint64_t)header->bucketCount + 1) * sizeof(uint32_t) +
+    (uint64_t)header->postingCount * sizeof(uint32_t) +
+    header->namesLength + header->foldedNamesLength;
+    if (data.length != expectedLength) {
+        return nil;
+    }
+
+    self = [super init];
+    if (self) {
+        _data = data;
+        _recordCount = header->recordCount;
+        _postingCount = header->postingCount;
+        _namesLength = header->namesLength;
+        _foldedNamesLength = header->foldedNamesLength;
+        const char *bytes = data.bytes;
+        size_t offset = sizeof(TOSMBShareIndexHeader);
+        _records = (const TOSMBShareIndexRecord *)(bytes + offset);
+        offset += _recordCount * sizeof(TOSMBShareIndexRecord);
+        _bucketOffsets = (const uint32_t *)(bytes + offset);
+        offset += (kTOSMBShareIndexBucketCount + 1) * sizeof(uint32_t);
+        _postings = (const uint32_t *)(bytes + offset);
+        offset += header->postingCount * sizeof(uint32_t);
+        _names = bytes + offset;
+        _foldedNames = _names + header->namesLength;
+    }
+    return self;
+}
+
+/* Whether both of a record's names lie inside their sections and end where the record says. A damaged
+   record reads as one with no name, so a bad file can never make a lookup read out of bounds. */
+static inline BOOL TOSMBShareIndexTableNamesAreValid(TOSMBShareIndexTable *table, uint32_t index){
+    const TOSMBShareIndexRecord *record = &table->_records[index];
+    return ((uint64_t)record->nameOffset + record->nameLength < table->_namesLength &&
+            table->_names[record->nameOffset + record->nameLength] == '\0' &&
+            (uint64_t)record->foldedNameOffset + record->foldedNameLength < table->_foldedNamesLength &&
+            table->_foldedNames[record->foldedNameOffset + record->foldedNameLength] == '\0');
+}
+
+#pragma mark - Accessors -
+
+- (uint32_t)recordCount{
+    return _recordCount;
+}
+
+- (const TOSMBShareIndexRecord *)records{
+    return _records;
+}
+
+- (const char *)UTF8NameAtIndex:(uint32_t)index{
+    NSParameterAssert(index < _recordCount);
+    if (index >= _recordCount || TOSMBShareIndexTableNamesAreValid(self, index) == NO) {
+        return "";
+    }
+    return _names + _records[index].nameOffset;
+}
+
+- (const char *)foldedUTF8NameAtIndex:(uint32_t)index{
+    NSParameterAssert(index < _recordCount);
+    if (index >= _recordCount || TOSMBShareIndexTableNamesAreValid(self, index) == NO) {
+        return "";
+    }
+    return _foldedNames + _records[index].foldedNameOffset;
+}
+
+- (NSString *)nameAtIndex:(uint32_t)index{
+    NSParameterAssert(index < _recordCount);
+    if (index >= _recordCount || TOSMBShareIndexTableNamesAreValid(self, index) == NO) {
+        return @"";
+    }
+    return [[NSString alloc] initWithBytes:_names + _records[index].nameOffset
+                                    length:_records[index].nameLength
+                                  encoding:NSUTF8StringEncoding] ?: @"";
+}
+
+- (NSRange)childRangeOfRecordAtIndex:(uint32_t)index{
+    NSParameterAssert(index < _recordCount);
+    if (index >= _recordCount) {
+        return NSMakeRange(0, 0);
+    }
+    //Children are always stored after their parent, which also keeps a damaged file from looping
+    const TOSMBShareIndexRecord *record = &_records[index];
+    if (record->childCount == 0 || record->firstChild <= index ||
+        (uint64_t)record->firstChild + record->childCount > _recordCount) {
+        return NSMakeRange(0, 0);
+    }
+    return NSMakeRange(record->firstChild, record->childCount);
+}
+
+- (NSString *)relativePathAtIndex:(uint32_t)index{
+    NSMutableArray<NSString *> *components = [NSMutableArray array];
+    for (uint32_t i = index; i != 0 && i < _recordCount; i = _records[i].parent) {
+        [components insertObject:[self nameAtIndex:i] atIndex:0];
+        //Parents are always stored before their children
+        if (_records[i].parent >= i) {
+            break;
+        }
+    }
+    return [components componentsJoinedByString:@"/"];
+}
+
+#pragma mark - Searching -
+
+typedef struct {
+    const uint32_t *postings;
+    uint32_t count;
+} TOSMBShareIndexPostingList;
+
+static int TOSMBShareIndexComparePostingLists(const void *a, const void *b){
+    const uint32_t countA = ((const TOSMBShareIndexPostingList *)a)->count;
+    const uint32_t countB = ((const TOSMBShareIndexPostingList *)b)->count;
+    return (countA < countB) ? -1 : (countA > countB);
+}
+
+static inline BOOL TOSMBShareIndexNameMatches(const char *name, size_t nameLength, const char *query, size_t length, BOOL prefix){
+    if (nameLength < length) {
+        return NO;
+    }
+    if (prefix) {
+        return (memcmp(name, query, length) == 0);
+    }
+    return (memmem(name, nameLength, query, length) != NULL);
+}
+
+- (void)enumerateRecordsMatchingFoldedUTF8String:(const char *)query
+                                          length:(size_t)length
+                                          prefix:(BOOL)prefix
+                                      usingBlock:(void (^)(uint32_t, BOOL *))block
+{
+    NSParameterAssert(query);
+    NSParameterAssert(block);
+    if (length == 0 || length > UINT16_MAX) {
+        return;
+    }
+
+    BOOL stop = NO;
+
+    //Too short to have a trigram, so compare against every name
+    if (length < kTOSMBShareIndexTrigramLength) {
+        for (uint32_t i = 1; i < _recordCount && stop == NO; i++) {
+            const TOSMBShareIndexRecord *record = &_records[i];
+            if (TOSMBShareIndexTableNamesAreValid(self, i) &&
+                TOSMBShareIndexNameMatches(_foldedNames + record->foldedNameOffset, record->foldedNameLength, query, length, prefix)) {
+                block(i, &stop);
+            }
+        }
+        return;
+    }
+
+    //Gather the posting list of each distinct bucket the query touches, shortest first
+    const size_t trigramCount = length - kTOSMBShareIndexTrigramLength + 1;
+    TOSMBShareIndexPostingList *lists = malloc(trigramCount * sizeof(TOSMBShareIndexPostingList));
+    uint32_t *buckets = malloc(trigramCount * sizeof(uint32_t));
+    size_t listCount = 0;
+    for (size_t i = 0; i < trigramCount; i++) {
+        const uint32_t bucket = TOSMBShareIndexBucketForTrigram(query + i);
+        BOOL seen = NO;
+        for (size_t j = 0; j < listCount && seen == NO; j++) {
+            seen = (buckets[j] == bucket);
+        }
+        if (seen) {
+            continue;
+        }
+        buckets[listCount] = bucket;
+        lists[listCount].postings = _postings + _bucketOffsets[bucket];
+        lists[listCount].count = _bucketOffsets[bucket + 1] - _bucketOffsets[bucket];
+        //A damaged bucket can't hold any matches
+        if (_bucketOffsets[bucket] > _bucketOffsets[bucket + 1] || _bucketOffsets[bucket + 1] > _postingCount) {
+            lists[listCount].postings = _postings;
+            lists[listCount].count = 0;
+        }
+        listCount++;
+    }
+    free(buckets);
+    qsort(lists, listCount, sizeof(TOSMBShareIndexPostingList), TOSMBShareIndexComparePostingLists);
+
+    //Intersect, starting from the shortest list so the candidates only ever shrink
+    uint32_t candidateCount = lists[0].count;
+    uint32_t *candidates = malloc(MAX(candidateCount, 1) * sizeof(uint32_t));
+    memcpy(candidates, lists[0].postings, candidateCount * sizeof(uint32_t));
+    for (size_t l = 1; l < listCount && candidateCount > 0; l++) {
+        const uint32_t *postings = lists[l].postings;
+        const uint32_t count = lists[l].count;
+        uint32_t position = 0;
+        uint32_t kept = 0;
+        for (uint32_t c = 0; c < candidateCount && position < count; c++) {
+            //Binary search forward from the last position, as both lists are sorted
+            uint32_t low = position;
+            uint32_t high = count;
+            while (low < high) {
+                const uint32_t middle = low + (high - low) / 2;
+                if (postings[middle] < candidates[c]) {
+                    low = middle + 1;
+                }
+                else {
+                    high = middle;
+                }
+            }
+            position = low;
+            if (position < count && postings[position] == candidates[c]) {
+                candidates[kept++] = candidates[c];
+            }
+        }
+        candidateCount = kept;
+    }
+    free(lists);
+
+    for (uint32_t c = 0; c < candidateCount && stop == NO; c++) {
+        if (candidates[c] >= _recordCount || TOSMBShareIndexTableNamesAreValid(self, candidates[c]) == NO) {
+            continue;
+        }
+        const TOSMBShareIndexRecord *record = &_records[candidates[c]];
+        if (TOSMBShareIndexNameMatches(_foldedNames + record->foldedNameOffset, record->foldedNameLength, query, length, prefix)) {
+            block(candidates[c], &stop);
+        }
+    }
+    free(candidates);
+}
+
+#pragma mark - Writing -
+
+- (BOOL)writeToURL:(NSURL *)URL error:(NSError **)error{
+    return [self.data writeToURL:URL options:NSDataWritingAtomic error:error];
+}
+
+#pragma mark - Debug -
+
+- (NSString *)description{
+    return [NSString stringWithFormat:@"Share Index Table - Records: %u | Size: %lu", _recordCount, (unsigned long)self.data.length];
+}
+
+@end
+
+#pragma mark - Builder -
+
+@interface TOSMBShareIndexTableBuilder ()
+
+@property (nonatomic, strong) NSMutableData *records;
+@property (nonatomic, strong) NSMutableData *names;
+@property (nonatomic, strong) NSMutableData *foldedNames;
+
+@end
+
+@implementation TOSMBShareIndexTableBuilder
+
+- (instancetype)initWithRootWriteTime:(uint64_t)writeTime{
+    self = [super init];
+    if (self) {
+        _records = [NSMutableData data];
+        _names = [NSMutableData data];
+        _foldedNames = [NSMutableData data];
+        [self appendRecordWithUTF8Name:"" length:0 foldedName:"" foldedLength:0
+                                parent:TOSMBShareIndexNoRecord directory:YES size:0 writeTime:writeTime];
+    }
+    return self;
+}
+
+- (uint32_t)recordCount{
+    return (uint32_t)(self.records.length / sizeof(TOSMBShareIndexRecord));
+}
+
+- (uint32_t)appendRecordWithUTF8Name:(const char *)name
+                              length:(size_t)length
+                          foldedName:(const char *)foldedName
+                        foldedLength:(size_t)foldedLength
+                              parent:(uint32_t)parent
+                           directory:(BOOL)directory
+                                size:(uint64_t)size
+                           writeTime:(uint64_t)writeTime
+{
+    NSParameterAssert(name);
+    NSParameterAssert(self.records);
+
+    NSData *foldedData = nil;
+    if (foldedName == NULL) {
+        NSString *string = [[NSString alloc] initWithBytes:name length:length encoding:NSUTF8StringEncoding] ?: @"";
+        foldedData = [TOSMBShareIndexFoldedString(string) dataUsingEncoding:NSUTF8StringEncoding];
+        foldedName = foldedData.bytes ?: "";
+        foldedLength = foldedData.length;
+    }
+    length = MIN(length, UINT16_MAX);
+    foldedLength = MIN(foldedLength, UINT16_MAX);
+
+    TOSMBShareIndexRecord record = {0};
+    record.parent = parent;
+    record.nameOffset = (uint32_t)self.names.length;
+    record.nameLength = (uint16_t)length;
+    record.foldedNameOffset = (uint32_t)self.foldedNames.length;
+    record.foldedNameLength = (uint16_t)foldedLength;
+    record.flags = directory ? TOSMBShareIndexRecordFlagDirectory : 0;
+    record.size = size;
+    record.writeTime = writeTime;
+
+    [self.names appendBytes:name length:length];
+    [self.names appendBytes:"\0" length:1];
+    [self.foldedNames appendBytes:foldedName length:foldedLength];
+    [self.foldedNames appendBytes:"\0" length:1];
+
+    const uint32_t index = self.recordCount;
+    [self.records appendBytes:&record length:sizeof(record)];
+    return index;
+}
+
+- (void)setChildrenOfRecord:(uint32_t)index first:(uint32_t)first count:(uint32_t)count writeTime:(uint64_t)writeTime{
+    NSParameterAssert(index < self.recordCount);
+    NSParameterAssert(first + count <= self.recordCount);
+    TOSMBShareIndexRecord *record = (TOSMBShareIndexRecord *)self.records.mutableBytes + index;
+    record->firstChild = first;
+    record->childCount = count;
+    record->writeTime = writeTime;
+}
+
+/* Calls the block once for every distinct bucket among a name's trigrams */
+static void TOSMBShareIndexEnumerateBuckets(const char *name, size_t length, uint32_t record, uint32_t *lastRecordInBucket,
+                                            void (^block)(uint32_t bucket))
+{
+    for (size_t i = 0; i + kTOSMBShareIndexTrigramLength <= length; i++) {
+        const uint32_t bucket = TOSMBShareIndexBucketForTrigram(name + i);
+        if (lastRecordInBucket[bucket] == record) {
+            continue;
+        }
+        lastRecordInBucket[bucket] = record;
+        block(bucket);
+    }
+}
+
+- (TOSMBShareIndexTable *)finish{
+    NSParameterAssert(self.records);
+
+    const uint32_t recordCount = self.recordCount;
+    const TOSMBShareIndexRecord *records = self.records.bytes;
+    const char *foldedNames = self.foldedNames.bytes;
+
+    //First pass counts the records in each bucket, the second one fills them in. Walking the
+    //records in order leaves every bucket sorted.
+    uint32_t *bucketOffsets = calloc(kTOSMBShareIndexBucketCount + 1, sizeof(uint32_t));
+    uint32_t *lastRecordInBucket = malloc(kTOSMBShareIndexBucketCount * sizeof(uint32_t));
+    memset(lastRecordInBucket, 0xFF, kTOSMBShareIndexBucketCount * sizeof(uint32_t));
+    for (uint32_t i = 1; i < recordCount; i++) {
+        TOSMBShareIndexEnumerateBuckets(foldedNames + records[i].foldedNameOffset, records[i].foldedNameLength, i, lastRecordInBucket, ^(uint32_t bucket) {
+            bucketOffsets[bucket + 1]++;
+        });
+    }
+    for (uint32_t i = 0; i < kTOSMBShareIndexBucketCount; i++) {
+        bucketOffsets[i + 1] += bucketOffsets[i];
+    }
+    const uint32_t postingCount = bucketOffsets[kTOSMBShareIndexBucketCount];
+
+    TOSMBShareIndexHeader header = {0};
+    header.magic = kTOSMBShareIndexMagic;
+    header.version = kTOSMBShareIndexVersion;
+    header.recordCount = recordCount;
+    header.bucketCount = kTOSMBShareIndexBucketCount;
+    header.postingCount = postingCount;
+    header.namesLength = (uint32_t)self.names.length;
+    header.foldedNamesLength = (uint32_t)self.foldedNames.length;
+
+    NSMutableData *data = [NSMutableData dataWithCapacity:sizeof(header) + self.records.length +
+                           (kTOSMBShareIndexBucketCount + 1) * sizeof(uint32_t) + postingCount * sizeof(uint32_t) +
+                           self.names.length + self.foldedNames.length];
+    [data appendBytes:&header length:sizeof(header)];
+    [data appendData:self.records];
+    [data appendBytes:bucketOffsets length:(kTOSMBShareIndexBucketCount + 1) * sizeof(uint32_t)];
+    const NSUInteger postingsOffset = data.length;
+    [data increaseLengthBy:postingCount * sizeof(uint32_t)];
+    [data appendData:self.names];
+    [data appendData:self.foldedNames];
+
+    uint32_t *postings = (uint32_t *)((char *)data.mutableBytes + postingsOffset);
+    uint32_t *cursors = bucketOffsets;
+    memset(lastRecordInBucket, 0xFF, kTOSMBShareIndexBucketCount * sizeof(uint32_t));
+    for (uint32_t i = 1; i < recordCount; i++) {
+        TOSMBShareIndexEnumerateBuckets(foldedNames + records[i].foldedNameOffset, records[i].foldedNameLength, i, lastRecordInBucket, ^(uint32_t bucket) {
+            postings[cursors[bucket]++] = i;
+        });
+    }
+    free(lastRecordInBucket);
+    free(bucketOffsets);
+
+    self.records = nil;
+    self.names = nil;
+    self.foldedNames = nil;
+    return [[TOSMBShareIndexTable alloc] initWithTrustedData:data];
+}
+
+@end
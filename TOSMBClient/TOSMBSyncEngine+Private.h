@@ -0,0 +1,49 @@
+//
+//  TOSMBSyncEngine+Private.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBSyncEngine.h"
+#import "TOSMBSyncSnapshot.h"
+
+@interface TOSMBSyncAction ()
+
+@property (nonatomic, assign, readwrite) TOSMBSyncActionType type;
+@property (nonatomic, copy, readwrite) NSString *path;
+@property (nonatomic, assign, readwrite) BOOL directory;
+@property (nonatomic, assign, readwrite) uint64_t size;
+@property (nonatomic, strong, readwrite) NSError *error;
+
+@property (nonatomic, strong) TOSMBSyncEntry *baseEntry;
+@property (nonatomic, strong) TOSMBSyncEntry *remoteEntry;
+@property (nonatomic, strong) TOSMBSyncEntry *localEntry;
+
+/* For a directory deletion, the snapshot entries of everything inside it, kept in case the deletion fails */
+@property (nonatomic, copy) NSArray<TOSMBSyncEntry *> *descendantBaseEntries;
+
+/* The snapshot entry once the action succeeded. Nil when the item no longer exists. */
+@property (nonatomic, strong) TOSMBSyncEntry *resultEntry;
+@property (nonatomic, assign) BOOL completed;
+
+@end
+
+@interface TOSMBSyncEngine ()
+
+/* Merges the three streams in path order and works out the actions. Unchanged items are written to the writer. */
+- (BOOL)planActions:(NSMutableArray<TOSMBSyncAction *> *)actions
+             result:(TOSMBSyncResult *)result
+    unchangedWriter:(TOSMBSyncSnapshotWriter *)unchangedWriter
+         baseSource:(id<TOSMBSyncEntrySource>)baseSource
+       remoteSource:(id<TOSMBSyncEntrySource>)remoteSource
+        localSource:(id<TOSMBSyncEntrySource>)localSource
+              error:(NSError **)error;
+
+/* Writes the new snapshot from the unchanged entries and the outcome of every action */
+- (BOOL)saveSnapshotMergingUnchangedURL:(NSURL *)unchangedURL
+                                actions:(NSArray<TOSMBSyncAction *> *)actions
+                                  error:(NSError **)error;
+
+@end
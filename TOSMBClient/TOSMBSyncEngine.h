@@ -0,0 +1,125 @@
+//
+//  TOSMBSyncEngine.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class TOSMBSession;
+@class TOSMBPath;
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSInteger, TOSMBSyncDirection) {
+    TOSMBSyncDirectionDownload,         /* Mirror the folder on the device to the local folder */
+    TOSMBSyncDirectionUpload,           /* Mirror the local folder to the folder on the device */
+    TOSMBSyncDirectionBidirectional     /* Carry changes made on either side over to the other */
+};
+
+/** What a two-way sync does with a file that changed on both sides since the last sync */
+typedef NS_ENUM(NSInteger, TOSMBSyncConflictPolicy) {
+    TOSMBSyncConflictPolicyNewerWins,
+    TOSMBSyncConflictPolicyPreferRemote,
+    TOSMBSyncConflictPolicyPreferLocal,
+    TOSMBSyncConflictPolicySkip         /* Leave both copies alone and report the conflict */
+};
+
+typedef NS_ENUM(NSInteger, TOSMBSyncActionType) {
+    TOSMBSyncActionTypeDownload,
+    TOSMBSyncActionTypeUpload,
+    TOSMBSyncActionTypeCreateLocalDirectory,
+    TOSMBSyncActionTypeCreateRemoteDirectory,
+    TOSMBSyncActionTypeDeleteLocal,
+    TOSMBSyncActionTypeDeleteRemote,
+    TOSMBSyncActionTypeConflict         /* Nothing was done. The item needs attention. */
+};
+
+/** One change made, or planned, by a sync */
+@interface TOSMBSyncAction : NSObject
+
+@property (nonatomic, readonly) TOSMBSyncActionType type;
+@property (nonatomic, readonly, copy) NSString *path;       /** Relative to the synced folders */
+@property (nonatomic, readonly) BOOL directory;
+@property (nonatomic, readonly) uint64_t size;              /** Bytes to transfer, for downloads and uploads */
+@property (nonatomic, readonly, nullable) NSError *error;   /** Set if the action failed */
+
+@end
+
+@interface TOSMBSyncResult : NSObject
+
+/** Every action, in path order. Unchanged items are not listed. */
+@property (nonatomic, readonly, copy) NSArray<TOSMBSyncAction *> *actions;
+@property (nonatomic, readonly, copy) NSArray<TOSMBSyncAction *> *failedActions;
+
+@property (nonatomic, readonly) NSUInteger scannedItemCount;    /** Items seen on either side */
+@property (nonatomic, readonly) NSUInteger unchangedItemCount;
+@property (nonatomic, readonly) uint64_t transferredByteCount;
+
+@end
+
+/**
+ Keeps a folder on an SMB device and a local folder in sync, transferring only what changed.
+
+ After every sync a compact binary snapshot of both trees (path, size and write time of every item)
+ is saved. The next sync walks the device and the local folder again and streams both walks and the
+ saved snapshot through a single merge, so it can tell which side changed without re-reading any
+ file contents. The walks and the merge hold only the current branch of each tree in memory, so
+ trees with millions of items can be synced; memory use grows with the number of changes instead.
+
+ Nothing is transferred if either walk fails, and items whose transfer fails keep their previous
+ snapshot entry, so they are retried by the next sync.
+ */
+@interface TOSMBSyncEngine : NSObject
+
+/**
+ @param session The session for the device
+ @param remotePath The folder on the device. It must be inside a share.
+ @param localURL The local folder
+ @param snapshotURL Where the snapshot is saved between syncs. A new file means everything that differs is transferred.
+ */
+- (instancetype)initWithSession:(TOSMBSession *)session
+                     remotePath:(TOSMBPath *)remotePath
+                       localURL:(NSURL *)localURL
+                    snapshotURL:(NSURL *)snapshotURL;
+
+@property (nonatomic, readonly) TOSMBSession *session;
+@property (nonatomic, readonly) TOSMBPath *remotePath;
+@property (nonatomic, readonly) NSURL *localURL;
+@property (nonatomic, readonly) NSURL *snapshotURL;
+
+@property (nonatomic, assign) TOSMBSyncDirection direction;             /** Default is download */
+@property (nonatomic, assign) TOSMBSyncConflictPolicy conflictPolicy;   /** Default is newer wins */
+
+/** Delete items on one side that were removed from the other since the last sync. Default is YES. */
+@property (nonatomic, assign) BOOL propagatesDeletions;
+
+/** Work out what would change, without changing anything or saving the snapshot */
+@property (nonatomic, assign) BOOL dryRun;
+
+/** Directory listings requested ahead of the walk at once. Default is 4. */
+@property (nonatomic, assign) NSUInteger maximumConcurrentListings;
+
+/** Transfers run at once. Default is 2. */
+@property (nonatomic, assign) NSUInteger maximumConcurrentTransfers;
+
+/** Called on the session's callback queue as each action finishes */
+@property (atomic, copy, nullable) void (^actionHandler)(TOSMBSyncAction *action);
+
+/**
+ Runs a sync in the background. Syncs started on the same engine run one after the other.
+
+ @param completionHandler Called on the session's callback queue. The error is set if the sync could not run at all.
+ */
+- (NSOperation *)syncWithCompletionHandler:(void (^)(TOSMBSyncResult * _Nullable result, NSError * _Nullable error))completionHandler;
+
+/** Runs a sync on the calling thread. Must not be called on the main thread. */
+- (nullable TOSMBSyncResult *)sync:(NSError **)error;
+
+- (void)cancel;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,897 @@
+//
+//  TOSMBSyncEngine.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <sys/stat.h>
+
+#import "TOSMBSyncEngine.h"
+#import "TOSMBSyncEngine+Private.h"
+#import "TOSMBSyncSnapshot.h"
+#import "TOSMBSyncTreeWalker.h"
+#import "TOSMBSession.h"
+#import "TOSMBSession+Private.h"
+#import "TOSMBSessionFile+Private.h"
+#import "TOSMBSessionFileList.h"
+#import "TOSMBSessionDownloadTask.h"
+#import "TOSMBSessionUploadTask.h"
+#import "TOSMBPath.h"
+#import "NSString+TOSMB.h"
+
+static const NSUInteger kTOSMBSyncEngineDefaultConcurrentListings = 4;
+static const NSUInteger kTOSMBSyncEngineDefaultConcurrentTransfers = 2;
+
+/* Hidden folder inside the local folder that downloads are staged in, so they can replace files atomically */
+static NSString * const kTOSMBSyncEngineStagingDirectoryName = @".tosmbsync";
+
+/* Without a snapshot entry, a file with the same size and times this close on both sides is taken to be in sync */
+static const int64_t kTOSMBSyncEngineTimeTolerance = 2 * 1000000;
+
+/* Difference between the FILETIME epoch (1601) and 1970, in microseconds */
+static const int64_t kTOSMBSyncEngineFileTimeEpochOffset = 11644473600LL * 1000000LL;
+
+static int64_t TOSMBSyncMicrosecondsFromFileTime(uint64_t fileTime){
+    return (int64_t)(fileTime / 10) - kTOSMBSyncEngineFileTimeEpochOffset;
+}
+
+#pragma mark - Action -
+
+@implementation TOSMBSyncAction
+
+- (BOOL)isTransfer{
+    return (self.type == TOSMBSyncActionTypeDownload || self.type == TOSMBSyncActionTypeUpload);
+}
+
+- (BOOL)isDeletion{
+    return (self.type == TOSMBSyncActionTypeDeleteLocal || self.type == TOSMBSyncActionTypeDeleteRemote);
+}
+
+/* A deletion that failed or never ran leaves everything inside the directory where it was */
+- (BOOL)keepsDescendants{
+    return self.isDeletion && (self.completed == NO || self.error != nil);
+}
+
+- (BOOL)isDirectoryCreation{
+    return (self.type == TOSMBSyncActionTypeCreateLocalDirectory || self.type == TOSMBSyncActionTypeCreateRemoteDirectory);
+}
+
+/* What goes into the new snapshot for this item */
+- (TOSMBSyncEntry *)snapshotEntry{
+    if (self.completed && self.error == nil) {
+        return self.resultEntry;
+    }
+    return self.baseEntry;
+}
+
+- (NSString *)description{
+    return [NSString stringWithFormat:@"Sync Action - Type: %ld | Path: %@ | Error: %@", (long)self.type, self.path, self.error];
+}
+
+@end
+
+#pragma mark - Pending Deletion -
+
+/* A directory deletion held back while the walk checks what is inside it */
+@interface TOSMBSyncPendingDeletion : NSObject
+
+@property (nonatomic, strong) TOSMBSyncAction *action;
+@property (nonatomic, assign) BOOL blocked;
+@property (nonatomic, strong) NSMutableArray *items;                            /* Planned actions and unchanged entries */
+@property (nonatomic, strong) NSMutableArray<TOSMBSyncEntry *> *baseEntries;    /* Snapshot entries of the contents */
+
+@end
+
+@implementation TOSMBSyncPendingDeletion
+
+- (instancetype)init{
+    self = [super init];
+    if (self) {
+        _items = [NSMutableArray array];
+        _baseEntries = [NSMutableArray array];
+    }
+    return self;
+}
+
+@end
+
+#pragma mark - Result -
+
+@interface TOSMBSyncResult ()
+
+@property (nonatomic, copy, readwrite) NSArray<TOSMBSyncAction *> *actions;
+@property (nonatomic, copy, readwrite) NSArray<TOSMBSyncAction *> *failedActions;
+@property (nonatomic, assign, readwrite) NSUInteger scannedItemCount;
+@property (nonatomic, assign, readwrite) NSUInteger unchangedItemCount;
+@property (nonatomic, assign, readwrite) uint64_t transferredByteCount;
+
+@end
+
+@implementation TOSMBSyncResult
+
+- (NSString *)description{
+    return [NSString stringWithFormat:@"Sync Result - Scanned: %lu | Unchanged: %lu | Actions: %lu | Failed: %lu | Bytes: %llu",
+            (unsigned long)self.scannedItemCount, (unsigned long)self.unchangedItemCount,
+            (unsigned long)self.actions.count, (unsigned long)self.failedActions.count, self.transferredByteCount];
+}
+
+@end
+
+#pragma mark - Engine -
+
+@interface TOSMBSyncEngine ()
+
+@property (nonatomic, strong, readwrite) TOSMBSession *session;
+@property (nonatomic, strong, readwrite) TOSMBPath *remotePath;
+@property (nonatomic, strong, readwrite) NSURL *localURL;
+@property (nonatomic, strong, readwrite) NSURL *snapshotURL;
+
+@property (atomic, assign) BOOL cancelled;
+@property (atomic, strong) TOSMBSyncRemoteWalker *remoteWalker;
+@property (nonatomic, strong) NSMutableSet<TOSMBSessionTransferTask *> *runningTasks;
+
+/* Syncs run here rather than on the session's request queue, which their own transfers need */
+@property (nonatomic, strong) NSOperationQueue *syncQueue;
+
+@end
+
+@implementation TOSMBSyncEngine
+
+- (instancetype)initWithSession:(TOSMBSession *)session
+                     remotePath:(TOSMBPath *)remotePath
+                       localURL:(NSURL *)localURL
+                    snapshotURL:(NSURL *)snapshotURL
+{
+    NSParameterAssert(session);
+    NSParameterAssert(remotePath.shareName);
+    NSParameterAssert(localURL.isFileURL);
+    NSParameterAssert(snapshotURL.isFileURL);
+    self = [super init];
+    if (self) {
+        _session = session;
+        _remotePath = remotePath;
+        _localURL = [localURL copy];
+        _snapshotURL = [snapshotURL copy];
+        _direction = TOSMBSyncDirectionDownload;
+        _conflictPolicy = TOSMBSyncConflictPolicyNewerWins;
+        _propagatesDeletions = YES;
+        _maximumConcurrentListings = kTOSMBSyncEngineDefaultConcurrentListings;
+        _maximumConcurrentTransfers = kTOSMBSyncEngineDefaultConcurrentTransfers;
+        _runningTasks = [NSMutableSet set];
+        _syncQueue = [[NSOperationQueue alloc] init];
+        _syncQueue.maxConcurrentOperationCount = 1;
+    }
+    return self;
+}
+
+#pragma mark - Public -
+
+- (NSOperation *)syncWithCompletionHandler:(void (^)(TOSMBSyncResult *, NSError *))completionHandler{
+    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
+    TOSMBMakeWeakReference();
+    TOSMBMakeWeakReferenceForOperation();
+
+    id operationBlock = ^{
+        TOSMBCheckIfWeakReferenceForOperationIsCancelledOrNilAndReturn();
+        TOSMBCheckIfWeakReferenceIsNilAndReturn();
+        TOSMBMakeStrongFromWeakReference();
+
+        NSError *error = nil;
+        TOSMBSyncResult *result = [strongSelf sync:&error];
+        if (completionHandler) {
+            [strongSelf.session performCallBackWithBlock:^{ completionHandler(result, error); }];
+        }
+    };
+
+    [operation addExecutionBlock:operationBlock];
+    [self.syncQueue addOperation:operation];
+    return operation;
+}
+
+- (void)cancel{
+    self.cancelled = YES;
+    [self.remoteWalker cancel];
+    @synchronized (self.runningTasks) {
+        [self.runningTasks makeObjectsPerformSelector:@selector(cancel)];
+    }
+}
+
+- (TOSMBSyncResult *)sync:(NSError **)error{
+    NSParameterAssert([NSThread isMainThread] == NO);
+    self.cancelled = NO;
+
+    NSError *resultError = [self.session attemptConnection];
+    if (resultError) {
+        if (error) {
+            *error = resultError;
+        }
+        return nil;
+    }
+
+    NSString *stagingPath = [self.localURL.path stringByAppendingPathComponent:kTOSMBSyncEngineStagingDirectoryName];
+    NSURL *unchangedURL = [self.snapshotURL URLByAppendingPathExtension:@"unchanged"];
+    [[NSFileManager defaultManager] createDirectoryAtURL:[self.snapshotURL URLByDeletingLastPathComponent]
+                             withIntermediateDirectories:YES
+                                              attributes:nil
+                                                   error:nil];
+
+    //---------------------------------------------------------------------------------------
+    //Merge the saved snapshot with both walks, and work out what has to change
+
+    TOSMBSyncResult *result = [[TOSMBSyncResult alloc] init];
+    NSMutableArray<TOSMBSyncAction *> *actions = [NSMutableArray array];
+
+    TOSMBSyncSnapshotWriter *unchangedWriter = nil;
+    if (self.dryRun == NO) {
+        unchangedWriter = [[TOSMBSyncSnapshotWriter alloc] initWithURL:unchangedURL error:&resultError];
+        if (unchangedWriter == nil) {
+            if (error) {
+                *error = resultError;
+            }
+            return nil;
+        }
+    }
+
+    BOOL planned = [self planActions:actions result:result unchangedWriter:unchangedWriter error:&resultError];
+    if (planned == NO || [unchangedWriter finish] == NO) {
+        [[NSFileManager defaultManager] removeItemAtURL:unchangedURL error:nil];
+        if (error) {
+            *error = resultError ?: errorForErrorCode(TOSMBSessionErrorCodeUnknown);
+        }
+        return nil;
+    }
+
+    result.actions = actions;
+    if (self.dryRun) {
+        return result;
+    }
+
+    //---------------------------------------------------------------------------------------
+    //Make the changes. Parents are created before their contents, and deleted after them.
+
+    for (TOSMBSyncAction *action in actions) {
+        if (action.isDirectoryCreation) {
+            [self performAction:action stagingPath:stagingPath];
+        }
+    }
+    [self performTransfers:actions stagingPath:stagingPath];
+    for (TOSMBSyncAction *action in actions.reverseObjectEnumerator) {
+        if (action.isDeletion) {
+            [self performAction:action stagingPath:stagingPath];
+        }
+    }
+    for (TOSMBSyncAction *action in actions) {
+        if (action.type == TOSMBSyncActionTypeConflict) {
+            [self didFinishAction:action];
+        }
+    }
+    [[NSFileManager defaultManager] removeItemAtPath:stagingPath error:nil];
+
+    //---------------------------------------------------------------------------------------
+    //Save the new snapshot: the unchanged entries merged with the outcome of every action
+
+    if ([self saveSnapshotMergingUnchangedURL:unchangedURL actions:actions error:&resultError] == NO) {
+        if (error) {
+            *error = resultError;
+        }
+    }
+    [[NSFileManager defaultManager] removeItemAtURL:unchangedURL error:nil];
+
+    NSMutableArray<TOSMBSyncAction *> *failedActions = [NSMutableArray array];
+    uint64_t transferredByteCount = 0;
+    for (TOSMBSyncAction *action in actions) {
+        if (action.error) {
+            [failedActions addObject:action];
+        }
+        else if (action.isTransfer) {
+            transferredByteCount += action.size;
+        }
+    }
+    result.failedActions = failedActions;
+    result.transferredByteCount = transferredByteCount;
+    return result;
+}
+
+#pragma mark - Planning -
+
+- (BOOL)planActions:(NSMutableArray<TOSMBSyncAction *> *)actions
+             result:(TOSMBSyncResult *)result
+    unchangedWriter:(TOSMBSyncSnapshotWriter *)unchangedWriter
+              error:(NSError **)error
+{
+    //A snapshot that is missing or unreadable is the same as syncing for the first time
+    id<TOSMBSyncEntrySource> baseSource = [[TOSMBSyncSnapshotReader alloc] initWithURL:self.snapshotURL error:nil];
+    if (baseSource == nil) {
+        baseSource = [TOSMBSyncSnapshotReader emptySource];
+    }
+    TOSMBSyncRemoteWalker *remoteWalker = [[TOSMBSyncRemoteWalker alloc] initWithSession:self.session
+                                                                                rootPath:self.remotePath
+                                                               maximumConcurrentListings:self.maximumConcurrentListings];
+    self.remoteWalker = remoteWalker;
+    TOSMBSyncLocalWalker *localWalker = [[TOSMBSyncLocalWalker alloc] initWithRootURL:self.localURL];
+
+    BOOL planned = [self planActions:actions
+                              result:result
+                     unchangedWriter:unchangedWriter
+                          baseSource:baseSource
+                        remoteSource:remoteWalker
+                         localSource:localWalker
+                               error:error];
+
+    if ([baseSource isKindOfClass:[TOSMBSyncSnapshotReader class]]) {
+        [(TOSMBSyncSnapshotReader *)baseSource close];
+    }
+    [remoteWalker cancel];
+    self.remoteWalker = nil;
+    return planned;
+}
+
+- (BOOL)planActions:(NSMutableArray<TOSMBSyncAction *> *)actions
+             result:(TOSMBSyncResult *)result
+    unchangedWriter:(TOSMBSyncSnapshotWriter *)unchangedWriter
+         baseSource:(id<TOSMBSyncEntrySource>)baseSource
+       remoteSource:(id<TOSMBSyncEntrySource>)remoteSource
+        localSource:(id<TOSMBSyncEntrySource>)localSource
+              error:(NSError **)error
+{
+    NSError *walkError = nil;
+    TOSMBSyncEntry *base = [baseSource nextEntry:nil];
+    TOSMBSyncEntry *remote = [remoteSource nextEntry:&walkError];
+    TOSMBSyncEntry *local = walkError ? nil : [localSource nextEntry:&walkError];
+
+    //Directory deletions whose contents are still being checked, innermost last
+    NSMutableArray<TOSMBSyncPendingDeletion *> *pendingDeletions = [NSMutableArray array];
+    NSUInteger scannedItemCount = 0;
+    __block NSUInteger unchangedItemCount = 0;
+
+    //Actions and unchanged entries go out in path order, held back while inside a pending deletion
+    void (^emit)(id) = ^(id item) {
+        TOSMBSyncPendingDeletion *pendingDeletion = pendingDeletions.lastObject;
+        if (pendingDeletion) {
+            [pendingDeletion.items addObject:item];
+        }
+        else if ([item isKindOfClass:[TOSMBSyncAction class]]) {
+            [actions addObject:item];
+        }
+        else {
+            unchangedItemCount++;
+            [unchangedWriter appendEntry:item];
+        }
+    };
+
+    while (walkError == nil && (base || remote || local)) {
+        if (self.cancelled) {
+            walkError = errorForErrorCode(TOSMBSessionErrorCodeCancelled);
+            break;
+        }
+
+        //The next path is the lowest of the three
+        NSString *path = base.path;
+        if (remote && (path == nil || TOSMBSyncComparePaths(remote.path, path) == NSOrderedAscending)) {
+            path = remote.path;
+        }
+        if (local && (path == nil || TOSMBSyncComparePaths(local.path, path) == NSOrderedAscending)) {
+            path = local.path;
+        }
+
+        TOSMBSyncEntry *b = nil, *r = nil, *l = nil;
+        if (base && [base.path isEqualToString:path]) {
+            b = base;
+            base = [baseSource nextEntry:nil];
+        }
+        if (remote && [remote.path isEqualToString:path]) {
+            r = remote;
+            remote = [remoteSource nextEntry:&walkError];
+        }
+        if (local && [local.path isEqualToString:path]) {
+            l = local;
+            local = [localSource nextEntry:&walkError];
+        }
+
+        while (pendingDeletions.count > 0 && TOSMBSyncPathIsInsideDirectory(path, pendingDeletions.lastObject.action.path) == NO) {
+            [self resolvePendingDeletions:pendingDeletions emit:emit];
+        }
+
+        if (r == nil && l == nil) {
+            continue;
+        }
+        scannedItemCount++;
+        if (b) {
+            [pendingDeletions.lastObject.baseEntries addObject:b];
+        }
+
+        TOSMBSyncAction *action = [self actionForPath:path base:b remote:r local:l];
+
+        //Anything inside a directory about to be deleted that wouldn't be deleted on its own, such as a file
+        //added or changed on the other side since the last sync, keeps the directory
+        if (pendingDeletions.count > 0 && action.isDeletion == NO) {
+            for (TOSMBSyncPendingDeletion *pendingDeletion in pendingDeletions) {
+                pendingDeletion.blocked = YES;
+            }
+        }
+
+        if (action == nil) {
+            emit([self entryForPath:path remote:r local:l]);
+        }
+        else if (action.isDeletion && action.directory) {
+            TOSMBSyncPendingDeletion *pendingDeletion = [[TOSMBSyncPendingDeletion alloc] init];
+            pendingDeletion.action = action;
+            [pendingDeletions addObject:pendingDeletion];
+        }
+        else {
+            emit(action);
+        }
+    }
+
+    while (walkError == nil && pendingDeletions.count > 0) {
+        [self resolvePendingDeletions:pendingDeletions emit:emit];
+    }
+
+    if (walkError) {
+        if (error) {
+            *error = walkError;
+        }
+        return NO;
+    }
+
+    result.scannedItemCount = scannedItemCount;
+    result.unchangedItemCount = unchangedItemCount;
+    return YES;
+}
+
+/*
+ Called once the walk has left the innermost pending deletion. If nothing inside it has to be kept, the directory is
+ deleted as a whole and the plans for its contents are dropped. Otherwise the directory is created again on the side
+ it is missing from and its contents are planned one by one.
+ */
+- (void)resolvePendingDeletions:(NSMutableArray<TOSMBSyncPendingDeletion *> *)pendingDeletions emit:(void (^)(id))emit{
+    TOSMBSyncPendingDeletion *pendingDeletion = pendingDeletions.lastObject;
+    [pendingDeletions removeLastObject];
+    [pendingDeletions.lastObject.baseEntries addObjectsFromArray:pendingDeletion.baseEntries];
+
+    TOSMBSyncAction *action = pendingDeletion.action;
+    if (pendingDeletion.blocked == NO) {
+        action.descendantBaseEntries = pendingDeletion.baseEntries;
+        emit(action);
+        return;
+    }
+
+    action.type = (action.type == TOSMBSyncActionTypeDeleteRemote) ?
+    TOSMBSyncActionTypeCreateLocalDirectory : TOSMBSyncActionTypeCreateRemoteDirectory;
+    emit(action);
+    for (id item in pendingDeletion.items) {
+        emit(item);
+    }
+}
+
+- (TOSMBSyncEntry *)entryForPath:(NSString *)path remote:(TOSMBSyncEntry *)remote local:(TOSMBSyncEntry *)local{
+    TOSMBSyncEntry *entry = [[TOSMBSyncEntry alloc] init];
+    entry.path = path;
+    entry.directory = remote ? remote.directory : local.directory;
+    entry.hasRemote = (remote != nil);
+    entry.remoteSize = remote.remoteSize;
+    entry.remoteWriteTime = remote.remoteWriteTime;
+    entry.hasLocal = (local != nil);
+    entry.localSize = local.localSize;
+    entry.localModificationTime = local.localModificationTime;
+    return entry;
+}
+
+- (BOOL)remote:(TOSMBSyncEntry *)remote changedSince:(TOSMBSyncEntry *)base{
+    if (base == nil || base.hasRemote == NO || base.directory != remote.directory) {
+        return YES;
+    }
+    if (remote.directory) {
+        return NO;
+    }
+    return (base.remoteSize != remote.remoteSize || base.remoteWriteTime != remote.remoteWriteTime);
+}
+
+- (BOOL)local:(TOSMBSyncEntry *)local changedSince:(TOSMBSyncEntry *)base{
+    if (base == nil || base.hasLocal == NO || base.directory != local.directory) {
+        return YES;
+    }
+    if (local.directory) {
+        return NO;
+    }
+    return (base.localSize != local.localSize || base.localModificationTime != local.localModificationTime);
+}
+
+/* For files found on both sides with no snapshot entry, e.g. on the first sync of folders that were copied by hand */
+- (BOOL)remote:(TOSMBSyncEntry *)remote probablyMatchesLocal:(TOSMBSyncEntry *)local{
+    if (remote.remoteSize != local.localSize) {
+        return NO;
+    }
+    const int64_t difference = TOSMBSyncMicrosecondsFromFileTime(remote.remoteWriteTime) - local.localModificationTime;
+    return (llabs(difference) <= kTOSMBSyncEngineTimeTolerance);
+}
+
+- (TOSMBSyncAction *)actionForPath:(NSString *)path
+                              base:(TOSMBSyncEntry *)base
+                            remote:(TOSMBSyncEntry *)remote
+                             local:(TOSMBSyncEntry *)local
+{
+    TOSMBSyncActionType type;
+
+    if (remote && local) {
+        if (remote.directory != local.directory) {
+            type = TOSMBSyncActionTypeConflict;
+        }
+        else if (remote.directory) {
+            return nil;
+        }
+        else {
+            const BOOL remoteChanged = [self remote:remote changedSince:base];
+            const BOOL localChanged = [self local:local changedSince:base];
+            if (base == nil && [self remote:remote probablyMatchesLocal:local]) {
+                return nil;
+            }
+            if (remoteChanged == NO && localChanged == NO) {
+                return nil;
+            }
+            switch (self.direction) {
+                case TOSMBSyncDirectionDownload:
+                    type = TOSMBSyncActionTypeDownload;
+                    break;
+                case TOSMBSyncDirectionUpload:
+                    type = TOSMBSyncActionTypeUpload;
+                    break;
+                case TOSMBSyncDirectionBidirectional:
+                    if (remoteChanged && localChanged) {
+                        type = [self typeForConflictWithRemote:remote local:local];
+                    }
+                    else {
+                        type = remoteChanged ? TOSMBSyncActionTypeDownload : TOSMBSyncActionTypeUpload;
+                    }
+                    break;
+            }
+        }
+    }
+    else if (remote) {
+        //Only on the device: it is new there, or was deleted locally
+        const BOOL deletedLocally = (base.hasLocal && [self remote:remote changedSince:base] == NO);
+        if (self.direction == TOSMBSyncDirectionUpload ||
+            (self.direction == TOSMBSyncDirectionBidirectional && deletedLocally)) {
+            if (self.propagatesDeletions == NO || (base.hasLocal == NO && self.direction == TOSMBSyncDirectionUpload)) {
+                return nil;
+            }
+            type = TOSMBSyncActionTypeDeleteRemote;
+        }
+        else {
+            type = remote.directory ? TOSMBSyncActionTypeCreateLocalDirectory : TOSMBSyncActionTypeDownload;
+        }
+    }
+    else {
+        //Only local: it is new here, or was deleted on the device
+        const BOOL deletedRemotely = (base.hasRemote && [self local:local changedSince:base] == NO);
+        if (self.direction == TOSMBSyncDirectionDownload ||
+            (self.direction == TOSMBSyncDirectionBidirectional && deletedRemotely)) {
+            if (self.propagatesDeletions == NO || (base.hasRemote == NO && self.direction == TOSMBSyncDirectionDownload)) {
+                return nil;
+            }
+            type = TOSMBSyncActionTypeDeleteLocal;
+        }
+        else {
+            type = local.directory ? TOSMBSyncActionTypeCreateRemoteDirectory : TOSMBSyncActionTypeUpload;
+        }
+    }
+
+    TOSMBSyncAction *action = [[TOSMBSyncAction alloc] init];
+    action.type = type;
+    action.path = path;
+    action.directory = remote ? remote.directory : local.directory;
+    action.size = (type == TOSMBSyncActionTypeDownload) ? remote.remoteSize :
+                  ((type == TOSMBSyncActionTypeUpload) ? local.localSize : 0);
+    action.baseEntry = base;
+    action.remoteEntry = remote;
+    action.localEntry = local;
+    return action;
+}
+
+- (TOSMBSyncActionType)typeForConflictWithRemote:(TOSMBSyncEntry *)remote local:(TOSMBSyncEntry *)local{
+    switch (self.conflictPolicy) {
+        case TOSMBSyncConflictPolicyPreferRemote:
+            return TOSMBSyncActionTypeDownload;
+        case TOSMBSyncConflictPolicyPreferLocal:
+            return TOSMBSyncActionTypeUpload;
+        case TOSMBSyncConflictPolicySkip:
+            return TOSMBSyncActionTypeConflict;
+        case TOSMBSyncConflictPolicyNewerWins:
+        default:
+            return (TOSMBSyncMicrosecondsFromFileTime(remote.remoteWriteTime) >= local.localModificationTime) ?
+            TOSMBSyncActionTypeDownload : TOSMBSyncActionTypeUpload;
+    }
+}
+
+#pragma mark - Performing -
+
+- (NSString *)localPathForAction:(TOSMBSyncAction *)action{
+    return action.localEntry.localPath ?: [self.localURL.path stringByAppendingPathComponent:action.path];
+}
+
+- (TOSMBPath *)remotePathForAction:(TOSMBSyncAction *)action{
+    return action.remoteEntry.remotePath ?: [self.remotePath pathByAppendingComponent:action.path];
+}
+
+- (TOSMBSyncEntry *)localEntryForPath:(NSString *)localPath{
+    struct stat status;
+    if (lstat(localPath.fileSystemRepresentation, &status) != 0) {
+        return nil;
+    }
+    TOSMBSyncEntry *entry = [[TOSMBSyncEntry alloc] init];
+    entry.directory = S_ISDIR(status.st_mode);
+    entry.localSize = entry.directory ? 0 : (uint64_t)status.st_size;
+    entry.localModificationTime = entry.directory ? 0 :
+    (int64_t)status.st_mtimespec.tv_sec * 1000000 + status.st_mtimespec.tv_nsec / 1000;
+    return entry;
+}
+
+/* Directory creations and deletions, run on the syncing thread */
+- (void)performAction:(TOSMBSyncAction *)action stagingPath:(NSString *)stagingPath{
+    if (self.cancelled) {
+        action.error = errorForErrorCode(TOSMBSessionErrorCodeCancelled);
+        [self didFinishAction:action];
+        return;
+    }
+
+    NSError *error = nil;
+    TOSMBSyncEntry *resultEntry = nil;
+    switch (action.type) {
+        case TOSMBSyncActionTypeCreateLocalDirectory:
+            if ([[NSFileManager defaultManager] createDirectoryAtPath:[self localPathForAction:action]
+                                          withIntermediateDirectories:YES
+                                                           attributes:nil
+                                                                error:&error]) {
+                resultEntry = [self entryForPath:action.path remote:action.remoteEntry local:nil];
+                resultEntry.hasLocal = YES;
+            }
+            break;
+        case TOSMBSyncActionTypeCreateRemoteDirectory:
+            if ([self.session createDirectoryAtSMBPath:[self remotePathForAction:action] error:&error]) {
+                resultEntry = [self entryForPath:action.path remote:nil local:action.localEntry];
+                resultEntry.hasRemote = YES;
+            }
+            break;
+        case TOSMBSyncActionTypeDeleteLocal:
+            [[NSFileManager defaultManager] removeItemAtPath:[self localPathForAction:action] error:&error];
+            break;
+        case TOSMBSyncActionTypeDeleteRemote:
+            [self.session deleteItemAtSMBPath:[self remotePathForAction:action] error:&error];
+            break;
+        default:
+            NSParameterAssert(NO);
+            break;
+    }
+    action.resultEntry = resultEntry;
+    action.error = error;
+    [self didFinishAction:action];
+}
+
+- (void)performTransfers:(NSArray<TOSMBSyncAction *> *)actions stagingPath:(NSString *)stagingPath{
+    dispatch_semaphore_t slots = dispatch_semaphore_create(MAX(self.maximumConcurrentTransfers, 1));
+    dispatch_group_t group = dispatch_group_create();
+
+    for (TOSMBSyncAction *action in actions) {
+        if (action.isTransfer == NO) {
+            continue;
+        }
+        dispatch_semaphore_wait(slots, DISPATCH_TIME_FOREVER);
+        if (self.cancelled) {
+            action.error = errorForErrorCode(TOSMBSessionErrorCodeCancelled);
+            [self didFinishAction:action];
+            dispatch_semaphore_signal(slots);
+            continue;
+        }
+
+        dispatch_group_enter(group);
+        void (^finish)(void) = ^{
+            dispatch_semaphore_signal(slots);
+            dispatch_group_leave(group);
+        };
+        if (action.type == TOSMBSyncActionTypeDownload) {
+            [self startDownloadForAction:action stagingPath:stagingPath completion:finish];
+        }
+        else {
+            [self startUploadForAction:action completion:finish];
+        }
+    }
+
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+}
+
+- (void)trackTask:(TOSMBSessionTransferTask *)task running:(BOOL)running{
+    @synchronized (self.runningTasks) {
+        if (running) {
+            [self.runningTasks addObject:task];
+        }
+        else {
+            [self.runningTasks removeObject:task];
+        }
+    }
+}
+
+- (void)startDownloadForAction:(TOSMBSyncAction *)action stagingPath:(NSString *)stagingPath completion:(void (^)(void))completion{
+    [[NSFileManager defaultManager] createDirectoryAtPath:stagingPath withIntermediateDirectories:YES attributes:nil error:nil];
+    NSString *stagedPath = [stagingPath stringByAppendingPathComponent:[NSString stringWithFormat:@"%@.download", [NSString TOSMB_uuidString]]];
+    NSString *localPath = [self localPathForAction:action];
+
+    __block TOSMBSessionDownloadTask *task = nil;
+    TOSMBMakeWeakReference();
+    void (^finish)(NSString *, NSError *) = ^(NSString *downloadedPath, NSError *error) {
+        //Moving files around and stat calls stay off the session's callback queue
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+            TOSMBMakeStrongFromWeakReference();
+            if (error == nil && downloadedPath) {
+                action.error = [strongSelf placeDownloadedFileAtPath:downloadedPath
+                                                              atPath:localPath
+                                                           writeTime:action.remoteEntry.remoteWriteTime];
+            }
+            else {
+                action.error = error ?: errorForErrorCode(TOSMBSessionErrorCodeFileDownloadFailed);
+                [[NSFileManager defaultManager] removeItemAtPath:stagedPath error:nil];
+            }
+            if (action.error == nil) {
+                TOSMBSyncEntry *localEntry = [strongSelf localEntryForPath:localPath];
+                action.resultEntry = [strongSelf entryForPath:action.path remote:action.remoteEntry local:localEntry];
+            }
+            [strongSelf didFinishAction:action];
+            [strongSelf trackTask:task running:NO];
+            //The task holds this block through its handlers, so let go of it to break the cycle
+            task = nil;
+            completion();
+        });
+    };
+
+    task = [self.session downloadTaskForFileAtSMBPath:[self remotePathForAction:action]
+                                      destinationPath:stagedPath
+                                      progressHandler:nil
+                                    completionHandler:^(NSString *filePath) { finish(filePath, nil); }
+                                          failHandler:^(NSError *error) { finish(nil, error); }];
+    [self trackTask:task running:YES];
+    [task start];
+}
+
+- (NSError *)placeDownloadedFileAtPath:(NSString *)downloadedPath atPath:(NSString *)localPath writeTime:(uint64_t)writeTime{
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSError *error = nil;
+    [fileManager createDirectoryAtPath:[localPath stringByDeletingLastPathComponent]
+           withIntermediateDirectories:YES
+                            attributes:nil
+                                 error:nil];
+
+    //Replace the old copy in one step, so it survives if anything goes wrong
+    BOOL placed = NO;
+    if ([fileManager fileExistsAtPath:localPath]) {
+        placed = [fileManager replaceItemAtURL:[NSURL fileURLWithPath:localPath]
+                                 withItemAtURL:[NSURL fileURLWithPath:downloadedPath]
+                                backupItemName:nil
+                                       options:NSFileManagerItemReplacementUsingNewMetadataOnly
+                              resultingItemURL:nil
+                                         error:&error];
+    }
+    else {
+        placed = [fileManager moveItemAtPath:downloadedPath toPath:localPath error:&error];
+    }
+    if (placed == NO) {
+        [fileManager removeItemAtPath:downloadedPath error:nil];
+        return error ?: errorForErrorCode(TOSMBSessionErrorCodeFileDownloadFailed);
+    }
+
+    //Match the write time on the device, so the two copies can be compared later without a snapshot
+    if (writeTime > 0) {
+        NSDate *date = [NSDate dateWithTimeIntervalSince1970:TOSMBSyncMicrosecondsFromFileTime(writeTime) / 1000000.0];
+        [fileManager setAttributes:@{NSFileModificationDate:date} ofItemAtPath:localPath error:nil];
+    }
+    return nil;
+}
+
+- (void)startUploadForAction:(TOSMBSyncAction *)action completion:(void (^)(void))completion{
+    TOSMBPath *remotePath = [self remotePathForAction:action];
+
+    __block TOSMBSessionUploadTask *task = nil;
+    TOSMBMakeWeakReference();
+    void (^finish)(NSError *) = ^(NSError *error) {
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+            TOSMBMakeStrongFromWeakReference();
+            action.error = error;
+            if (error == nil) {
+                //The device sets the write time, so read it back for the snapshot
+                NSError *attributesError = nil;
+                TOSMBSessionFile *file = [strongSelf.session itemAttributesAtSMBPath:remotePath error:&attributesError];
+                if (file) {
+                    TOSMBSyncEntry *resultEntry = [strongSelf entryForPath:action.path remote:nil local:action.localEntry];
+                    resultEntry.hasRemote = YES;
+                    resultEntry.remoteSize = file.fileSize;
+                    resultEntry.remoteWriteTime = file.writeTimestamp;
+                    action.resultEntry = resultEntry;
+                }
+                else {
+                    action.error = attributesError ?: errorForErrorCode(TOSMBSessionErrorCodeFileNotFound);
+                }
+            }
+            [strongSelf didFinishAction:action];
+            [strongSelf trackTask:task running:NO];
+            //The task holds this block through its handlers, so let go of it to break the cycle
+            task = nil;
+            completion();
+        });
+    };
+
+    task = [self.session uploadTaskForFileAtPath:action.localEntry.localPath
+                              destinationSMBPath:remotePath
+                                 progressHandler:nil
+                               completionHandler:^(NSString *filePath) { finish(nil); }
+                                     failHandler:^(NSError *error) { finish(error ?: errorForErrorCode(TOSMBSessionErrorCodeFailToUpload)); }];
+    [self trackTask:task running:YES];
+    [task start];
+}
+
+- (void)didFinishAction:(TOSMBSyncAction *)action{
+    action.completed = YES;
+    void (^actionHandler)(TOSMBSyncAction *) = self.actionHandler;
+    if (actionHandler) {
+        [self.session performCallBackWithBlock:^{ actionHandler(action); }];
+    }
+}
+
+#pragma mark - Snapshot -
+
+- (BOOL)saveSnapshotMergingUnchangedURL:(NSURL *)unchangedURL
+                                actions:(NSArray<TOSMBSyncAction *> *)actions
+                                  error:(NSError **)error
+{
+    TOSMBSyncSnapshotReader *unchangedReader = [[TOSMBSyncSnapshotReader alloc] initWithURL:unchangedURL error:error];
+    if (unchangedReader == nil) {
+        return NO;
+    }
+    NSURL *temporaryURL = [self.snapshotURL URLByAppendingPathExtension:@"new"];
+    TOSMBSyncSnapshotWriter *writer = [[TOSMBSyncSnapshotWriter alloc] initWithURL:temporaryURL error:error];
+    if (writer == nil) {
+        return NO;
+    }
+
+    //Both are already in path order and never share a path
+    TOSMBSyncEntry *unchanged = [unchangedReader nextEntry:nil];
+    NSEnumerator<TOSMBSyncAction *> *actionEnumerator = actions.objectEnumerator;
+    TOSMBSyncAction *action = actionEnumerator.nextObject;
+    while (unchanged || action) {
+        if (action && (unchanged == nil || TOSMBSyncComparePaths(action.path, unchanged.path) == NSOrderedAscending)) {
+            TOSMBSyncEntry *entry = action.snapshotEntry;
+            if (entry) {
+                entry.path = action.path;
+                [writer appendEntry:entry];
+            }
+            if (action.keepsDescendants) {
+                for (TOSMBSyncEntry *descendant in action.descendantBaseEntries) {
+                    [writer appendEntry:descendant];
+                }
+            }
+            action = actionEnumerator.nextObject;
+        }
+        else {
+            [writer appendEntry:unchanged];
+            unchanged = [unchangedReader nextEntry:nil];
+        }
+    }
+    [unchangedReader close];
+
+    if ([writer finish] == NO || rename(temporaryURL.fileSystemRepresentation, self.snapshotURL.fileSystemRepresentation) != 0) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        }
+        [[NSFileManager defaultManager] removeItemAtURL:temporaryURL error:nil];
+        return NO;
+    }
+    return YES;
+}
+
+#pragma mark - Debug -
+
+- (NSString *)description{
+    return [NSString stringWithFormat:@"Sync Engine - Remote: %@ | Local: %@ | Direction: %ld",
+            self.remotePath.string, self.localURL.path, (long)self.direction];
+}
+
+@end
@@ -0,0 +1,94 @@
+//
+//  TOSMBSyncSnapshot.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class TOSMBPath;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The state of one item of a synced tree, on the device, locally, or both.
+
+ Paths are relative to the synced folders, use "/" as the separator and are in precomposed
+ Unicode form, so the same name compares equal whichever file system it came from.
+ */
+@interface TOSMBSyncEntry : NSObject
+
+@property (nonatomic, copy) NSString *path;
+@property (nonatomic, assign) BOOL directory;
+
+@property (nonatomic, assign) BOOL hasRemote;
+@property (nonatomic, assign) uint64_t remoteSize;
+@property (nonatomic, assign) uint64_t remoteWriteTime;          /* Windows FILETIME */
+
+@property (nonatomic, assign) BOOL hasLocal;
+@property (nonatomic, assign) uint64_t localSize;
+@property (nonatomic, assign) int64_t localModificationTime;     /* Microseconds since 1970 */
+
+/* Where the item was found by a walk, with its name exactly as stored there. Not saved in snapshots. */
+@property (nonatomic, strong, nullable) TOSMBPath *remotePath;
+@property (nonatomic, copy, nullable) NSString *localPath;
+
+@end
+
+/**
+ Orders paths component by component, which is the order of a depth first walk that visits
+ siblings sorted by name: a directory comes straight before everything inside it.
+ Every stream of entries that is merged during a sync must be in this order.
+ */
+extern NSComparisonResult TOSMBSyncComparePaths(NSString *path, NSString *otherPath);
+
+/* Whether `path` is inside the directory at `directoryPath` */
+extern BOOL TOSMBSyncPathIsInsideDirectory(NSString *path, NSString *directoryPath);
+
+/** Anything that hands out entries one at a time, in `TOSMBSyncComparePaths` order */
+@protocol TOSMBSyncEntrySource <NSObject>
+
+/** The next entry, or nil when there are no more entries or an error occurred */
+- (nullable TOSMBSyncEntry *)nextEntry:(NSError **)error;
+
+@end
+
+/**
+ Streams a snapshot file. Only the entry being read is held in memory, so snapshots of any size
+ can be read.
+
+ The file starts with a magic number, a version and an entry count, followed by the entries in
+ path order. Each entry is a flags byte, a 32-bit path length, the UTF-8 path and the sizes and
+ times as 64-bit values. All integers are little-endian.
+ */
+@interface TOSMBSyncSnapshotReader : NSObject <TOSMBSyncEntrySource>
+
+/** Returns nil if the file can't be opened or isn't a snapshot */
+- (nullable instancetype)initWithURL:(NSURL *)URL error:(NSError **)error;
+
+/** An empty source, used when there is no snapshot yet */
++ (id<TOSMBSyncEntrySource>)emptySource;
+
+@property (nonatomic, readonly) uint64_t count;
+
+- (void)close;
+
+@end
+
+/** Writes a snapshot file. Entries must be appended in path order. */
+@interface TOSMBSyncSnapshotWriter : NSObject
+
+- (nullable instancetype)initWithURL:(NSURL *)URL error:(NSError **)error;
+
+@property (nonatomic, readonly) uint64_t count;
+
+- (BOOL)appendEntry:(TOSMBSyncEntry *)entry;
+
+/** Writes the entry count and closes the file. Returns NO if any write failed. */
+- (BOOL)finish;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,336 @@
+//
+//  TOSMBSyncSnapshot.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import "TOSMBSyncSnapshot.h"
+
+static const uint32_t kTOSMBSyncSnapshotMagic = 0x4E595354; // "TSYN"
+static const uint32_t kTOSMBSyncSnapshotVersion = 1;
+
+/* Offset of the entry count, which is filled in when the writer finishes */
+static const long kTOSMBSyncSnapshotCountOffset = 8;
+
+/* stdio buffer used for reading and writing snapshots */
+static const size_t kTOSMBSyncSnapshotBufferSize = 256 * 1024;
+
+/* Longest path accepted when reading, to catch corrupt files before allocating */
+static const uint32_t kTOSMBSyncSnapshotMaximumPathLength = 64 * 1024;
+
+typedef NS_OPTIONS(uint8_t, TOSMBSyncSnapshotFlags) {
+    TOSMBSyncSnapshotFlagDirectory = 1 << 0,
+    TOSMBSyncSnapshotFlagRemote = 1 << 1,
+    TOSMBSyncSnapshotFlagLocal = 1 << 2
+};
+
+#pragma mark - Paths -
+
+NSComparisonResult TOSMBSyncComparePaths(NSString *path, NSString *otherPath){
+    const char *bytes = path.UTF8String;
+    const char *otherBytes = otherPath.UTF8String;
+    //Compare byte-wise, with the separator sorting before every other character
+    for (size_t i = 0; ; i++) {
+        const unsigned char c = (unsigned char)bytes[i];
+        const unsigned char otherC = (unsigned char)otherBytes[i];
+        if (c == otherC) {
+            if (c == '\0') {
+                return NSOrderedSame;
+            }
+            continue;
+        }
+        if (c == '\0') {
+            return NSOrderedAscending;
+        }
+        if (otherC == '\0') {
+            return NSOrderedDescending;
+        }
+        const unsigned char weight = (c == '/') ? 1 : c;
+        const unsigned char otherWeight = (otherC == '/') ? 1 : otherC;
+        return (weight < otherWeight) ? NSOrderedAscending : NSOrderedDescending;
+    }
+}
+
+BOOL TOSMBSyncPathIsInsideDirectory(NSString *path, NSString *directoryPath){
+    return (path.length > directoryPath.length &&
+            [path hasPrefix:directoryPath] &&
+            [path characterAtIndex:directoryPath.length] == '/');
+}
+
+#pragma mark - Entry -
+
+@implementation TOSMBSyncEntry
+
+- (NSString *)description{
+    return [NSString stringWithFormat:@"Sync Entry - Path: %@ | Directory: %@ | Remote: %@ %llu | Local: %@ %llu",
+            self.path, self.directory ? @"YES" : @"NO",
+            self.hasRemote ? @"YES" : @"NO", self.remoteSize,
+            self.hasLocal ? @"YES" : @"NO", self.localSize];
+}
+
+@end
+
+#pragma mark - Empty Source -
+
+@interface TOSMBSyncEmptySource : NSObject <TOSMBSyncEntrySource>
+@end
+
+@implementation TOSMBSyncEmptySource
+
+- (TOSMBSyncEntry *)nextEntry:(NSError **)error{
+    return nil;
+}
+
+@end
+
+#pragma mark - Reader -
+
+@interface TOSMBSyncSnapshotReader () {
+    FILE *_file;
+    char *_pathBuffer;
+    uint32_t _pathBufferLength;
+}
+
+@property (nonatomic, assign, readwrite) uint64_t count;
+@property (nonatomic, assign) uint64_t readCount;
+
+@end
+
+@implementation TOSMBSyncSnapshotReader
+
++ (id<TOSMBSyncEntrySource>)emptySource{
+    return [[TOSMBSyncEmptySource alloc] init];
+}
+
+static NSError *TOSMBSyncSnapshotCorruptError(void){
+    return [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:nil];
+}
+
+static NSError *TOSMBSyncSnapshotPOSIXError(void){
+    return [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+}
+
+static BOOL TOSMBSyncSnapshotRead(FILE *file, void *value, size_t length){
+    return fread(value, 1, length, file) == length;
+}
+
+static BOOL TOSMBSyncSnapshotRead32(FILE *file, uint32_t *value){
+    if (TOSMBSyncSnapshotRead(file, value, sizeof(*value)) == NO) {
+        return NO;
+    }
+    *value = CFSwapInt32LittleToHost(*value);
+    return YES;
+}
+
+static BOOL TOSMBSyncSnapshotRead64(FILE *file, uint64_t *value){
+    if (TOSMBSyncSnapshotRead(file, value, sizeof(*value)) == NO) {
+        return NO;
+    }
+    *value = CFSwapInt64LittleToHost(*value);
+    return YES;
+}
+
+- (instancetype)initWithURL:(NSURL *)URL error:(NSError **)error{
+    self = [super init];
+    if (self) {
+        _file = fopen(URL.fileSystemRepresentation, "rb");
+        if (_file == NULL) {
+            if (error) {
+                *error = TOSMBSyncSnapshotPOSIXError();
+            }
+            return nil;
+        }
+        setvbuf(_file, NULL, _IOFBF, kTOSMBSyncSnapshotBufferSize);
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint64_t count = 0;
+        if (TOSMBSyncSnapshotRead32(_file, &magic) == NO || magic != kTOSMBSyncSnapshotMagic ||
+            TOSMBSyncSnapshotRead32(_file, &version) == NO || version != kTOSMBSyncSnapshotVersion ||
+            TOSMBSyncSnapshotRead64(_file, &count) == NO) {
+            if (error) {
+                *error = TOSMBSyncSnapshotCorruptError();
+            }
+            return nil;
+        }
+        _count = count;
+    }
+    return self;
+}
+
+- (void)dealloc{
+    [self close];
+}
+
+- (void)close{
+    if (_file) {
+        fclose(_file);
+        _file = NULL;
+    }
+    free(_pathBuffer);
+    _pathBuffer = NULL;
+    _pathBufferLength = 0;
+}
+
+- (TOSMBSyncEntry *)nextEntry:(NSError **)error{
+    if (_file == NULL || self.readCount >= self.count) {
+        return nil;
+    }
+
+    uint8_t flags = 0;
+    uint32_t pathLength = 0;
+    if (TOSMBSyncSnapshotRead(_file, &flags, sizeof(flags)) == NO ||
+        TOSMBSyncSnapshotRead32(_file, &pathLength) == NO ||
+        pathLength == 0 || pathLength > kTOSMBSyncSnapshotMaximumPathLength) {
+        if (error) {
+            *error = TOSMBSyncSnapshotCorruptError();
+        }
+        return nil;
+    }
+
+    if (pathLength > _pathBufferLength) {
+        char *pathBuffer = realloc(_pathBuffer, pathLength);
+        if (pathBuffer == NULL) {
+            return nil;
+        }
+        _pathBuffer = pathBuffer;
+        _pathBufferLength = pathLength;
+    }
+
+    uint64_t remoteSize = 0, remoteWriteTime = 0, localSize = 0, localModificationTime = 0;
+    if (TOSMBSyncSnapshotRead(_file, _pathBuffer, pathLength) == NO ||
+        TOSMBSyncSnapshotRead64(_file, &remoteSize) == NO ||
+        TOSMBSyncSnapshotRead64(_file, &remoteWriteTime) == NO ||
+        TOSMBSyncSnapshotRead64(_file, &localSize) == NO ||
+        TOSMBSyncSnapshotRead64(_file, &localModificationTime) == NO) {
+        if (error) {
+            *error = TOSMBSyncSnapshotCorruptError();
+        }
+        return nil;
+    }
+
+    NSString *path = [[NSString alloc] initWithBytes:_pathBuffer length:pathLength encoding:NSUTF8StringEncoding];
+    if (path == nil) {
+        if (error) {
+            *error = TOSMBSyncSnapshotCorruptError();
+        }
+        return nil;
+    }
+
+    TOSMBSyncEntry *entry = [[TOSMBSyncEntry alloc] init];
+    entry.path = path;
+    entry.directory = (flags & TOSMBSyncSnapshotFlagDirectory) != 0;
+    entry.hasRemote = (flags & TOSMBSyncSnapshotFlagRemote) != 0;
+    entry.remoteSize = remoteSize;
+    entry.remoteWriteTime = remoteWriteTime;
+    entry.hasLocal = (flags & TOSMBSyncSnapshotFlagLocal) != 0;
+    entry.localSize = localSize;
+    entry.localModificationTime = (int64_t)localModificationTime;
+    self.readCount++;
+    return entry;
+}
+
+@end
+
+#pragma mark - Writer -
+
+@interface TOSMBSyncSnapshotWriter () {
+    FILE *_file;
+}
+
+@property (nonatomic, assign, readwrite) uint64_t count;
+@property (nonatomic, assign) BOOL failed;
+
+@end
+
+@implementation TOSMBSyncSnapshotWriter
+
+static BOOL TOSMBSyncSnapshotWrite32(FILE *file, uint32_t value){
+    value = CFSwapInt32HostToLittle(value);
+    return fwrite(&value, sizeof(value), 1, file) == 1;
+}
+
+static BOOL TOSMBSyncSnapshotWrite64(FILE *file, uint64_t value){
+    value = CFSwapInt64HostToLittle(value);
+    return fwrite(&value, sizeof(value), 1, file) == 1;
+}
+
+- (instancetype)initWithURL:(NSURL *)URL error:(NSError **)error{
+    self = [super init];
+    if (self) {
+        _file = fopen(URL.fileSystemRepresentation, "wb");
+        if (_file == NULL) {
+            if (error) {
+                *error = TOSMBSyncSnapshotPOSIXError();
+            }
+            return nil;
+        }
+        setvbuf(_file, NULL, _IOFBF, kTOSMBSyncSnapshotBufferSize);
+        if (TOSMBSyncSnapshotWrite32(_file, kTOSMBSyncSnapshotMagic) == NO ||
+            TOSMBSyncSnapshotWrite32(_file, kTOSMBSyncSnapshotVersion) == NO ||
+            TOSMBSyncSnapshotWrite64(_file, 0) == NO) {
+            if (error) {
+                *error = TOSMBSyncSnapshotPOSIXError();
+            }
+            fclose(_file);
+            _file = NULL;
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (void)dealloc{
+    if (_file) {
+        fclose(_file);
+    }
+}
+
+- (BOOL)appendEntry:(TOSMBSyncEntry *)entry{
+    if (_file == NULL || self.failed) {
+        return NO;
+    }
+
+    const char *path = entry.path.UTF8String;
+    const size_t pathLength = path ? strlen(path) : 0;
+    if (pathLength == 0 || pathLength > kTOSMBSyncSnapshotMaximumPathLength) {
+        return NO;
+    }
+
+    uint8_t flags = 0;
+    flags |= entry.directory ? TOSMBSyncSnapshotFlagDirectory : 0;
+    flags |= entry.hasRemote ? TOSMBSyncSnapshotFlagRemote : 0;
+    flags |= entry.hasLocal ? TOSMBSyncSnapshotFlagLocal : 0;
+
+    BOOL success =
+    fwrite(&flags, sizeof(flags), 1, _file) == 1 &&
+    TOSMBSyncSnapshotWrite32(_file, (uint32_t)pathLength) &&
+    fwrite(path, 1, pathLength, _file) == pathLength &&
+    TOSMBSyncSnapshotWrite64(_file, entry.remoteSize) &&
+    TOSMBSyncSnapshotWrite64(_file, entry.remoteWriteTime) &&
+    TOSMBSyncSnapshotWrite64(_file, entry.localSize) &&
+    TOSMBSyncSnapshotWrite64(_file, (uint64_t)entry.localModificationTime);
+
+    if (success == NO) {
+        self.failed = YES;
+        return NO;
+    }
+    self.count++;
+    return YES;
+}
+
+- (BOOL)finish{
+    if (_file == NULL) {
+        return NO;
+    }
+    BOOL success = (self.failed == NO &&
+                    fseek(_file, kTOSMBSyncSnapshotCountOffset, SEEK_SET) == 0 &&
+                    TOSMBSyncSnapshotWrite64(_file, self.count));
+    success = (fclose(_file) == 0) && success;
+    _file = NULL;
+    return success;
+}
+
+@end
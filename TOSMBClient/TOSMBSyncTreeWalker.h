@@ -0,0 +1,50 @@
+//
+//  TOSMBSyncTreeWalker.h
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "TOSMBSyncSnapshot.h"
+
+@class TOSMBSession;
+@class TOSMBPath;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Walks a folder on the device depth first, handing out one entry at a time in
+ `TOSMBSyncComparePaths` order.
+
+ Listings of the directories the walk is about to enter are requested ahead of time on a
+ bounded queue, so listing overlaps with whatever the caller does with the entries. Only the
+ listings along the current branch and the prefetched ones are held in memory.
+ Entries returned by this walker have `remotePath` set.
+ */
+@interface TOSMBSyncRemoteWalker : NSObject <TOSMBSyncEntrySource>
+
+- (instancetype)initWithSession:(TOSMBSession *)session
+                       rootPath:(TOSMBPath *)rootPath
+      maximumConcurrentListings:(NSUInteger)maximumConcurrentListings;
+
+/** The number of directories listed so far, including the root */
+@property (atomic, readonly) NSUInteger listedDirectoryCount;
+
+- (void)cancel;
+
+@end
+
+/**
+ Walks a local folder depth first, in `TOSMBSyncComparePaths` order.
+ Hidden items and anything that isn't a regular file or a directory are skipped, matching
+ what is listed on the device. Entries returned by this walker have `localPath` set.
+ */
+@interface TOSMBSyncLocalWalker : NSObject <TOSMBSyncEntrySource>
+
+- (instancetype)initWithRootURL:(NSURL *)rootURL;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,395 @@
+//
+//  TOSMBSyncTreeWalker.m
+//  TOSMBClient
+//
+//  Created by Artem on 19/10/2026.
+//  Copyright © 2026 TOSMB. All rights reserved.
+//
+
+#import <dirent.h>
+#import <sys/stat.h>
+
+#import "TOSMBSyncTreeWalker.h"
+#import "TOSMBSession.h"
+#import "TOSMBSession+Private.h"
+#import "TOSMBSessionFileList.h"
+#import "TOSMBPath.h"
+
+/* Listings that may be requested ahead of the walk, per concurrent listing */
+static const NSUInteger kTOSMBSyncRemoteWalkerPrefetchFactor = 4;
+
+/* Sorts names the same way `TOSMBSyncComparePaths` orders siblings */
+static NSComparisonResult TOSMBSyncCompareNames(NSString *name, NSString *otherName){
+    const int result = strcmp(name.UTF8String, otherName.UTF8String);
+    return (result < 0) ? NSOrderedAscending : ((result > 0) ? NSOrderedDescending : NSOrderedSame);
+}
+
+static NSString *TOSMBSyncChildPath(NSString *prefix, NSString *name){
+    return (prefix.length > 0) ? [NSString stringWithFormat:@"%@/%@", prefix, name] : name;
+}
+
+#pragma mark - Remote Listing -
+
+/* A directory listing that is either loaded or on its way */
+@interface TOSMBSyncRemoteListing : NSObject
+
+@property (nonatomic, strong) dispatch_group_t group;
+@property (nonatomic, strong) TOSMBSessionFileList *fileList;
+@property (nonatomic, strong) NSError *error;
+
+@end
+
+@implementation TOSMBSyncRemoteListing
+@end
+
+/* One directory on the current branch of the walk */
+@interface TOSMBSyncRemoteFrame : NSObject
+
+@property (nonatomic, copy) NSString *prefix;
+@property (nonatomic, strong) TOSMBPath *directoryPath;
+@property (nonatomic, strong) TOSMBSessionFileList *fileList;
+@property (nonatomic, copy) NSArray<NSNumber *> *order;     /* Indices into the list, sorted by name */
+@property (nonatomic, copy) NSArray<NSString *> *names;     /* Precomposed names, in the same order */
+@property (nonatomic, assign) NSUInteger cursor;
+@property (nonatomic, assign) NSUInteger prefetchCursor;
+
+@end
+
+@implementation TOSMBSyncRemoteFrame
+@end
+
+#pragma mark - Remote Walker -
+
+@interface TOSMBSyncRemoteWalker ()
+
+@property (nonatomic, weak) TOSMBSession *session;
+@property (nonatomic, strong) TOSMBPath *rootPath;
+@property (nonatomic, assign) NSUInteger maximumPrefetchedListings;
+@property (nonatomic, strong) NSOperationQueue *listingQueue;
+@property (nonatomic, strong) NSMutableArray<TOSMBSyncRemoteFrame *> *frames;
+@property (nonatomic, strong) NSMutableDictionary<TOSMBPath *, TOSMBSyncRemoteListing *> *listings;
+@property (nonatomic, assign) BOOL started;
+@property (nonatomic, assign) BOOL finished;
+@property (atomic, assign, readwrite) NSUInteger listedDirectoryCount;
+
+@end
+
+@implementation TOSMBSyncRemoteWalker
+
+- (instancetype)initWithSession:(TOSMBSession *)session
+                       rootPath:(TOSMBPath *)rootPath
+      maximumConcurrentListings:(NSUInteger)maximumConcurrentListings
+{
+    NSParameterAssert(session);
+    NSParameterAssert(rootPath.shareName);
+    self = [super init];
+    if (self) {
+        _session = session;
+        _rootPath = rootPath;
+        _maximumPrefetchedListings = MAX(maximumConcurrentListings, 1) * kTOSMBSyncRemoteWalkerPrefetchFactor;
+        _listingQueue = [[NSOperationQueue alloc] init];
+        _listingQueue.maxConcurrentOperationCount = MAX(maximumConcurrentListings, 1);
+        _frames = [NSMutableArray array];
+        _listings = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)dealloc{
+    [_listingQueue cancelAllOperations];
+}
+
+- (void)cancel{
+    self.finished = YES;
+    [self.listingQueue cancelAllOperations];
+}
+
+#pragma mark Listings
+
+- (TOSMBSyncRemoteListing *)requestListingForPath:(TOSMBPath *)path{
+    TOSMBSyncRemoteListing *listing = self.listings[path];
+    if (listing) {
+        return listing;
+    }
+
+    listing = [[TOSMBSyncRemoteListing alloc] init];
+    listing.group = dispatch_group_create();
+    self.listings[path] = listing;
+
+    dispatch_group_enter(listing.group);
+    TOSMBMakeWeakReference();
+    NSBlockOperation *operation = [NSBlockOperation blockOperationWithBlock:^{
+        TOSMBMakeStrongFromWeakReference();
+        NSError *error = nil;
+        TOSMBSessionFileList *fileList = [strongSelf.session fileListOfDirectoryAtSMBPath:path error:&error];
+        listing.fileList = fileList;
+        listing.error = (fileList == nil) ? (error ?: errorForErrorCode(TOSMBSessionErrorCodeFileNotFound)) : nil;
+        strongSelf.listedDirectoryCount++;
+    }];
+    //Leave the group whether the operation ran or was cancelled
+    operation.completionBlock = ^{
+        dispatch_group_leave(listing.group);
+    };
+    [self.listingQueue addOperation:operation];
+    return listing;
+}
+
+- (TOSMBSessionFileList *)waitForListingForPath:(TOSMBPath *)path error:(NSError **)error{
+    TOSMBSyncRemoteListing *listing = [self requestListingForPath:path];
+    dispatch_group_wait(listing.group, DISPATCH_TIME_FOREVER);
+    [self.listings removeObjectForKey:path];
+    if (listing.fileList == nil) {
+        if (error) {
+            *error = listing.error ?: errorForErrorCode(TOSMBSessionErrorCodeCancelled);
+        }
+    }
+    return listing.fileList;
+}
+
+/* Requests the listings of the next directories the walk will enter, nearest first */
+- (void)prefetchListings{
+    for (TOSMBSyncRemoteFrame *frame in self.frames.reverseObjectEnumerator) {
+        frame.prefetchCursor = MAX(frame.prefetchCursor, frame.cursor);
+        while (frame.prefetchCursor < frame.order.count) {
+            if (self.listings.count >= self.maximumPrefetchedListings) {
+                return;
+            }
+            const NSUInteger index = frame.order[frame.prefetchCursor++].unsignedIntegerValue;
+            if ([frame.fileList isDirectoryAtIndex:index]) {
+                [self requestListingForPath:[frame.directoryPath pathByAppendingComponent:[frame.fileList nameAtIndex:index]]];
+            }
+        }
+    }
+}
+
+- (BOOL)pushFrameForDirectoryAtPath:(TOSMBPath *)path prefix:(NSString *)prefix error:(NSError **)error{
+    TOSMBSessionFileList *fileList = [self waitForListingForPath:path error:error];
+    if (fileList == nil) {
+        return NO;
+    }
+
+    NSMutableArray<NSString *> *names = [NSMutableArray arrayWithCapacity:fileList.count];
+    NSMutableArray<NSNumber *> *indices = [NSMutableArray arrayWithCapacity:fileList.count];
+    for (NSUInteger i = 0; i < fileList.count; i++) {
+        NSString *name = [fileList nameAtIndex:i].precomposedStringWithCanonicalMapping;
+        if (name.length == 0 || [name isEqualToString:@"."] || [name isEqualToString:@".."]) {
+            continue;
+        }
+        [names addObject:name];
+        [indices addObject:@(i)];
+    }
+
+    NSMutableArray<NSNumber *> *positions = [NSMutableArray arrayWithCapacity:names.count];
+    for (NSUInteger i = 0; i < names.count; i++) {
+        [positions addObject:@(i)];
+    }
+    [positions sortUsingComparator:^NSComparisonResult(NSNumber *first, NSNumber *second) {
+        return TOSMBSyncCompareNames(names[first.unsignedIntegerValue], names[second.unsignedIntegerValue]);
+    }];
+
+    NSMutableArray<NSString *> *sortedNames = [NSMutableArray arrayWithCapacity:names.count];
+    NSMutableArray<NSNumber *> *sortedIndices = [NSMutableArray arrayWithCapacity:names.count];
+    for (NSNumber *position in positions) {
+        [sortedNames addObject:names[position.unsignedIntegerValue]];
+        [sortedIndices addObject:indices[position.unsignedIntegerValue]];
+    }
+
+    TOSMBSyncRemoteFrame *frame = [[TOSMBSyncRemoteFrame alloc] init];
+    frame.prefix = prefix;
+    frame.directoryPath = path;
+    frame.fileList = fileList;
+    frame.order = sortedIndices;
+    frame.names = sortedNames;
+    [self.frames addObject:frame];
+    return YES;
+}
+
+#pragma mark TOSMBSyncEntrySource
+
+- (TOSMBSyncEntry *)nextEntry:(NSError **)error{
+    if (self.finished) {
+        return nil;
+    }
+
+    if (self.started == NO) {
+        self.started = YES;
+        if ([self pushFrameForDirectoryAtPath:self.rootPath prefix:@"" error:error] == NO) {
+            self.finished = YES;
+            return nil;
+        }
+        [self prefetchListings];
+    }
+
+    while (self.frames.count > 0) {
+        TOSMBSyncRemoteFrame *frame = self.frames.lastObject;
+        if (frame.cursor >= frame.order.count) {
+            [self.frames removeLastObject];
+            continue;
+        }
+
+        const NSUInteger position = frame.cursor++;
+        const NSUInteger index = frame.order[position].unsignedIntegerValue;
+        TOSMBSessionFileList *fileList = frame.fileList;
+
+        TOSMBSyncEntry *entry = [[TOSMBSyncEntry alloc] init];
+        entry.path = TOSMBSyncChildPath(frame.prefix, frame.names[position]);
+        entry.directory = [fileList isDirectoryAtIndex:index];
+        entry.hasRemote = YES;
+        entry.remoteSize = entry.directory ? 0 : [fileList fileSizeAtIndex:index];
+        entry.remoteWriteTime = entry.directory ? 0 : [fileList writeFileTimeAtIndex:index];
+        entry.remotePath = [frame.directoryPath pathByAppendingComponent:[fileList nameAtIndex:index]];
+
+        //Enter the directory straight away, so everything inside it follows it
+        if (entry.directory) {
+            if ([self pushFrameForDirectoryAtPath:entry.remotePath prefix:entry.path error:error] == NO) {
+                [self cancel];
+                return nil;
+            }
+        }
+        [self prefetchListings];
+        return entry;
+    }
+
+    self.finished = YES;
+    return nil;
+}
+
+@end
+
+#pragma mark - Local Walker -
+
+@interface TOSMBSyncLocalFrame : NSObject
+
+@property (nonatomic, copy) NSString *prefix;
+@property (nonatomic, copy) NSString *directoryPath;
+@property (nonatomic, copy) NSArray<NSString *> *names;         /* Precomposed, sorted */
+@property (nonatomic, copy) NSArray<NSString *> *fileNames;     /* As stored on disk, in the same order */
+@property (nonatomic, assign) NSUInteger cursor;
+
+@end
+
+@implementation TOSMBSyncLocalFrame
+@end
+
+@interface TOSMBSyncLocalWalker ()
+
+@property (nonatomic, copy) NSString *rootPath;
+@property (nonatomic, strong) NSMutableArray<TOSMBSyncLocalFrame *> *frames;
+@property (nonatomic, assign) BOOL started;
+
+@end
+
+@implementation TOSMBSyncLocalWalker
+
+- (instancetype)initWithRootURL:(NSURL *)rootURL{
+    NSParameterAssert(rootURL.isFileURL);
+    self = [super init];
+    if (self) {
+        _rootPath = [rootURL.path copy];
+        _frames = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (BOOL)pushFrameForDirectoryAtPath:(NSString *)directoryPath prefix:(NSString *)prefix error:(NSError **)error{
+    DIR *directory = opendir(directoryPath.fileSystemRepresentation);
+    if (directory == NULL) {
+        //A missing root just means nothing has been synced locally yet
+        if (errno == ENOENT && prefix.length == 0) {
+            return YES;
+        }
+        if (error) {
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:@{NSFilePathErrorKey:directoryPath}];
+        }
+        return NO;
+    }
+
+    NSMutableArray<NSString *> *names = [NSMutableArray array];
+    NSMutableArray<NSString *> *fileNames = [NSMutableArray array];
+    struct dirent *item = NULL;
+    while ((item = readdir(directory)) != NULL) {
+        if (item->d_name[0] == '.') { //skip hidden files, as the device listing does
+            continue;
+        }
+        NSString *fileName = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:item->d_name
+                                                                                         length:strlen(item->d_name)];
+        if (fileName.length == 0) {
+            continue;
+        }
+        [fileNames addObject:fileName];
+        [names addObject:fileName.precomposedStringWithCanonicalMapping];
+    }
+    closedir(directory);
+
+    NSMutableArray<NSNumber *> *positions = [NSMutableArray arrayWithCapacity:names.count];
+    for (NSUInteger i = 0; i < names.count; i++) {
+        [positions addObject:@(i)];
+    }
+    [positions sortUsingComparator:^NSComparisonResult(NSNumber *first, NSNumber *second) {
+        return TOSMBSyncCompareNames(names[first.unsignedIntegerValue], names[second.unsignedIntegerValue]);
+    }];
+
+    NSMutableArray<NSString *> *sortedNames = [NSMutableArray arrayWithCapacity:names.count];
+    NSMutableArray<NSString *> *sortedFileNames = [NSMutableArray arrayWithCapacity:names.count];
+    for (NSNumber *position in positions) {
+        [sortedNames addObject:names[position.unsignedIntegerValue]];
+        [sortedFileNames addObject:fileNames[position.unsignedIntegerValue]];
+    }
+
+    TOSMBSyncLocalFrame *frame = [[TOSMBSyncLocalFrame alloc] init];
+    frame.prefix = prefix;
+    frame.directoryPath = directoryPath;
+    frame.names = sortedNames;
+    frame.fileNames = sortedFileNames;
+    [self.frames addObject:frame];
+    return YES;
+}
+
+- (TOSMBSyncEntry *)nextEntry:(NSError **)error{
+    if (self.started == NO) {
+        self.started = YES;
+        if ([self pushFrameForDirectoryAtPath:self.rootPath prefix:@"" error:error] == NO) {
+            [self.frames removeAllObjects];
+            return nil;
+        }
+    }
+
+    while (self.frames.count > 0) {
+        TOSMBSyncLocalFrame *frame = self.frames.lastObject;
+        if (frame.cursor >= frame.names.count) {
+            [self.frames removeLastObject];
+            continue;
+        }
+
+        const NSUInteger position = frame.cursor++;
+        NSString *localPath = [frame.directoryPath stringByAppendingPathComponent:frame.fileNames[position]];
+        struct stat status;
+        if (lstat(localPath.fileSystemRepresentation, &status) != 0) {
+            continue; //Removed while walking
+        }
+        const BOOL directory = S_ISDIR(status.st_mode);
+        if (directory == NO && S_ISREG(status.st_mode) == NO) {
+            continue;
+        }
+
+        TOSMBSyncEntry *entry = [[TOSMBSyncEntry alloc] init];
+        entry.path = TOSMBSyncChildPath(frame.prefix, frame.names[position]);
+        entry.directory = directory;
+        entry.hasLocal = YES;
+        entry.localSize = directory ? 0 : (uint64_t)status.st_size;
+        entry.localModificationTime = directory ? 0 :
+        (int64_t)status.st_mtimespec.tv_sec * 1000000 + status.st_mtimespec.tv_nsec / 1000;
+        entry.localPath = localPath;
+
+        if (directory) {
+            if ([self pushFrameForDirectoryAtPath:localPath prefix:entry.path error:error] == NO) {
+                [self.frames removeAllObjects];
+                return nil;
+            }
+        }
+        return entry;
+    }
+    return nil;
+}
+
+@end
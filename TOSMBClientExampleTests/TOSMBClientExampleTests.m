@@ -8,6 +8,151 @@
 
 #import <UIKit/UIKit.h>
 #import <XCTest/XCTest.h>
+#import "TOSMBCSessionWrapper.h"
+#import "TOSMBCSessionWrapper+Private.h"
+#import "TOSMBCSessionRegistry.h"
+#import "TOSMBNetworkHostRegistry.h"
+#import "TOHostResolver.h"
+#import "TONetBIOSNameResolver.h"
+#import "netbios_ns.h"
+#import "TOSMBSessionFile+Private.h"
+#import "TOSMBSessionFileList+Private.h"
+#import "TOSMBPath.h"
+#import "NSString+TOSMB.h"
+#import "TOSMBDigest.h"
+#import "TOSMBSyncSnapshot.h"
+#import "TOSMBSyncEngine+Private.h"
+#import "TOSMBShareIndexTable.h"
+#import "TOSMBSession.h"
+#import "TOSMBPrefetcher.h"
+#import "TOSMBSessionDownloadTask.h"
+#import "TOSMBSessionAsyncOperation.h"
+#import "TOSMBSession+Private.h"
+#import "TOSMBSessionTransferTask+Private.h"
+#import "TOSMBProgressStream.h"
+
+/* Number of simulated libdsm call sequences per measured iteration */
+static const NSInteger kTOSMBClientExampleTestsOperationCount = 10000;
+
+/* Number of requests in flight at once, and the simulated time each spends in libdsm */
+static const NSUInteger kTOSMBClientExampleTestsConcurrentRequestCount = 128;
+static const useconds_t kTOSMBClientExampleTestsRequestDuration = 200;
+
+/* Number of entries in the simulated directory listing */
+static const NSUInteger kTOSMBClientExampleTestsListingCount = 100000;
+
+/* Size of the simulated transfer hashed per measured iteration, and of each chunk */
+static const NSUInteger kTOSMBClientExampleTestsDigestLength = 64 * 1024 * 1024;
+static const NSUInteger kTOSMBClientExampleTestsDigestChunkLength = 32 * 1024;
+
+/* Number of entries in the simulated sync snapshot */
+static const NSUInteger kTOSMBClientExampleTestsSnapshotCount = 1000000;
+
+/* Number of names in the simulated share index, and searches per measured iteration */
+static const uint32_t kTOSMBClientExampleTestsIndexCount = 1000000;
+static const NSUInteger kTOSMBClientExampleTestsIndexSearchCount = 100;
+
+/* 2020-01-01 as a FILETIME */
+static const uint64_t kTOSMBClientExampleTestsFileTime = 132223104000000000ULL;
+
+@interface TOHostResolver (Testing)
+- (NSMutableDictionary *)entries;
+@end
+
+@interface TONetBIOSNameResolver (Testing)
+- (NSString *)performQueryWithTimeout:(NSTimeInterval)timeout operation:(NSOperation *)operation block:(NSString *(^)(netbios_ns *nameService))queryBlock;
+@end
+
+@interface TOSMBNetworkHostRegistry (Testing)
+- (TOSMBNetworkHost *)mergeHostWithNetBIOSName:(NSString *)name group:(NSString *)group address:(NSString *)address seen:(BOOL)seen;
+@end
+
+@interface TOSMBPrefetcher (Testing)
+- (void)cacheHead:(NSData *)head ofFile:(TOSMBSessionFile *)file inSession:(TOSMBSession *)session;
+@end
+
+@interface TOSMBSessionDownloadTask (Testing)
+- (void)didSucceedInMemory;
+- (void)didFailWithError:(NSError *)error;
+@end
+
+@interface TOSMBSession (Testing)
+- (void)setConnected:(BOOL)connected;
+@end
+
+/* State of the simulated connection behind the stubbed contexts */
+static NSInteger TOSMBClientExampleTestsFailedReadCount = 0;
+static BOOL TOSMBClientExampleTestsConnectionDown = NO;
+static uint64_t TOSMBClientExampleTestsOpenOffset = 0;
+
+/* Stands in for libdsm: reads fail while asked to, and the connection is down until the session reconnects */
+@interface TOSMBClientExampleTestsOperationContext : TOSMBSessionOperationContext
+@end
+
+@implementation TOSMBClientExampleTestsOperationContext
+- (smb_tid)treeIDForShareName:(NSString *)shareName { return 1; }
+- (int)openFileAtPath:(const char *)path inTree:(smb_tid)treeID mode:(uint32_t)mode offset:(uint64_t)offset fileID:(smb_fd *)fileID {
+    TOSMBClientExampleTestsOpenOffset = offset;
+    *fileID = 7;
+    return DSM_SUCCESS;
+}
+- (ssize_t)readFile:(smb_fd)fileID intoBuffer:(void *)buffer length:(size_t)length {
+    if (TOSMBClientExampleTestsFailedReadCount > 0) {
+        TOSMBClientExampleTestsFailedReadCount--;
+        return -1;
+    }
+    memset(buffer, 0, length);
+    return (ssize_t)length;
+}
+- (BOOL)hasConnectionFailed { return TOSMBClientExampleTestsConnectionDown; }
+@end
+
+@interface TOSMBClientExampleTestsSessionWrapper : TOSMBCSessionWrapper
+@end
+
+@implementation TOSMBClientExampleTestsSessionWrapper
++ (Class)operationContextClass { return [TOSMBClientExampleTestsOperationContext class]; }
+@end
+
+/* Reconnects without the network, taking a moment so requests running side by side overlap */
+@interface TOSMBClientExampleTestsSession : TOSMBSession
+@end
+
+@implementation TOSMBClientExampleTestsSession
++ (Class)sessionWrapperClass { return [TOSMBClientExampleTestsSessionWrapper class]; }
+- (NSError *)attemptConnection {
+    [NSThread sleepForTimeInterval:0.01];
+    TOSMBClientExampleTestsConnectionDown = NO;
+    [self setConnected:YES];
+    return nil;
+}
+@end
+
+/* Answers lookups from a table instead of the network, and counts how many it was asked to make */
+@interface TOSMBClientExampleTestsHostResolver : TOHostResolver
+@property (atomic, copy) NSDictionary<NSString *, NSArray<NSString *> *> *answers;
+@property (atomic, assign) NSTimeInterval lookupDuration;
+@property (atomic, assign) NSInteger lookupCount;
+@end
+
+@implementation TOSMBClientExampleTestsHostResolver
+- (NSArray<NSString *> *)performLookupWithQueryType:(NSInteger)queryType host:(NSString *)host netBIOSType:(TONetBIOSNameServiceType)netBIOSType {
+    @synchronized (self) {
+        self.lookupCount++;
+    }
+    [NSThread sleepForTimeInterval:self.lookupDuration];
+    return self.answers[host];
+}
+@end
+
+/* Hands out a fixed list of entries, standing in for a snapshot or a walk */
+@interface TOSMBClientExampleTestsEntrySource : NSObject <TOSMBSyncEntrySource>
+@property (nonatomic, strong) NSEnumerator<TOSMBSyncEntry *> *entries;
+@end
+
+@implementation TOSMBClientExampleTestsEntrySource
+- (TOSMBSyncEntry *)nextEntry:(NSError **)error { return self.entries.nextObject; }
+@end
 
 @interface TOSMBClientExampleTests : XCTestCase
 
@@ -37,4 +182,987 @@
     }];
 }
 
+#pragma mark - Session Operation Context -
+
+- (void)testPerformancePerCallSessionHops {
+    // The hops of a tree ID lookup followed by stat, read and destroy, each taking its own trip onto the session queue.
+    // There is no server here, so the blocks make no libdsm calls: this measures only the locking and queue hops
+    // that a per-call sequence pays on top of its network round trips.
+    TOSMBCSessionWrapper *wrapper = [[TOSMBCSessionWrapper alloc] init];
+    [self measureBlock:^{
+        for (NSInteger i = 0; i < kTOSMBClientExampleTestsOperationCount; i++) {
+            __block NSInteger calls = 0;
+            [wrapper cachedShareIDForName:@"Share"];
+            [wrapper inSMBCSession:^(smb_session *session) { calls++; }];
+            [wrapper inSMBCSession:^(smb_session *session) { calls++; }];
+            [wrapper inSMBCSession:^(smb_session *session) { calls++; }];
+        }
+    }];
+    [wrapper close];
+}
+
+- (void)testPerformanceOperationContext {
+    // The same sequence run inside one operation context. As above, only the hop is measured, not the libdsm calls.
+    TOSMBCSessionWrapper *wrapper = [[TOSMBCSessionWrapper alloc] init];
+    [self measureBlock:^{
+        for (NSInteger i = 0; i < kTOSMBClientExampleTestsOperationCount; i++) {
+            __block NSInteger calls = 0;
+            [wrapper performOperation:^(TOSMBSessionOperationContext *context) {
+                [context cachedTreeIDForShareName:@"Share"];
+                calls += 3;
+            }];
+        }
+    }];
+    [wrapper close];
+}
+
+#pragma mark - Host Resolver -
+
+- (void)testHostResolverCachesResults {
+    TOSMBClientExampleTestsHostResolver *resolver = [[TOSMBClientExampleTestsHostResolver alloc] init];
+    resolver.answers = @{@"nas.local": @[@"192.0.2.1"]};
+    resolver.positiveTTL = 0.5;
+    resolver.negativeTTL = 0.5;
+
+    // Fresh answers come from the cache, failed lookups included
+    XCTAssertEqualObjects([resolver addressesForHostname:@"nas.local"], @[@"192.0.2.1"]);
+    XCTAssertEqualObjects([resolver addressesForHostname:@"NAS.local"], @[@"192.0.2.1"]);
+    XCTAssertNil([resolver addressesForHostname:@"missing.local"]);
+    XCTAssertNil([resolver addressesForHostname:@"missing.local"]);
+    XCTAssertEqual(resolver.lookupCount, 2);
+
+    // Expired answers are looked up again
+    [NSThread sleepForTimeInterval:0.6];
+    XCTAssertEqualObjects([resolver addressesForHostname:@"nas.local"], @[@"192.0.2.1"]);
+    XCTAssertEqual(resolver.lookupCount, 3);
+
+    // Invalidating an address drops every answer that mentions it
+    [resolver invalidateCachedResultsForHost:@"192.0.2.1"];
+    XCTAssertEqualObjects([resolver addressesForHostname:@"nas.local"], @[@"192.0.2.1"]);
+    XCTAssertEqual(resolver.lookupCount, 4);
+}
+
+- (void)testHostResolverDropsExpiredResults {
+    TOSMBClientExampleTestsHostResolver *resolver = [[TOSMBClientExampleTestsHostResolver alloc] init];
+    resolver.answers = @{@"nas.local": @[@"192.0.2.1"]};
+    resolver.positiveTTL = 0.5;
+    resolver.negativeTTL = 0.5;
+
+    for (NSUInteger i = 0; i < 20; i++) {
+        [resolver addressesForHostname:[NSString stringWithFormat:@"host%lu.local", (unsigned long)i]];
+    }
+    XCTAssertEqual(resolver.entries.count, 20);
+
+    // Hosts that are never asked about again are swept out when the next answer comes in
+    [NSThread sleepForTimeInterval:0.6];
+    XCTAssertEqualObjects([resolver addressesForHostname:@"nas.local"], @[@"192.0.2.1"]);
+    XCTAssertEqual(resolver.entries.count, 1);
+}
+
+- (void)testHostResolverCoalescesRequests {
+    TOSMBClientExampleTestsHostResolver *resolver = [[TOSMBClientExampleTestsHostResolver alloc] init];
+    resolver.answers = @{@"nas.local": @[@"192.0.2.1"]};
+    resolver.lookupDuration = 0.2;
+
+    // Requests made while a lookup is running all wait on that one lookup
+    dispatch_group_t group = dispatch_group_create();
+    for (NSUInteger i = 0; i < 20; i++) {
+        dispatch_group_enter(group);
+        [resolver addressesForHostname:@"nas.local" completion:^(NSArray<NSString *> *results) {
+            XCTAssertEqualObjects(results, @[@"192.0.2.1"]);
+            dispatch_group_leave(group);
+        }];
+    }
+    XCTAssertEqual(dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(2.0 * NSEC_PER_SEC))), 0);
+    XCTAssertEqual(resolver.lookupCount, 1);
+
+    // Other queries don't join it
+    XCTAssertNil([resolver hostnamesForAddress:@"192.0.2.1"]);
+    XCTAssertEqual(resolver.lookupCount, 2);
+}
+
+#pragma mark - NetBIOS Name Resolver -
+
+- (void)testNetBIOSNameResolverReleasesSlotsOfAbandonedQueries {
+    TONetBIOSNameResolver *resolver = [[TONetBIOSNameResolver alloc] initWithMaximumConcurrentQueries:2];
+
+    // Queries nobody answers fill every slot, but give them back once their callers give up
+    dispatch_group_t group = dispatch_group_create();
+    for (NSUInteger i = 0; i < resolver.maximumConcurrentQueries; i++) {
+        dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+            NSString *result = [resolver performQueryWithTimeout:0.2 operation:nil block:^NSString *(netbios_ns *nameService) {
+                [NSThread sleepForTimeInterval:2.0];
+                return @"late";
+            }];
+            XCTAssertNil(result);
+        });
+    }
+    XCTAssertEqual(dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(1.0 * NSEC_PER_SEC))), 0);
+
+    // So the next query still runs while they are stuck in libdsm
+    NSString *result = [resolver performQueryWithTimeout:0.5 operation:nil block:^NSString *(netbios_ns *nameService) {
+        return @"NAS";
+    }];
+    XCTAssertEqualObjects(result, @"NAS");
+
+    // A cancelled query gives its slot back too
+    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
+    [operation cancel];
+    XCTAssertNil([resolver performQueryWithTimeout:5.0 operation:operation block:^NSString *(netbios_ns *nameService) {
+        [NSThread sleepForTimeInterval:2.0];
+        return @"late";
+    }]);
+    XCTAssertEqualObjects([resolver performQueryWithTimeout:0.5 operation:nil block:^NSString *(netbios_ns *nameService) {
+        return @"NAS";
+    }], @"NAS");
+}
+
+#pragma mark - Network Host Registry -
+
+- (void)testNetworkHostRegistryMerging {
+    TOSMBNetworkHostRegistry *registry = [[TOSMBNetworkHostRegistry alloc] initWithStorageURL:nil];
+
+    // A host first known only by its address is re-keyed once its name turns up
+    [registry mergeHostWithNetBIOSName:nil group:nil address:@"192.0.2.20" seen:YES];
+    [registry mergeHostWithNetBIOSName:@"NAS-A" group:@"WORKGROUP" address:@"192.0.2.20" seen:YES];
+    XCTAssertEqual(registry.hosts.count, 1);
+    XCTAssertEqualObjects([registry hostForNameOrAddress:@"192.0.2.20"].identifier, @"NAS-A");
+
+    // Another device on the same address is a new host, and takes the address with it
+    [registry mergeHostWithNetBIOSName:@"NAS-B" group:nil address:@"192.0.2.20" seen:YES];
+    XCTAssertEqual(registry.hosts.count, 2);
+    XCTAssertEqualObjects([registry hostForNameOrAddress:@"NAS-A"].netBIOSName, @"NAS-A");
+    XCTAssertEqual([registry hostForNameOrAddress:@"NAS-A"].addresses.count, 0);
+    XCTAssertEqualObjects([registry hostForNameOrAddress:@"192.0.2.20"].netBIOSName, @"NAS-B");
+
+    // Only the latest few addresses are kept, most recent first
+    for (NSUInteger i = 21; i <= 26; i++) {
+        [registry mergeHostWithNetBIOSName:@"NAS-B" group:nil address:[NSString stringWithFormat:@"192.0.2.%lu", (unsigned long)i] seen:YES];
+    }
+    NSArray<NSString *> *addresses = [registry hostForNameOrAddress:@"NAS-B"].addresses;
+    XCTAssertEqual(addresses.count, 4);
+    XCTAssertEqualObjects(addresses.firstObject, @"192.0.2.26");
+    XCTAssertFalse([addresses containsObject:@"192.0.2.20"]);
+}
+
+- (void)testNetworkHostRegistryPersistence {
+    NSURL *URL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[NSString TOSMB_uuidString]]];
+    TOSMBNetworkHostRegistry *registry = [[TOSMBNetworkHostRegistry alloc] initWithStorageURL:URL];
+    [registry mergeHostWithNetBIOSName:@"NAS" group:@"WORKGROUP" address:@"192.0.2.30" seen:YES];
+    [registry save];
+
+    TOSMBNetworkHost *host = [[[TOSMBNetworkHostRegistry alloc] initWithStorageURL:URL] hostForNameOrAddress:@"NAS"];
+    [[NSFileManager defaultManager] removeItemAtURL:URL error:nil];
+    XCTAssertEqualObjects(host.group, @"WORKGROUP");
+    XCTAssertEqualObjects(host.addresses, @[@"192.0.2.30"]);
+    XCTAssertNotNil(host.lastSeenDate);
+
+    // Nothing is online until it has been seen again
+    XCTAssertFalse(host.online);
+}
+
+#pragma mark - Session Registry -
+
+- (TOSMBCSessionWrapper *)unconnectedWrapperForAddress:(NSString *)ipAddress {
+    TOSMBCSessionWrapper *wrapper = [[TOSMBCSessionWrapper alloc] init];
+    wrapper.ipAddress = ipAddress;
+    wrapper.userName = @"guest";
+    return wrapper;
+}
+
+/* Closing happens in the background, and a closed wrapper hands async operations a nil context */
+- (void)waitUntilWrapperIsClosed:(TOSMBCSessionWrapper *)wrapper {
+    NSPredicate *closed = [NSPredicate predicateWithBlock:^BOOL(TOSMBCSessionWrapper *object, NSDictionary *bindings) {
+        dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+        __block BOOL isClosed = NO;
+        [object performAsyncOperation:^(TOSMBSessionOperationContext *context) {
+            isClosed = (context == nil);
+            dispatch_semaphore_signal(semaphore);
+        }];
+        dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+        return isClosed;
+    }];
+    [self expectationForPredicate:closed evaluatedWithObject:wrapper handler:nil];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (void)testSessionRegistryReferenceCounting {
+    TOSMBCSessionRegistry *registry = [[TOSMBCSessionRegistry alloc] init];
+    registry.idleTimeout = 60.0;
+    TOSMBCSessionWrapper *wrapper = [self unconnectedWrapperForAddress:@"192.0.2.10"];
+    XCTAssertEqual([registry registerSession:wrapper], wrapper);
+
+    // A second login with the same key is handed the first one and closes its own
+    TOSMBCSessionWrapper *loser = [self unconnectedWrapperForAddress:@"192.0.2.10"];
+    XCTAssertEqual([registry registerSession:loser], wrapper);
+    XCTAssertFalse([registry containsSession:loser]);
+    XCTAssertFalse([registry releaseSession:loser]);
+    [loser close];
+
+    // Only an unreferenced session is closed
+    XCTAssertTrue([registry releaseSession:wrapper]);
+    [registry closeIdleSessions];
+    XCTAssertTrue([registry containsSession:wrapper]);
+    XCTAssertTrue([registry releaseSession:wrapper]);
+    [registry closeIdleSessions];
+    XCTAssertFalse([registry containsSession:wrapper]);
+    [self waitUntilWrapperIsClosed:wrapper];
+}
+
+- (void)testSessionRegistryRetiresInvalidatedSessions {
+    TOSMBCSessionRegistry *registry = [[TOSMBCSessionRegistry alloc] init];
+    TOSMBCSessionWrapper *wrapper = [self unconnectedWrapperForAddress:@"192.0.2.11"];
+    [registry registerSession:wrapper];
+
+    // No longer handed out, but kept open until its last user lets go
+    [registry invalidateSession:wrapper];
+    XCTAssertTrue([registry containsSession:wrapper]);
+    TOSMBCSessionWrapper *replacement = [self unconnectedWrapperForAddress:@"192.0.2.11"];
+    XCTAssertEqual([registry registerSession:replacement], replacement);
+    XCTAssertTrue([registry releaseSession:wrapper]);
+    XCTAssertFalse([registry containsSession:wrapper]);
+    [self waitUntilWrapperIsClosed:wrapper];
+
+    // A session that isn't connected is retired instead of being checked out
+    XCTAssertTrue([registry releaseSession:replacement]);
+    XCTAssertNil([registry checkoutSessionForKey:replacement.sessionKey]);
+    XCTAssertFalse([registry containsSession:replacement]);
+    [self waitUntilWrapperIsClosed:replacement];
+}
+
+- (void)testSessionRegistryClosesIdleSessions {
+    TOSMBCSessionRegistry *registry = [[TOSMBCSessionRegistry alloc] init];
+    registry.idleTimeout = 0.5;
+    TOSMBCSessionWrapper *wrapper = [self unconnectedWrapperForAddress:@"192.0.2.12"];
+    [registry registerSession:wrapper];
+    [registry releaseSession:wrapper];
+
+    // Kept for a while in case it is picked up again, then closed
+    XCTAssertTrue([registry containsSession:wrapper]);
+    [self waitUntilWrapperIsClosed:wrapper];
+    XCTAssertFalse([registry containsSession:wrapper]);
+}
+
+#pragma mark - Completion-Based Core -
+
+- (void)testPerformanceBlockingConcurrentRequests {
+    // Every request parks a request queue thread until the session queue gets to it
+    TOSMBCSessionWrapper *wrapper = [[TOSMBCSessionWrapper alloc] init];
+    NSOperationQueue *queue = [[NSOperationQueue alloc] init];
+    queue.maxConcurrentOperationCount = kTOSMBClientExampleTestsConcurrentRequestCount;
+    NSObject *lock = [[NSObject alloc] init];
+    __block NSInteger parkedThreads = 0;
+    __block NSInteger peakParkedThreads = 0;
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < kTOSMBClientExampleTestsConcurrentRequestCount; i++) {
+            [queue addOperationWithBlock:^{
+                @synchronized (lock) {
+                    parkedThreads++;
+                    peakParkedThreads = MAX(peakParkedThreads, parkedThreads);
+                }
+                [wrapper performOperation:^(TOSMBSessionOperationContext *context) {
+                    usleep(kTOSMBClientExampleTestsRequestDuration);
+                }];
+                @synchronized (lock) {
+                    parkedThreads--;
+                }
+            }];
+        }
+        [queue waitUntilAllOperationsAreFinished];
+    }];
+    // The session queue runs one request at a time, so the rest each hold a thread while they wait
+    XCTAssertGreaterThan(peakParkedThreads, 1);
+    [wrapper close];
+}
+
+- (void)testPerformanceCompletionBasedConcurrentRequests {
+    // The same requests queued on the session queue, with no thread waiting on any of them
+    TOSMBCSessionWrapper *wrapper = [[TOSMBCSessionWrapper alloc] init];
+    [self measureBlock:^{
+        dispatch_group_t group = dispatch_group_create();
+        for (NSUInteger i = 0; i < kTOSMBClientExampleTestsConcurrentRequestCount; i++) {
+            dispatch_group_enter(group);
+            [wrapper performAsyncOperation:^(TOSMBSessionOperationContext *context) {
+                usleep(kTOSMBClientExampleTestsRequestDuration);
+                dispatch_group_leave(group);
+            }];
+        }
+        dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    }];
+    [wrapper close];
+}
+
+- (void)testAsyncOperationOnClosedSession {
+    TOSMBCSessionWrapper *wrapper = [[TOSMBCSessionWrapper alloc] init];
+    [wrapper close];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Closed session"];
+    [wrapper performAsyncOperation:^(TOSMBSessionOperationContext *context) {
+        XCTAssertNil(context);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+}
+
+- (void)testAsyncOperationRunsUntilFinished {
+    NSOperationQueue *queue = [[NSOperationQueue alloc] init];
+    __block TOSMBSessionAsyncOperation *started = nil;
+    TOSMBSessionAsyncOperation *operation = [[TOSMBSessionAsyncOperation alloc] initWithBlock:^(TOSMBSessionAsyncOperation *asyncOperation) {
+        started = asyncOperation;
+    }];
+    [queue addOperation:operation];
+    [self expectationForPredicate:[NSPredicate predicateWithFormat:@"isExecuting == YES"] evaluatedWithObject:operation handler:nil];
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+    XCTAssertEqual(started, operation);
+    XCTAssertFalse(operation.isFinished);
+
+    [operation finish];
+    [operation finish];
+    [queue waitUntilAllOperationsAreFinished];
+    XCTAssertTrue(operation.isFinished);
+
+    // Cancelled before it starts, the block never runs
+    __block BOOL ran = NO;
+    TOSMBSessionAsyncOperation *cancelled = [[TOSMBSessionAsyncOperation alloc] initWithBlock:^(TOSMBSessionAsyncOperation *asyncOperation) {
+        ran = YES;
+        [asyncOperation finish];
+    }];
+    [cancelled cancel];
+    [queue addOperation:cancelled];
+    [queue waitUntilAllOperationsAreFinished];
+    XCTAssertFalse(ran);
+}
+
+#pragma mark - Compact Listing -
+
+- (void)testFileTimeConversion {
+    XCTAssertEqualWithAccuracy(TOSMBTimeIntervalSince1970FromFileTime(kTOSMBClientExampleTestsFileTime), 1577836800.0, 0.0001);
+    XCTAssertEqualWithAccuracy(TOSMBTimeIntervalSince1970FromFileTime(116444736000000000ULL), 0.0, 0.0001);
+}
+
+- (void)testPerformanceObjectPerEntryListing {
+    // One file object per entry with both dates built through a calendar, as listings used to
+    [self measureBlock:^{
+        NSMutableArray *files = [NSMutableArray arrayWithCapacity:kTOSMBClientExampleTestsListingCount];
+        for (NSUInteger i = 0; i < kTOSMBClientExampleTestsListingCount; i++) {
+            NSString *name = [NSString stringWithFormat:@"File %lu.jpg", (unsigned long)i];
+            NSString *fullPath = [@"/Share/Photos" stringByAppendingPathComponent:name];
+            TOSMBSessionFile *file = [[TOSMBSessionFile alloc] initWithName:name fullPath:fullPath directory:NO];
+            file.fileSize = i;
+            file.modificationTimestamp = kTOSMBClientExampleTestsFileTime + i;
+            file.creationTimestamp = kTOSMBClientExampleTestsFileTime;
+            file.modificationTime = [self calendarDateFromFileTime:file.modificationTimestamp];
+            file.creationTime = [self calendarDateFromFileTime:file.creationTimestamp];
+            [files addObject:file];
+        }
+    }];
+}
+
+- (void)testPerformanceCompactListing {
+    // The same listing in columns, reading sizes and modification times without creating objects
+    [self measureBlock:^{
+        TOSMBSessionFileList *fileList = [[TOSMBSessionFileList alloc] initWithPath:@"/Share/Photos"
+                                                                           capacity:kTOSMBClientExampleTestsListingCount];
+        char name[64];
+        for (NSUInteger i = 0; i < kTOSMBClientExampleTestsListingCount; i++) {
+            int length = snprintf(name, sizeof(name), "File %lu.jpg", (unsigned long)i);
+            [fileList addEntryWithName:name length:length fileSize:i allocationSize:i directory:NO
+                          creationTime:kTOSMBClientExampleTestsFileTime accessTime:0 writeTime:0
+                      modificationTime:kTOSMBClientExampleTestsFileTime + i];
+        }
+        uint64_t totalSize = 0;
+        NSTimeInterval newest = 0;
+        for (NSUInteger i = 0; i < fileList.count; i++) {
+            totalSize += [fileList fileSizeAtIndex:i];
+            newest = MAX(newest, [fileList modificationTimeIntervalSince1970AtIndex:i]);
+        }
+        XCTAssertEqual(fileList.count, kTOSMBClientExampleTestsListingCount);
+        XCTAssertGreaterThan(totalSize, 0);
+    }];
+}
+
+- (void)testPathParsing {
+    TOSMBPath *path = [TOSMBPath pathWithString:@"\\Share//Folder\\File.txt"];
+    XCTAssertEqualObjects(path.string, @"/Share/Folder/File.txt");
+    XCTAssertEqualObjects(path.shareName, @"Share");
+    XCTAssertEqualObjects(path.relativeSMBPath, @"\\Folder\\File.txt");
+    XCTAssertEqual(strcmp(path.relativeSMBPathUTF8String, "\\Folder\\File.txt"), 0);
+    XCTAssertEqualObjects(path.parentPath.relativeSMBPath, @"\\Folder");
+    XCTAssertEqualObjects(path.parentPath.parentPath.relativeSMBPath, @"\\");
+    XCTAssertTrue(path.parentPath.parentPath.isShareRoot);
+    XCTAssertTrue(path.parentPath.parentPath.parentPath.isRoot);
+    XCTAssertEqualObjects([path.parentPath pathByAppendingComponent:@"File.txt"], path);
+    XCTAssertEqualObjects([[TOSMBPath rootPath] pathByAppendingComponent:@"Share"].relativeSMBPath, @"\\");
+}
+
+- (void)testPerformanceStringPathParsing {
+    // What every operation used to do: re-derive the share and relative path from the string each time
+    [self measureBlock:^{
+        for (NSInteger i = 0; i < kTOSMBClientExampleTestsOperationCount; i++) {
+            NSString *path = [NSString stringWithFormat:@"/Share/Folder/File %ld.txt", (long)i];
+            NSString *shareName = [path TOSMB_shareNameFromPath];
+            const char *relativePath = [[path TOSMB_relativeSMBPathFromPath] cStringUsingEncoding:NSUTF8StringEncoding];
+            XCTAssert(shareName.length > 0 && relativePath != NULL);
+        }
+    }];
+}
+
+- (void)testPerformanceParsedPathDerivation {
+    // Children derived from an already parsed folder, without going back to a string
+    [self measureBlock:^{
+        TOSMBPath *folder = [TOSMBPath pathWithString:@"/Share/Folder"];
+        for (NSInteger i = 0; i < kTOSMBClientExampleTestsOperationCount; i++) {
+            TOSMBPath *path = [folder pathByAppendingComponent:[NSString stringWithFormat:@"File %ld.txt", (long)i]];
+            XCTAssert(path.shareName.length > 0 && path.relativeSMBPathUTF8String != NULL);
+        }
+    }];
+}
+
+- (void)testDigestVectors {
+    NSData *empty = [NSData data];
+    NSData *abc = [@"abc" dataUsingEncoding:NSUTF8StringEncoding];
+    XCTAssertEqualObjects([TOSMBDigest hexStringFromDigest:[TOSMBDigest digestOfData:empty algorithm:TOSMBDigestAlgorithmXXH64]], @"ef46db3751d8e999");
+    XCTAssertEqualObjects([TOSMBDigest hexStringFromDigest:[TOSMBDigest digestOfData:abc algorithm:TOSMBDigestAlgorithmXXH64]], @"44bc2cf5ad770999");
+    XCTAssertEqualObjects([TOSMBDigest hexStringFromDigest:[TOSMBDigest digestOfData:abc algorithm:TOSMBDigestAlgorithmSHA256]],
+                          @"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    XCTAssertNil([[TOSMBDigest alloc] initWithAlgorithm:TOSMBDigestAlgorithmNone]);
+}
+
+- (void)testDigestIsIndependentOfChunking {
+    NSMutableData *data = [NSMutableData dataWithLength:100003];
+    uint8_t *bytes = data.mutableBytes;
+    for (NSUInteger i = 0; i < data.length; i++) {
+        bytes[i] = (uint8_t)(i * 31);
+    }
+    for (NSNumber *algorithm in @[@(TOSMBDigestAlgorithmXXH64), @(TOSMBDigestAlgorithmSHA256)]) {
+        TOSMBDigest *digest = [[TOSMBDigest alloc] initWithAlgorithm:algorithm.integerValue];
+        for (NSUInteger offset = 0; offset < data.length; offset += 7) {
+            [digest updateWithBytes:bytes + offset length:MIN(7, data.length - offset)];
+        }
+        XCTAssertEqualObjects([digest finish], [TOSMBDigest digestOfData:data algorithm:algorithm.integerValue]);
+    }
+}
+
+- (void)testPerformanceStreamingXXH64Digest {
+    [self measureStreamingDigestWithAlgorithm:TOSMBDigestAlgorithmXXH64];
+}
+
+- (void)testPerformanceStreamingSHA256Digest {
+    [self measureStreamingDigestWithAlgorithm:TOSMBDigestAlgorithmSHA256];
+}
+
+- (void)measureStreamingDigestWithAlgorithm:(TOSMBDigestAlgorithm)algorithm {
+    // Hashing transfer-sized chunks as they pass through, as a download or upload does
+    NSMutableData *chunk = [NSMutableData dataWithLength:kTOSMBClientExampleTestsDigestChunkLength];
+    memset(chunk.mutableBytes, 0xA5, chunk.length);
+    [self measureBlock:^{
+        TOSMBDigest *digest = [[TOSMBDigest alloc] initWithAlgorithm:algorithm];
+        for (NSUInteger offset = 0; offset < kTOSMBClientExampleTestsDigestLength; offset += chunk.length) {
+            [digest updateWithBytes:chunk.bytes length:chunk.length];
+        }
+        XCTAssertGreaterThan([digest finish].length, 0);
+    }];
+}
+
+- (void)testSyncPathOrdering {
+    // A directory sorts straight before its contents, even when a sibling shares its prefix
+    XCTAssertEqual(TOSMBSyncComparePaths(@"a", @"a/b"), NSOrderedAscending);
+    XCTAssertEqual(TOSMBSyncComparePaths(@"a/z", @"a-b"), NSOrderedAscending);
+    XCTAssertEqual(TOSMBSyncComparePaths(@"a-b", @"a"), NSOrderedDescending);
+    XCTAssertEqual(TOSMBSyncComparePaths(@"a/b", @"a/b"), NSOrderedSame);
+    XCTAssertTrue(TOSMBSyncPathIsInsideDirectory(@"a/b", @"a"));
+    XCTAssertFalse(TOSMBSyncPathIsInsideDirectory(@"ab", @"a"));
+    XCTAssertFalse(TOSMBSyncPathIsInsideDirectory(@"a", @"a"));
+}
+
+- (void)testSyncSnapshotRoundTrip {
+    NSURL *URL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[NSString TOSMB_uuidString]]];
+    TOSMBSyncSnapshotWriter *writer = [[TOSMBSyncSnapshotWriter alloc] initWithURL:URL error:nil];
+    XCTAssertNotNil(writer);
+
+    TOSMBSyncEntry *directory = [[TOSMBSyncEntry alloc] init];
+    directory.path = @"Caf\u00e9";
+    directory.directory = YES;
+    directory.hasRemote = YES;
+    directory.hasLocal = YES;
+    TOSMBSyncEntry *file = [[TOSMBSyncEntry alloc] init];
+    file.path = @"Caf\u00e9/menu.pdf";
+    file.hasRemote = YES;
+    file.remoteSize = 4096;
+    file.remoteWriteTime = kTOSMBClientExampleTestsFileTime;
+    file.localModificationTime = -1;
+    XCTAssertTrue([writer appendEntry:directory]);
+    XCTAssertTrue([writer appendEntry:file]);
+    XCTAssertTrue([writer finish]);
+
+    TOSMBSyncSnapshotReader *reader = [[TOSMBSyncSnapshotReader alloc] initWithURL:URL error:nil];
+    XCTAssertEqual(reader.count, 2);
+    TOSMBSyncEntry *readDirectory = [reader nextEntry:nil];
+    TOSMBSyncEntry *readFile = [reader nextEntry:nil];
+    XCTAssertNil([reader nextEntry:nil]);
+    [reader close];
+    [[NSFileManager defaultManager] removeItemAtURL:URL error:nil];
+
+    XCTAssertEqualObjects(readDirectory.path, directory.path);
+    XCTAssertTrue(readDirectory.directory && readDirectory.hasRemote && readDirectory.hasLocal);
+    XCTAssertEqualObjects(readFile.path, file.path);
+    XCTAssertFalse(readFile.directory || readFile.hasLocal);
+    XCTAssertEqual(readFile.remoteSize, file.remoteSize);
+    XCTAssertEqual(readFile.remoteWriteTime, file.remoteWriteTime);
+    XCTAssertEqual(readFile.localModificationTime, file.localModificationTime);
+}
+
+/* A session for a device that is never connected to */
+- (TOSMBSession *)offlineSession {
+    return [[TOSMBSession alloc] initWithHostName:@"NAS" ipAddress:@"192.0.2.1" port:nil
+                                         userName:@"guest" password:nil domain:nil
+                        useInternalNameResolution:NO];
+}
+
+/* A session on the stubbed connection, with retries that don't keep the tests waiting */
+- (TOSMBSession *)offlineTestsSession {
+    TOSMBSession *session = [[TOSMBClientExampleTestsSession alloc] initWithHostName:@"NAS" ipAddress:@"192.0.2.1" port:nil
+                                                                            userName:@"guest" password:nil domain:nil
+                                                           useInternalNameResolution:NO];
+    session.retryDelay = 0.01;
+    session.maximumRetryDelay = 0.01;
+    return session;
+}
+
+- (TOSMBSyncEntry *)syncEntryWithPath:(NSString *)path directory:(BOOL)directory remoteSize:(uint64_t)remoteSize local:(BOOL)local {
+    TOSMBSyncEntry *entry = [[TOSMBSyncEntry alloc] init];
+    entry.path = path;
+    entry.directory = directory;
+    entry.hasRemote = (remoteSize > 0 || directory);
+    entry.remoteSize = directory ? 0 : remoteSize;
+    entry.remoteWriteTime = directory ? 0 : kTOSMBClientExampleTestsFileTime;
+    entry.hasLocal = local;
+    entry.localSize = (local && directory == NO) ? remoteSize : 0;
+    return entry;
+}
+
+- (id<TOSMBSyncEntrySource>)syncSourceWithEntries:(NSArray<TOSMBSyncEntry *> *)entries {
+    TOSMBClientExampleTestsEntrySource *source = [[TOSMBClientExampleTestsEntrySource alloc] init];
+    source.entries = entries.objectEnumerator;
+    return source;
+}
+
+- (NSArray<TOSMBSyncAction *> *)syncActionsWithBase:(NSArray<TOSMBSyncEntry *> *)base remote:(NSArray<TOSMBSyncEntry *> *)remote {
+    TOSMBSyncEngine *engine = [[TOSMBSyncEngine alloc] initWithSession:[self offlineSession]
+                                                             remotePath:[TOSMBPath pathWithString:@"/Share"]
+                                                               localURL:[NSURL fileURLWithPath:NSTemporaryDirectory()]
+                                                            snapshotURL:[NSURL fileURLWithPath:NSTemporaryDirectory()]];
+    engine.direction = TOSMBSyncDirectionBidirectional;
+    NSMutableArray<TOSMBSyncAction *> *actions = [NSMutableArray array];
+    NSError *error = nil;
+    XCTAssertTrue([engine planActions:actions
+                               result:[[TOSMBSyncResult alloc] init]
+                      unchangedWriter:nil
+                           baseSource:[self syncSourceWithEntries:base]
+                         remoteSource:[self syncSourceWithEntries:remote]
+                          localSource:[self syncSourceWithEntries:@[]]
+                                error:&error]);
+    XCTAssertNil(error);
+    return actions;
+}
+
+- (void)testSyncKeepsDirectoryChangedOnOtherSide {
+    // Synced last time, then the folder was deleted locally
+    NSArray<TOSMBSyncEntry *> *base = @[[self syncEntryWithPath:@"Photos" directory:YES remoteSize:0 local:YES],
+                                        [self syncEntryWithPath:@"Photos/a.jpg" directory:NO remoteSize:10 local:YES]];
+
+    // Nothing changed on the device, so the folder is deleted there as a whole
+    NSArray<TOSMBSyncAction *> *actions = [self syncActionsWithBase:base remote:@[[self syncEntryWithPath:@"Photos" directory:YES remoteSize:0 local:NO],
+                                                                                  [self syncEntryWithPath:@"Photos/a.jpg" directory:NO remoteSize:10 local:NO]]];
+    XCTAssertEqual(actions.count, 1);
+    XCTAssertEqual(actions.firstObject.type, TOSMBSyncActionTypeDeleteRemote);
+    XCTAssertEqualObjects(actions.firstObject.descendantBaseEntries.firstObject.path, @"Photos/a.jpg");
+
+    // A file changed and another added on the device since then keep the folder and are downloaded
+    actions = [self syncActionsWithBase:base remote:@[[self syncEntryWithPath:@"Photos" directory:YES remoteSize:0 local:NO],
+                                                      [self syncEntryWithPath:@"Photos/a.jpg" directory:NO remoteSize:20 local:NO],
+                                                      [self syncEntryWithPath:@"Photos/b.jpg" directory:NO remoteSize:30 local:NO]]];
+    XCTAssertEqual(actions.count, 3);
+    for (TOSMBSyncAction *action in actions) {
+        XCTAssertNotEqual(action.type, TOSMBSyncActionTypeDeleteLocal);
+        XCTAssertNotEqual(action.type, TOSMBSyncActionTypeDeleteRemote);
+    }
+    XCTAssertEqual(actions[0].type, TOSMBSyncActionTypeCreateLocalDirectory);
+    XCTAssertEqual(actions[1].type, TOSMBSyncActionTypeDownload);
+    XCTAssertEqual(actions[2].type, TOSMBSyncActionTypeDownload);
+}
+
+- (void)testSyncFailedDirectoryDeletionKeepsSnapshot {
+    NSURL *snapshotURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[NSString TOSMB_uuidString]]];
+    NSURL *unchangedURL = [snapshotURL URLByAppendingPathExtension:@"unchanged"];
+    XCTAssertTrue([[[TOSMBSyncSnapshotWriter alloc] initWithURL:unchangedURL error:nil] finish]);
+
+    TOSMBSyncAction *action = [[TOSMBSyncAction alloc] init];
+    action.type = TOSMBSyncActionTypeDeleteRemote;
+    action.path = @"Photos";
+    action.directory = YES;
+    action.baseEntry = [self syncEntryWithPath:@"Photos" directory:YES remoteSize:0 local:YES];
+    action.descendantBaseEntries = @[[self syncEntryWithPath:@"Photos/a.jpg" directory:NO remoteSize:10 local:YES]];
+    action.error = errorForErrorCode(TOSMBSessionErrorCodeUnknown);
+    action.completed = YES;
+
+    TOSMBSyncEngine *engine = [[TOSMBSyncEngine alloc] initWithSession:[self offlineSession]
+                                                             remotePath:[TOSMBPath pathWithString:@"/Share"]
+                                                               localURL:[NSURL fileURLWithPath:NSTemporaryDirectory()]
+                                                            snapshotURL:snapshotURL];
+    XCTAssertTrue([engine saveSnapshotMergingUnchangedURL:unchangedURL actions:@[action] error:nil]);
+
+    // The contents stay in the snapshot, so the next sync doesn't take them for new items
+    TOSMBSyncSnapshotReader *reader = [[TOSMBSyncSnapshotReader alloc] initWithURL:snapshotURL error:nil];
+    XCTAssertEqualObjects([reader nextEntry:nil].path, @"Photos");
+    XCTAssertEqualObjects([reader nextEntry:nil].path, @"Photos/a.jpg");
+    XCTAssertNil([reader nextEntry:nil]);
+    [reader close];
+    [[NSFileManager defaultManager] removeItemAtURL:snapshotURL error:nil];
+    [[NSFileManager defaultManager] removeItemAtURL:unchangedURL error:nil];
+}
+
+- (void)testPerformanceSyncSnapshot {
+    // Writing and streaming back the snapshot of a large tree, as every sync does
+    NSURL *URL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[NSString TOSMB_uuidString]]];
+    TOSMBSyncEntry *entry = [[TOSMBSyncEntry alloc] init];
+    entry.hasRemote = YES;
+    entry.hasLocal = YES;
+    entry.remoteSize = 1024;
+    entry.remoteWriteTime = kTOSMBClientExampleTestsFileTime;
+    [self measureBlock:^{
+        TOSMBSyncSnapshotWriter *writer = [[TOSMBSyncSnapshotWriter alloc] initWithURL:URL error:nil];
+        for (NSUInteger i = 0; i < kTOSMBClientExampleTestsSnapshotCount; i++) {
+            @autoreleasepool {
+                entry.path = [NSString stringWithFormat:@"Folder %04lu/File %08lu.jpg", (unsigned long)(i / 1000), (unsigned long)i];
+                [writer appendEntry:entry];
+            }
+        }
+        XCTAssertTrue([writer finish]);
+
+        TOSMBSyncSnapshotReader *reader = [[TOSMBSyncSnapshotReader alloc] initWithURL:URL error:nil];
+        NSUInteger count = 0;
+        while (true) {
+            @autoreleasepool {
+                if ([reader nextEntry:nil] == nil) { break; }
+                count++;
+            }
+        }
+        [reader close];
+        XCTAssertEqual(count, kTOSMBClientExampleTestsSnapshotCount);
+    }];
+    [[NSFileManager defaultManager] removeItemAtURL:URL error:nil];
+}
+
+- (TOSMBShareIndexTable *)indexTableWithNames:(NSArray<NSString *> *)names {
+    // A root holding one folder, which holds every name
+    TOSMBShareIndexTableBuilder *builder = [[TOSMBShareIndexTableBuilder alloc] initWithRootWriteTime:0];
+    const uint32_t folder = [builder appendRecordWithUTF8Name:"Photos" length:6 foldedName:NULL foldedLength:0
+                                                       parent:0 directory:YES size:0 writeTime:kTOSMBClientExampleTestsFileTime];
+    [builder setChildrenOfRecord:0 first:folder count:1 writeTime:0];
+    for (NSString *name in names) {
+        [builder appendRecordWithUTF8Name:name.UTF8String length:strlen(name.UTF8String) foldedName:NULL foldedLength:0
+                                   parent:folder directory:NO size:name.length writeTime:kTOSMBClientExampleTestsFileTime];
+    }
+    [builder setChildrenOfRecord:folder first:folder + 1 count:(uint32_t)names.count writeTime:kTOSMBClientExampleTestsFileTime];
+    return [builder finish];
+}
+
+- (NSArray<NSString *> *)namesInIndexTable:(TOSMBShareIndexTable *)table matching:(NSString *)string prefix:(BOOL)prefix {
+    NSData *query = [TOSMBShareIndexFoldedString(string) dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableArray<NSString *> *names = [NSMutableArray array];
+    [table enumerateRecordsMatchingFoldedUTF8String:query.bytes length:query.length prefix:prefix usingBlock:^(uint32_t index, BOOL *stop) {
+        [names addObject:[table relativePathAtIndex:index]];
+    }];
+    return names;
+}
+
+- (void)testShareIndexSearch {
+    TOSMBShareIndexTable *table = [self indexTableWithNames:@[@"Beach.JPG", @"Caf\u00e9 Night.png", @"notes.txt", @"beachball.mov"]];
+    XCTAssertEqual(table.recordCount, 6);
+
+    NSArray *beach = @[@"Photos/Beach.JPG", @"Photos/beachball.mov"];
+    XCTAssertEqualObjects([self namesInIndexTable:table matching:@"BEACH" prefix:NO], beach);
+    XCTAssertEqualObjects([self namesInIndexTable:table matching:@"ball" prefix:NO], @[@"Photos/beachball.mov"]);
+    XCTAssertEqualObjects([self namesInIndexTable:table matching:@"ball" prefix:YES], @[]);
+    XCTAssertEqualObjects([self namesInIndexTable:table matching:@"cafe n" prefix:YES], @[@"Photos/Caf\u00e9 Night.png"]);
+    XCTAssertEqualObjects([self namesInIndexTable:table matching:@"ph" prefix:YES], @[@"Photos"]);
+    XCTAssertEqualObjects([self namesInIndexTable:table matching:@"zebra" prefix:NO], @[]);
+
+    // The same buffer reads back as the same index
+    TOSMBShareIndexTable *copy = [[TOSMBShareIndexTable alloc] initWithData:table.data error:nil];
+    XCTAssertEqualObjects([self namesInIndexTable:copy matching:@"beach" prefix:NO], beach);
+    XCTAssertNil([[TOSMBShareIndexTable alloc] initWithData:[table.data subdataWithRange:NSMakeRange(0, 64)] error:nil]);
+}
+
+- (void)testShareIndexDamagedRecords {
+    TOSMBShareIndexTable *table = [self indexTableWithNames:@[@"Beach.JPG", @"beachball.mov"]];
+    XCTAssertEqual(NSMaxRange([table childRangeOfRecordAtIndex:1]), 4);
+
+    // Point a name past the end of the names and a child range past the end of the records
+    NSMutableData *data = [table.data mutableCopy];
+    const ptrdiff_t recordsOffset = (const char *)table.records - (const char *)table.data.bytes;
+    TOSMBShareIndexRecord *records = (TOSMBShareIndexRecord *)((char *)data.mutableBytes + recordsOffset);
+    records[1].childCount = UINT32_MAX;
+    records[2].nameOffset = UINT32_MAX - 4;
+
+    // Opening only reads the header, and the damaged records read as empty rather than out of bounds
+    TOSMBShareIndexTable *damaged = [[TOSMBShareIndexTable alloc] initWithData:data error:nil];
+    XCTAssertNotNil(damaged);
+    XCTAssertEqualObjects([damaged nameAtIndex:2], @"");
+    XCTAssertEqual(strlen([damaged UTF8NameAtIndex:2]), 0);
+    XCTAssertEqual([damaged childRangeOfRecordAtIndex:1].length, 0);
+    XCTAssertEqualObjects([self namesInIndexTable:damaged matching:@"beach" prefix:NO], @[@"Photos/beachball.mov"]);
+    XCTAssertEqualObjects([self namesInIndexTable:damaged matching:@"b" prefix:YES], @[@"Photos/beachball.mov"]);
+}
+
+- (void)testPerformanceShareIndexSearch {
+    NSMutableArray<NSString *> *names = [NSMutableArray arrayWithCapacity:kTOSMBClientExampleTestsIndexCount];
+    for (uint32_t i = 0; i < kTOSMBClientExampleTestsIndexCount; i++) {
+        [names addObject:[NSString stringWithFormat:@"IMG_%07u Holiday %u.jpg", i, i % 97]];
+    }
+    TOSMBShareIndexTable *table = [self indexTableWithNames:names];
+    const char *query = "img_0123";
+    [self measureBlock:^{
+        __block NSUInteger matches = 0;
+        for (NSUInteger i = 0; i < kTOSMBClientExampleTestsIndexSearchCount; i++) {
+            [table enumerateRecordsMatchingFoldedUTF8String:query length:strlen(query) prefix:NO usingBlock:^(uint32_t index, BOOL *stop) {
+                matches++;
+            }];
+        }
+        XCTAssertEqual(matches, 1000 * kTOSMBClientExampleTestsIndexSearchCount);
+    }];
+}
+
+- (void)testPrefetcherServesCachedHeads {
+    TOSMBSession *session = [self offlineSession];
+    TOSMBPrefetcher *prefetcher = [[TOSMBPrefetcher alloc] initWithCacheCapacity:1024 * 1024];
+    TOSMBSessionFile *file = [[TOSMBSessionFile alloc] initWithName:@"a.jpg" fullPath:@"/Share/a.jpg" directory:NO];
+    file.fileSize = 100000;
+    file.writeTimestamp = kTOSMBClientExampleTestsFileTime;
+    NSMutableData *head = [NSMutableData dataWithLength:4096];
+
+    [prefetcher cacheHead:head ofFile:file inSession:session];
+    XCTAssertEqual([prefetcher cachedHeadOfFile:file inSession:session length:1024].length, 1024);
+    XCTAssertEqual([prefetcher cachedHeadOfFile:file inSession:session length:4096].length, 4096);
+    XCTAssertNil([prefetcher cachedHeadOfFile:file inSession:session length:8192]);
+
+    // Cached heads are served without touching the network, and directories are skipped
+    TOSMBSessionFile *folder = [[TOSMBSessionFile alloc] initWithName:@"b" fullPath:@"/Share/b" directory:YES];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Cached head"];
+    TOSMBPrefetchRequest *request = [prefetcher prefetchHeadsOfFiles:@[file, folder] inSession:session length:2048
+                                                            priority:TOSMBPrefetchPriorityVisible
+                                                             handler:^(TOSMBSessionFile *prefetchedFile, NSData *data, NSError *error) {
+        XCTAssertEqual(data.length, 2048);
+        XCTAssertNil(error);
+        [expectation fulfill];
+    }];
+    XCTAssertEqual(request.fileCount, 1);
+    XCTAssertEqual(request.completedFileCount, 1);
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+
+    // A changed file no longer matches its cached head
+    file.writeTimestamp += 1;
+    XCTAssertNil([prefetcher cachedHeadOfFile:file inSession:session length:1024]);
+}
+
+- (void)testMemoryDownloadTasks {
+    TOSMBSession *session = [self offlineSession];
+    char buffer[16];
+    TOSMBPath *path = [TOSMBPath pathWithString:@"/Share/a.jpg"];
+    NSArray<TOSMBSessionDownloadTask *> *tasks = @[
+        [session dataTaskForFileAtSMBPath:path progressHandler:nil completionHandler:nil failHandler:nil],
+        [session downloadTaskForFileAtSMBPath:path toBuffer:buffer length:sizeof(buffer)
+                              progressHandler:nil completionHandler:nil failHandler:nil]
+    ];
+    for (TOSMBSessionDownloadTask *task in tasks) {
+        XCTAssertEqual(task.state, TOSMBSessionTransferTaskStateReady);
+        XCTAssertEqualObjects(task.sourceFilePath, path.string);
+        XCTAssertNil(task.destinationFilePath);
+
+        // Nothing was staged on disk, so cancelling has nothing to clean up
+        [task cancel];
+        XCTAssertEqual(task.state, TOSMBSessionTransferTaskStateCancelled);
+    }
+}
+
+- (void)testRetryBackoff {
+    TOSMBSession *session = [self offlineSession];
+    session.retryDelay = 0.5;
+    session.maximumRetryDelay = 8.0;
+
+    // Doubles with each attempt, with up to a quarter of jitter on top, and stops growing at the maximum
+    for (NSUInteger attempt = 0; attempt < 8; attempt++) {
+        const NSTimeInterval base = MIN(0.5 * (1 << attempt), 8.0);
+        const NSTimeInterval delay = [session retryDelayForAttempt:attempt];
+        XCTAssertGreaterThanOrEqual(delay, base);
+        XCTAssertLessThanOrEqual(delay, base * 1.25);
+    }
+    XCTAssertLessThanOrEqual([session retryDelayForAttempt:1000], 10.0);
+
+    // With no retries left, nothing is reconnected
+    session.maximumRetryCount = 0;
+    NSUInteger attempt = 0;
+    XCTAssertFalse([session reconnectAfterFailureOfSessionWrapper:[session currentSMBSessionWrapper] attempt:&attempt]);
+    XCTAssertEqual(attempt, 0);
+    XCTAssertEqual(session.retryMetrics.droppedConnectionCount, 0);
+    XCTAssertEqual(session.retryMetrics.reconnectAttemptCount, 0);
+}
+
+- (void)testConcurrentReconnectsReplaceConnectionOnce {
+    TOSMBSession *session = [self offlineTestsSession];
+    [session setConnected:YES];
+    TOSMBCSessionWrapper *failedWrapper = [session currentSMBSessionWrapper];
+
+    // Two transfers see the same connection drop, and only one of them replaces it
+    __block BOOL firstReconnected = NO;
+    __block BOOL secondReconnected = NO;
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+        NSUInteger attempt = 0;
+        firstReconnected = [session reconnectAfterFailureOfSessionWrapper:failedWrapper attempt:&attempt];
+    });
+    dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+        NSUInteger attempt = 0;
+        secondReconnected = [session reconnectAfterFailureOfSessionWrapper:failedWrapper attempt:&attempt];
+    });
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+    XCTAssertTrue(firstReconnected);
+    XCTAssertTrue(secondReconnected);
+    XCTAssertNotEqual([session currentSMBSessionWrapper], failedWrapper);
+    XCTAssertEqual(session.retryMetrics.droppedConnectionCount, 1);
+    XCTAssertEqual(session.retryMetrics.reconnectAttemptCount, 1);
+
+    // A caller that comes late goes again on the new connection without replacing it
+    TOSMBCSessionWrapper *currentWrapper = [session currentSMBSessionWrapper];
+    NSUInteger attempt = 0;
+    XCTAssertTrue([session reconnectAfterFailureOfSessionWrapper:failedWrapper attempt:&attempt]);
+    XCTAssertEqual([session currentSMBSessionWrapper], currentWrapper);
+    XCTAssertEqual(session.retryMetrics.droppedConnectionCount, 1);
+}
+
+- (void)testTransferResumesAfterDroppedConnection {
+    TOSMBSession *session = [self offlineTestsSession];
+    [session setConnected:YES];
+    TOSMBPath *path = [TOSMBPath pathWithString:@"/Share/a.jpg"];
+    TOSMBSessionDownloadTask *task = [session dataTaskForFileAtSMBPath:path progressHandler:nil completionHandler:nil failHandler:nil];
+    TOSMBCSessionWrapper *failedWrapper = [session currentSMBSessionWrapper];
+    char buffer[16];
+
+    // Transport errors are told apart from the server's answers by the result alone, where there is one
+    TOSMBClientExampleTestsConnectionDown = NO;
+    TOSMBSessionOperationContext *context = [[TOSMBClientExampleTestsOperationContext alloc] init];
+    XCTAssertTrue([context hasConnectionFailedAfterResult:DSM_ERROR_NETWORK]);
+    XCTAssertFalse([context hasConnectionFailedAfterResult:DSM_ERROR_NT]);
+    XCTAssertFalse([context hasConnectionFailedAfterResult:DSM_ERROR_GENERIC]);
+
+    // A read the server turned down fails without reconnecting
+    TOSMBClientExampleTestsFailedReadCount = 1;
+    XCTAssertEqual([task readRemoteFileAtPath:path offset:1024 intoBuffer:buffer length:sizeof(buffer)], -1);
+    XCTAssertEqual([session currentSMBSessionWrapper], failedWrapper);
+    XCTAssertEqual(session.retryMetrics.droppedConnectionCount, 0);
+
+    // A read that lost the connection reconnects, reopens the file where it left off and reads again
+    TOSMBClientExampleTestsFailedReadCount = 1;
+    TOSMBClientExampleTestsConnectionDown = YES;
+    TOSMBClientExampleTestsOpenOffset = 0;
+    XCTAssertEqual([task readRemoteFileAtPath:path offset:1024 intoBuffer:buffer length:sizeof(buffer)], (ssize_t)sizeof(buffer));
+    XCTAssertNotEqual([session currentSMBSessionWrapper], failedWrapper);
+    XCTAssertEqual(TOSMBClientExampleTestsOpenOffset, 1024);
+    XCTAssertEqual(task.fileID, 7);
+    XCTAssertEqual(session.retryMetrics.droppedConnectionCount, 1);
+    XCTAssertEqual(session.retryMetrics.resumedTransferCount, 1);
+}
+
+- (void)testProgressStreamCoalescesTasks {
+    TOSMBSession *session = [self offlineSession];
+    TOSMBPath *path = [TOSMBPath pathWithString:@"/Share/a.jpg"];
+    TOSMBSessionDownloadTask *resumed = [session dataTaskForFileAtSMBPath:path progressHandler:nil completionHandler:nil failHandler:nil];
+    XCTestExpectation *failHandled = [self expectationWithDescription:@"fail handler"];
+    TOSMBSessionDownloadTask *failed = [session dataTaskForFileAtSMBPath:path progressHandler:nil completionHandler:nil failHandler:^(NSError *error) {
+        XCTAssertEqual(error.code, TOSMBSessionErrorCodeFileDownloadFailed);
+        [failHandled fulfill];
+    }];
+
+    XCTestExpectation *finished = [self expectationWithDescription:@"final event"];
+    __block NSUInteger eventCount = 0;
+    dispatch_queue_t queue = dispatch_queue_create("progress_stream_test", DISPATCH_QUEUE_SERIAL);
+    TOSMBProgressStream *stream = [[TOSMBProgressStream alloc] initWithInterval:0.1 queue:queue handler:^(TOSMBProgressEvent *event) {
+        eventCount++;
+        if (event.activeTaskCount == 0) {
+            [finished fulfill];
+        }
+    }];
+    [stream addTask:resumed];
+    [stream addTasksOfSession:session];
+
+    // Thousands of tiny chunks still make only a handful of events
+    const CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    const int64_t resumeOffset = 1000000;
+    [resumed reportProgressWithCompletedBytes:resumeOffset totalBytes:resumeOffset + 10000];
+    for (int64_t i = 1; i <= 10000; i++) {
+        [resumed reportProgressWithCompletedBytes:resumeOffset + i totalBytes:resumeOffset + 10000];
+        [failed reportProgressWithCompletedBytes:i totalBytes:50000];
+    }
+    [resumed didSucceedInMemory];
+    [failed didFailWithError:errorForErrorCode(TOSMBSessionErrorCodeFileDownloadFailed)];
+
+    const NSTimeInterval elapsed = CFAbsoluteTimeGetCurrent() - start;
+
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    dispatch_sync(queue, ^{});
+    XCTAssertLessThanOrEqual(eventCount, (NSUInteger)(elapsed / 0.1) + 2);
+
+    // The failed task's missing bytes are dropped from the total
+    TOSMBProgressEvent *event = stream.lastEvent;
+    XCTAssertEqual(event.finishedTaskCount, 2);
+    XCTAssertEqual(event.completedBytes, (uint64_t)(resumeOffset + 20000));
+    XCTAssertEqual(event.totalBytes, event.completedBytes);
+    XCTAssertEqualWithAccuracy(event.fractionCompleted, 1.0, DBL_EPSILON);
+    XCTAssertEqual(event.estimatedTimeRemaining, 0.0);
+}
+
+- (void)testProgressStreamCountsOffAbandonedTasks {
+    TOSMBSession *session = [self offlineSession];
+    TOSMBPath *path = [TOSMBPath pathWithString:@"/Share/a.jpg"];
+    TOSMBSessionDownloadTask *finished = [session dataTaskForFileAtSMBPath:path progressHandler:nil completionHandler:nil failHandler:nil];
+
+    dispatch_queue_t queue = dispatch_queue_create("progress_stream_test", DISPATCH_QUEUE_SERIAL);
+    TOSMBProgressStream *stream = [[TOSMBProgressStream alloc] initWithInterval:0.0 queue:queue handler:^(TOSMBProgressEvent *event) {}];
+    [stream addTask:finished];
+    [finished reportProgressWithCompletedBytes:100 totalBytes:100];
+
+    // A task that goes away half done, and one that is never started, stop counting as active
+    @autoreleasepool {
+        TOSMBSessionDownloadTask *abandoned = [session dataTaskForFileAtSMBPath:path progressHandler:nil completionHandler:nil failHandler:nil];
+        TOSMBSessionDownloadTask *neverStarted = [session dataTaskForFileAtSMBPath:path progressHandler:nil completionHandler:nil failHandler:nil];
+        [stream addTask:abandoned];
+        [stream addTask:neverStarted];
+        [abandoned reportProgressWithCompletedBytes:10 totalBytes:50];
+    }
+    [finished didSucceedInMemory];
+
+    NSPredicate *settled = [NSPredicate predicateWithBlock:^BOOL(TOSMBProgressStream *object, NSDictionary *bindings) {
+        return object.lastEvent.activeTaskCount == 0 && object.lastEvent.finishedTaskCount == 3;
+    }];
+    [self expectationForPredicate:settled evaluatedWithObject:stream handler:nil];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    TOSMBProgressEvent *event = stream.lastEvent;
+    XCTAssertEqual(event.completedBytes, 110);
+    XCTAssertEqual(event.totalBytes, 110);
+    XCTAssertEqual(event.estimatedTimeRemaining, 0.0);
+}
+
+- (NSDate *)calendarDateFromFileTime:(uint64_t)fileTime {
+    NSDateComponents *base = [[NSDateComponents alloc] init];
+    [base setDay:1];
+    [base setMonth:1];
+    [base setYear:1601];
+    [base setEra:1];
+    NSCalendar *gregorian = [[NSCalendar alloc] initWithCalendarIdentifier:NSCalendarIdentifierGregorian];
+    NSDate *baseDate = [gregorian dateFromComponents:base];
+    return [baseDate dateByAddingTimeInterval:fileTime / 10000000.0];
+}
+
 @end